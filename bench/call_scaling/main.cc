@@ -0,0 +1,171 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include <datadriven/datadriven.h>
+#include <datadriven/Semaphore.h>
+#include <alljoyn/Init.h>
+
+#include "CallScalingInterface.h"
+#include "CallScalingProxy.h"
+
+using namespace std;
+using namespace gen::org_allseenalliance_test;
+
+/**
+ * Method call throughput with many threads calling on the same proxy.
+ *
+ * Every consumer thread does synchronous Echo round trips on one shared
+ * proxy, so all of them contend on its liveness check and on the consumer
+ * side bookkeeping of pending calls. Prints one line per thread count:
+ *
+ *   call_scaling <threads> <calls/s> <us/call per thread>
+ */
+namespace bench_call_scaling {
+#define CALLS_PER_THREAD 2000
+#define MAX_THREADS 16
+
+static unsigned long long NowNanos()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/***[ provider code ]**********************************************************/
+
+class CallScaling :
+    public datadriven::ProvidedObject,
+    public CallScalingInterface {
+  public:
+    CallScaling(shared_ptr<datadriven::ObjectAdvertiser> advertiser) :
+        datadriven::ProvidedObject(advertiser),
+        CallScalingInterface(this)
+    {
+    }
+
+  protected:
+    void Echo(int32_t i, std::shared_ptr<EchoReply> _reply)
+    {
+        _reply->Send(i);
+    }
+};
+
+static void be_provider(void)
+{
+    shared_ptr<datadriven::ObjectAdvertiser> advertiser = datadriven::ObjectAdvertiser::Create();
+    assert(nullptr != advertiser);
+
+    CallScaling obj(advertiser);
+    QStatus status = obj.UpdateAll();
+    assert(ER_OK == status);
+    (void)status;
+
+    while (true) {
+        sleep(1);
+    }
+}
+
+/***[ consumer code ]**********************************************************/
+
+static datadriven::Semaphore _sync;
+
+class UpdateListener :
+    public datadriven::Observer<CallScalingProxy>::Listener {
+  public:
+    void OnUpdate(const std::shared_ptr<CallScalingProxy>& proxy)
+    {
+        _sync.Post();
+    }
+};
+
+static void Call(const CallScalingProxy* proxy)
+{
+    for (int32_t i = 0; i < CALLS_PER_THREAD; i++) {
+        std::shared_ptr<datadriven::MethodInvocation<CallScalingProxy::EchoReply> > inv = proxy->Echo(i);
+        const CallScalingProxy::EchoReply& reply = inv->GetReply();
+        assert(ER_OK == reply.GetStatus());
+        assert(i == reply.o);
+        (void)reply;
+    }
+}
+
+static void be_consumer(void)
+{
+    UpdateListener ul;
+    std::shared_ptr<datadriven::Observer<CallScalingProxy> > observer =
+        datadriven::Observer<CallScalingProxy>::Create(&ul);
+    assert(nullptr != observer);
+
+    // wait for object
+    _sync.Wait();
+    std::shared_ptr<CallScalingProxy> proxy = *observer->begin();
+    assert(nullptr != proxy);
+
+    for (unsigned int n = 1; n <= MAX_THREADS; n *= 2) {
+        std::vector<std::thread> threads;
+        unsigned long long start = NowNanos();
+        for (unsigned int i = 0; i < n; i++) {
+            threads.push_back(std::thread(Call, proxy.get()));
+        }
+        for (unsigned int i = 0; i < n; i++) {
+            threads[i].join();
+        }
+        unsigned long long elapsed = NowNanos() - start;
+
+        printf("call_scaling %u %.0f %.1f\n", n,
+               (double)n * CALLS_PER_THREAD * 1e9 / elapsed,
+               elapsed / 1000.0 / CALLS_PER_THREAD);
+        fflush(stdout);
+    }
+}
+};
+
+/***[ main code ]**************************************************************/
+
+using namespace bench_call_scaling;
+
+int main(int argc, char** argv)
+{
+    if (AllJoynInit() != ER_OK) {
+        return EXIT_FAILURE;
+    }
+
+    // only play provider if first command-line argument starts with a 'p'
+    if (argc <= 1) {
+        printf("Usage: %s <consumer|provider>\n", argv[0]);
+        return 1;
+    }
+    if ('p' == *argv[1]) {
+        be_provider();
+    } else {
+        be_consumer();
+    }
+
+    AllJoynShutdown();
+
+    return 0;
+}
@@ -0,0 +1,162 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <iostream>
+#include <map>
+#include <type_traits>
+
+#include <datadriven/datadriven.h>
+#include <datadriven/FlatMap.h>
+#include <datadriven/Marshal.h>
+#include <alljoyn/Init.h>
+
+#include "AllDictionariesInterface.h"
+
+using namespace std;
+using namespace gen::org_allseenalliance_test;
+
+/**
+ * Dictionary marshalling benchmark.
+ *
+ * Marshals and unmarshals the dictionary types of the AllDictionaries test
+ * interface backed by std::map and by datadriven::FlatMap, and prints one line
+ * per measurement:
+ *
+ *   dict_bench <type> <container> <elements> <marshal ns/elem> <unmarshal ns/elem>
+ */
+namespace bench_dict {
+#define TOTAL_ELEMENTS (1 << 20)
+
+typedef AllDictionariesInterface::Type Type;
+
+static unsigned long long NowNanos()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+template <typename T> void Fill(T& t, size_t i)
+{
+    t = (T)i;
+}
+
+static void Fill(qcc::String& s, size_t i)
+{
+    char buf[32];
+
+    snprintf(buf, sizeof(buf), "key%08zu", i);
+    s = buf;
+}
+
+/* Both containers are built from the key and value types of the generated
+ * dictionary, so the benchmark works whatever DICT_TYPE the code was
+ * generated with. */
+template <typename D> struct Containers {
+    typedef typename std::remove_const<typename D::key_type>::type K;
+    typedef typename D::mapped_type V;
+    typedef std::map<const K, V> Map;
+    typedef datadriven::FlatMap<const K, V> Flat;
+};
+
+template <typename C> void Populate(C& c, size_t nelem)
+{
+    for (size_t i = 0; i < nelem; i++) {
+        typename std::remove_const<typename C::key_type>::type k;
+        typename C::mapped_type v;
+
+        Fill(k, i);
+        Fill(v, nelem - i);
+        c[k] = v;
+    }
+}
+
+template <typename C> void Run(const char* type, const char* container, size_t nelem, C& result)
+{
+    C src;
+    Populate(src, nelem);
+
+    size_t rounds = TOTAL_ELEMENTS / nelem;
+    unsigned long long tmarshal = 0;
+    unsigned long long tunmarshal = 0;
+
+    for (size_t r = 0; r < rounds; r++) {
+        ajn::MsgArg arg;
+        unsigned long long t0 = NowNanos();
+        QStatus status = datadriven::Marshal(arg, src);
+        unsigned long long t1 = NowNanos();
+        assert(ER_OK == status);
+        status = datadriven::Unmarshal(result, arg);
+        unsigned long long t2 = NowNanos();
+        assert(ER_OK == status);
+        (void)status;
+
+        tmarshal += t1 - t0;
+        tunmarshal += t2 - t1;
+    }
+    assert(nelem == result.size());
+
+    double total = (double)rounds * nelem;
+    printf("dict_bench %s %s %zu %.1f %.1f\n", type, container, nelem, tmarshal / total, tunmarshal / total);
+}
+
+template <typename D> void Bench(const char* type)
+{
+    static const size_t sizes[] = { 16, 256, 4096, 65536 };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        typename Containers<D>::Map m;
+        typename Containers<D>::Flat f;
+
+        Run(type, "map", sizes[i], m);
+        Run(type, "flat", sizes[i], f);
+
+        // both containers must hold the same, ordered content
+        assert(m.size() == f.size());
+        typename Containers<D>::Flat::const_iterator fit = f.begin();
+        for (typename Containers<D>::Map::const_iterator mit = m.begin(); mit != m.end(); ++mit, ++fit) {
+            assert(mit->first == fit->first);
+            assert(mit->second == fit->second);
+        }
+    }
+}
+};
+
+/***[ main code ]**************************************************************/
+
+using namespace bench_dict;
+
+int main(int argc, char** argv)
+{
+    if (AllJoynInit() != ER_OK) {
+        return EXIT_FAILURE;
+    }
+
+    Bench<Type::DictionaryOfInt32>("DictionaryOfInt32");
+    Bench<Type::DictionaryOfUnsignedInt64>("DictionaryOfUnsignedInt64");
+    Bench<Type::DictionaryOfDouble>("DictionaryOfDouble");
+    Bench<Type::DictionaryOfString>("DictionaryOfString");
+
+    AllJoynShutdown();
+
+    return 0;
+}
@@ -0,0 +1,210 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <datadriven/datadriven.h>
+#include <datadriven/Semaphore.h>
+#include <alljoyn/Init.h>
+
+#include "DiscoveryLatencyInterface.h"
+#include "DiscoveryLatencyProxy.h"
+
+using namespace std;
+using namespace gen::org_allseenalliance_test;
+
+/**
+ * Method reply latency during discovery.
+ *
+ * The provider exposes a first object and, shortly after, a large batch of
+ * additional objects. The consumer spends time on every discovered object,
+ * so the batch floods its queue, and meanwhile measures the time from
+ * calling Echo on the first object until its reply listener runs. Prints:
+ *
+ *   discovery_latency <p50 us> <p99 us> <objects discovered while calling>
+ */
+namespace bench_discovery_latency {
+#define CALLS 1000
+#define OBJECTS 2000
+#define DISCOVERY_DELAY_S 2
+#define DISCOVERY_WORK_US 200
+
+static double NowMicros()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/***[ provider code ]**********************************************************/
+
+class DiscoveryLatency :
+    public datadriven::ProvidedObject,
+    public DiscoveryLatencyInterface {
+  public:
+    DiscoveryLatency(shared_ptr<datadriven::ObjectAdvertiser> advertiser) :
+        datadriven::ProvidedObject(advertiser),
+        DiscoveryLatencyInterface(this)
+    {
+    }
+
+  protected:
+    void Echo(int32_t i, std::shared_ptr<EchoReply> _reply)
+    {
+        _reply->Send(i);
+    }
+};
+
+static void Publish(DiscoveryLatency& obj, int32_t index)
+{
+    obj.Index = index;
+    QStatus status = obj.UpdateAll();
+    assert(ER_OK == status);
+    (void)status;
+}
+
+static void be_provider(void)
+{
+    shared_ptr<datadriven::ObjectAdvertiser> advertiser = datadriven::ObjectAdvertiser::Create();
+    assert(nullptr != advertiser);
+
+    DiscoveryLatency first(advertiser);
+    Publish(first, 0);
+
+    // give the consumer time to find the first object before the flood
+    sleep(DISCOVERY_DELAY_S);
+    std::vector<std::unique_ptr<DiscoveryLatency> > objects;
+    for (int32_t i = 1; i <= OBJECTS; i++) {
+        objects.push_back(std::unique_ptr<DiscoveryLatency>(new DiscoveryLatency(advertiser)));
+        Publish(*objects.back(), i);
+    }
+
+    while (true) {
+        sleep(1);
+    }
+}
+
+/***[ consumer code ]**********************************************************/
+
+static datadriven::Semaphore _sync;
+
+class DiscoveryListener :
+    public datadriven::Observer<DiscoveryLatencyProxy>::Listener {
+  public:
+    DiscoveryListener() :
+        discovered(0) { }
+
+    void OnUpdate(const std::shared_ptr<DiscoveryLatencyProxy>& proxy)
+    {
+        if (0 == discovered++) {
+            _sync.Post();
+        }
+        /* stand-in for application work on each discovered object */
+        double until = NowMicros() + DISCOVERY_WORK_US;
+        while (NowMicros() < until) {
+        }
+    }
+
+    std::atomic<int> discovered;
+};
+
+class EchoListener :
+    public datadriven::MethodReplyListener<DiscoveryLatencyProxy::EchoReply> {
+  public:
+    double sent;
+    std::vector<double> samples;
+
+    void OnReply(const DiscoveryLatencyProxy::EchoReply& reply)
+    {
+        assert(ER_OK == reply.GetStatus());
+        samples.push_back(NowMicros() - sent);
+        _sync.Post();
+    }
+};
+
+static void be_consumer(void)
+{
+    DiscoveryListener dl;
+    std::shared_ptr<datadriven::Observer<DiscoveryLatencyProxy> > observer =
+        datadriven::Observer<DiscoveryLatencyProxy>::Create(&dl);
+    assert(nullptr != observer);
+
+    // wait for the first object
+    _sync.Wait();
+    std::shared_ptr<DiscoveryLatencyProxy> proxy = *observer->begin();
+    assert(nullptr != proxy);
+
+    // start calling once the flood of discoveries has started
+    while (dl.discovered < 2) {
+        usleep(10 * 1000);
+    }
+    int before = dl.discovered;
+
+    EchoListener listener;
+    for (int32_t i = 0; i < CALLS; i++) {
+        listener.sent = NowMicros();
+        std::shared_ptr<datadriven::MethodInvocation<DiscoveryLatencyProxy::EchoReply> > inv = proxy->Echo(i);
+        QStatus status = inv->SetListener(listener, datadriven::MethodInvocationBase::DISPATCH_QUEUED);
+        assert(ER_OK == status);
+        (void)status;
+        _sync.Wait();
+    }
+    int during = dl.discovered - before;
+
+    std::sort(listener.samples.begin(), listener.samples.end());
+    printf("discovery_latency %.0f %.0f %d\n",
+           listener.samples[listener.samples.size() / 2],
+           listener.samples[listener.samples.size() * 99 / 100],
+           during);
+}
+};
+
+/***[ main code ]**************************************************************/
+
+using namespace bench_discovery_latency;
+
+int main(int argc, char** argv)
+{
+    if (AllJoynInit() != ER_OK) {
+        return EXIT_FAILURE;
+    }
+
+    // only play provider if first command-line argument starts with a 'p'
+    if (argc <= 1) {
+        printf("Usage: %s <consumer|provider>\n", argv[0]);
+        return 1;
+    }
+    if ('p' == *argv[1]) {
+        be_provider();
+    } else {
+        be_consumer();
+    }
+
+    AllJoynShutdown();
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <datadriven/datadriven.h>
+#include <datadriven/Semaphore.h>
+#include <alljoyn/Init.h>
+
+#include "DiscoveryTimeInterface.h"
+#include "DiscoveryTimeProxy.h"
+
+using namespace std;
+using namespace gen::org_allseenalliance_test;
+
+/**
+ * Discovery time of many objects.
+ *
+ * The provider exposes OBJECTS objects. The consumer repeatedly creates an
+ * observer and measures the time until it discovered 1, 10, 100 and all
+ * objects. Every observer is destroyed before the next is created, which
+ * also tears down the consumer's bus connection, so each round starts
+ * discovery from scratch. An unreported first round waits for the provider
+ * to publish all objects. Prints one line per round and milestone:
+ *
+ *   discovery_time <round> <objects> <ms>
+ */
+namespace bench_discovery_time {
+#define OBJECTS 500
+#define ROUNDS 3
+#define SETTLE_S 1
+
+static const int _milestones[] = { 1, 10, 100, OBJECTS };
+#define NUM_MILESTONES (sizeof(_milestones) / sizeof(_milestones[0]))
+
+static double NowMillis()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/***[ provider code ]**********************************************************/
+
+class DiscoveryTime :
+    public datadriven::ProvidedObject,
+    public DiscoveryTimeInterface {
+  public:
+    DiscoveryTime(shared_ptr<datadriven::ObjectAdvertiser> advertiser) :
+        datadriven::ProvidedObject(advertiser),
+        DiscoveryTimeInterface(this)
+    {
+    }
+};
+
+static void be_provider(void)
+{
+    shared_ptr<datadriven::ObjectAdvertiser> advertiser = datadriven::ObjectAdvertiser::Create();
+    assert(nullptr != advertiser);
+
+    std::vector<std::unique_ptr<DiscoveryTime> > objects;
+    for (int32_t i = 0; i < OBJECTS; i++) {
+        objects.push_back(std::unique_ptr<DiscoveryTime>(new DiscoveryTime(advertiser)));
+        objects.back()->Index = i;
+        QStatus status = objects.back()->UpdateAll();
+        assert(ER_OK == status);
+        (void)status;
+    }
+
+    while (true) {
+        sleep(1);
+    }
+}
+
+/***[ consumer code ]**********************************************************/
+
+class DiscoveryListener :
+    public datadriven::Observer<DiscoveryTimeProxy>::Listener {
+  public:
+    DiscoveryListener() :
+        discovered(0), start(NowMillis()) { }
+
+    void OnUpdate(const std::shared_ptr<DiscoveryTimeProxy>& proxy)
+    {
+        int n = ++discovered;
+        for (size_t i = 0; i < NUM_MILESTONES; i++) {
+            if (n == _milestones[i]) {
+                elapsed[i] = NowMillis() - start;
+            }
+        }
+        if (OBJECTS == n) {
+            done.Post();
+        }
+    }
+
+    std::atomic<int> discovered;
+    double start;
+    double elapsed[NUM_MILESTONES];
+    datadriven::Semaphore done;
+};
+
+static void Round(int round)
+{
+    DiscoveryListener listener;
+    {
+        std::shared_ptr<datadriven::Observer<DiscoveryTimeProxy> > observer =
+            datadriven::Observer<DiscoveryTimeProxy>::Create(&listener);
+        assert(nullptr != observer);
+
+        QStatus status = listener.done.Wait();
+        assert(ER_OK == status);
+        (void)status;
+    }
+
+    if (round > 0) {
+        for (size_t i = 0; i < NUM_MILESTONES; i++) {
+            printf("discovery_time %d %d %.1f\n", round, _milestones[i], listener.elapsed[i]);
+        }
+        fflush(stdout);
+    }
+    sleep(SETTLE_S);
+}
+
+static void be_consumer(void)
+{
+    for (int round = 0; round <= ROUNDS; round++) {
+        Round(round);
+    }
+}
+};
+
+/***[ main code ]**************************************************************/
+
+using namespace bench_discovery_time;
+
+int main(int argc, char** argv)
+{
+    if (AllJoynInit() != ER_OK) {
+        return EXIT_FAILURE;
+    }
+
+    // only play provider if first command-line argument starts with a 'p'
+    if (argc <= 1) {
+        printf("Usage: %s <consumer|provider>\n", argv[0]);
+        return 1;
+    }
+    if ('p' == *argv[1]) {
+        be_provider();
+    } else {
+        be_consumer();
+    }
+
+    AllJoynShutdown();
+
+    return 0;
+}
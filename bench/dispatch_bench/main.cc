@@ -0,0 +1,250 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <datadriven/datadriven.h>
+#include <datadriven/Semaphore.h>
+#include <alljoyn/Init.h>
+
+#include "Dispatch0Interface.h"
+#include "Dispatch1Interface.h"
+#include "Dispatch2Interface.h"
+#include "Dispatch3Interface.h"
+#include "Dispatch4Interface.h"
+#include "Dispatch5Interface.h"
+#include "Dispatch6Interface.h"
+#include "Dispatch7Interface.h"
+#include "Dispatch7Proxy.h"
+
+using namespace std;
+using namespace gen::org_allseenalliance_test;
+
+/**
+ * Provider side method dispatch benchmark.
+ *
+ * The provider exposes two objects implementing the Dispatch7 interface:
+ * one that implements only that interface, and one that implements eight
+ * interfaces with the Dispatch7 interface added last. The consumer does
+ * synchronous Echo7 round trips on both, so the difference shows the cost
+ * of finding the provided interface of an incoming call. Prints one line
+ * per object:
+ *
+ *   dispatch_bench <interfaces> <calls/s> <us/call>
+ */
+namespace bench_dispatch {
+#define CALLS 20000
+#define ONE_PATH "/dispatch/one"
+#define MANY_PATH "/dispatch/many"
+
+static unsigned long long NowNanos()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/***[ provider code ]**********************************************************/
+
+class One :
+    public datadriven::ProvidedObject,
+    public Dispatch7Interface {
+  public:
+    One(shared_ptr<datadriven::ObjectAdvertiser> advertiser) :
+        datadriven::ProvidedObject(advertiser, ONE_PATH),
+        Dispatch7Interface(this)
+    {
+    }
+
+  protected:
+    void Echo7(int32_t i, std::shared_ptr<Echo7Reply> _reply)
+    {
+        _reply->Send(i);
+    }
+};
+
+class Many :
+    public datadriven::ProvidedObject,
+    public Dispatch0Interface,
+    public Dispatch1Interface,
+    public Dispatch2Interface,
+    public Dispatch3Interface,
+    public Dispatch4Interface,
+    public Dispatch5Interface,
+    public Dispatch6Interface,
+    public Dispatch7Interface {
+  public:
+    Many(shared_ptr<datadriven::ObjectAdvertiser> advertiser) :
+        datadriven::ProvidedObject(advertiser, MANY_PATH),
+        Dispatch0Interface(this),
+        Dispatch1Interface(this),
+        Dispatch2Interface(this),
+        Dispatch3Interface(this),
+        Dispatch4Interface(this),
+        Dispatch5Interface(this),
+        Dispatch6Interface(this),
+        Dispatch7Interface(this)
+    {
+    }
+
+  protected:
+    void Echo0(int32_t i, std::shared_ptr<Echo0Reply> _reply)
+    {
+        _reply->Send(i);
+    }
+
+    void Echo1(int32_t i, std::shared_ptr<Echo1Reply> _reply)
+    {
+        _reply->Send(i);
+    }
+
+    void Echo2(int32_t i, std::shared_ptr<Echo2Reply> _reply)
+    {
+        _reply->Send(i);
+    }
+
+    void Echo3(int32_t i, std::shared_ptr<Echo3Reply> _reply)
+    {
+        _reply->Send(i);
+    }
+
+    void Echo4(int32_t i, std::shared_ptr<Echo4Reply> _reply)
+    {
+        _reply->Send(i);
+    }
+
+    void Echo5(int32_t i, std::shared_ptr<Echo5Reply> _reply)
+    {
+        _reply->Send(i);
+    }
+
+    void Echo6(int32_t i, std::shared_ptr<Echo6Reply> _reply)
+    {
+        _reply->Send(i);
+    }
+
+    void Echo7(int32_t i, std::shared_ptr<Echo7Reply> _reply)
+    {
+        _reply->Send(i);
+    }
+};
+
+static void be_provider(void)
+{
+    shared_ptr<datadriven::ObjectAdvertiser> advertiser = datadriven::ObjectAdvertiser::Create();
+    assert(nullptr != advertiser);
+
+    One one(advertiser);
+    Many many(advertiser);
+    QStatus status = one.UpdateAll();
+    assert(ER_OK == status);
+    status = many.UpdateAll();
+    assert(ER_OK == status);
+    (void)status;
+
+    while (true) {
+        sleep(1);
+    }
+}
+
+/***[ consumer code ]**********************************************************/
+
+static datadriven::Semaphore _sync;
+
+class UpdateListener :
+    public datadriven::Observer<Dispatch7Proxy>::Listener {
+  public:
+    void OnUpdate(const std::shared_ptr<Dispatch7Proxy>& proxy)
+    {
+        _sync.Post();
+    }
+};
+
+static void Run(const Dispatch7Proxy& proxy, int interfaces)
+{
+    unsigned long long start = NowNanos();
+    for (int32_t i = 0; i < CALLS; i++) {
+        std::shared_ptr<datadriven::MethodInvocation<Dispatch7Proxy::Echo7Reply> > inv = proxy.Echo7(i);
+        const Dispatch7Proxy::Echo7Reply& reply = inv->GetReply();
+        assert(ER_OK == reply.GetStatus());
+        assert(i == reply.o);
+        (void)reply;
+    }
+    unsigned long long elapsed = NowNanos() - start;
+
+    printf("dispatch_bench %d %.0f %.1f\n", interfaces,
+           (double)CALLS * 1e9 / elapsed, elapsed / 1000.0 / CALLS);
+    fflush(stdout);
+}
+
+static void be_consumer(void)
+{
+    UpdateListener ul;
+    std::shared_ptr<datadriven::Observer<Dispatch7Proxy> > observer =
+        datadriven::Observer<Dispatch7Proxy>::Create(&ul);
+    assert(nullptr != observer);
+
+    // wait for both objects
+    _sync.Wait();
+    _sync.Wait();
+
+    std::shared_ptr<Dispatch7Proxy> one;
+    std::shared_ptr<Dispatch7Proxy> many;
+    for (datadriven::Observer<Dispatch7Proxy>::iterator it = observer->begin(); it != observer->end(); ++it) {
+        if ((*it)->GetObjectId().GetBusObjectPath() == ONE_PATH) {
+            one = *it;
+        } else if ((*it)->GetObjectId().GetBusObjectPath() == MANY_PATH) {
+            many = *it;
+        }
+    }
+    assert(nullptr != one);
+    assert(nullptr != many);
+
+    Run(*one, 1);
+    Run(*many, 8);
+}
+};
+
+/***[ main code ]**************************************************************/
+
+using namespace bench_dispatch;
+
+int main(int argc, char** argv)
+{
+    if (AllJoynInit() != ER_OK) {
+        return EXIT_FAILURE;
+    }
+
+    // only play provider if first command-line argument starts with a 'p'
+    if (argc <= 1) {
+        printf("Usage: %s <consumer|provider>\n", argv[0]);
+        return 1;
+    }
+    if ('p' == *argv[1]) {
+        be_provider();
+    } else {
+        be_consumer();
+    }
+
+    AllJoynShutdown();
+
+    return 0;
+}
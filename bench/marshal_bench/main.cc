@@ -0,0 +1,162 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <map>
+#include <new>
+#include <vector>
+
+#include <datadriven/datadriven.h>
+#include <datadriven/Marshal.h>
+#include <datadriven/MarshalArena.h>
+#include <alljoyn/Init.h>
+
+#include "AllDictionariesInterface.h"
+
+/***[ allocation counting ]****************************************************/
+
+static volatile size_t _allocations = 0;
+
+void* operator new(size_t size)
+{
+    __sync_fetch_and_add(&_allocations, 1);
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        abort();
+    }
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) throw()
+{
+    free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+    free(p);
+}
+
+using namespace std;
+using namespace gen::org_allseenalliance_test;
+
+/**
+ * Marshalling allocation benchmark.
+ *
+ * Marshals nested values once per operation on the heap and inside a
+ * MarshalArena scope, and prints one line per measurement:
+ *
+ *   marshal_bench <type> <heap|arena> <elements> <allocations/op> <ns/op>
+ */
+namespace bench_marshal {
+#define OPERATIONS 2000
+
+typedef AllDictionariesInterface::Type Type;
+typedef std::vector<std::map<const int32_t, std::vector<qcc::String> > > NestedStrings;
+
+static unsigned long long NowNanos()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void Init(NestedStrings& v, size_t nelem)
+{
+    v.resize(nelem);
+    for (size_t i = 0; i < nelem; i++) {
+        for (size_t j = 0; j < nelem; j++) {
+            v[i][j].assign(4, qcc::String("some string value"));
+        }
+    }
+}
+
+static void Init(Type::DictionaryOfDictionary& d, size_t nelem)
+{
+    for (size_t i = 0; i < nelem; i++) {
+        for (size_t j = 0; j < nelem; j++) {
+            d[i][j] = i * j;
+        }
+    }
+}
+
+static void Init(Type::DictionaryOfStruct& d, size_t nelem)
+{
+    for (size_t i = 0; i < nelem; i++) {
+        d[i] = Type::DictionaryOfStruct::mapped_type();
+    }
+}
+
+template <typename T> void Run(const char* type, size_t nelem)
+{
+    T value;
+    Init(value, nelem);
+
+    for (int useArena = 0; useArena < 2; useArena++) {
+        datadriven::MarshalArena arena;
+        size_t allocs = _allocations;
+        unsigned long long t0 = NowNanos();
+
+        for (int op = 0; op < OPERATIONS; op++) {
+            {
+                datadriven::MarshalArena::Scope scope(useArena ? &arena : NULL);
+                ajn::MsgArg arg;
+                QStatus status = datadriven::Marshal(arg, value);
+                assert(ER_OK == status);
+                (void)status;
+            }
+            arena.Reset();
+        }
+
+        unsigned long long t1 = NowNanos();
+        allocs = _allocations - allocs;
+        printf("marshal_bench %s %s %zu %.1f %.0f\n", type, useArena ? "arena" : "heap", nelem,
+               (double)allocs / OPERATIONS, (double)(t1 - t0) / OPERATIONS);
+    }
+}
+};
+
+/***[ main code ]**************************************************************/
+
+using namespace bench_marshal;
+
+int main(int argc, char** argv)
+{
+    if (AllJoynInit() != ER_OK) {
+        return EXIT_FAILURE;
+    }
+
+    static const size_t sizes[] = { 4, 16, 64 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        Run<NestedStrings>("NestedStrings", sizes[i]);
+        Run<Type::DictionaryOfDictionary>("DictionaryOfDictionary", sizes[i]);
+        Run<Type::DictionaryOfStruct>("DictionaryOfStruct", sizes[i]);
+    }
+
+    AllJoynShutdown();
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <datadriven/Semaphore.h>
+
+#include "common/AsyncTaskQueue.h"
+
+using namespace std;
+using namespace datadriven;
+
+/**
+ * Task queue throughput.
+ *
+ * Producer threads enqueue small tasks on one AsyncTaskQueue and the time
+ * until its thread executed all of them is measured. Scenario "fifo" uses a
+ * plain queue, "lanes" spreads the tasks over four priority lanes and
+ * "bounded" limits the queue to a small capacity so producers block.
+ * Prints one line per scenario and number of producers:
+ *
+ *   queue_bench <scenario> <producers> <tasks/s> <ns/task>
+ */
+namespace bench_queue {
+#define TASKS 400000
+#define MAX_PRODUCERS 4
+#define LANES 4
+#define MAX_WAIT_MS 250
+#define CAPACITY 256
+
+static unsigned long long NowNanos()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+class Task :
+    public TaskData {
+  public:
+    Task(unsigned int value) :
+        value(value) { }
+
+    unsigned int value;
+};
+
+class Consumer :
+    public AsyncTask {
+  public:
+    Consumer() :
+        executed(0), sum(0) { }
+
+    void OnEmptyQueue() { }
+
+    void OnTask(TaskData const* taskdata)
+    {
+        sum += static_cast<const Task*>(taskdata)->value;
+        if (TASKS == ++executed) {
+            done.Post();
+        }
+    }
+
+    unsigned int executed;
+    unsigned long long sum;
+    Semaphore done;
+};
+
+static void Produce(AsyncTaskQueue* queue,
+                    unsigned int first,
+                    unsigned int count,
+                    unsigned int lanes)
+{
+    for (unsigned int i = first; i < first + count; i++) {
+        queue->Enqueue(new Task(i), i % lanes);
+    }
+}
+
+static void Run(const char* scenario,
+                unsigned int producers)
+{
+    Consumer consumer;
+    AsyncTaskQueue queue(&consumer, true);
+    unsigned int lanes = 1;
+
+    if (0 == strcmp(scenario, "lanes")) {
+        lanes = LANES;
+        queue.SetLanes(lanes, MAX_WAIT_MS);
+    } else if (0 == strcmp(scenario, "bounded")) {
+        queue.SetCapacity(CAPACITY, AsyncTaskQueue::OVERFLOW_BLOCK);
+    }
+    queue.Start();
+
+    std::vector<std::thread> threads;
+    unsigned int perProducer = TASKS / producers;
+    unsigned long long start = NowNanos();
+    for (unsigned int i = 0; i < producers; i++) {
+        threads.push_back(std::thread(Produce, &queue, i * perProducer, perProducer, lanes));
+    }
+    for (unsigned int i = 0; i < producers; i++) {
+        threads[i].join();
+    }
+    QStatus status = consumer.done.Wait();
+    unsigned long long elapsed = NowNanos() - start;
+    assert(ER_OK == status);
+    (void)status;
+    queue.Stop();
+
+    printf("queue_bench %s %u %.0f %.1f\n", scenario, producers,
+           (double)TASKS * 1e9 / elapsed, (double)elapsed / TASKS);
+    fflush(stdout);
+}
+};
+
+/***[ main code ]**************************************************************/
+
+using namespace bench_queue;
+
+int main(int argc, char** argv)
+{
+    static const char* scenarios[] = { "fifo", "lanes", "bounded" };
+
+    for (size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); s++) {
+        for (unsigned int producers = 1; producers <= MAX_PRODUCERS; producers *= 4) {
+            Run(scenarios[s], producers);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <datadriven/datadriven.h>
+#include <datadriven/Mutex.h>
+#include <datadriven/Semaphore.h>
+#include <datadriven/SharedMutex.h>
+#include <alljoyn/Init.h>
+
+#include "ReadScalingInterface.h"
+#include "ReadScalingProxy.h"
+
+using namespace std;
+using namespace gen::org_allseenalliance_test;
+
+/**
+ * Read-side lock scaling.
+ *
+ * Runs a read-only workload on a growing number of threads and prints the
+ * aggregate throughput, one line per scenario and thread count:
+ *
+ *   read_scaling <scenario> <threads> <Mops/s>
+ *
+ * Scenario "observer" looks up a discovered object through the Observer and
+ * checks whether it is alive, as done before every method call. Scenarios
+ * "recursive", "plain" and "shared" do a map lookup under a recursive Mutex,
+ * a non-recursive Mutex and a shared SharedMutex lock respectively.
+ */
+namespace bench_read_scaling {
+#define DURATION_MS 1000
+#define MAX_THREADS 8
+#define MAP_SIZE 64
+
+static unsigned long long NowNanos()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Run \a op on \a numThreads threads for DURATION_MS and print the
+ * aggregate number of operations per second.
+ */
+template <typename Op> void Run(const char* scenario,
+                                unsigned int numThreads,
+                                Op op)
+{
+    std::atomic<bool> stop(false);
+    std::atomic<unsigned long long> total(0);
+    std::vector<std::thread> threads;
+
+    unsigned long long start = NowNanos();
+    for (unsigned int i = 0; i < numThreads; i++) {
+        threads.push_back(std::thread([&stop, &total, op]() {
+                                          unsigned long long ops = 0;
+                                          while (!stop.load(std::memory_order_relaxed)) {
+                                              op();
+                                              ops++;
+                                          }
+                                          total += ops;
+                                      }));
+    }
+    usleep(DURATION_MS * 1000);
+    stop = true;
+    for (unsigned int i = 0; i < numThreads; i++) {
+        threads[i].join();
+    }
+    unsigned long long elapsed = NowNanos() - start;
+
+    printf("read_scaling %s %u %.2f\n", scenario, numThreads, (double)total / elapsed * 1000.0);
+    fflush(stdout);
+}
+
+/***[ provider code ]**********************************************************/
+
+class ReadScaling :
+    public datadriven::ProvidedObject,
+    public ReadScalingInterface {
+  public:
+    ReadScaling(shared_ptr<datadriven::ObjectAdvertiser> advertiser) :
+        datadriven::ProvidedObject(advertiser),
+        ReadScalingInterface(this)
+    {
+    }
+};
+
+static void be_provider(void)
+{
+    shared_ptr<datadriven::ObjectAdvertiser> advertiser = datadriven::ObjectAdvertiser::Create();
+    assert(nullptr != advertiser);
+
+    ReadScaling obj(advertiser);
+    obj.Counter = 0;
+    QStatus status = obj.UpdateAll();
+    assert(ER_OK == status);
+    (void)status;
+
+    while (true) {
+        sleep(1);
+    }
+}
+
+/***[ consumer code ]**********************************************************/
+
+static datadriven::Semaphore _sync;
+
+class UpdateListener :
+    public datadriven::Observer<ReadScalingProxy>::Listener {
+  public:
+    void OnUpdate(const std::shared_ptr<ReadScalingProxy>& proxy)
+    {
+        _sync.Post();
+    }
+};
+
+static void be_consumer(void)
+{
+    UpdateListener ul;
+    std::shared_ptr<datadriven::Observer<ReadScalingProxy> > observer =
+        datadriven::Observer<ReadScalingProxy>::Create(&ul);
+    assert(nullptr != observer);
+
+    // wait for object
+    _sync.Wait();
+    const datadriven::ObjectId objId = (*observer->begin())->GetObjectId();
+
+    std::map<int, int> map;
+    for (int i = 0; i < MAP_SIZE; i++) {
+        map[i] = i;
+    }
+    datadriven::Mutex recursive;
+    datadriven::Mutex plain(false);
+    datadriven::SharedMutex shared;
+
+    for (unsigned int n = 1; n <= MAX_THREADS; n *= 2) {
+        Run("observer", n, [&observer, &objId]() {
+                std::shared_ptr<ReadScalingProxy> proxy = observer->GetObject(objId);
+                assert(nullptr != proxy);
+                bool alive = proxy->IsAlive();
+                assert(alive);
+                (void)alive;
+            });
+        Run("recursive", n, [&map, &recursive]() {
+                recursive.Lock();
+                assert(map.find(MAP_SIZE / 2) != map.end());
+                recursive.Unlock();
+            });
+        Run("plain", n, [&map, &plain]() {
+                plain.Lock();
+                assert(map.find(MAP_SIZE / 2) != map.end());
+                plain.Unlock();
+            });
+        Run("shared", n, [&map, &shared]() {
+                shared.LockShared();
+                assert(map.find(MAP_SIZE / 2) != map.end());
+                shared.UnlockShared();
+            });
+    }
+}
+};
+
+/***[ main code ]**************************************************************/
+
+using namespace bench_read_scaling;
+
+int main(int argc, char** argv)
+{
+    if (AllJoynInit() != ER_OK) {
+        return EXIT_FAILURE;
+    }
+
+    // only play provider if first command-line argument starts with a 'p'
+    if (argc <= 1) {
+        printf("Usage: %s <consumer|provider>\n", argv[0]);
+        return 1;
+    }
+    if ('p' == *argv[1]) {
+        be_provider();
+    } else {
+        be_consumer();
+    }
+
+    AllJoynShutdown();
+
+    return 0;
+}
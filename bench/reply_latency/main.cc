@@ -0,0 +1,200 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <datadriven/datadriven.h>
+#include <datadriven/Semaphore.h>
+#include <alljoyn/Init.h>
+
+#include "ReplyLatencyInterface.h"
+#include "ReplyLatencyProxy.h"
+
+using namespace std;
+using namespace gen::org_allseenalliance_test;
+
+/**
+ * Method reply latency under observation load.
+ *
+ * The provider updates a property continuously while the consumer spends
+ * time on every update, so the consumer queue is always busy. The consumer
+ * then measures the time from calling Echo until its reply listener runs,
+ * for every reply dispatch policy, and prints one line per policy:
+ *
+ *   reply_latency <policy> <p50 us> <p99 us>
+ */
+namespace bench_reply_latency {
+#define CALLS 1000
+#define UPDATE_INTERVAL_US 500
+#define UPDATE_WORK_US 400
+
+static double NowMicros()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/***[ provider code ]**********************************************************/
+
+class ReplyLatency :
+    public datadriven::ProvidedObject,
+    public ReplyLatencyInterface {
+  public:
+    ReplyLatency(shared_ptr<datadriven::ObjectAdvertiser> advertiser) :
+        datadriven::ProvidedObject(advertiser),
+        ReplyLatencyInterface(this)
+    {
+    }
+
+  protected:
+    void Echo(int32_t i, std::shared_ptr<EchoReply> _reply)
+    {
+        _reply->Send(i);
+    }
+};
+
+static void be_provider(void)
+{
+    shared_ptr<datadriven::ObjectAdvertiser> advertiser = datadriven::ObjectAdvertiser::Create();
+    assert(nullptr != advertiser);
+
+    ReplyLatency obj(advertiser);
+    obj.Counter = 0;
+    QStatus status = obj.UpdateAll();
+    assert(ER_OK == status);
+    (void)status;
+
+    while (true) {
+        usleep(UPDATE_INTERVAL_US);
+        obj.Counter++;
+        obj.ReplyLatencyInterface::Update();
+    }
+}
+
+/***[ consumer code ]**********************************************************/
+
+static datadriven::Semaphore _sync;
+
+class UpdateListener :
+    public datadriven::Observer<ReplyLatencyProxy>::Listener {
+  public:
+    UpdateListener() :
+        seen(false) { }
+
+    void OnUpdate(const std::shared_ptr<ReplyLatencyProxy>& proxy)
+    {
+        if (!seen) {
+            seen = true;
+            _sync.Post();
+        }
+        /* stand-in for application work on each update */
+        double until = NowMicros() + UPDATE_WORK_US;
+        while (NowMicros() < until) {
+        }
+    }
+
+  private:
+    bool seen;
+};
+
+class EchoListener :
+    public datadriven::MethodReplyListener<ReplyLatencyProxy::EchoReply> {
+  public:
+    double sent;
+    std::vector<double> samples;
+
+    void OnReply(const ReplyLatencyProxy::EchoReply& reply)
+    {
+        assert(ER_OK == reply.GetStatus());
+        samples.push_back(NowMicros() - sent);
+        _sync.Post();
+    }
+};
+
+static void Measure(const ReplyLatencyProxy& proxy,
+                    datadriven::MethodInvocationBase::ReplyDispatch dispatch,
+                    const char* name)
+{
+    EchoListener listener;
+
+    for (int32_t i = 0; i < CALLS; i++) {
+        listener.sent = NowMicros();
+        std::shared_ptr<datadriven::MethodInvocation<ReplyLatencyProxy::EchoReply> > inv = proxy.Echo(i);
+        QStatus status = inv->SetListener(listener, dispatch);
+        assert(ER_OK == status);
+        (void)status;
+        _sync.Wait();
+    }
+
+    std::sort(listener.samples.begin(), listener.samples.end());
+    printf("reply_latency %s %.0f %.0f\n", name,
+           listener.samples[listener.samples.size() / 2],
+           listener.samples[listener.samples.size() * 99 / 100]);
+}
+
+static void be_consumer(void)
+{
+    UpdateListener ul;
+    std::shared_ptr<datadriven::Observer<ReplyLatencyProxy> > observer =
+        datadriven::Observer<ReplyLatencyProxy>::Create(&ul);
+    assert(nullptr != observer);
+
+    // wait for object
+    _sync.Wait();
+    std::shared_ptr<ReplyLatencyProxy> proxy = *observer->begin();
+    assert(nullptr != proxy);
+
+    Measure(*proxy, datadriven::MethodInvocationBase::DISPATCH_QUEUED, "queued");
+    Measure(*proxy, datadriven::MethodInvocationBase::DISPATCH_EXECUTOR, "executor");
+    Measure(*proxy, datadriven::MethodInvocationBase::DISPATCH_INLINE, "inline");
+}
+};
+
+/***[ main code ]**************************************************************/
+
+using namespace bench_reply_latency;
+
+int main(int argc, char** argv)
+{
+    if (AllJoynInit() != ER_OK) {
+        return EXIT_FAILURE;
+    }
+
+    // only play provider if first command-line argument starts with a 'p'
+    if (argc <= 1) {
+        printf("Usage: %s <consumer|provider>\n", argv[0]);
+        return 1;
+    }
+    if ('p' == *argv[1]) {
+        be_provider();
+    } else {
+        be_consumer();
+    }
+
+    AllJoynShutdown();
+
+    return 0;
+}
@@ -0,0 +1,191 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <vector>
+
+#include <datadriven/datadriven.h>
+#include <datadriven/Semaphore.h>
+#include <alljoyn/Init.h>
+
+#include "SignalBenchInterface.h"
+#include "SignalBenchProxy.h"
+
+using namespace std;
+using namespace gen::org_allseenalliance_test;
+
+/**
+ * Signal fan-out benchmark.
+ *
+ * The provider emits signals as fast as it can. The consumer adds 1, 4 and
+ * 16 listeners for the signal to one observer and measures how fast the
+ * signals are delivered to all of them. Prints one line per listener count:
+ *
+ *   signal_bench <listeners> <signals/s> <consumer cpu us/signal>
+ */
+namespace bench_signal {
+#define SIGNALS 20000
+#define BURST 100
+#define PAYLOAD_ELEMENTS 16
+
+static unsigned long long Nanos(clockid_t clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/***[ provider code ]**********************************************************/
+
+class SignalBench :
+    public datadriven::ProvidedObject,
+    public SignalBenchInterface {
+  public:
+    SignalBench(shared_ptr<datadriven::ObjectAdvertiser> advertiser) :
+        datadriven::ProvidedObject(advertiser),
+        SignalBenchInterface(this)
+    {
+    }
+};
+
+static void be_provider(void)
+{
+    shared_ptr<datadriven::ObjectAdvertiser> advertiser = datadriven::ObjectAdvertiser::Create();
+    assert(nullptr != advertiser);
+
+    SignalBench obj(advertiser);
+    QStatus status = obj.UpdateAll();
+    assert(ER_OK == status);
+    (void)status;
+
+    std::vector<qcc::String> payload(PAYLOAD_ELEMENTS, qcc::String("signal payload element"));
+    for (uint32_t seq = 0;; seq++) {
+        obj.Tick(seq, payload);
+        if (0 == (seq % BURST)) {
+            /* do not flood the router */
+            usleep(1000);
+        }
+    }
+}
+
+/***[ consumer code ]**********************************************************/
+
+static datadriven::Semaphore _sync;
+
+class ObjectListener :
+    public datadriven::Observer<SignalBenchProxy>::Listener {
+  public:
+    void OnAdd(const std::shared_ptr<SignalBenchProxy>& proxy)
+    {
+        _sync.Post();
+    }
+};
+
+class TickListener :
+    public datadriven::SignalListener<SignalBenchProxy, SignalBenchProxy::Tick> {
+  public:
+    TickListener() :
+        received(0), target(0) { }
+
+    void OnSignal(const SignalBenchProxy::Tick& signal)
+    {
+        if (++received == target) {
+            _sync.Post();
+        }
+    }
+
+    std::atomic<unsigned long> received;
+    unsigned long target;
+};
+
+static void Run(datadriven::Observer<SignalBenchProxy>& observer,
+                size_t numListeners)
+{
+    std::vector<TickListener> listeners(numListeners);
+
+    /* the last listener added counts for all, the others get the same signals and more */
+    listeners[numListeners - 1].target = SIGNALS;
+    for (size_t i = 0; i < numListeners; i++) {
+        QStatus status = observer.AddSignalListener(listeners[i]);
+        assert(ER_OK == status);
+        (void)status;
+    }
+
+    unsigned long long cpu = Nanos(CLOCK_PROCESS_CPUTIME_ID);
+    unsigned long long wall = Nanos(CLOCK_MONOTONIC);
+    _sync.Wait();
+    cpu = Nanos(CLOCK_PROCESS_CPUTIME_ID) - cpu;
+    wall = Nanos(CLOCK_MONOTONIC) - wall;
+
+    for (size_t i = 0; i < numListeners; i++) {
+        observer.RemoveSignalListener(listeners[i]);
+    }
+    for (size_t i = 0; i < numListeners; i++) {
+        assert(listeners[i].received >= SIGNALS);
+    }
+    printf("signal_bench %zu %.0f %.2f\n", numListeners,
+           SIGNALS / (wall / 1e9), cpu / 1000.0 / SIGNALS);
+}
+
+static void be_consumer(void)
+{
+    ObjectListener ol;
+    std::shared_ptr<datadriven::Observer<SignalBenchProxy> > observer =
+        datadriven::Observer<SignalBenchProxy>::Create(&ol);
+    assert(nullptr != observer);
+
+    // wait for object
+    _sync.Wait();
+
+    static const size_t counts[] = { 1, 4, 16 };
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        Run(*observer, counts[i]);
+    }
+}
+};
+
+/***[ main code ]**************************************************************/
+
+using namespace bench_signal;
+
+int main(int argc, char** argv)
+{
+    if (AllJoynInit() != ER_OK) {
+        return EXIT_FAILURE;
+    }
+
+    // only play provider if first command-line argument starts with a 'p'
+    if (argc <= 1) {
+        printf("Usage: %s <consumer|provider>\n", argv[0]);
+        return 1;
+    }
+    if ('p' == *argv[1]) {
+        be_provider();
+    } else {
+        be_consumer();
+    }
+
+    AllJoynShutdown();
+
+    return 0;
+}
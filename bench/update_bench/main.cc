@@ -0,0 +1,136 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <vector>
+
+#include <datadriven/datadriven.h>
+#include <alljoyn/Init.h>
+
+#include "UpdateBenchInterface.h"
+
+using namespace std;
+using namespace gen::org_allseenalliance_test;
+
+/**
+ * Property update benchmark.
+ *
+ * Exposes an object with many large cacheable properties and measures the
+ * cost of ProvidedInterface::Update when no, one or all properties changed.
+ * Prints one line per scenario:
+ *
+ *   update_bench <scenario> <elements/property> <cpu us/update> <wall us/update>
+ */
+namespace bench_update {
+#define UPDATES 200
+#define NUM_PROPERTIES 16
+
+static unsigned long long Nanos(clockid_t clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+class UpdateBench :
+    public datadriven::ProvidedObject,
+    public UpdateBenchInterface {
+  public:
+    UpdateBench(shared_ptr<datadriven::ObjectAdvertiser> advertiser) :
+        datadriven::ProvidedObject(advertiser),
+        UpdateBenchInterface(this)
+    {
+    }
+
+    std::vector<qcc::String>& Prop(int i)
+    {
+        std::vector<qcc::String>* props[NUM_PROPERTIES] = {
+            &Prop0, &Prop1, &Prop2, &Prop3, &Prop4, &Prop5, &Prop6, &Prop7,
+            &Prop8, &Prop9, &Prop10, &Prop11, &Prop12, &Prop13, &Prop14, &Prop15
+        };
+        return *props[i];
+    }
+
+    void Init(size_t nelem)
+    {
+        for (int i = 0; i < NUM_PROPERTIES; i++) {
+            Prop(i).assign(nelem, qcc::String("a fairly long string property element"));
+        }
+    }
+
+    void Touch(int i, int round)
+    {
+        Prop(i)[0] = (round & 1) ? "odd" : "even";
+    }
+};
+
+static void Run(UpdateBench& obj, const char* scenario, int touched, size_t nelem)
+{
+    unsigned long long cpu = Nanos(CLOCK_PROCESS_CPUTIME_ID);
+    unsigned long long wall = Nanos(CLOCK_MONOTONIC);
+
+    for (int round = 0; round < UPDATES; round++) {
+        for (int i = 0; i < touched; i++) {
+            obj.Touch(i, round);
+        }
+        QStatus status = obj.Update();
+        assert(ER_OK == status);
+        (void)status;
+    }
+
+    cpu = Nanos(CLOCK_PROCESS_CPUTIME_ID) - cpu;
+    wall = Nanos(CLOCK_MONOTONIC) - wall;
+    printf("update_bench %s %zu %.1f %.1f\n", scenario, nelem,
+           cpu / 1000.0 / UPDATES, wall / 1000.0 / UPDATES);
+}
+};
+
+/***[ main code ]**************************************************************/
+
+using namespace bench_update;
+
+int main(int argc, char** argv)
+{
+    if (AllJoynInit() != ER_OK) {
+        return EXIT_FAILURE;
+    }
+    {
+        shared_ptr<datadriven::ObjectAdvertiser> advertiser = datadriven::ObjectAdvertiser::Create();
+        assert(nullptr != advertiser);
+
+        static const size_t sizes[] = { 16, 256, 4096 };
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            UpdateBench obj(advertiser);
+            obj.Init(sizes[i]);
+            if (ER_OK != obj.UpdateAll()) {
+                return EXIT_FAILURE;
+            }
+
+            Run(obj, "unchanged", 0, sizes[i]);
+            Run(obj, "one", 1, sizes[i]);
+            Run(obj, "all", NUM_PROPERTIES, sizes[i]);
+        }
+    }
+
+    AllJoynShutdown();
+
+    return 0;
+}
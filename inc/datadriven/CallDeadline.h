@@ -0,0 +1,176 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef DATADRIVEN_CALLDEADLINE_H_
+#define DATADRIVEN_CALLDEADLINE_H_
+
+#include <stdint.h>
+
+namespace datadriven {
+/**
+ * \class CallDeadline
+ * \brief Absolute deadline, hedging and failover policy for method calls on
+ *        generated proxies.
+ *
+ * While a CallDeadline::Scope is active on the current thread, method calls
+ * on generated proxies are bounded by the deadline instead of by their
+ * fixed timeout alone:
+ *
+ *  - a call made after the deadline passed fails with ER_TIMEOUT without
+ *    being sent, and the reply timeout of a call is never longer than the
+ *    time left until the deadline;
+ *  - if a hedge delay is set and no reply arrived after that delay, the same
+ *    call is sent again to the same object, and the first reply wins;
+ *  - if failover is enabled and the object is gone (or the call fails
+ *    because the connection to it is lost), the call is sent again as soon
+ *    as the object is alive again, as long as the deadline did not pass.
+ *
+ * The total number of times a single call is sent, hedges and failovers
+ * included, is bounded by the retry budget (SetMaxAttempts). Calls are
+ * only sent more than once if they are safe to repeat, so do not enable
+ * hedging for methods that are not idempotent.
+ *
+ * \code
+ * datadriven::CallDeadline deadline(200);     // 200 ms from now
+ * deadline.SetHedgeDelay(50);
+ * {
+ *     datadriven::CallDeadline::Scope scope(deadline);
+ *     inv = proxy->Bar(42);
+ * }
+ * FooProxy::BarReply reply = inv->GetReply(); // no later than the deadline
+ * \endcode
+ *
+ * Scopes nest, and a nested deadline never extends the enclosing one. Fire
+ * and forget (NoReply) calls and calls queued on a MethodBatch only have
+ * their timeout bounded, they are neither hedged nor failed over.
+ */
+class CallDeadline {
+  public:
+    class Scope;
+
+    /**
+     * Construct a deadline \a timeout milliseconds from now, without hedging
+     * and with failover enabled.
+     *
+     * \param[in] timeout time in ms until the deadline
+     */
+    CallDeadline(uint32_t timeout);
+
+    /**
+     * Send a call again if it was not answered after \a delay milliseconds.
+     *
+     * \param[in] delay hedge delay in ms, 0 (the default) disables hedging
+     * \return this deadline
+     */
+    CallDeadline& SetHedgeDelay(uint32_t delay);
+
+    /**
+     * Enable or disable sending a call again when its object comes back.
+     *
+     * \param[in] enable whether failover is enabled (the default)
+     * \return this deadline
+     */
+    CallDeadline& SetFailover(bool enable);
+
+    /**
+     * Limit the number of times a single call is sent.
+     *
+     * \param[in] attempts maximum number of sends, at least 1 (default 3)
+     * \return this deadline
+     */
+    CallDeadline& SetMaxAttempts(unsigned int attempts);
+
+    /**
+     * Time left until the deadline.
+     *
+     * \return the remaining time in ms, 0 once the deadline passed
+     */
+    uint32_t GetRemaining() const;
+
+    /**
+     * Check whether the deadline passed.
+     */
+    bool IsExpired() const;
+
+    /** \private
+     * The deadline as a monotonic time stamp, see Now()
+     */
+    uint64_t GetDeadline() const;
+
+    /** \private
+     * Hedge delay in ms, 0 if hedging is disabled
+     */
+    uint32_t GetHedgeDelay() const;
+
+    /** \private
+     * Whether failover is enabled
+     */
+    bool GetFailover() const;
+
+    /** \private
+     * Maximum number of sends of a single call
+     */
+    unsigned int GetMaxAttempts() const;
+
+    /** \private
+     * Monotonic time stamp in ms, the time base of deadlines.
+     */
+    static uint64_t Now();
+
+    /** \private
+     * Get the deadline that is active on the current thread.
+     *
+     * \return the active deadline or NULL if there is none
+     */
+    static const CallDeadline* GetCurrent();
+
+  private:
+    uint64_t deadline;
+    uint32_t hedgeDelay;
+    unsigned int maxAttempts;
+    bool failover;
+};
+
+/**
+ * \class CallDeadline::Scope
+ * \brief Applies a deadline to the method calls made on the current
+ *        thread.
+ */
+class CallDeadline::Scope {
+  public:
+    /**
+     * Make \a deadline, bounded by the enclosing one if any, the active
+     * deadline on the current thread.
+     *
+     * \param[in] deadline the deadline to apply
+     */
+    Scope(const CallDeadline& deadline);
+
+    /**
+     * Restore the previously active deadline.
+     */
+    ~Scope();
+
+  private:
+    CallDeadline effective;
+    const CallDeadline* previous;
+
+    Scope(const Scope&);
+    void operator=(const Scope&);
+};
+} /* namespace datadriven */
+
+#endif /* DATADRIVEN_CALLDEADLINE_H_ */
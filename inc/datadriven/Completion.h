@@ -0,0 +1,75 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+
+#ifndef DATADRIVEN_COMPLETION_H_
+#define DATADRIVEN_COMPLETION_H_
+
+#include <atomic>
+#include <stdint.h>
+
+namespace datadriven {
+/**
+ * \class Completion
+ * \brief One-shot event that can be waited for.
+ *
+ * A Completion starts out pending and becomes signaled exactly once. Its
+ * whole state is a single atomic word, so signaling and polling it never
+ * take a lock. Only a thread that actually has to block in Wait() parks in
+ * the kernel (a futex on Linux, a shared pool of condition variables on
+ * other platforms), and Signal() only makes a system call if such a thread
+ * may exist.
+ */
+class Completion {
+  public:
+    /**
+     * Construct a pending completion.
+     */
+    Completion();
+
+    /**
+     * Mark the completion as signaled and wake up all threads waiting for
+     * it. Signaling an already signaled completion has no effect.
+     */
+    void Signal();
+
+    /**
+     * Check whether the completion was signaled, without blocking.
+     */
+    bool IsSignaled() const;
+
+    /**
+     * Block the calling thread until the completion is signaled.
+     */
+    void Wait();
+
+  private:
+    /** Pending, nobody is waiting */
+    static const uint32_t PENDING = 0;
+    /** Signaled */
+    static const uint32_t SIGNALED = 1;
+    /** Pending, at least one thread is (about to start) waiting */
+    static const uint32_t CONTENDED = 2;
+
+    std::atomic<uint32_t> word;
+
+    // prevent copy by construction or assignment
+    Completion(const Completion& other);
+    Completion& operator=(const Completion& other);
+};
+} /* namespace datadriven */
+
+#endif /* DATADRIVEN_COMPLETION_H_ */
@@ -0,0 +1,201 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef DATADRIVEN_FLATMAP_H_
+#define DATADRIVEN_FLATMAP_H_
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace datadriven {
+/**
+ * \class FlatMap
+ * \brief Associative container backed by a sorted vector.
+ *
+ * FlatMap offers the subset of the std::map interface used by generated
+ * dictionary types, but keeps its elements in one contiguous, key-ordered
+ * array. Lookups are binary searches, iteration is a linear walk and bulk
+ * construction (as done when unmarshalling) costs a single allocation.
+ *
+ * The code generator emits dictionaries as FlatMap when the build is
+ * configured with DICT_TYPE=flat. Like the std::map based dictionaries the
+ * key type may be const qualified (FlatMap<const K, V>).
+ *
+ * Code written against the std::map based dictionaries keeps working as long
+ * as it does not rely on what a vector cannot offer:
+ *  - inserting or erasing an element invalidates all iterators and
+ *    references into the map, not just those to the erased element;
+ *  - the key of an element is not const, but must not be modified through
+ *    an iterator as that breaks the ordering;
+ *  - single element insertion is linear in the size of the map. Prefer
+ *    building a vector of elements and handing it over with Assign().
+ */
+template <typename K, typename V> class FlatMap {
+  public:
+    typedef typename std::remove_const<K>::type key_type;
+    typedef V mapped_type;
+    typedef std::pair<key_type, V> value_type;
+    typedef std::vector<value_type> container_type;
+    typedef typename container_type::size_type size_type;
+    typedef typename container_type::iterator iterator;
+    typedef typename container_type::const_iterator const_iterator;
+
+    FlatMap() { }
+
+    iterator begin() { return elements.begin(); }
+    iterator end() { return elements.end(); }
+    const_iterator begin() const { return elements.begin(); }
+    const_iterator end() const { return elements.end(); }
+
+    size_type size() const { return elements.size(); }
+    bool empty() const { return elements.empty(); }
+    void clear() { elements.clear(); }
+    void reserve(size_type n) { elements.reserve(n); }
+    void swap(FlatMap& other) { elements.swap(other.elements); }
+
+    iterator lower_bound(const key_type& key)
+    {
+        return std::lower_bound(elements.begin(), elements.end(), key, KeyLess());
+    }
+
+    const_iterator lower_bound(const key_type& key) const
+    {
+        return std::lower_bound(elements.begin(), elements.end(), key, KeyLess());
+    }
+
+    iterator find(const key_type& key)
+    {
+        iterator it = lower_bound(key);
+        return (it != elements.end() && !(key < it->first)) ? it : elements.end();
+    }
+
+    const_iterator find(const key_type& key) const
+    {
+        const_iterator it = lower_bound(key);
+        return (it != elements.end() && !(key < it->first)) ? it : elements.end();
+    }
+
+    size_type count(const key_type& key) const
+    {
+        return (find(key) != elements.end()) ? 1 : 0;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        iterator it = lower_bound(value.first);
+        if (it != elements.end() && !(value.first < it->first)) {
+            return std::make_pair(it, false);
+        }
+        return std::make_pair(elements.insert(it, value), true);
+    }
+
+    V& operator[](const key_type& key)
+    {
+        return insert(value_type(key, V())).first->second;
+    }
+
+    size_type erase(const key_type& key)
+    {
+        iterator it = find(key);
+        if (it == elements.end()) {
+            return 0;
+        }
+        elements.erase(it);
+        return 1;
+    }
+
+    iterator erase(iterator it)
+    {
+        return elements.erase(it);
+    }
+
+    /**
+     * Replaces the content of the map by the given elements.
+     *
+     * The elements are taken over without copying (\a unsorted is left
+     * empty). They do not have to be sorted; when the same key occurs more
+     * than once the last occurrence wins, which matches repeated
+     * std::map::operator[] assignments. Input that is already in key order,
+     * as produced by a peer marshalling a std::map or FlatMap, is detected
+     * in a single pass and not sorted again.
+     *
+     * \param[in,out] unsorted the new elements of the map
+     */
+    void Assign(container_type& unsorted)
+    {
+        elements.swap(unsorted);
+        unsorted.clear();
+        if (IsStrictlySorted()) {
+            return;
+        }
+        std::stable_sort(elements.begin(), elements.end(), ValueLess());
+        // keep the last occurrence of every key
+        iterator out = elements.begin();
+        for (iterator it = elements.begin(); it != elements.end(); ++it) {
+            iterator next = it + 1;
+            if (next != elements.end() && !(it->first < next->first)) {
+                continue;
+            }
+            if (out != it) {
+                *out = *it;
+            }
+            ++out;
+        }
+        elements.erase(out, elements.end());
+    }
+
+    bool operator==(const FlatMap& other) const
+    {
+        return elements == other.elements;
+    }
+
+    bool operator!=(const FlatMap& other) const
+    {
+        return elements != other.elements;
+    }
+
+  private:
+    struct KeyLess {
+        bool operator()(const value_type& value, const key_type& key) const
+        {
+            return value.first < key;
+        }
+    };
+
+    struct ValueLess {
+        bool operator()(const value_type& a, const value_type& b) const
+        {
+            return a.first < b.first;
+        }
+    };
+
+    bool IsStrictlySorted() const
+    {
+        for (size_type i = 1; i < elements.size(); ++i) {
+            if (!(elements[i - 1].first < elements[i].first)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    container_type elements;
+};
+}
+
+#endif /* DATADRIVEN_FLATMAP_H_ */
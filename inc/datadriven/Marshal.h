@@ -26,6 +26,8 @@
 #include <alljoyn/MsgArg.h>
 #include <alljoyn/Status.h>
 
+#include <datadriven/FlatMap.h>
+#include <datadriven/MarshalArena.h>
 #include <datadriven/ObjectPath.h>
 #include <datadriven/Signature.h>
 
@@ -36,6 +38,38 @@ namespace datadriven {
  */
 const ajn::MsgArg& MsgArgDereference(const ajn::MsgArg& msgarg);
 
+/**
+ * Allocates \a numArgs MsgArgs to be handed to MarshalArray or
+ * MarshalStruct. They come from the MarshalArena that is active on the
+ * current thread, or from the heap if there is none.
+ */
+ajn::MsgArg* NewMsgArgs(size_t numArgs);
+
+/**
+ * Releases MsgArgs obtained from NewMsgArgs that were not handed over.
+ */
+void DeleteMsgArgs(ajn::MsgArg* args);
+
+/**
+ * Allocates a single MsgArg to be handed to MarshalDictEntry.
+ */
+ajn::MsgArg* NewMsgArg();
+
+/**
+ * Releases a MsgArg obtained from NewMsgArg that was not handed over.
+ */
+void DeleteMsgArg(ajn::MsgArg* arg);
+
+/** \private unique_ptr deleter for NewMsgArgs */
+struct MsgArgsDeleter {
+    void operator()(ajn::MsgArg* args) const { DeleteMsgArgs(args); }
+};
+
+/** \private unique_ptr deleter for NewMsgArg */
+struct MsgArgDeleter {
+    void operator()(ajn::MsgArg* arg) const { DeleteMsgArg(arg); }
+};
+
 QStatus MarshalArray(ajn::MsgArg& msgarg,
                      ajn::MsgArg* elements,
                      size_t numElements);
@@ -90,16 +124,19 @@ QStatus Marshal(ajn::MsgArg& msgarg,
 template <typename K, typename V> QStatus Marshal(ajn::MsgArg& msgarg,
                                                   const std::map<const K, V>& data);
 
+template <typename K, typename V> QStatus Marshal(ajn::MsgArg& msgarg,
+                                                  const FlatMap<K, V>& data);
+
 template <typename T> QStatus Marshal(ajn::MsgArg& msgarg, const std::vector<T>& data)
 {
     QStatus status = ER_OK;
     size_t numElements = data.size();
-    std::unique_ptr<ajn::MsgArg[]> elements;
+    std::unique_ptr<ajn::MsgArg[], MsgArgsDeleter> elements;
 
     if (numElements > 0) {
         size_t i = 0;
 
-        elements = std::unique_ptr<ajn::MsgArg[]>(new ajn::MsgArg[numElements]);
+        elements.reset(NewMsgArgs(numElements));
         for (typename std::vector<T>::const_iterator it = data.begin(); it != data.end(); ++it) {
             if (ER_OK != (status = Marshal(elements[i++], *it))) {
                 break;
@@ -107,7 +144,7 @@ template <typename T> QStatus Marshal(ajn::MsgArg& msgarg, const std::vector<T>&
         }
     } else {
         // determine signature of element
-        elements = std::unique_ptr<ajn::MsgArg[]>(new ajn::MsgArg[1]);
+        elements.reset(NewMsgArgs(1));
         status = Marshal(elements[0], T());
     }
     if (ER_OK == status) {
@@ -116,24 +153,30 @@ template <typename T> QStatus Marshal(ajn::MsgArg& msgarg, const std::vector<T>&
     return status;
 }
 
-template <typename K, typename V> QStatus Marshal(ajn::MsgArg& msgarg, const std::map<const K, V>& data)
+/**
+ * Marshals the dictionary entries in [\a begin, \a end) as an array of
+ * dictionary entries. Shared by all dictionary containers.
+ */
+template <typename K, typename V, typename It> QStatus MarshalDictionary(ajn::MsgArg& msgarg,
+                                                                         It begin,
+                                                                         It end,
+                                                                         size_t numElements)
 {
     QStatus status = ER_OK;
-    size_t numElements = data.size();
-    std::unique_ptr<ajn::MsgArg[]> elements;
-    std::unique_ptr<ajn::MsgArg> key;
-    std::unique_ptr<ajn::MsgArg> val;
+    std::unique_ptr<ajn::MsgArg[], MsgArgsDeleter> elements;
+    std::unique_ptr<ajn::MsgArg, MsgArgDeleter> key;
+    std::unique_ptr<ajn::MsgArg, MsgArgDeleter> val;
 
     if (numElements > 0) {
         size_t i = 0;
 
-        elements = std::unique_ptr<ajn::MsgArg[]>(new ajn::MsgArg[numElements]);
-        for (typename std::map<K, V>::const_iterator it = data.begin(); it != data.end(); ++it) {
-            key = std::unique_ptr<ajn::MsgArg>(new ajn::MsgArg);
+        elements.reset(NewMsgArgs(numElements));
+        for (It it = begin; it != end; ++it) {
+            key.reset(NewMsgArg());
             if (ER_OK != (status = Marshal(*key, it->first))) {
                 break;
             }
-            val = std::unique_ptr<ajn::MsgArg>(new ajn::MsgArg);
+            val.reset(NewMsgArg());
             if (ER_OK != (status = Marshal(*val, it->second))) {
                 break;
             }
@@ -145,12 +188,12 @@ template <typename K, typename V> QStatus Marshal(ajn::MsgArg& msgarg, const std
     } else {
         // determine signature of dictionary
         do {
-            elements = std::unique_ptr<ajn::MsgArg[]>(new ajn::MsgArg[1]);
-            key = std::unique_ptr<ajn::MsgArg>(new ajn::MsgArg);
+            elements.reset(NewMsgArgs(1));
+            key.reset(NewMsgArg());
             if (ER_OK != (status = Marshal(*key, K()))) {
                 break;
             }
-            val = std::unique_ptr<ajn::MsgArg>(new ajn::MsgArg);
+            val.reset(NewMsgArg());
             if (ER_OK != (status = Marshal(*val, V()))) {
                 break;
             }
@@ -165,6 +208,17 @@ template <typename K, typename V> QStatus Marshal(ajn::MsgArg& msgarg, const std
     return status;
 }
 
+template <typename K, typename V> QStatus Marshal(ajn::MsgArg& msgarg, const std::map<const K, V>& data)
+{
+    return MarshalDictionary<K, V>(msgarg, data.begin(), data.end(), data.size());
+}
+
+template <typename K, typename V> QStatus Marshal(ajn::MsgArg& msgarg, const FlatMap<K, V>& data)
+{
+    typedef typename FlatMap<K, V>::key_type key_type;
+    return MarshalDictionary<key_type, V>(msgarg, data.begin(), data.end(), data.size());
+}
+
 QStatus Unmarshal(bool& data,
                   const ajn::MsgArg& msgarg);
 
@@ -207,6 +261,9 @@ QStatus Unmarshal(ajn::MsgArg& data,
 template <typename K, typename V> QStatus Unmarshal(std::map<const K, V>& data,
                                                     const ajn::MsgArg& msgarg);
 
+template <typename K, typename V> QStatus Unmarshal(FlatMap<K, V>& data,
+                                                    const ajn::MsgArg& msgarg);
+
 template <typename T> QStatus Unmarshal(std::vector<T>& data, const ajn::MsgArg& msgarg)
 {
     QStatus status = ER_FAIL;
@@ -250,17 +307,20 @@ template <typename K, typename V> QStatus Unmarshal(std::map<const K, V>& data,
         if (numElements > 0) {
             const ajn::MsgArg* elements = m.v_array.GetElements();
             std::map<const K, V> tmp;
+            typename std::map<const K, V>::iterator it;
 
             for (size_t i = 0; i < numElements; ++i) {
                 K k;
                 if (ER_OK != (status = Unmarshal(k, *elements[i].v_dictEntry.key))) {
                     break;
                 }
-                V v;
-                if (ER_OK != (status = Unmarshal(v, *elements[i].v_dictEntry.val))) {
+                // peers marshal dictionaries in key order, so hinting at the
+                // end makes every insertion amortized constant time; the value
+                // is unmarshalled in place (a duplicate key is overwritten)
+                it = tmp.insert(tmp.end(), typename std::map<const K, V>::value_type(k, V()));
+                if (ER_OK != (status = Unmarshal(it->second, *elements[i].v_dictEntry.val))) {
                     break;
                 }
-                tmp[k] = v;
             }
             if (ER_OK == status) {
                 data.swap(tmp);
@@ -272,6 +332,38 @@ template <typename K, typename V> QStatus Unmarshal(std::map<const K, V>& data,
     return status;
 }
 
+template <typename K, typename V> QStatus Unmarshal(FlatMap<K, V>& data, const ajn::MsgArg& msgarg)
+{
+    QStatus status = ER_FAIL;
+    const ajn::MsgArg& m = MsgArgDereference(msgarg);
+
+    if (ajn::ALLJOYN_ARRAY == m.typeId) {
+        size_t numElements = m.v_array.GetNumElements();
+        data.clear();
+
+        if (numElements > 0) {
+            const ajn::MsgArg* elements = m.v_array.GetElements();
+            typename FlatMap<K, V>::container_type tmp;
+
+            tmp.resize(numElements);
+            for (size_t i = 0; i < numElements; ++i) {
+                if (ER_OK != (status = Unmarshal(tmp[i].first, *elements[i].v_dictEntry.key))) {
+                    break;
+                }
+                if (ER_OK != (status = Unmarshal(tmp[i].second, *elements[i].v_dictEntry.val))) {
+                    break;
+                }
+            }
+            if (ER_OK == status) {
+                data.Assign(tmp);
+            }
+        } else {
+            status = ER_OK;
+        }
+    }
+    return status;
+}
+
 template <> QStatus Unmarshal<bool>(std::vector<bool>& data,
                                     const ajn::MsgArg& msgarg);
 
@@ -0,0 +1,172 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef DATADRIVEN_MARSHALARENA_H_
+#define DATADRIVEN_MARSHALARENA_H_
+
+#include <stddef.h>
+#include <utility>
+#include <vector>
+
+#include <alljoyn/MsgArg.h>
+
+namespace datadriven {
+/**
+ * \class MarshalArena
+ * \brief Bump allocator for the temporary MsgArgs of a single operation.
+ *
+ * Marshalling nested types (arrays, structs and dictionaries) allocates a
+ * MsgArg, or an array of them, for every level and every dictionary key and
+ * value. While a MarshalArena is active on the current thread (see Scope),
+ * these MsgArgs and the string data they refer to are carved from the arena
+ * instead of the heap, and released all at once by Reset().
+ *
+ * MsgArgs marshalled inside a scope refer to arena memory, so they must not
+ * be used after the arena is reset or destroyed. Typical use is around a
+ * generated signal emission, method call or method reply, which serialize
+ * their arguments before returning:
+ *
+ * \code
+ * datadriven::MarshalArena arena;
+ * for (...) {
+ *     {
+ *         datadriven::MarshalArena::Scope scope(arena);
+ *         obj.MySignal(bigNestedValue);
+ *     }
+ *     arena.Reset();
+ * }
+ * \endcode
+ *
+ * Property values cached by ProvidedInterface outlive any single operation
+ * and are therefore always marshalled on the heap, even inside a scope.
+ *
+ * A MarshalArena is not thread-safe; it can be active on one thread at a time.
+ */
+class MarshalArena {
+  public:
+    /**
+     * \class Scope
+     * \brief Makes an arena the active one for the current thread.
+     *
+     * Scopes nest: the previously active arena is restored when the scope
+     * ends. A scope constructed with NULL suspends arena allocation.
+     */
+    class Scope {
+      public:
+        /**
+         * Activate \a arena on the current thread.
+         *
+         * \param[in] arena the arena to use, or NULL for heap allocation
+         */
+        Scope(MarshalArena* arena);
+
+        /**
+         * Activate \a arena on the current thread.
+         *
+         * \param[in] arena the arena to use
+         */
+        Scope(MarshalArena& arena);
+
+        /**
+         * Restore the previously active arena.
+         */
+        ~Scope();
+
+      private:
+        MarshalArena* previous;
+
+        Scope(const Scope&);
+        void operator=(const Scope&);
+    };
+
+    /**
+     * Construct an arena.
+     *
+     * \param[in] chunkSize size in bytes of the first memory chunk, later
+     *                      chunks grow geometrically
+     */
+    MarshalArena(size_t chunkSize = 4096);
+
+    /**
+     * Destruct the arena and all MsgArgs allocated from it.
+     */
+    ~MarshalArena();
+
+    /**
+     * Allocate and default construct \a numArgs MsgArgs.
+     *
+     * \param[in] numArgs number of MsgArgs (> 0)
+     * \return pointer to the first MsgArg
+     */
+    ajn::MsgArg* NewArgs(size_t numArgs);
+
+    /**
+     * Copy \a len bytes of \a str into the arena and NUL terminate the copy.
+     *
+     * \param[in] str string to copy (may be NULL if \a len is 0)
+     * \param[in] len length of the string
+     * \return the copy
+     */
+    const char* CopyString(const char* str,
+                           size_t len);
+
+    /**
+     * Check whether \a ptr points into memory handed out by this arena.
+     */
+    bool Owns(const void* ptr) const;
+
+    /**
+     * Destruct all MsgArgs allocated from the arena and make its memory
+     * available again. Only the largest chunk is kept, so a recurring
+     * operation settles on a single chunk.
+     */
+    void Reset();
+
+    /**
+     * Number of heap allocations performed by the arena itself since
+     * construction, for diagnostics and benchmarks.
+     */
+    size_t GetHeapAllocations() const;
+
+    /**
+     * Get the arena that is active on the current thread.
+     *
+     * \return the active arena or NULL if MsgArgs are heap allocated
+     */
+    static MarshalArena* GetCurrent();
+
+  private:
+    struct Chunk {
+        char* data;
+        size_t size;
+    };
+
+    void* Allocate(size_t size);
+
+    void AddChunk(size_t minSize);
+
+    std::vector<Chunk> chunks;
+    /** MsgArg blocks to destruct on Reset */
+    std::vector<std::pair<ajn::MsgArg*, size_t> > args;
+    size_t used;
+    size_t heapAllocations;
+
+    MarshalArena(const MarshalArena&);
+    void operator=(const MarshalArena&);
+};
+}
+
+#endif /* DATADRIVEN_MARSHALARENA_H_ */
@@ -0,0 +1,152 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+
+#ifndef DATADRIVEN_METHODBATCH_H_
+#define DATADRIVEN_METHODBATCH_H_
+
+#include <stddef.h>
+#include <memory>
+
+#include <datadriven/MethodInvocationBase.h>
+
+namespace datadriven {
+class MethodBatchState;
+
+/**
+ * \class MethodBatchListener
+ * \brief Receives a single notification when all calls of a MethodBatch
+ *        completed.
+ */
+class MethodBatchListener {
+  public:
+    virtual ~MethodBatchListener() { }
+
+    /**
+     * Called once all method invocations of the batch are complete (replied,
+     * timed out, failed or cancelled). The outcome of the individual calls is
+     * available from their MethodInvocation objects.
+     */
+    virtual void OnBatchComplete() = 0;
+};
+
+/**
+ * \class MethodBatch
+ * \brief Collects method calls on generated proxies and sends them as one
+ *        pipelined batch.
+ *
+ * While a MethodBatch::Scope is active on the current thread, method calls
+ * on generated proxies are queued on the batch instead of being sent. They
+ * still return their MethodInvocation, which completes as usual once the
+ * call was sent and answered. Send() then issues the queued calls, keeping
+ * at most \a window of them in flight at any time:
+ *
+ * \code
+ * datadriven::MethodBatch batch(64);
+ * std::vector<std::shared_ptr<datadriven::MethodInvocation<FooProxy::BarReply> > > replies;
+ * {
+ *     datadriven::MethodBatch::Scope scope(batch);
+ *     for (auto& proxy : proxies) {
+ *         replies.push_back(proxy->Bar(42));
+ *     }
+ * }
+ * batch.Send();
+ * batch.Wait();
+ * \endcode
+ *
+ * Calls on proxies of dead objects fail immediately and are not part of the
+ * batch. Cancelled invocations that were not sent yet are not sent at all.
+ *
+ * A CallDeadline::Scope active while a call is queued only bounds the
+ * timeout of that call. Batched calls are sent once, they are neither
+ * hedged, failed over nor retried as the deadline specifies.
+ */
+class MethodBatch {
+  public:
+    /**
+     * \class Scope
+     * \brief Queues method calls made on the current thread on a batch.
+     *
+     * Scopes nest: the previously active batch is restored when the scope
+     * ends. Calls made while the batch is already sent are sent immediately.
+     */
+    class Scope {
+      public:
+        /**
+         * Make \a batch the active batch on the current thread.
+         *
+         * \param[in] batch the batch to queue calls on
+         */
+        Scope(MethodBatch& batch);
+
+        /**
+         * Restore the previously active batch.
+         */
+        ~Scope();
+
+      private:
+        MethodBatchState* previous;
+
+        Scope(const Scope&);
+        void operator=(const Scope&);
+    };
+
+    /**
+     * Construct an empty batch.
+     *
+     * \param[in] window maximum number of calls in flight, 0 for no limit
+     */
+    MethodBatch(size_t window = 0);
+
+    /**
+     * Destruct the batch. Calls that were queued but not sent complete
+     * with ER_FAIL. Calls that were sent still complete normally, and the
+     * listener passed to Send() is still called.
+     */
+    ~MethodBatch();
+
+    /**
+     * Send the queued calls. This can only be done once.
+     *
+     * \param[in] listener optional listener called when all calls completed
+     * \param[in] dispatch where \a listener is called
+     *
+     * \retval ER_OK on success
+     * \retval ER_FAIL if the batch was already sent
+     */
+    QStatus Send(MethodBatchListener* listener = NULL,
+                 MethodInvocationBase::ReplyDispatch dispatch = MethodInvocationBase::GetDefaultReplyDispatch());
+
+    /**
+     * Block the calling thread until all calls of the batch completed.
+     * Returns immediately if the batch was not sent.
+     */
+    void Wait();
+
+    /**
+     * Number of calls queued on the batch.
+     */
+    size_t GetSize() const;
+
+  private:
+    std::shared_ptr<MethodBatchState> state;
+
+    MethodBatch(const MethodBatch&);
+    void operator=(const MethodBatch&);
+};
+} /* namespace datadriven */
+
+#endif /* DATADRIVEN_METHODBATCH_H_ */
@@ -17,10 +17,12 @@
 #ifndef METHODINVOCATION_H_
 #define METHODINVOCATION_H_
 
+#include <atomic>
 #include <memory>
 
 #include <datadriven/MethodInvocationBase.h>
 #include <datadriven/MethodReplyListener.h>
+#include <datadriven/PoolAllocator.h>
 
 #include <qcc/Debug.h>
 #define QCC_MODULE "DD_CONSUMER"
@@ -44,15 +46,19 @@ template <typename T> class MethodInvocation :
   public:
     /** \private
      * Use by generated code for creating a shared pointer to an invocation.
+     * The invocation and its reference count share a single block that is
+     * recycled through a PoolAllocator. The application gets a handle with
+     * a reference count of its own, which holds one framework reference.
      * \return A shared pointer to the invocation.
      */
     static std::shared_ptr<MethodInvocation<T> > Create()
     {
-        MethodInvocation<T>* inv = new datadriven::MethodInvocation<T>();
-        std::shared_ptr<MethodInvocationBase> sp(inv);
-        inv->SetRefCountedPtr(sp);
-        inv->methodReplyListener = nullptr;
-        return std::static_pointer_cast<MethodInvocation<T> >(sp);
+        std::shared_ptr<MethodInvocation<T> > sp =
+            std::allocate_shared<Pooled>(PoolAllocator<Pooled>());
+        sp->SetRefCountedPtr(sp);
+        std::shared_ptr<MethodInvocation<T> > handle(sp.get(), Release(sp), PoolAllocator<MethodInvocation<T> >());
+        sp->SetUserHandle(handle);
+        return handle;
     }
 
     /** Cleanup of the Future object. */
@@ -85,6 +91,9 @@ template <typename T> class MethodInvocation :
      * The most common practice is to call this right after receiving
      * the method invocation from the method call.
      *
+     * The listener is called as selected by the default reply dispatch
+     * policy, see MethodInvocationBase::SetDefaultReplyDispatch.
+     *
      * \param listener The listener to be called when a reply arrives.
      *
      * \retval ER_OK When the listener is set correctly.
@@ -92,43 +101,40 @@ template <typename T> class MethodInvocation :
      */
     QStatus SetListener(MethodReplyListener<T>& listener)
     {
-        QStatus status = ER_OK;
-        methodReplyListenerMutex.Lock();
-        if (methodReplyListener) {
-            status = ER_FAIL;
-        } else {
-            methodReplyListener = &listener;
-
-            /* If we notice that a reply is already processed,
-             * we can immediately schedule the listener */
-            if (READY == state) {
-                ScheduleMethodReplyListener();
-            }
-        }
-        methodReplyListenerMutex.Unlock();
-        return status;
+        return SetListener(listener, GetDefaultReplyDispatch());
     }
 
     /**
-     * \brief Tell the framework you do not care about the reply of this method call.
+     * \brief Add a listener for the method reply, called as selected by
+     *        \a dispatch.
+     *
+     * \param listener The listener to be called when a reply arrives.
+     * \param dispatch Where the listener is called.
      *
-     * This is only a local reinforcement, it explicitly tells the framework
-     * you are no longer interested in the reply of the method call.
+     * \retval ER_OK When the listener is set correctly.
+     * \retval ER_FAIL When the listener is already set.
      */
-    void Cancel()
+    QStatus SetListener(MethodReplyListener<T>& listener,
+                        ReplyDispatch dispatch)
     {
-        methodReplyListenerMutex.Lock();
-        MethodInvocationBase::Cancel();
-        methodReplyListenerMutex.Unlock();
+        MethodReplyListener<T>* expected = nullptr;
+        if (!methodReplyListener.compare_exchange_strong(expected, &listener)) {
+            return ER_FAIL;
+        }
+        replyDispatch = dispatch;
+        /* If a reply is already processed, this schedules the listener immediately */
+        ListenerAttached();
+        return ER_OK;
     }
 
     /** \private
      * Move constructor.
      * \param inv Original MethodInvocation object to be moved.
      */
-    MethodInvocation(const MethodInvocation&& inv) :
-        reply(std::move(inv.reply)), methodReplyListener(inv.methodReplyListener)
-    { inv.methodReplyListener =  nullptr; }
+    MethodInvocation(MethodInvocation&& inv) :
+        MethodInvocationBase(std::move(inv)),
+        reply(std::move(inv.reply)), methodReplyListener(inv.methodReplyListener.exchange(nullptr))
+    { }
 
   protected:
     /**
@@ -145,44 +151,46 @@ template <typename T> class MethodInvocation :
      */
     virtual void HandleReply()
     {
-        if (methodReplyListener) {
-            methodReplyListener->OnReply(reply);
+        MethodReplyListener<T>* listener = methodReplyListener.load();
+        if (listener) {
+            listener->OnReply(reply);
         }
     }
 
-    /**
-     * \private
-     * To check if there is a listener set. We need to know this
-     * whether we want to schedule the listener or not.
-     *
-     * \retval true When a listener is set.
-     * \retval false When a listener is not set.
-     */
-    virtual bool HasListener()
-    {
-        bool ret = false;
-        methodReplyListenerMutex.Lock();
-        if (methodReplyListener) {
-            ret = true;
-        }
-        methodReplyListenerMutex.Unlock();
-        return ret;
-    }
-
   private:
     T reply;
-    MethodReplyListener<T>* methodReplyListener;
-    datadriven::Mutex methodReplyListenerMutex;
+    std::atomic<MethodReplyListener<T>*> methodReplyListener;
 
     /** Initializes the Future object. */
     MethodInvocation() :
         methodReplyListener(nullptr)
     { }
 
-    // prevent copy by assignment (can not copy semaphore)
+    /** Gives allocate_shared access to the private constructor */
+    struct Pooled;
+
+    /** Drops the framework reference of the application's handle */
+    struct Release {
+        std::shared_ptr<MethodInvocation<T> > inv;
+
+        Release(const std::shared_ptr<MethodInvocation<T> >& inv) :
+            inv(inv) { }
+
+        void operator()(MethodInvocation<T>*)
+        {
+            inv.reset();
+        }
+    };
+
+    // prevent copy by assignment (can not copy completion)
     MethodInvocation(const MethodInvocation&);
     void operator=(const MethodInvocation&);
 };
+
+template <typename T> struct MethodInvocation<T>::Pooled :
+    public MethodInvocation<T> {
+    Pooled() { }
+};
 }
 
 #undef QCC_MODULE
@@ -17,6 +17,7 @@
 #ifndef METHODINVOCATIONBASE_H_
 #define METHODINVOCATIONBASE_H_
 
+#include <atomic>
 #include <memory>
 
 #include <alljoyn/InterfaceDescription.h> // needed by MessageReceiver.h
@@ -25,20 +26,22 @@
 #include <alljoyn/MsgArg.h>
 #include <alljoyn/ProxyBusObject.h>
 
+#include <datadriven/Completion.h>
 #include <datadriven/ConsumerMethodReply.h>
 #include <datadriven/ProxyInterface.h>
-#include <datadriven/Semaphore.h>
 
 namespace datadriven {
 class MethodReplyListenerBase;
+class MethodBatchState;
+class PendingCalls;
+class CachePropertyContext;
+class DeadlineCall;
 
 /**
  * \class MethodInvocationBase
  * \brief Base class for an invocation of a method on an AllJoyn interface.
  */
-class MethodInvocationBase :
-    public ajn::MessageReceiver,
-    public ajn::ProxyBusObject::Listener {
+class MethodInvocationBase {
   public:
     /**
      * The default timeout for method calls (25 seconds)
@@ -55,6 +58,43 @@ class MethodInvocationBase :
         CANCELLED /**< Invocation was cancelled by the user */
     };
 
+    /**
+     * \enum ReplyDispatch
+     * Where a MethodReplyListener is called.
+     */
+    enum ReplyDispatch {
+        /**
+         * On the consumer queue shared with the observers, in order with
+         * object discovery and property updates (the default).
+         */
+        DISPATCH_QUEUED,
+        /**
+         * On a dedicated reply thread, so replies do not wait behind
+         * observer notifications. Listeners are still called one at a time.
+         */
+        DISPATCH_EXECUTOR,
+        /**
+         * Directly on the thread that completes the invocation: the AllJoyn
+         * thread that received the reply, or the thread calling SetListener
+         * if the reply was already there. The listener must not block.
+         */
+        DISPATCH_INLINE
+    };
+
+    /**
+     * \brief Set the dispatch policy for listeners set without an explicit one.
+     *
+     * \param[in] dispatch the new default policy
+     */
+    static void SetDefaultReplyDispatch(ReplyDispatch dispatch);
+
+    /**
+     * \brief Get the dispatch policy for listeners set without an explicit one.
+     *
+     * \return the default policy
+     */
+    static ReplyDispatch GetDefaultReplyDispatch();
+
     /** \private Initializes the Future object. */
     MethodInvocationBase();
 
@@ -84,10 +124,21 @@ class MethodInvocationBase :
      *  \brief Tell the framework you do not care about the reply of this method call.
      *
      * This is only a local reinforcement, it explicitly tells the framework
-     * you are no longer interested in the reply of the method call.
+     * you are no longer interested in the reply of the method call. The
+     * framework releases its reference to the invocation immediately, and
+     * threads blocked in GetReply() return. A reply that arrives later is
+     * dropped.
      */
     void Cancel();
 
+    /**
+     * \brief Get the number of method calls, in the whole process, that were
+     *        sent and are still waiting for a reply or a time-out.
+     *
+     * Cancelled calls are not included.
+     */
+    static size_t GetPendingCount();
+
     /**
      * Block calling thread until a reply has arrived.  This could also be a
      * time out or an error
@@ -96,6 +147,11 @@ class MethodInvocationBase :
 
     /** \private
      * Executes an asynchronous method call on the underlying communication layer.
+     * If a MethodBatch::Scope is active on the calling thread, the call is
+     * queued on the batch instead. If a CallDeadline::Scope is active, the
+     * timeout is bounded by the deadline, and the call may be hedged or
+     * failed over as the deadline specifies. A call queued on a batch only
+     * gets its timeout bounded, it is sent once (see MethodBatch).
      * \param[in] intf Proxy object for a remote interface on which the call is invoked.
      * \param[in] member Member of the interface for which the the call is intended.
      * \param[in] args List of input arguments to be taken by the Method invocation.
@@ -136,35 +192,46 @@ class MethodInvocationBase :
      */
     virtual void HandleReply() = 0;
 
-    /**
-     * \private
-     * To check if there is a listener set. We need to know this
-     * whether we want to schedule the listener or not.
-     *
-     * \retval true When a listener is set.
-     * \retval false When a listener is not set.
-     */
-    virtual bool HasListener() = 0;
-
   protected:
     /** \private
-     * state of the method reply, can be either WAITING or READY
+     * state of the method reply, can be either WAITING, READY or CANCELLED
      */
-    MethodInvocationBase::InvState state;
+    std::atomic<InvState> state;
 
     /** \private
-     * Sets shared_this.
+     * Sets weak_this.
      *
-     * \param[in] inv the new shared pointer to set to shared_this
+     * \param[in] inv the shared pointer owning this invocation
      */
     void SetRefCountedPtr(std::shared_ptr<MethodInvocationBase> inv);
 
+    /** \private
+     * Sets userHandle.
+     *
+     * \param[in] handle the shared pointer handed to the application
+     */
+    void SetUserHandle(std::shared_ptr<MethodInvocationBase> handle);
+
     /**
      * \private
-     * Schedule the MethodReplyListener on the correct thread
+     * Schedule the MethodReplyListener on the thread selected by replyDispatch
      */
     void ScheduleMethodReplyListener();
 
+    /**
+     * \private
+     * Policy for calling the listener, set together with the listener
+     */
+    ReplyDispatch replyDispatch;
+
+    /**
+     * \private
+     * Record that a listener was set. The listener is scheduled right away
+     * if the reply already arrived, otherwise it is scheduled by the reply
+     * handler. Either way it is scheduled exactly once.
+     */
+    void ListenerAttached();
+
     /**
      * Returns the method reply linked to this method invocation.
      *
@@ -174,35 +241,91 @@ class MethodInvocationBase :
 
   private:
     /**
-     * Shared pointer to ensure that the invocation object stays alive until
-     * the response from the Core framework arrives even if the caller does
-     * not keep a reference.
+     * Weak pointer to the invocation, for the framework to take references
+     * with. While a call is pending, PendingCalls keeps the invocation alive.
      */
-    mutable std::shared_ptr<MethodInvocationBase> shared_this;
+    mutable std::weak_ptr<MethodInvocationBase> weak_this;
 
     /**
-     * Weak pointer to be able to check whether the caller still has a
-     * reference to the invocation in the case where a listener is used.
+     * The handle given to the application. It has a reference count of its
+     * own, so whether the application still refers to the invocation does
+     * not depend on how many references the framework holds.
      */
-    mutable std::weak_ptr<MethodInvocationBase> weak_this;
+    std::weak_ptr<MethodInvocationBase> userHandle;
 
-    Semaphore* sem;
+    /** Id of the call in PendingCalls while it is pending, 0 otherwise */
+    std::atomic<uintptr_t> callId;
 
-    // prevent copy by construction or assignment (can not copy semaphore)
+    /** Where to cache the value of a get property call, if anywhere */
+    CachePropertyContext* cacheContext;
+
+    /** Signaled once the invocation left the WAITING state */
+    Completion completion;
+
+    /** LISTENER_SET and REPLY_DONE, see ListenerAttached */
+    std::atomic<unsigned int> listenerFlags;
+
+    static const unsigned int LISTENER_SET = 1;
+    static const unsigned int REPLY_DONE = 2;
+
+    /** Batch this invocation is part of, until it completes */
+    std::shared_ptr<MethodBatchState> batch;
+
+    /** Hedging and failover state of a call made under a CallDeadline */
+    std::shared_ptr<DeadlineCall> deadlineCall;
+
+    /**
+     * Send the method call. Fire-and-forget (NoReply) calls complete as
+     * soon as they are sent.
+     */
+    void Send(const ajn::ProxyBusObject& proxy,
+              const ajn::InterfaceDescription::Member& member,
+              bool noReply,
+              const ajn::MsgArg* msgarg,
+              size_t numArgs,
+              uint32_t timeout);
+
+    /**
+     * Send one attempt of a call made under a CallDeadline. The invocation
+     * is registered in PendingCalls as \a id.
+     */
+    QStatus SendAttempt(const ProxyInterface& intf,
+                        int memberNumber,
+                        const ajn::MsgArg* msgarg,
+                        size_t numArgs,
+                        uintptr_t id,
+                        uint32_t timeout);
+
+    /**
+     * Register the invocation in PendingCalls before it is sent.
+     * \return the call id, or 0 if nobody refers to the invocation anymore
+     */
+    uintptr_t AddPending();
+
+    /**
+     * Unregister a call that could not be sent, see AddPending
+     * \return false if the call was cancelled in the meantime
+     */
+    bool RemovePending(uintptr_t id);
+
+    // prevent copy by construction or assignment (can not copy completion)
     MethodInvocationBase(const MethodInvocationBase&);
     void operator=(const MethodInvocationBase&);
 
+    /**
+     * Handle the reply message of a method call. The reply is only
+     * unmarshalled while the application still refers to the invocation.
+     * \param[in] id call id of the reply in PendingCalls
+     */
     void OnReplyMessage(ajn::Message& message,
-                        void* context);
+                        uintptr_t id);
 
     void OnGetProperty(QStatus status,
-                       ajn::ProxyBusObject* obj,
-                       const ajn::MsgArg& value,
-                       void* context);
+                       const ajn::MsgArg& value);
 
-    void OnSetProperty(QStatus status,
-                       ajn::ProxyBusObject* obj,
-                       void* context);
+    friend class DeadlineCall;
+    friend class MethodBatchState;
+    friend class PendingCalls;
 };
 }
 
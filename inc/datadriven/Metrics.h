@@ -0,0 +1,244 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef DATADRIVEN_METRICS_H_
+#define DATADRIVEN_METRICS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <vector>
+
+#include <qcc/String.h>
+
+#include <datadriven/MutexProfiler.h>
+
+namespace datadriven {
+/**
+ * \class Metrics
+ * \brief Runtime metrics of the observers, caches, queues and sessions of
+ *        the library and of the provided objects.
+ *
+ * Metrics are off by default. Once enabled with Enable(true), the library
+ * counts events (property gets and sets, method calls, signals, session
+ * joins, ...) in per-thread counters that only their own thread writes to,
+ * so counting takes no locks and shares no cache lines between threads.
+ * While disabled, counting is a single relaxed load.
+ *
+ * GetSnapshot() merges the counters of all threads and samples the current
+ * state of every observer cache, task queue and session manager. Counters
+ * only grow, so rates follow from two snapshots and their time stamps:
+ *
+ * \code
+ * datadriven::Metrics::Enable(true);
+ * datadriven::Metrics::Snapshot before, after;
+ * datadriven::Metrics::GetSnapshot(before);
+ * sleep(10);
+ * datadriven::Metrics::GetSnapshot(after);
+ * double callsPerSecond = (after.counters[datadriven::Metrics::PROVIDER_METHOD_CALLS] -
+ *                          before.counters[datadriven::Metrics::PROVIDER_METHOD_CALLS]) * 1e9 /
+ *                         (after.time - before.time);
+ * \endcode
+ */
+class Metrics {
+  public:
+    /**
+     * Event counters
+     */
+    enum Counter {
+        PROVIDER_GETS,          /**< property reads by consumers */
+        PROVIDER_SETS,          /**< property writes by consumers */
+        PROVIDER_METHOD_CALLS,  /**< method calls dispatched to provided objects */
+        PROVIDER_SIGNALS,       /**< signals emitted by provided objects */
+        PROVIDER_UPDATES,       /**< PropertiesChanged signals emitted by provided objects */
+        SESSION_JOINS,          /**< sessions joined with providers */
+        SESSION_JOIN_FAILURES,  /**< failed attempts to join a session */
+        SESSION_LOSSES,         /**< sessions lost */
+        NUM_COUNTERS
+    };
+
+    /**
+     * Recorded durations
+     */
+    enum Timing {
+        SESSION_JOIN_LATENCY,   /**< from starting to join a session until it was joined */
+        NUM_TIMINGS
+    };
+
+    /**
+     * Log2 histogram of durations in ns, as used by the mutex profiler.
+     */
+    typedef MutexProfiler::Histogram Histogram;
+
+    /**
+     * \brief State of the cache of discovered objects for one interface.
+     */
+    struct Cache {
+        /** Name of the interface */
+        qcc::String interfaceName;
+        /** Objects currently alive */
+        size_t living;
+        /** Objects that disappeared but are still referenced by the application */
+        size_t dead;
+        /** Observers for the interface */
+        size_t observers;
+    };
+
+    /**
+     * \brief State of an internal task queue.
+     */
+    struct Queue {
+        /** Which queue: "consumer", "reply", "session" or "provider" */
+        const char* name;
+        /** Tasks currently queued */
+        size_t depth;
+        /** Highest depth seen */
+        size_t highWatermark;
+        /** Tasks accepted */
+        uint64_t enqueued;
+        /** Tasks taken off the queue and executed */
+        uint64_t executed;
+        /** Tasks discarded because the queue was full */
+        uint64_t dropped;
+        /** Tasks merged into a queued one because the queue was full */
+        uint64_t coalesced;
+        /** Enqueue calls that waited for room */
+        uint64_t blocked;
+        /** Longest time in ms a task waited in the queue while metrics were enabled */
+        uint64_t maxWait;
+    };
+
+    /**
+     * \brief All metrics at one point in time.
+     */
+    struct Snapshot {
+        /** Monotonic time stamp in ns */
+        uint64_t time;
+        /** Event counters, indexed by Counter */
+        uint64_t counters[NUM_COUNTERS];
+        /** Durations, indexed by Timing */
+        Histogram timings[NUM_TIMINGS];
+        /** One entry per observed interface */
+        std::vector<Cache> caches;
+        /** One entry per task queue */
+        std::vector<Queue> queues;
+        /** Sessions with providers the consumer side needs */
+        size_t sessions;
+        /** Of those, the sessions that are currently joined */
+        size_t establishedSessions;
+
+        Snapshot();
+    };
+
+    /** \private
+     * \brief Something that adds its current state to a snapshot.
+     */
+    class Source {
+      public:
+        virtual ~Source() { }
+
+        /**
+         * Add the current state to \a snapshot. Called with the source
+         * registry locked, so it must not add or remove sources.
+         */
+        virtual void CollectMetrics(Snapshot& snapshot) const = 0;
+    };
+
+    /**
+     * Start or stop counting.
+     */
+    static void Enable(bool enable);
+
+    /**
+     * Whether counting is on.
+     */
+    static bool IsEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Take a snapshot of all metrics.
+     *
+     * \param[out] snapshot the metrics
+     */
+    static void GetSnapshot(Snapshot& snapshot);
+
+    /**
+     * Write a snapshot to \a out, one metric per line:
+     *
+     *   counter <name> <value>
+     *   timing <name> <count> <p50_us> <p99_us> <max_us>
+     *   cache <interface> <living> <dead> <observers>
+     *   queue <name> <depth> <high_watermark> <enqueued> <executed> <dropped> <coalesced> <blocked> <max_wait_ms>
+     *   sessions <sessions> <established>
+     */
+    static void Dump(FILE* out);
+
+    /**
+     * Clear the counters and timings of all threads. Events counted
+     * concurrently with the reset may be lost.
+     */
+    static void Reset();
+
+    /**
+     * Name of \a counter as used by Dump.
+     */
+    static const char* GetName(Counter counter);
+
+    /**
+     * Name of \a timing as used by Dump.
+     */
+    static const char* GetName(Timing timing);
+
+    /** \private
+     * Count \a n events.
+     */
+    static void Increment(Counter counter,
+                          uint64_t n = 1)
+    {
+        if (IsEnabled()) {
+            Record(counter, n);
+        }
+    }
+
+    /** \private
+     * Record a duration of \a ns.
+     */
+    static void RecordTiming(Timing timing,
+                             uint64_t ns);
+
+    /** \private
+     * Add a source to every following snapshot.
+     */
+    static void AddSource(const Source* source);
+
+    /** \private
+     * Remove a source, waits for a snapshot in progress.
+     */
+    static void RemoveSource(const Source* source);
+
+  private:
+    static std::atomic<bool> enabled;
+
+    static void Record(Counter counter,
+                       uint64_t n);
+};
+}
+
+#endif /* DATADRIVEN_METRICS_H_ */
@@ -0,0 +1,153 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef DATADRIVEN_MUTEXPROFILER_H_
+#define DATADRIVEN_MUTEXPROFILER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <vector>
+
+namespace datadriven {
+/**
+ * \class MutexProfiler
+ * \brief Opt-in contention profiler for datadriven::Mutex.
+ *
+ * When enabled, every Mutex::Lock(MUTEX_CONTEXT) records, for its call site,
+ * the number of acquisitions, how many of them had to wait, the wait time
+ * and, at the matching Mutex::Unlock(MUTEX_CONTEXT), the hold time. The
+ * plain Lock() and Unlock() overloads are never profiled.
+ *
+ * Samples are kept in per-thread tables that only their own thread writes
+ * to, so recording takes no locks and shares no cache lines with other
+ * threads. GetSites() and Dump() merge the tables of all threads.
+ *
+ * In debug builds MUTEX_CONTEXT always passes the call site. In release
+ * builds it only does so when the library and the application are built
+ * with DATADRIVEN_MUTEX_PROFILING defined (scons MUTEX_PROFILING=on);
+ * otherwise profiling has no effect and no cost.
+ */
+class MutexProfiler {
+  public:
+    /** Number of histogram buckets. Bucket i counts durations below 2^i ns. */
+    static const unsigned int BUCKETS = 32;
+
+    /**
+     * \brief Log2 histogram of durations in nanoseconds.
+     */
+    struct Histogram {
+        /** Number of samples per bucket, the last one also counts larger values */
+        uint64_t buckets[BUCKETS];
+        /** Sum of all samples in ns */
+        uint64_t total;
+        /** Largest sample in ns */
+        uint64_t max;
+
+        Histogram();
+
+        /**
+         * Number of samples in the histogram.
+         */
+        uint64_t GetCount() const;
+
+        /**
+         * Upper bound in ns of the bucket holding the given percentile.
+         *
+         * \param[in] percentile percentile in [0, 100]
+         */
+        uint64_t GetPercentile(unsigned int percentile) const;
+    };
+
+    /**
+     * \brief Statistics of a single call site.
+     */
+    struct Site {
+        /** File (or function) name passed to Mutex::Lock */
+        const char* file;
+        /** Line passed to Mutex::Lock */
+        uint32_t line;
+        /** Number of times the lock was acquired here */
+        uint64_t acquisitions;
+        /** Number of acquisitions that had to wait for another thread */
+        uint64_t contended;
+        /** Wait times of the contended acquisitions */
+        Histogram wait;
+        /** Time the lock was held after being acquired here */
+        Histogram hold;
+    };
+
+    /**
+     * Start or stop recording.
+     */
+    static void Enable(bool enable);
+
+    /**
+     * Whether recording is on.
+     */
+    static bool IsEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Merge the statistics of all threads, one entry per call site, sorted
+     * by total wait time, most contended first.
+     *
+     * \param[out] sites the call sites
+     */
+    static void GetSites(std::vector<Site>& sites);
+
+    /**
+     * Write the merged statistics to \a out, one line per call site:
+     *
+     *   file:line acquisitions contended wait_total_us wait_p99_us hold_total_us hold_p99_us hold_max_us
+     */
+    static void Dump(FILE* out);
+
+    /**
+     * Clear the statistics of all threads. Samples recorded concurrently
+     * with the reset may be lost.
+     */
+    static void Reset();
+
+    /** \private
+     * Monotonic clock in ns.
+     */
+    static uint64_t Now();
+
+    /** \private
+     * Record an acquisition at \a file:\a line that waited \a wait ns.
+     */
+    static void RecordLock(const char* file,
+                           uint32_t line,
+                           bool contended,
+                           uint64_t wait);
+
+    /** \private
+     * Record that the lock acquired at \a file:\a line was held \a hold ns.
+     */
+    static void RecordHold(const char* file,
+                           uint32_t line,
+                           uint64_t hold);
+
+  private:
+    static std::atomic<bool> enabled;
+};
+}
+
+#endif /* DATADRIVEN_MUTEXPROFILER_H_ */
@@ -382,13 +382,7 @@ template <typename T> class Observer :
      */
     std::shared_ptr<T> Get(const ajn::Message& message)
     {
-        ObjectId* objId = GetObjectId(message);
-        if (nullptr != objId) {
-            std::shared_ptr<T> proxy = CastToTPtr(GetObject(*objId));
-            delete objId;
-            return proxy;
-        }
-        return nullptr;
+        return CastToTPtr(ObserverBase::GetObject(message));
     }
 
     /**
@@ -28,6 +28,7 @@
 
 namespace datadriven {
 class SignalListenerBase;
+class SignalHub;
 class BusConnectionImpl;
 class ObserverManager;
 class ObserverCache;
@@ -89,17 +90,6 @@ class ObserverBase :
      */
     QStatus SetRefCountedPtr(std::weak_ptr<ObserverBase> observer);
 
-    /**
-     * \private
-     *
-     * Called to handle an incoming signal.
-     *
-     * \param[in] listener The listener to dispatch the signal to.
-     * \param[in] message Incoming signal message.
-     */
-    void HandleSignal(SignalListenerBase* listener,
-                      const ajn::Message& message);
-
     /**
      * Return the number of discovered objects.
      * \return number of discovered objects
@@ -124,7 +114,8 @@ class ObserverBase :
      * \brief Add a signal listener for a specific signal.
      *
      * It is allowed to add multiple signal listeners for the same signal to a
-     * single Observer.
+     * single Observer. Each signal is unmarshaled once and delivered to all of
+     * them. Adding a listener that was already added has no effect.
      *
      * \tparam S the signal class created by the code generator for the signal
      *           in question.
@@ -142,6 +133,9 @@ class ObserverBase :
      *
      * \tparam S the signal class created by the code generator for the signal
      *           in question.
+     * Once this returns the listener is no longer called, unless it is
+     * removed from within one of its own callbacks.
+     *
      * \param[in] listener the signal listener
      * \retval ER_OK    success
      * \retval other    failure
@@ -184,6 +178,17 @@ class ObserverBase :
      */
     std::shared_ptr<ProxyInterface> GetObject(const ObjectId& objId);
 
+    /**
+     * \private
+     * Retrieves the object that sent \a message from the cache linked to
+     * this observer base. Unlike GetObject(GetObjectId(message)) this
+     * does not allocate and does not go through the observer manager.
+     *
+     * \param[in] message the message received
+     * \return a shared pointer to the object, or nullptr if it is not alive
+     */
+    std::shared_ptr<ProxyInterface> GetObject(const ajn::Message& message);
+
     /**
      * \private
      * Returns a vector containing all objects from the cache linked to this observer base
@@ -224,6 +229,12 @@ class ObserverBase :
      */
     std::shared_ptr<BusConnectionImpl> busConnectionImpl;
 
+    /**
+     * The cache of the observed interface, kept alive by this observer's
+     * registration with the observer manager.
+     */
+    std::shared_ptr<ObserverCache> cache;
+
     /**
      * A weak pointer to be able to guarantee that ObserverBase is not deleted while
      * there are still tasks running on them
@@ -231,19 +242,19 @@ class ObserverBase :
     std::weak_ptr<ObserverBase> observerBase;
 
     /**
-     * Signal listeners map type.
+     * Signal hubs map type, one hub per signal that has listeners.
      */
-    typedef std::map<const ajn::InterfaceDescription::Member*, SignalListenerBase*> SignalListenerMap;
+    typedef std::map<const ajn::InterfaceDescription::Member*, std::shared_ptr<SignalHub> > SignalHubMap;
 
     /**
-     * Signal listeners map.
+     * Signal hubs map.
      */
-    SignalListenerMap signalListeners;
+    SignalHubMap signalHubs;
 
     /**
-     * Mutex protecting the signal listeners map.
+     * Mutex protecting the signal hubs map.
      */
-    datadriven::Mutex signalListenersMutex;
+    datadriven::Mutex signalHubsMutex;
 
     /**
      * Called when the object identified by \a objId needs to be updated. This actually
@@ -0,0 +1,87 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+
+#ifndef DATADRIVEN_POOLALLOCATOR_H_
+#define DATADRIVEN_POOLALLOCATOR_H_
+
+#include <stddef.h>
+
+namespace datadriven {
+/** \private
+ * Allocate \a size bytes from the calling thread's block cache, falling
+ * back to the heap for large sizes or when the cache is empty.
+ */
+void* PoolAllocate(size_t size);
+
+/** \private
+ * Return a block obtained from PoolAllocate with the same \a size. The
+ * block is cached by the calling thread, up to a fixed number of blocks
+ * per size class; beyond that, and when the thread exits, it goes back to
+ * the heap.
+ */
+void PoolFree(void* ptr,
+              size_t size);
+
+/** \private
+ * \class PoolAllocator
+ * \brief Standard allocator on top of PoolAllocate and PoolFree.
+ *
+ * Meant for small objects that are created and destroyed at a high rate,
+ * such as method invocations (see MethodInvocation::Create), so that they
+ * mostly recycle memory instead of going to the heap.
+ */
+template <typename T> class PoolAllocator {
+  public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename U> struct rebind {
+        typedef PoolAllocator<U> other;
+    };
+
+    PoolAllocator() { }
+
+    template <typename U> PoolAllocator(const PoolAllocator<U>&) { }
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(PoolAllocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t n)
+    {
+        PoolFree(ptr, n * sizeof(T));
+    }
+};
+
+template <typename T, typename U> bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&)
+{
+    return true;
+}
+
+template <typename T, typename U> bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&)
+{
+    return false;
+}
+} /* namespace datadriven */
+
+#endif /* DATADRIVEN_POOLALLOCATOR_H_ */
@@ -20,6 +20,7 @@
 #include <memory>
 #include <map>
 #include <set>
+#include <vector>
 
 #include <datadriven/Mutex.h>
 
@@ -87,6 +88,11 @@ class ProvidedInterface :
      * ProvidedObject::UpdateAll method is defined as a convenience method that
      * calls the Update method for all interfaces implemented by the object.
      *
+     * Only properties whose value differs from the one last sent, and
+     * properties that were invalidated, are included in the update. If
+     * nothing changed no update is sent at all. The first update after the
+     * object is exposed on the bus always includes all properties.
+     *
      * \retval ER_OK on success
      * \retval others on failure
      */
@@ -120,6 +126,16 @@ class ProvidedInterface :
     QStatus SetProperty(const char* name,
                         ajn::MsgArg& value);
 
+    /** \private
+     * Reply to a GetAll request for this interface. The part of the reply
+     * holding the cached properties is prebuilt and only refreshed when the
+     * properties were marshaled again.
+     * \param msg the GetAll method call
+     * \retval ER_OK on success
+     * \retval others on failure
+     */
+    QStatus ReplyGetAll(const ajn::Message& msg);
+
   protected:
     /**
      * \class PropertyValue
@@ -137,13 +153,28 @@ class ProvidedInterface :
          */
         unsigned int idx;
 
+        /**
+         * Hash of msgArg as last marshaled
+         */
+        uint64_t hash;
+
+        /**
+         * Whether \a hash is valid
+         */
+        bool hashed;
+
+        /**
+         * Whether the value changed since it was last sent to consumers
+         */
+        bool dirty;
+
         /**
          * Constucts a PropertyValue object with a given index
          *
          * \param[in] idx index of the property
          */
         PropertyValue(unsigned int idx) :
-            idx(idx) { };
+            idx(idx), hash(0), hashed(false), dirty(true) { };
     };
     /** \private
      * A map of the marshaled properties (name-value pairs)
@@ -224,13 +255,51 @@ class ProvidedInterface :
     /** Protects the invalidatedProperties set. */
     mutable datadriven::Mutex invalidatedPropertiesMutex;
 
+    /** Protects the marshaled properties and the GetAll reply against concurrent bus requests. */
+    mutable datadriven::Mutex propertiesMutex;
+
+    /** Incremented each time marshaling changes the properties, or fails. */
+    uint32_t propertiesVersion;
+
+    /** Value of propertiesVersion the GetAll reply was built for. */
+    uint32_t getAllVersion;
+
+    /** Readable properties that are not cached, fetched on every GetAll. */
+    const std::vector<const char*> uncachedProperties;
+
+    struct GetAllReply;
+
+    /**
+     * Copies of the cached properties for the GetAll reply, shared with the
+     * replies still being sent so those need no lock.
+     */
+    std::shared_ptr<const GetAllReply> getAllReply;
+
     /**
      * \private
-     * Send the update signal
+     * Marshal all properties and mark the ones whose marshaled value changed
+     * as dirty.
      * \retval ER_OK on success
      * \retval others on failure
      */
-    QStatus SignalUpdate();
+    QStatus RefreshProperties();
+
+    /**
+     * \private
+     * Mark all properties dirty so they are all part of the next update.
+     */
+    void MarkAllDirty();
+
+    /**
+     * \private
+     * Send the update signal for the dirty and invalidated properties
+     * \param trace UpdateTracer trace of the update, 0 if not traced
+     * \retval ER_OK on success
+     * \retval others on failure
+     */
+    QStatus SignalUpdate(uint64_t trace = 0);
+
+    friend class ProvidedObject;
 };
 }
 
@@ -190,6 +190,18 @@ class ProvidedObject {
                 const char* propName,
                 ajn::MsgArg& val);
 
+    /** \private
+     * Handle a bus request to read all properties of an interface of this
+     * object, by replying to \a msg directly.
+     *
+     * \param ifcName  Identifies the interface of which the properties are requested
+     * \param msg      The org.freedesktop.DBus.Properties.GetAll method call
+     * \retval ER_BUS_NO_SUCH_INTERFACE if the interface is not provided by this object
+     * \retval others the status of the reply
+     */
+    QStatus ReplyGetAll(const char* ifcName,
+                        const ajn::Message& msg);
+
   protected:
     /**
      * \brief Constructor
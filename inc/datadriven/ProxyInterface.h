@@ -17,6 +17,8 @@
 #ifndef PROXYINTERFACE_H_
 #define PROXYINTERFACE_H_
 
+#include <atomic>
+#include <map>
 #include <vector>
 
 #include <datadriven/Mutex.h>
@@ -94,6 +96,25 @@ class ProxyInterface {
      */
     bool IsAlive() const;
 
+    /** \private
+     * Get the liveness state of the remote object. The state is incremented
+     * on every transition between alive and dead, so it is odd while the
+     * object is alive, and it changes when a removed object reappears. A
+     * call can compare the state at send time with the current one to tell
+     * whether its object was resurrected meanwhile.
+     *
+     * \return the liveness state
+     */
+    uint32_t GetLiveness() const;
+
+    /** \private
+     * Whether a liveness state, as returned by GetLiveness, is alive.
+     */
+    static bool IsAlive(uint32_t liveness)
+    {
+        return 0 != (liveness & 1);
+    }
+
     /** \private
      * Method to populate/update the cached values.
      *
@@ -101,6 +122,78 @@ class ProxyInterface {
      */
     void UpdateProperties(const ajn::MsgArg* values = nullptr);
 
+    /** \private
+     * Mark properties as stale after the provider invalidated them.
+     *
+     * \param[in] invalidated The names of the invalidated properties (signature = "as").
+     */
+    void InvalidateProperties(const ajn::MsgArg& invalidated);
+
+    /** \private
+     * Get the locally cached value of a property that signals invalidation
+     * (EmitsChangedSignal "invalidates").
+     *
+     * \param[in]  propName The property name
+     * \param[out] value The cached value
+     *
+     * \retval true if a value is cached and was not invalidated since
+     * \retval false if the value must be fetched from the remote object
+     */
+    bool GetCachedProperty(const char* propName,
+                           ajn::MsgArg& value) const;
+
+    /** \private
+     * Cache the value of a property that signals invalidation, after it was
+     * fetched from the remote object.
+     *
+     * \param[in] propName The property name
+     * \param[in] value The property value
+     */
+    void CacheProperty(const char* propName,
+                       const ajn::MsgArg& value);
+
+    /**
+     * \brief Check whether the cached value of a property is out of date.
+     *
+     * Properties annotated with EmitsChangedSignal "invalidates" are not sent
+     * along with change notifications. The value obtained when the object was
+     * discovered, or when the property was last read, is cached until the
+     * provider invalidates the property. From then on the property is stale:
+     * the next read goes to the remote object, or all stale properties can be
+     * fetched at once with RefreshStaleProperties.
+     *
+     * \param[in] propName The property name
+     *
+     * \retval true if the property was invalidated and not fetched since
+     * \retval false otherwise
+     */
+    bool IsStale(const char* propName) const;
+
+    /**
+     * \brief Check whether the cached value of any property is out of date.
+     *
+     * \see ProxyInterface::IsStale
+     *
+     * \retval true if at least one property is stale
+     * \retval false otherwise
+     */
+    bool HasStaleProperties() const;
+
+    /**
+     * \brief Fetch the stale properties from the remote object.
+     *
+     * The properties are fetched asynchronously: a single stale property with
+     * a Get call, several stale properties with one GetAll call. When the
+     * values arrive, they are cached and the Observer listeners get an
+     * OnUpdate callback, just like for a change notification.
+     *
+     * \param[in] timeout Timeout (in ms) to wait for the reply
+     *
+     * \retval ER_OK if the request was sent or no property is stale
+     * \retval others on failure
+     */
+    QStatus RefreshStaleProperties(uint32_t timeout = ajn::ProxyBusObject::DefaultCallTimeout);
+
     /**
      * \brief Destructor
      */
@@ -169,14 +262,23 @@ class ProxyInterface {
     std::vector<const char*> propNames;
     ObjectId objId;
     ajn::ProxyBusObject proxyBusObject;
-    bool alive;   /* alternatively we could retrieve this from the reader cache */
-    mutable datadriven::Mutex mutex;
+    std::atomic<uint32_t> liveness;   /* see GetLiveness, checked before every method call */
+    /* values of the properties that only signal invalidation, protected by mutex */
+    struct LazyProperty {
+        ajn::MsgArg value;
+        bool valid;
+        LazyProperty() : valid(false) { }
+    };
+    std::map<qcc::String, LazyProperty> lazyProperties;
+    mutable datadriven::Mutex mutex;   /* not recursive */
 
     ajn::ProxyBusObject::PropertiesChangedListener* propChangedListener;
 
     friend class MethodInvocationBase;
     friend class ObserverCache;
 
+    class RefreshListener;
+
     /**
      * \brief Get the values of all properties on an interface
      *
@@ -0,0 +1,146 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef DATADRIVEN_SIGNALDELIVERYPOLICY_H_
+#define DATADRIVEN_SIGNALDELIVERYPOLICY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace datadriven {
+/**
+ * \class SignalDeliveryPolicy
+ * \brief Limits how many signals are queued for a single signal listener.
+ *
+ * By default every signal received is queued for delivery to the listener,
+ * however slow the listener is. A listener that cannot keep up with a
+ * high-frequency provider can instead be given a delivery policy (see
+ * SignalListener::SetDeliveryPolicy) that combines any of:
+ *
+ *  - sampling: only every Nth signal received is queued, the others are
+ *    dropped on arrival;
+ *  - latest per object: a signal from an object that already has a signal
+ *    waiting for the listener replaces the waiting one (merging);
+ *  - a capacity: when the listener already has that many signals waiting,
+ *    the oldest waiting signal is dropped to make room for the new one.
+ *
+ * \code
+ * // at most 100 signals waiting, one per object, of every 10th signal sent
+ * listener.SetDeliveryPolicy(datadriven::SignalDeliveryPolicy::EveryNth(10)
+ *                            .SetLatestPerObject(true)
+ *                            .SetCapacity(100));
+ * \endcode
+ *
+ * Signals are still delivered in the order they were received. How many
+ * signals were dropped or merged is reported by
+ * SignalListener::GetDeliveryStats.
+ */
+class SignalDeliveryPolicy {
+  public:
+    /**
+     * Construct the default policy: deliver every signal, no capacity.
+     */
+    SignalDeliveryPolicy();
+
+    /**
+     * Policy that keeps at most \a capacity signals waiting, dropping the
+     * oldest one on overflow.
+     *
+     * \param[in] capacity maximum number of waiting signals
+     */
+    static SignalDeliveryPolicy DropOldest(size_t capacity);
+
+    /**
+     * Policy that keeps at most one signal per object waiting, the latest.
+     */
+    static SignalDeliveryPolicy LatestPerObject();
+
+    /**
+     * Policy that only delivers every \a n th signal received.
+     *
+     * \param[in] n sampling interval
+     */
+    static SignalDeliveryPolicy EveryNth(uint32_t n);
+
+    /**
+     * Set the maximum number of waiting signals.
+     *
+     * \param[in] capacity maximum number of waiting signals, 0 for no limit
+     * \return this policy
+     */
+    SignalDeliveryPolicy& SetCapacity(size_t capacity);
+
+    /**
+     * Only keep the latest signal per object waiting.
+     *
+     * \param[in] latest whether a signal replaces a waiting one from the
+     *                   same object
+     * \return this policy
+     */
+    SignalDeliveryPolicy& SetLatestPerObject(bool latest);
+
+    /**
+     * Only deliver every \a n th signal received.
+     *
+     * \param[in] n sampling interval, 0 and 1 deliver every signal
+     * \return this policy
+     */
+    SignalDeliveryPolicy& SetSampling(uint32_t n);
+
+    /**
+     * Get the maximum number of waiting signals, 0 if there is no limit.
+     */
+    size_t GetCapacity() const;
+
+    /**
+     * Whether only the latest signal per object is kept waiting.
+     */
+    bool GetLatestPerObject() const;
+
+    /**
+     * Get the sampling interval, 1 if every signal is delivered.
+     */
+    uint32_t GetSampling() const;
+
+    /**
+     * Whether this is the default policy, that delivers every signal.
+     */
+    bool IsDefault() const;
+
+  private:
+    size_t capacity;
+    bool latestPerObject;
+    uint32_t sampling;
+};
+
+/**
+ * \struct SignalDeliveryStats
+ * \brief Counters of a signal listener with a delivery policy other than the
+ *        default one.
+ */
+struct SignalDeliveryStats {
+    /** Signals received for the listener */
+    uint64_t received;
+    /** Signals handed to the listener */
+    uint64_t delivered;
+    /** Signals dropped by sampling or on overflow */
+    uint64_t dropped;
+    /** Signals that replaced a waiting signal from the same object */
+    uint64_t merged;
+};
+}
+
+#endif /* DATADRIVEN_SIGNALDELIVERYPOLICY_H_ */
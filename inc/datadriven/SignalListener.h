@@ -62,8 +62,30 @@ template <typename T, typename Signal> class SignalListener :
      */
     virtual void OnSignal(const Signal& signal) = 0;
 
+    /**
+     * Limit the signals queued for this listener when it cannot keep up
+     * with the rate at which they are received. Set the policy before
+     * adding the listener with Observer::AddSignalListener.
+     *
+     * \param[in] policy the delivery policy
+     */
+    using SignalListenerBase::SetDeliveryPolicy;
+
+    /**
+     * Get the delivery policy of this listener.
+     */
+    using SignalListenerBase::GetDeliveryPolicy;
+
+    /**
+     * Get the number of signals received, delivered, dropped and merged by
+     * the delivery policy of this listener.
+     */
+    using SignalListenerBase::GetDeliveryStats;
+
   private:
-    virtual void SignalHandler(const ajn::Message& message)
+    virtual void DispatchSignal(const ajn::Message& message,
+                                SignalListenerBase* const* listeners,
+                                size_t numListeners)
     {
         std::shared_ptr<ObserverBase> obs = observerBase.lock();
         if (obs) {
@@ -75,7 +97,10 @@ template <typename T, typename Signal> class SignalListener :
                 Signal s(obj);
                 QStatus status = s.Unmarshal(const_cast<ajn::Message&>(message));
                 if (ER_OK == status) {
-                    OnSignal(s);
+                    // all listeners for this signal on this observer are of this type
+                    for (size_t i = 0; i < numListeners; i++) {
+                        static_cast<SignalListener<T, Signal>*>(listeners[i])->OnSignal(s);
+                    }
                 } else {
                     QCC_LogError(status, ("Signal unmarshaling failed"));
                 }
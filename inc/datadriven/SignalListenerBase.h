@@ -17,15 +17,18 @@
 #ifndef SIGNAL_IMPL_H_
 #define SIGNAL_IMPL_H_
 
-#include <alljoyn/InterfaceDescription.h> // needed by MessageReceiver.h
-#include <alljoyn/MessageReceiver.h>
+#include <stddef.h>
+#include <atomic>
+
+#include <alljoyn/InterfaceDescription.h>
+#include <alljoyn/Message.h>
 
 #include <datadriven/ObserverBase.h>
+#include <datadriven/SignalDeliveryPolicy.h>
 
 namespace datadriven {
 /** \private */
-class SignalListenerBase :
-    public ajn::MessageReceiver {
+class SignalListenerBase {
   public:
     SignalListenerBase();
 
@@ -34,11 +37,6 @@ class SignalListenerBase :
      */
     virtual ~SignalListenerBase();
 
-    /**
-     * Returns the signal handler of this listener
-     */
-    static ajn::MessageReceiver::SignalHandler GetHandler();
-
     /**
      * Set the Observer base class
      */
@@ -54,24 +52,57 @@ class SignalListenerBase :
      */
     void SetMember(const ajn::InterfaceDescription::Member* member);
 
+    /**
+     * Set the delivery policy of this listener. The policy takes effect
+     * when the listener is added to an observer; changing it while the
+     * listener is added has no effect until it is removed and added again.
+     *
+     * \param[in] policy the delivery policy
+     */
+    void SetDeliveryPolicy(const SignalDeliveryPolicy& policy);
+
+    /**
+     * Get the delivery policy of this listener.
+     */
+    const SignalDeliveryPolicy& GetDeliveryPolicy() const;
+
+    /**
+     * Get the delivery counters of this listener. Signals are only counted
+     * while the listener has a policy other than the default one.
+     */
+    SignalDeliveryStats GetDeliveryStats() const;
+
   protected:
     /**
-     * The actual handler of the signal. Needs to be implemented
-     * by the derived templated SignalListener
+     * Unmarshal the signal in \a message once and deliver it to all
+     * \a listeners. Needs to be implemented by the derived templated
+     * SignalListener.
+     *
+     * \param[in] message the signal message
+     * \param[in] listeners the listeners for the signal, all added to the
+     *                      same observer for the same signal as this one
+     * \param[in] numListeners number of listeners
      */
-    virtual void SignalHandler(const ajn::Message& message) = 0;
+    virtual void DispatchSignal(const ajn::Message& message,
+                                SignalListenerBase* const* listeners,
+                                size_t numListeners) = 0;
 
-    friend class ObserverBase;
+    friend class SignalHub;
+    friend class SignalQueue;
 
     std::weak_ptr<ObserverBase> observerBase;
     const ajn::InterfaceDescription::Member* member;
 
   private:
-    void ThreadHandler(const ajn::InterfaceDescription::Member* member,
-                       const char* srcPath,
-                       ajn::Message& message);
+    SignalDeliveryPolicy policy;
+
+    std::atomic<uint64_t> received;
+    std::atomic<uint64_t> delivered;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> merged;
 
-    class SignalTask;
+    SignalListenerBase(const SignalListenerBase&);
+    void operator=(const SignalListenerBase&);
 };
 }
 #endif
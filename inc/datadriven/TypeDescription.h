@@ -47,9 +47,18 @@ class TypeDescription {
     QStatus ResolveMembers(const ajn::InterfaceDescription& iface,
                            const ajn::InterfaceDescription::Member*** member) const;
 
+    /** returns the number of members (methods and signals) */
+    size_t GetMemberCount() const;
+
     /** returns a vector of all emitted (a.k.a. cached) properties */
     std::vector<const char*> GetEmittablePropertyNames() const;
 
+    /** returns a vector of all readable properties that are not cached */
+    std::vector<const char*> GetUncachedReadablePropertyNames() const;
+
+    /** returns a vector of all readable properties that only signal invalidation */
+    std::vector<const char*> GetInvalidatingPropertyNames() const;
+
     /** return true if there are any properties */
     bool HasProperties() const;
 
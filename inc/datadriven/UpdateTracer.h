@@ -0,0 +1,179 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef DATADRIVEN_UPDATETRACER_H_
+#define DATADRIVEN_UPDATETRACER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <vector>
+
+#include <qcc/String.h>
+
+namespace datadriven {
+/**
+ * \class UpdateTracer
+ * \brief Opt-in tracing of property updates, from ProvidedInterface::Update
+ *        on the provider to Observer<T>::Listener::OnUpdate on the consumer.
+ *
+ * When enabled, every traced update records the time at which it passed
+ * each Stage. The provider records the stages of Update (marshaling the
+ * properties and emitting the PropertiesChanged signal); the consumer
+ * records those of the signal (queued for the consumer thread, taken off
+ * the queue, unmarshaled into the cache and delivered to the listeners).
+ * Updates that are merged into an update that is still queued end at
+ * RECEIVED, and refer to the update they were merged into.
+ *
+ * The last CAPACITY traces are kept in an in-memory ring that can be read
+ * with GetTraces() or written as Chrome trace JSON with DumpChromeTrace().
+ * Time stamps come from the monotonic clock, which all processes on a host
+ * share, so the traces of a provider and a consumer on the same host can
+ * be loaded together (in chrome://tracing or Perfetto) and matched by object
+ * path, interface and time.
+ */
+class UpdateTracer {
+  public:
+    /** Number of traces kept */
+    static const unsigned int CAPACITY = 1024;
+
+    /**
+     * Points an update passes
+     */
+    enum Stage {
+        UPDATE,         /**< provider: Update called */
+        MARSHALED,      /**< provider: properties marshaled */
+        EMITTED,        /**< provider: PropertiesChanged emitted */
+        RECEIVED,       /**< consumer: PropertiesChanged received and queued */
+        DEQUEUED,       /**< consumer: taken off the queue by the consumer thread */
+        UNMARSHALED,    /**< consumer: properties unmarshaled into the cache */
+        DELIVERED,      /**< consumer: all listeners returned from OnUpdate */
+        NUM_STAGES
+    };
+
+    /**
+     * \brief One traced update.
+     */
+    struct Trace {
+        /** Sequence number among the traced updates, 0 for an unused slot */
+        uint64_t id;
+        /** Object path of the updated object */
+        qcc::String path;
+        /** Interface whose properties were updated */
+        qcc::String interfaceName;
+        /** Monotonic time stamp in ns of each stage, 0 if not reached */
+        uint64_t stamps[NUM_STAGES];
+        /** Trace this update was merged into while queued, 0 if none */
+        uint64_t mergedInto;
+
+        Trace();
+    };
+
+    /**
+     * Start or stop tracing.
+     *
+     * \param[in] enable whether to trace
+     * \param[in] every trace one in \a every updates
+     */
+    static void Enable(bool enable,
+                       unsigned int every = 1);
+
+    /**
+     * Whether tracing is on.
+     */
+    static bool IsEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Copy the traces in the ring, oldest first.
+     *
+     * \param[out] traces the traces
+     */
+    static void GetTraces(std::vector<Trace>& traces);
+
+    /**
+     * Write the traces in the ring to \a out in the Chrome trace event
+     * format. Each stage an update went through is written as an async
+     * slice from the previous stage; the category is "provider" or
+     * "consumer" and the slice id is the trace id.
+     */
+    static void DumpChromeTrace(FILE* out);
+
+    /**
+     * Empty the ring.
+     */
+    static void Reset();
+
+    /**
+     * Name of \a stage as used by DumpChromeTrace.
+     */
+    static const char* GetName(Stage stage);
+
+    /** \private
+     * Start a trace at \a stage (UPDATE or RECEIVED).
+     *
+     * \return the trace id, or 0 if the update is not traced
+     */
+    static uint64_t Begin(Stage stage,
+                          const char* path,
+                          const char* interfaceName)
+    {
+        return IsEnabled() ? Start(stage, path, interfaceName) : 0;
+    }
+
+    /** \private
+     * Record that trace \a id reached \a stage. Does nothing for id 0.
+     */
+    static void Record(uint64_t id,
+                       Stage stage)
+    {
+        if (0 != id) {
+            Stamp(id, stage);
+        }
+    }
+
+    /** \private
+     * Record that trace \a id was merged into trace \a into.
+     */
+    static void Merge(uint64_t id,
+                      uint64_t into);
+
+    /** \private
+     * Set the trace the calling thread is working on, 0 for none.
+     */
+    static void SetCurrent(uint64_t id);
+
+    /** \private
+     * The trace the calling thread is working on, 0 for none.
+     */
+    static uint64_t GetCurrent();
+
+  private:
+    static std::atomic<bool> enabled;
+
+    static uint64_t Start(Stage stage,
+                          const char* path,
+                          const char* interfaceName);
+
+    static void Stamp(uint64_t id,
+                      Stage stage);
+};
+}
+
+#endif /* DATADRIVEN_UPDATETRACER_H_ */
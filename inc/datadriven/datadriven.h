@@ -23,9 +23,15 @@
 #include <datadriven/ProviderMethodReply.h>
 #include <datadriven/ConsumerMethodReply.h>
 #include <datadriven/MethodInvocation.h>
+#include <datadriven/MethodBatch.h>
+#include <datadriven/CallDeadline.h>
 #include <datadriven/SignalBase.h>
+#include <datadriven/SignalDeliveryPolicy.h>
 #include <datadriven/SignalListener.h>
 #include <datadriven/Observer.h>
 #include <datadriven/ObjectAdvertiser.h>
+#include <datadriven/MarshalArena.h>
+#include <datadriven/Metrics.h>
+#include <datadriven/UpdateTracer.h>
 
 #endif /* DATADRIVEN_H_ */
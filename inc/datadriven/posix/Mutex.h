@@ -31,7 +31,7 @@
 #include <alljoyn/Status.h>
 
 namespace datadriven {
-#ifndef NDEBUG
+#if !defined(NDEBUG) || defined(DATADRIVEN_MUTEX_PROFILING)
 #define MUTEX_CONTEXT __FILE__, __LINE__
 #else
 #define MUTEX_CONTEXT
@@ -44,8 +44,12 @@ class Mutex {
   public:
     /**
      * The constructor initializes the underlying mutex implementation.
+     *
+     * @param recursive  Whether the thread holding the lock may lock it
+     *                   again. Non-recursive mutexes are cheaper; debug
+     *                   builds assert when one is locked twice.
      */
-    Mutex() { Init(); }
+    explicit Mutex(bool recursive = true) : recursive(recursive) { Init(); }
 
     /**
      * The destructor will destroy the underlying mutex.
@@ -89,20 +93,22 @@ class Mutex {
     /**
      * Mutex copy constructor creates a new mutex.
      */
-    Mutex(const Mutex& other) { Init(); }
+    Mutex(const Mutex& other) : recursive(other.recursive) { Init(); }
 
     /**
      * Mutex assignment operator.
      */
-    Mutex& operator=(const Mutex& other) { Init(); return *this; }
+    Mutex& operator=(const Mutex& other) { recursive = other.recursive; Init(); return *this; }
 
   private:
     pthread_mutex_t mutex;  ///< The Linux mutex implementation uses pthread mutex's.
     bool isInitialized;     ///< true iff mutex was successfully initialized.
+    bool recursive;         ///< true iff the owner may lock the mutex again.
     void Init();            ///< Initialize underlying OS mutex
 
     const char* file;
     uint32_t line;
+    uint64_t lockedAt;      ///< When the lock was acquired, 0 unless profiled (see MutexProfiler)
 
     /**
      * Give the condition variable class access to the underlying mutex so it
@@ -0,0 +1,116 @@
+/**
+ * @file
+ *
+ * Define a class that abstracts Linux reader-writer locks.
+ */
+
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#ifndef _OS_DATADRIVEN_SHAREDMUTEX_H
+#define _OS_DATADRIVEN_SHAREDMUTEX_H
+
+#include <qcc/platform.h>
+
+#include <pthread.h>
+
+#include <alljoyn/Status.h>
+
+#include <datadriven/Mutex.h>
+
+namespace datadriven {
+/**
+ * The Linux implementation of a reader-writer lock.
+ *
+ * Any number of threads can hold the lock shared, or a single thread can
+ * hold it exclusively. Unlike datadriven::Mutex the lock is not recursive:
+ * a thread must not lock it again, shared or exclusively, while holding it.
+ * Waiting writers are preferred over new readers, so a steady stream of
+ * readers cannot starve a writer.
+ *
+ * The MUTEX_CONTEXT overloads report to the MutexProfiler when it is
+ * enabled; hold times are only recorded for exclusive locks.
+ */
+class SharedMutex {
+  public:
+    /**
+     * The constructor initializes the underlying lock.
+     */
+    SharedMutex();
+
+    /**
+     * The destructor will destroy the underlying lock.
+     */
+    ~SharedMutex();
+
+    /**
+     * Acquires the lock exclusively, blocking until no other thread holds it.
+     *
+     * @return  ER_OK if the lock was acquired, ER_OS_ERROR if the underlying
+     *          OS reports an error.
+     */
+    QStatus Lock(const char* file,
+                 uint32_t line);
+
+    QStatus Lock();
+
+    /**
+     * Releases an exclusive lock.
+     *
+     * @return  ER_OK if the lock was released, ER_OS_ERROR if the underlying
+     *          OS reports an error.
+     */
+    QStatus Unlock(const char* file,
+                   uint32_t line);
+
+    QStatus Unlock();
+
+    /**
+     * Acquires the lock shared, blocking while another thread holds it
+     * exclusively or waits to do so.
+     *
+     * @return  ER_OK if the lock was acquired, ER_OS_ERROR if the underlying
+     *          OS reports an error.
+     */
+    QStatus LockShared(const char* file,
+                       uint32_t line);
+
+    QStatus LockShared();
+
+    /**
+     * Releases a shared lock.
+     *
+     * @return  ER_OK if the lock was released, ER_OS_ERROR if the underlying
+     *          OS reports an error.
+     */
+    QStatus UnlockShared(const char* file,
+                         uint32_t line);
+
+    QStatus UnlockShared();
+
+  private:
+    pthread_rwlock_t rwlock; ///< The Linux implementation uses a pthread rwlock.
+    bool isInitialized;      ///< true iff the lock was successfully initialized.
+
+    const char* file;        ///< Exclusive lock site, only set while profiled
+    uint32_t line;           ///< Exclusive lock site line, only set while profiled
+    uint64_t lockedAt;       ///< When the exclusive lock was acquired, 0 unless profiled
+
+    SharedMutex(const SharedMutex& other);
+    SharedMutex& operator=(const SharedMutex& other);
+};
+} /* namespace */
+
+#endif
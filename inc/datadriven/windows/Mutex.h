@@ -37,7 +37,7 @@ namespace datadriven {
  * file each time a Mutex lock is obtained and released. Logging must be turned
  * on to see this information.
  */
-#ifndef NDEBUG
+#if !defined(NDEBUG) || defined(DATADRIVEN_MUTEX_PROFILING)
 #define MUTEX_CONTEXT __FILE__, __LINE__
 #else
 #define MUTEX_CONTEXT
@@ -51,8 +51,11 @@ class Mutex {
 
     /**
      * Constructor
+     *
+     * @param recursive  Ignored, critical sections are always recursive.
+     *                   Accepted for compatibility with the other platforms.
      */
-    Mutex() :
+    explicit Mutex(bool recursive = true) :
         initialized(false) { Init(); }
 
     /**
@@ -142,6 +145,10 @@ class Mutex {
     CRITICAL_SECTION mutex; ///< Mutex variable.
     void Init();            ///< initialize a mutex
 
+    const char* file;       ///< Lock site, only set while profiled (see MutexProfiler)
+    uint32_t line;          ///< Lock site line, only set while profiled
+    uint64_t lockedAt;      ///< When the lock was acquired, 0 unless profiled
+
     /**
      * Give the condition variable class access to the underlying critical
      * section so it can get the private CRITICAL_SECTION out of a datadriven::Mutex
@@ -0,0 +1,110 @@
+/**
+ * @file
+ *
+ * Define a class that abstracts Windows reader-writer locks.
+ */
+
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#ifndef _OS_DATADRIVEN_SHAREDMUTEX_H
+#define _OS_DATADRIVEN_SHAREDMUTEX_H
+
+#include <qcc/platform.h>
+
+#include <windows.h>
+
+#include <Status.h>
+
+#include <datadriven/Mutex.h>
+
+namespace datadriven {
+/**
+ * The Windows implementation of a reader-writer lock, based on a slim
+ * reader/writer lock.
+ *
+ * Any number of threads can hold the lock shared, or a single thread can
+ * hold it exclusively. Unlike datadriven::Mutex the lock is not recursive:
+ * a thread must not lock it again, shared or exclusively, while holding it.
+ *
+ * The MUTEX_CONTEXT overloads report to the MutexProfiler when it is
+ * enabled; hold times are only recorded for exclusive locks.
+ */
+class SharedMutex {
+  public:
+    /**
+     * Constructor
+     */
+    SharedMutex();
+
+    /**
+     * Destructor
+     */
+    ~SharedMutex();
+
+    /**
+     * Acquires the lock exclusively, blocking until no other thread holds it.
+     *
+     * @return ER_OK
+     */
+    QStatus Lock(const char* file,
+                 uint32_t line);
+
+    QStatus Lock();
+
+    /**
+     * Releases an exclusive lock.
+     *
+     * @return ER_OK
+     */
+    QStatus Unlock(const char* file,
+                   uint32_t line);
+
+    QStatus Unlock();
+
+    /**
+     * Acquires the lock shared, blocking while another thread holds it
+     * exclusively.
+     *
+     * @return ER_OK
+     */
+    QStatus LockShared(const char* file,
+                       uint32_t line);
+
+    QStatus LockShared();
+
+    /**
+     * Releases a shared lock.
+     *
+     * @return ER_OK
+     */
+    QStatus UnlockShared(const char* file,
+                         uint32_t line);
+
+    QStatus UnlockShared();
+
+  private:
+    SRWLOCK rwlock;          ///< Slim reader/writer lock.
+
+    const char* file;        ///< Exclusive lock site, only set while profiled
+    uint32_t line;           ///< Exclusive lock site line, only set while profiled
+    uint64_t lockedAt;       ///< When the exclusive lock was acquired, 0 unless profiled
+
+    SharedMutex(const SharedMutex& other);
+    SharedMutex& operator=(const SharedMutex& other);
+};
+} /* namespace */
+
+#endif
@@ -17,6 +17,7 @@
 #include <datadriven/SignalListener.h>
 #include <datadriven/ProvidedInterface.h>
 #include "BusConnectionImpl.h"
+#include "DeadlineCall.h"
 #include "ProvidedObjectImpl.h"
 #include "RegisteredTypeDescription.h"
 
@@ -67,6 +68,8 @@ BusConnectionImpl::BusConnectionImpl(BusAttachment* _ba) :
 
 BusConnectionImpl::~BusConnectionImpl()
 {
+    // there is only one BusConnection, nothing can be called anymore
+    DeadlineCall::StopTimer();
     if (ownBa == true) {
         ba->Disconnect();
         ba->Stop();
@@ -0,0 +1,112 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <chrono>
+
+#include <datadriven/CallDeadline.h>
+
+#include "common/ThreadLocal.h"
+
+namespace datadriven {
+static DD_THREAD_LOCAL const CallDeadline* currentDeadline = NULL;
+
+/* CallDeadline */
+
+CallDeadline::CallDeadline(uint32_t timeout) :
+    deadline(Now() + timeout), hedgeDelay(0), maxAttempts(3), failover(true)
+{
+}
+
+CallDeadline& CallDeadline::SetHedgeDelay(uint32_t delay)
+{
+    hedgeDelay = delay;
+    return *this;
+}
+
+CallDeadline& CallDeadline::SetFailover(bool enable)
+{
+    failover = enable;
+    return *this;
+}
+
+CallDeadline& CallDeadline::SetMaxAttempts(unsigned int attempts)
+{
+    maxAttempts = attempts ? attempts : 1;
+    return *this;
+}
+
+uint32_t CallDeadline::GetRemaining() const
+{
+    uint64_t now = Now();
+    if (now >= deadline) {
+        return 0;
+    }
+    uint64_t remaining = deadline - now;
+    return remaining > UINT32_MAX ? UINT32_MAX : (uint32_t)remaining;
+}
+
+bool CallDeadline::IsExpired() const
+{
+    return Now() >= deadline;
+}
+
+uint64_t CallDeadline::GetDeadline() const
+{
+    return deadline;
+}
+
+uint32_t CallDeadline::GetHedgeDelay() const
+{
+    return hedgeDelay;
+}
+
+bool CallDeadline::GetFailover() const
+{
+    return failover;
+}
+
+unsigned int CallDeadline::GetMaxAttempts() const
+{
+    return maxAttempts;
+}
+
+uint64_t CallDeadline::Now()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const CallDeadline* CallDeadline::GetCurrent()
+{
+    return currentDeadline;
+}
+
+/* CallDeadline::Scope */
+
+CallDeadline::Scope::Scope(const CallDeadline& deadline) :
+    effective(deadline), previous(currentDeadline)
+{
+    if ((NULL != previous) && (previous->deadline < effective.deadline)) {
+        effective.deadline = previous->deadline;
+    }
+    currentDeadline = &effective;
+}
+
+CallDeadline::Scope::~Scope()
+{
+    currentDeadline = previous;
+}
+} /* namespace datadriven */
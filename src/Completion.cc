@@ -0,0 +1,119 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+
+#include <qcc/platform.h>
+
+#include <datadriven/Completion.h>
+
+#if defined(QCC_OS_LINUX) || defined(QCC_OS_ANDROID)
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define DD_USE_FUTEX
+#else
+#include <datadriven/Condition.h>
+#include <datadriven/Mutex.h>
+#endif
+
+namespace datadriven {
+#if defined(DD_USE_FUTEX)
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(int), "futex word must be a plain int");
+
+static void FutexWait(std::atomic<uint32_t>* word, uint32_t expected)
+{
+    /* returns immediately (EAGAIN) if *word no longer equals expected */
+    syscall(SYS_futex, reinterpret_cast<int*>(word), FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static void FutexWakeAll(std::atomic<uint32_t>* word)
+{
+    syscall(SYS_futex, reinterpret_cast<int*>(word), FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+#else
+/*
+ * Without futexes, blocked waiters park on one of a fixed set of condition
+ * variables, selected by the address of the completion. Completions that
+ * nobody waits for never touch them.
+ */
+#define PARKING_BUCKETS 64
+
+struct ParkingBucket {
+    datadriven::Mutex mutex;
+    datadriven::Condition cond;
+};
+
+static ParkingBucket& GetParkingBucket(const void* addr)
+{
+    static ParkingBucket buckets[PARKING_BUCKETS];
+    uintptr_t key = reinterpret_cast<uintptr_t>(addr);
+    return buckets[(key >> 4) % PARKING_BUCKETS];
+}
+#endif
+
+Completion::Completion() :
+    word(PENDING)
+{
+}
+
+bool Completion::IsSignaled() const
+{
+    return SIGNALED == word.load(std::memory_order_acquire);
+}
+
+void Completion::Signal()
+{
+    if (CONTENDED == word.exchange(SIGNALED, std::memory_order_acq_rel)) {
+#if defined(DD_USE_FUTEX)
+        FutexWakeAll(&word);
+#else
+        /* taking the lock orders us after a waiter that is about to block */
+        ParkingBucket& bucket = GetParkingBucket(this);
+        bucket.mutex.Lock();
+        bucket.cond.Broadcast();
+        bucket.mutex.Unlock();
+#endif
+    }
+}
+
+void Completion::Wait()
+{
+    uint32_t w = word.load(std::memory_order_acquire);
+    if (SIGNALED == w) {
+        return;
+    }
+#if defined(DD_USE_FUTEX)
+    while (SIGNALED != w) {
+        if (PENDING == w && !word.compare_exchange_weak(w, CONTENDED, std::memory_order_acquire)) {
+            continue;
+        }
+        FutexWait(&word, CONTENDED);
+        w = word.load(std::memory_order_acquire);
+    }
+#else
+    ParkingBucket& bucket = GetParkingBucket(this);
+    bucket.mutex.Lock();
+    w = PENDING;
+    word.compare_exchange_strong(w, CONTENDED, std::memory_order_acquire);
+    while (SIGNALED != word.load(std::memory_order_acquire)) {
+        bucket.cond.Wait(bucket.mutex);
+    }
+    bucket.mutex.Unlock();
+#endif
+}
+} /* namespace datadriven */
@@ -0,0 +1,483 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#ifdef _WIN32
+#include <Windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+#include <datadriven/Condition.h>
+#include <datadriven/MethodInvocationBase.h>
+#include <datadriven/ProxyInterface.h>
+
+#include "DeadlineCall.h"
+#include "ObserverCache.h"
+#include "ObserverManager.h"
+#include "PendingCalls.h"
+
+#include <qcc/Debug.h>
+#define QCC_MODULE "DD_CONSUMER"
+
+/** Interval in ms at which a call waiting for its object checks it again */
+#define FAILOVER_POLL_INTERVAL 50
+
+namespace datadriven {
+/**
+ * \private Wakes up deadline calls when their hedge or deadline is due, or
+ * when an object comes alive. A single thread, started on first use, calls
+ * DeadlineCall::OnTimer outside of the timer lock. Entries only refer to
+ * their call weakly, so completed calls are not kept alive. The thread is
+ * stopped when the last BusConnection goes away, failing the calls that
+ * were still waiting.
+ */
+class DeadlineTimer {
+  public:
+    static DeadlineTimer& GetInstance()
+    {
+        // never destroyed: calls may be scheduled until the process exits
+        static DeadlineTimer* instance = new DeadlineTimer();
+        return *instance;
+    }
+
+    void Schedule(uint64_t when,
+                  const std::weak_ptr<DeadlineCall>& call)
+    {
+        mutex.Lock();
+        Start();
+        bool first = alarms.empty() || when < alarms.begin()->first;
+        alarms.insert(std::make_pair(when, call));
+        if (first) {
+            cond.Signal();
+        }
+        mutex.Unlock();
+    }
+
+    void WaitForAlive(const std::weak_ptr<DeadlineCall>& call)
+    {
+        mutex.Lock();
+        bool found = false;
+        for (size_t i = 0; !found && i < aliveWaiters.size(); i++) {
+            found = !aliveWaiters[i].owner_before(call) && !call.owner_before(aliveWaiters[i]);
+        }
+        if (!found) {
+            aliveWaiters.push_back(call);
+            numAliveWaiters = aliveWaiters.size();
+        }
+        mutex.Unlock();
+    }
+
+    void NotifyAlive()
+    {
+        if (0 == numAliveWaiters.load()) {
+            return;
+        }
+        mutex.Lock();
+        aliveNotified = true;
+        cond.Signal();
+        mutex.Unlock();
+    }
+
+    /**
+     * Stop the timer thread and fail the calls still waiting with \a status.
+     * The thread is started again when a call is scheduled.
+     */
+    void Stop(QStatus status)
+    {
+        std::vector<std::weak_ptr<DeadlineCall> > left;
+
+        mutex.Lock();
+        if (!started) {
+            mutex.Unlock();
+            return;
+        }
+        started = false;
+        epoch++;
+        for (AlarmMap::iterator it = alarms.begin(); it != alarms.end(); ++it) {
+            left.push_back(it->second);
+        }
+        alarms.clear();
+        left.insert(left.end(), aliveWaiters.begin(), aliveWaiters.end());
+        aliveWaiters.clear();
+        numAliveWaiters = 0;
+        aliveNotified = false;
+        cond.Signal();
+        // a call that was answered on the timer thread may release the last BusConnection
+        bool self = IsTimerThread();
+        mutex.Unlock();
+
+#ifdef _WIN32
+        if (!self) {
+            WaitForSingleObject(handle, INFINITE);
+        }
+        CloseHandle(handle);
+#else
+        if (self) {
+            pthread_detach(thread);
+        } else {
+            pthread_join(thread, NULL);
+        }
+#endif
+
+        for (size_t i = 0; i < left.size(); i++) {
+            std::shared_ptr<DeadlineCall> call = left[i].lock();
+            if (call) {
+                call->Abort(status);
+            }
+        }
+    }
+
+  private:
+    typedef std::multimap<uint64_t, std::weak_ptr<DeadlineCall> > AlarmMap;
+
+    datadriven::Mutex mutex;
+    datadriven::Condition cond;
+    AlarmMap alarms;
+    std::vector<std::weak_ptr<DeadlineCall> > aliveWaiters;
+    std::atomic<size_t> numAliveWaiters;
+    bool aliveNotified;
+    bool started;
+    /** Incremented on every Start and Stop, a thread runs as long as it is the one it was started with */
+    uint32_t epoch;
+    /** The epoch of the thread started last */
+    uint32_t runEpoch;
+#ifdef _WIN32
+    HANDLE handle;
+    DWORD threadId;
+#else
+    pthread_t thread;
+#endif
+
+    DeadlineTimer() :
+        numAliveWaiters(0), aliveNotified(false), started(false), epoch(0), runEpoch(0) { }
+
+    /** Start the timer thread, called with mutex locked */
+    void Start()
+    {
+        if (started) {
+            return;
+        }
+        started = true;
+        runEpoch = ++epoch;
+#ifdef _WIN32
+        handle = reinterpret_cast<HANDLE>(_beginthreadex(NULL, 256 * 1024,
+                                                         (unsigned int(__stdcall*)(void*))ThreadWrapper,
+                                                         this, 0, (unsigned int*)&threadId));
+#else
+        pthread_create(&thread, NULL, ThreadWrapper, this);
+#endif
+    }
+
+    /** Whether the caller is the timer thread, called with mutex locked */
+    bool IsTimerThread() const
+    {
+#ifdef _WIN32
+        return GetCurrentThreadId() == threadId;
+#else
+        return pthread_equal(pthread_self(), thread);
+#endif
+    }
+
+    static void* ThreadWrapper(void* context)
+    {
+        static_cast<DeadlineTimer*>(context)->Run();
+        return NULL;
+    }
+
+    void Run()
+    {
+        std::vector<std::weak_ptr<DeadlineCall> > due;
+
+        mutex.Lock();
+        const uint32_t mine = runEpoch;
+        while (mine == epoch) {
+            uint64_t now = CallDeadline::Now();
+            if (aliveNotified) {
+                aliveNotified = false;
+                due.swap(aliveWaiters);
+                numAliveWaiters = 0;
+            }
+            while (!alarms.empty() && (alarms.begin()->first <= now)) {
+                due.push_back(alarms.begin()->second);
+                alarms.erase(alarms.begin());
+            }
+            if (due.empty()) {
+                if (alarms.empty()) {
+                    cond.Wait(mutex);
+                } else {
+                    cond.TimedWait(mutex, (uint32_t)(alarms.begin()->first - now));
+                }
+                continue;
+            }
+
+            mutex.Unlock();
+            for (size_t i = 0; i < due.size(); i++) {
+                std::shared_ptr<DeadlineCall> call = due[i].lock();
+                if (call) {
+                    call->OnTimer();
+                }
+            }
+            due.clear();
+            mutex.Lock();
+        }
+        mutex.Unlock();
+    }
+};
+
+/**
+ * Errors after which a call may succeed when it is sent again: the reply
+ * timed out before the deadline, or the connection to the object was lost.
+ */
+static bool IsRetryable(QStatus status)
+{
+    switch (status) {
+    case ER_TIMEOUT:
+    case ER_BUS_NO_SESSION:
+    case ER_BUS_NOT_CONNECTED:
+    case ER_BUS_NO_ENDPOINT:
+    case ER_BUS_ENDPOINT_CLOSING:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+DeadlineCall::DeadlineCall(const CallDeadline& policy,
+                           const qcc::String& ifName,
+                           const ObjectId& objId,
+                           int memberNumber,
+                           const ajn::MsgArg* args,
+                           size_t numArgs,
+                           uint32_t timeout) :
+    ifName(ifName), objId(objId), memberNumber(memberNumber), args(args, args + numArgs), timeout(timeout),
+    deadline(policy.GetDeadline()), hedgeDelay(policy.GetHedgeDelay()), maxAttempts(policy.GetMaxAttempts()),
+    failover(policy.GetFailover()), attempts(0), hedgeAt(0), sentLiveness(0), waiting(false), done(false)
+{
+}
+
+void DeadlineCall::NotifyAlive()
+{
+    DeadlineTimer::GetInstance().NotifyAlive();
+}
+
+void DeadlineCall::StopTimer()
+{
+    DeadlineTimer::GetInstance().Stop(ER_BUS_NOT_CONNECTED);
+}
+
+void DeadlineCall::Start(const std::shared_ptr<MethodInvocationBase>& invoc,
+                         const ProxyInterface& intf)
+{
+    inv = invoc;
+    if (intf.IsAlive()) {
+        mutex.Lock();
+        attempts++;
+        mutex.Unlock();
+        // the proxy owning intf, if it is still the one in the cache
+        std::shared_ptr<ProxyInterface> proxy = Resolve();
+        if (proxy.get() != &intf) {
+            proxy = nullptr;
+        }
+        Send(invoc, intf, proxy);
+    } else {
+        mutex.Lock();
+        WaitForObject(CallDeadline::Now());
+        mutex.Unlock();
+    }
+}
+
+std::shared_ptr<ProxyInterface> DeadlineCall::Resolve() const
+{
+    std::shared_ptr<ObserverManager> mgr = ObserverManager::GetInstance();
+    std::shared_ptr<ObserverCache> cache = mgr ? mgr->GetCache(ifName) : nullptr;
+    return cache ? cache->GetObject(objId) : nullptr;
+}
+
+void DeadlineCall::WaitForObject(uint64_t now)
+{
+    waiting = true;
+    DeadlineTimer& timer = DeadlineTimer::GetInstance();
+    timer.WaitForAlive(shared_from_this());
+    timer.Schedule(std::min(deadline, now + FAILOVER_POLL_INTERVAL), shared_from_this());
+}
+
+void DeadlineCall::Send(const std::shared_ptr<MethodInvocationBase>& invoc,
+                        const ProxyInterface& intf,
+                        const std::shared_ptr<ProxyInterface>& proxy)
+{
+    PendingCalls& pending = PendingCalls::GetInstance();
+    uintptr_t id = pending.Add(invoc);
+    uint64_t now = CallDeadline::Now();
+    uint32_t attemptTimeout = 0;
+    bool expired = false;
+    bool skip = false;
+
+    mutex.Lock();
+    if (done) {
+        skip = true; // cancelled or answered meanwhile
+    } else if (now >= deadline) {
+        done = true;
+        expired = true;
+    } else {
+        outstanding.push_back(id);
+        sentProxy = proxy;
+        sentLiveness = intf.GetLiveness();
+        attemptTimeout = (uint32_t)std::min<uint64_t>(timeout, deadline - now);
+        if ((0 != hedgeDelay) && (1 == attempts) && (now + hedgeDelay < deadline)) {
+            hedgeAt = now + hedgeDelay;
+            DeadlineTimer::GetInstance().Schedule(hedgeAt, shared_from_this());
+        }
+    }
+    mutex.Unlock();
+
+    if (skip || expired) {
+        pending.Remove(id);
+        if (expired) {
+            invoc->SetReplyStatus(ER_TIMEOUT);
+        }
+        return;
+    }
+
+    QStatus status = invoc->SendAttempt(intf, memberNumber, args.data(), args.size(), id, attemptTimeout);
+    if ((ER_OK != status) && pending.Remove(id) && OnResult(id, status)) {
+        QCC_LogError(status, ("Failed to call method"));
+        invoc->SetReplyStatus(status);
+    }
+}
+
+bool DeadlineCall::OnResult(uintptr_t id,
+                            QStatus status)
+{
+    std::vector<uintptr_t> losers;
+    bool deliver = false;
+    uint64_t now = CallDeadline::Now();
+    bool retryable = (ER_OK != status) && IsRetryable(status);
+    uint32_t liveness = 0;
+    std::shared_ptr<ProxyInterface> proxy;
+    if (retryable && failover) {
+        proxy = Resolve();
+        liveness = proxy ? proxy->GetLiveness() : 0;
+    }
+
+    mutex.Lock();
+    std::vector<uintptr_t>::iterator it = std::find(outstanding.begin(), outstanding.end(), id);
+    if (done || (outstanding.end() == it)) {
+        // another attempt won, or the call was cancelled
+    } else {
+        outstanding.erase(it);
+        if (retryable && !outstanding.empty()) {
+            // the other attempt may still succeed
+        } else if (retryable && failover && (attempts < maxAttempts) && (now < deadline)) {
+            // liveness states of different proxies cannot be compared, a new proxy is a new life
+            bool sameProxy = proxy && !sentProxy.owner_before(proxy) && !proxy.owner_before(sentProxy);
+            if (ProxyInterface::IsAlive(liveness) && (!sameProxy || (liveness != sentLiveness))) {
+                // the object went away and came back since the attempt was sent, no need to wait
+                QCC_DbgPrintf(("Attempt %u failed (%s), object resurrected", attempts, QCC_StatusText(status)));
+                waiting = true;
+                DeadlineTimer::GetInstance().Schedule(now, shared_from_this());
+            } else {
+                QCC_DbgPrintf(("Attempt %u failed (%s), waiting for object", attempts, QCC_StatusText(status)));
+                WaitForObject(now);
+            }
+        } else {
+            done = true;
+            deliver = true;
+            losers.swap(outstanding);
+        }
+    }
+    mutex.Unlock();
+
+    for (size_t i = 0; i < losers.size(); i++) {
+        PendingCalls::GetInstance().Remove(losers[i]);
+    }
+    return deliver;
+}
+
+bool DeadlineCall::Cancel()
+{
+    std::vector<uintptr_t> ids;
+
+    mutex.Lock();
+    bool inProgress = !done;
+    done = true;
+    ids.swap(outstanding);
+    mutex.Unlock();
+
+    for (size_t i = 0; i < ids.size(); i++) {
+        PendingCalls::GetInstance().Remove(ids[i]);
+    }
+    return inProgress;
+}
+
+void DeadlineCall::Abort(QStatus status)
+{
+    std::shared_ptr<MethodInvocationBase> invoc = inv.lock();
+    if (Cancel() && invoc) {
+        invoc->SetReplyStatus(status);
+    }
+}
+
+void DeadlineCall::OnTimer()
+{
+    std::shared_ptr<MethodInvocationBase> invoc = inv.lock();
+    if (!invoc) {
+        return; // nobody is interested in the reply anymore
+    }
+
+    std::shared_ptr<ProxyInterface> proxy = Resolve();
+    bool alive = proxy && proxy->IsAlive();
+    uint64_t now = CallDeadline::Now();
+    bool send = false;
+    bool expired = false;
+
+    mutex.Lock();
+    if (done) {
+        // nothing left to do
+    } else if (now >= deadline) {
+        // attempts in flight time out at the deadline by themselves
+        if (outstanding.empty()) {
+            done = true;
+            expired = true;
+        }
+    } else if (waiting) {
+        if (alive) {
+            waiting = false;
+            attempts++;
+            send = true;
+        } else {
+            WaitForObject(now);
+        }
+    } else if ((0 != hedgeAt) && (now >= hedgeAt)) {
+        hedgeAt = 0;
+        if (alive && !outstanding.empty() && (attempts < maxAttempts)) {
+            attempts++;
+            send = true;
+        }
+    }
+    mutex.Unlock();
+
+    if (expired) {
+        invoc->SetReplyStatus(ER_TIMEOUT);
+    } else if (send) {
+        Send(invoc, *proxy, proxy);
+    }
+}
+} /* namespace datadriven */
@@ -0,0 +1,148 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef DEADLINECALL_H_
+#define DEADLINECALL_H_
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include <alljoyn/MsgArg.h>
+
+#include <datadriven/CallDeadline.h>
+#include <datadriven/Mutex.h>
+#include <datadriven/ObjectId.h>
+
+namespace datadriven {
+class MethodInvocationBase;
+class ProxyInterface;
+
+/**
+ * \private A method call made under a CallDeadline. It owns a copy of the
+ * call arguments so the call can be sent more than once: a hedge when the
+ * first attempt is not answered in time, and a failover when an attempt
+ * fails because the object is gone and the object comes back before the
+ * deadline.
+ *
+ * Every attempt has its own entry in PendingCalls. The first attempt that
+ * produces a final outcome completes the invocation, and the entries of the
+ * other attempts are removed so their replies are dropped.
+ *
+ * The invocation owns the DeadlineCall, the DeadlineCall only refers to the
+ * invocation weakly: while waiting for its object the call is abandoned as
+ * soon as nobody refers to the invocation anymore.
+ */
+class DeadlineCall :
+    public std::enable_shared_from_this<DeadlineCall> {
+  public:
+    DeadlineCall(const CallDeadline& policy,
+                 const qcc::String& ifName,
+                 const ObjectId& objId,
+                 int memberNumber,
+                 const ajn::MsgArg* args,
+                 size_t numArgs,
+                 uint32_t timeout);
+
+    /**
+     * Send the first attempt, or wait for the object if it is not alive.
+     */
+    void Start(const std::shared_ptr<MethodInvocationBase>& inv,
+               const ProxyInterface& intf);
+
+    /**
+     * Handle the outcome of attempt \a id.
+     * \retval true the invocation must be completed with \a status
+     * \retval false the outcome is dropped: another attempt is still under
+     *         way, the call will be sent again, or it already completed
+     */
+    bool OnResult(uintptr_t id,
+                  QStatus status);
+
+    /**
+     * Stop all attempts.
+     * \retval true the call was still in progress, the caller completes it
+     */
+    bool Cancel();
+
+    /**
+     * Wake up the calls waiting for their object, called whenever an object
+     * comes alive.
+     */
+    static void NotifyAlive();
+
+    /**
+     * Stop the thread behind the deadlines, called when the last
+     * BusConnection goes away. Calls still waiting for their hedge, their
+     * object or their deadline fail with ER_BUS_NOT_CONNECTED.
+     */
+    static void StopTimer();
+
+  private:
+    /** Check what is due: a hedge, a failover or the deadline */
+    void OnTimer();
+
+    /** Stop all attempts and complete the call with \a status if still in progress */
+    void Abort(QStatus status);
+
+    /** Send one attempt to \a intf, owned by \a proxy if known */
+    void Send(const std::shared_ptr<MethodInvocationBase>& inv,
+              const ProxyInterface& intf,
+              const std::shared_ptr<ProxyInterface>& proxy);
+
+    /** Look up the proxy of the object in the observer cache */
+    std::shared_ptr<ProxyInterface> Resolve() const;
+
+    /** Wait for the object to be alive again, called with mutex locked */
+    void WaitForObject(uint64_t now);
+
+    std::weak_ptr<MethodInvocationBase> inv;
+    const qcc::String ifName;
+    const ObjectId objId;
+    const int memberNumber;
+    std::vector<ajn::MsgArg> args;
+    const uint32_t timeout;
+
+    const uint64_t deadline;
+    const uint32_t hedgeDelay;
+    const unsigned int maxAttempts;
+    const bool failover;
+
+    /** Protects the members below */
+    datadriven::Mutex mutex;
+    /** Ids in PendingCalls of the attempts that were sent and not answered */
+    std::vector<uintptr_t> outstanding;
+    /** Number of attempts sent */
+    unsigned int attempts;
+    /** Time the hedge is due, 0 if there is none */
+    uint64_t hedgeAt;
+    /** Proxy the last attempt was sent to, a resurrected object has a new one */
+    std::weak_ptr<ProxyInterface> sentProxy;
+    /** Liveness state of sentProxy when the last attempt was sent */
+    uint32_t sentLiveness;
+    /** Waiting for the object to come back */
+    bool waiting;
+    /** The outcome was delivered or the call was cancelled */
+    bool done;
+
+    friend class DeadlineTimer;
+
+    DeadlineCall(const DeadlineCall&);
+    void operator=(const DeadlineCall&);
+};
+} /* namespace datadriven */
+
+#endif /* DEADLINECALL_H_ */
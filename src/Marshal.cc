@@ -22,6 +22,53 @@ const ajn::MsgArg& MsgArgDereference(const ajn::MsgArg& msgarg)
     return (ajn::ALLJOYN_VARIANT == msgarg.typeId ? *msgarg.v_variant.val : msgarg);
 }
 
+ajn::MsgArg* NewMsgArgs(size_t numArgs)
+{
+    MarshalArena* arena = MarshalArena::GetCurrent();
+    return arena ? arena->NewArgs(numArgs) : new ajn::MsgArg[numArgs];
+}
+
+void DeleteMsgArgs(ajn::MsgArg* args)
+{
+    MarshalArena* arena = MarshalArena::GetCurrent();
+    if (!arena || !arena->Owns(args)) {
+        delete[] args;
+    }
+}
+
+ajn::MsgArg* NewMsgArg()
+{
+    MarshalArena* arena = MarshalArena::GetCurrent();
+    return arena ? arena->NewArgs(1) : new ajn::MsgArg;
+}
+
+void DeleteMsgArg(ajn::MsgArg* arg)
+{
+    MarshalArena* arena = MarshalArena::GetCurrent();
+    if (!arena || !arena->Owns(arg)) {
+        delete arg;
+    }
+}
+
+/**
+ * Hands the child MsgArgs over to \a msgarg. Without an arena the children
+ * become owned by \a msgarg and all referenced data is copied. Inside an arena
+ * scope, children carved from the arena are left unowned and string data has
+ * already been copied into the arena, so nothing needs to be stabilized.
+ */
+static void TakeArgs(ajn::MsgArg& msgarg,
+                     const ajn::MsgArg* args)
+{
+    MarshalArena* arena = MarshalArena::GetCurrent();
+
+    if (!arena) {
+        msgarg.SetOwnershipFlags(ajn::MsgArg::OwnsArgs);
+        msgarg.Stabilize();
+    } else if (!arena->Owns(args)) {
+        msgarg.SetOwnershipFlags(ajn::MsgArg::OwnsArgs);
+    }
+}
+
 QStatus MarshalArray(ajn::MsgArg& msgarg,
                      ajn::MsgArg* elements,
                      size_t numElements)
@@ -31,9 +78,12 @@ QStatus MarshalArray(ajn::MsgArg& msgarg,
     msgarg.typeId = ajn::ALLJOYN_ARRAY;
     status = msgarg.v_array.SetElements(elements[0].Signature().c_str(), numElements,
                                         numElements ? elements : NULL);
+    if (0 == numElements) {
+        // only used to determine the element signature
+        DeleteMsgArgs(elements);
+    }
     if (ER_OK == status) {
-        msgarg.SetOwnershipFlags(ajn::MsgArg::OwnsArgs);
-        msgarg.Stabilize();
+        TakeArgs(msgarg, elements);
     }
     return status;
 }
@@ -47,8 +97,7 @@ QStatus MarshalStruct(ajn::MsgArg& msgarg,
     msgarg.typeId = ajn::ALLJOYN_STRUCT;
     msgarg.v_struct.numMembers = numMembers;
     msgarg.v_struct.members = members;
-    msgarg.SetOwnershipFlags(ajn::MsgArg::OwnsArgs);
-    msgarg.Stabilize();
+    TakeArgs(msgarg, members);
     return status;
 }
 
@@ -57,12 +106,21 @@ QStatus MarshalDictEntry(ajn::MsgArg& msgarg,
                          ajn::MsgArg* val)
 {
     QStatus status = ER_OK;
-
+    MarshalArena* arena = MarshalArena::GetCurrent();
+
+    if (arena && (arena->Owns(key) != arena->Owns(val))) {
+        // mixed origin, move the arena allocated one to the heap so the
+        // entry can own both
+        if (arena->Owns(key)) {
+            key = new ajn::MsgArg(*key);
+        } else {
+            val = new ajn::MsgArg(*val);
+        }
+    }
     msgarg.typeId = ajn::ALLJOYN_DICT_ENTRY;
     msgarg.v_dictEntry.key = key;
     msgarg.v_dictEntry.val = val;
-    msgarg.SetOwnershipFlags(ajn::MsgArg::OwnsArgs);
-    msgarg.Stabilize();
+    TakeArgs(msgarg, key);
     return status;
 }
 
@@ -129,22 +187,32 @@ QStatus Marshal(ajn::MsgArg& msgarg, double data)
     return ER_OK;
 }
 
+/**
+ * Inside an arena scope the string is copied into the arena as the enclosing
+ * containers will not be stabilized.
+ */
+static const char* MarshalString(const qcc::String& data)
+{
+    MarshalArena* arena = MarshalArena::GetCurrent();
+    return arena ? arena->CopyString(data.c_str(), data.size()) : data.c_str();
+}
+
 QStatus Marshal(ajn::MsgArg& msgarg, const qcc::String& data)
 {
     msgarg.typeId = ajn::ALLJOYN_STRING;
-    msgarg.v_string.str = data.c_str();
+    msgarg.v_string.str = MarshalString(data);
     msgarg.v_string.len = msgarg.v_string.str ? strlen(msgarg.v_string.str) : 0;
     return ER_OK;
 }
 
 QStatus Marshal(ajn::MsgArg& msgarg, const Signature& data)
 {
-    return msgarg.Set("g", data.c_str());
+    return msgarg.Set("g", MarshalString(data));
 }
 
 QStatus Marshal(ajn::MsgArg& msgarg, const ObjectPath& data)
 {
-    return msgarg.Set("o", data.c_str());
+    return msgarg.Set("o", MarshalString(data));
 }
 
 QStatus Marshal(ajn::MsgArg& msgarg, const ajn::MsgArg& data)
@@ -0,0 +1,155 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <string.h>
+#include <new>
+
+#include <datadriven/MarshalArena.h>
+
+#include "common/ThreadLocal.h"
+
+/* MsgArgs contain 64-bit members, keep every allocation 16-byte aligned */
+#define ARENA_ALIGN(size) (((size) + 15) & ~((size_t)15))
+
+namespace datadriven {
+static DD_THREAD_LOCAL MarshalArena* currentArena = NULL;
+
+MarshalArena::Scope::Scope(MarshalArena* arena) :
+    previous(currentArena)
+{
+    currentArena = arena;
+}
+
+MarshalArena::Scope::Scope(MarshalArena& arena) :
+    previous(currentArena)
+{
+    currentArena = &arena;
+}
+
+MarshalArena::Scope::~Scope()
+{
+    currentArena = previous;
+}
+
+MarshalArena::MarshalArena(size_t chunkSize) :
+    used(0), heapAllocations(0)
+{
+    AddChunk(chunkSize);
+}
+
+MarshalArena::~MarshalArena()
+{
+    Reset();
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        delete[] chunks[i].data;
+    }
+}
+
+MarshalArena* MarshalArena::GetCurrent()
+{
+    return currentArena;
+}
+
+void MarshalArena::AddChunk(size_t minSize)
+{
+    Chunk chunk;
+
+    chunk.size = chunks.empty() ? ARENA_ALIGN(minSize) : chunks.back().size * 2;
+    if (chunk.size < minSize) {
+        chunk.size = ARENA_ALIGN(minSize);
+    }
+    chunk.data = new char[chunk.size];
+    heapAllocations++;
+    chunks.push_back(chunk);
+    used = 0;
+}
+
+void* MarshalArena::Allocate(size_t size)
+{
+    size = ARENA_ALIGN(size);
+    if (used + size > chunks.back().size) {
+        AddChunk(size);
+    }
+    void* ptr = chunks.back().data + used;
+    used += size;
+    return ptr;
+}
+
+ajn::MsgArg* MarshalArena::NewArgs(size_t numArgs)
+{
+    ajn::MsgArg* mem = static_cast<ajn::MsgArg*>(Allocate(numArgs * sizeof(ajn::MsgArg)));
+    for (size_t i = 0; i < numArgs; ++i) {
+        new (&mem[i])ajn::MsgArg();
+    }
+    if (args.size() == args.capacity()) {
+        heapAllocations++;
+    }
+    args.push_back(std::make_pair(mem, numArgs));
+    return mem;
+}
+
+const char* MarshalArena::CopyString(const char* str, size_t len)
+{
+    char* copy = static_cast<char*>(Allocate(len + 1));
+    if (len > 0) {
+        memcpy(copy, str, len);
+    }
+    copy[len] = '\0';
+    return copy;
+}
+
+bool MarshalArena::Owns(const void* ptr) const
+{
+    const char* p = static_cast<const char*>(ptr);
+
+    // most recent chunks are the biggest, search them first
+    for (size_t i = chunks.size(); i > 0; --i) {
+        const Chunk& chunk = chunks[i - 1];
+        if (p >= chunk.data && p < chunk.data + chunk.size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MarshalArena::Reset()
+{
+    // destruct in reverse order of construction
+    for (size_t i = args.size(); i > 0; --i) {
+        ajn::MsgArg* mem = args[i - 1].first;
+        for (size_t j = 0; j < args[i - 1].second; ++j) {
+            mem[j].~MsgArg();
+        }
+    }
+    args.clear();
+    // keep only the largest chunk so the next operation fits in one
+    if (chunks.size() > 1) {
+        Chunk largest = chunks.back();
+        chunks.pop_back();
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            delete[] chunks[i].data;
+        }
+        chunks.clear();
+        chunks.push_back(largest);
+    }
+    used = 0;
+}
+
+size_t MarshalArena::GetHeapAllocations() const
+{
+    return heapAllocations;
+}
+}
@@ -0,0 +1,245 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+
+#include <datadriven/MethodBatch.h>
+
+#include "MethodBatchState.h"
+#include "ObserverManager.h"
+#include "common/ThreadLocal.h"
+
+#include <qcc/Debug.h>
+#define QCC_MODULE "DD_CONSUMER"
+
+namespace datadriven {
+static DD_THREAD_LOCAL MethodBatchState* currentBatch = NULL;
+
+class BatchCompleteTask :
+    public ObserverManager::Task {
+  public:
+    BatchCompleteTask(MethodBatchListener* listener) :
+        listener(listener) { }
+
+    void Execute() const
+    {
+        listener->OnBatchComplete();
+    }
+
+  private:
+    MethodBatchListener* listener;
+};
+
+/* MethodBatchState */
+
+MethodBatchState::MethodBatchState(size_t window) :
+    window(window), size(0), next(0), inFlight(0), sent(false), pumping(false), finished(false),
+    listener(NULL), dispatch(MethodInvocationBase::DISPATCH_QUEUED)
+{
+}
+
+MethodBatchState::~MethodBatchState()
+{
+    for (size_t i = 0; i < calls.size(); i++) {
+        delete calls[i];
+    }
+}
+
+MethodBatchState* MethodBatchState::GetCurrent()
+{
+    return currentBatch;
+}
+
+void MethodBatchState::SetCurrent(MethodBatchState* state)
+{
+    currentBatch = state;
+}
+
+bool MethodBatchState::Add(const std::shared_ptr<MethodInvocationBase>& inv,
+                           const ajn::ProxyBusObject& proxy,
+                           const ajn::InterfaceDescription::Member& member,
+                           bool noReply,
+                           const ajn::MsgArg* args,
+                           size_t numArgs,
+                           uint32_t timeout)
+{
+    mutex.Lock();
+    bool queued = !sent;
+    if (queued) {
+        calls.push_back(new Call(inv, proxy, member, noReply, args, numArgs, timeout));
+        size++;
+        inv->batch = shared_from_this();
+    }
+    mutex.Unlock();
+    return queued;
+}
+
+QStatus MethodBatchState::Send(MethodBatchListener* listener,
+                               MethodInvocationBase::ReplyDispatch dispatch)
+{
+    mutex.Lock();
+    if (sent) {
+        mutex.Unlock();
+        return ER_FAIL;
+    }
+    sent = true;
+    this->listener = listener;
+    this->dispatch = dispatch;
+    mutex.Unlock();
+
+    Pump();
+    return ER_OK;
+}
+
+void MethodBatchState::Abandon()
+{
+    mutex.Lock();
+    if (sent) {
+        mutex.Unlock();
+        return;
+    }
+    sent = true;
+    finished = true;
+    std::vector<Call*> unsent;
+    unsent.swap(calls);
+    mutex.Unlock();
+
+    for (size_t i = 0; i < unsent.size(); i++) {
+        // not part of a running batch, complete it on its own
+        unsent[i]->inv->batch.reset();
+        unsent[i]->inv->SetReplyStatus(ER_FAIL);
+        delete unsent[i];
+    }
+    completion.Signal();
+}
+
+void MethodBatchState::Pump()
+{
+    // keep ourselves alive, the last call may complete while we are sending
+    std::shared_ptr<MethodBatchState> self = shared_from_this();
+    bool done = false;
+
+    mutex.Lock();
+    if (pumping) {
+        // the thread that is pumping will pick up our progress
+        mutex.Unlock();
+        return;
+    }
+    pumping = true;
+    while ((next < calls.size()) && ((0 == window) || (inFlight < window))) {
+        Call* call = calls[next];
+        calls[next++] = NULL;
+        inFlight++;
+        mutex.Unlock();
+
+        call->inv->Send(call->proxy, *call->member, call->noReply,
+                        call->args.empty() ? NULL : &call->args[0], call->args.size(), call->timeout);
+        delete call;
+
+        mutex.Lock();
+    }
+    pumping = false;
+    if ((next == calls.size()) && (0 == inFlight) && !finished) {
+        finished = true;
+        done = true;
+    }
+    mutex.Unlock();
+
+    if (done) {
+        Finish();
+    }
+}
+
+void MethodBatchState::OnCallDone()
+{
+    mutex.Lock();
+    inFlight--;
+    mutex.Unlock();
+    Pump();
+}
+
+void MethodBatchState::Finish()
+{
+    if (NULL != listener) {
+        std::shared_ptr<ObserverManager> mgr = ObserverManager::GetInstance();
+        if ((MethodInvocationBase::DISPATCH_INLINE == dispatch) || !mgr) {
+            listener->OnBatchComplete();
+        } else if (MethodInvocationBase::DISPATCH_EXECUTOR == dispatch) {
+            mgr->EnqueueReply(new BatchCompleteTask(listener));
+        } else {
+            mgr->Enqueue(new BatchCompleteTask(listener), ObserverManager::Lane::REPLY);
+        }
+    }
+    // last, a waiter may release the listener as soon as it returns
+    completion.Signal();
+}
+
+void MethodBatchState::Wait()
+{
+    mutex.Lock();
+    bool wait = sent;
+    mutex.Unlock();
+    if (wait) {
+        completion.Wait();
+    }
+}
+
+size_t MethodBatchState::GetSize() const
+{
+    mutex.Lock();
+    size_t n = size;
+    mutex.Unlock();
+    return n;
+}
+
+/* MethodBatch */
+
+MethodBatch::Scope::Scope(MethodBatch& batch) :
+    previous(MethodBatchState::GetCurrent())
+{
+    MethodBatchState::SetCurrent(batch.state.get());
+}
+
+MethodBatch::Scope::~Scope()
+{
+    MethodBatchState::SetCurrent(previous);
+}
+
+MethodBatch::MethodBatch(size_t window) :
+    state(std::make_shared<MethodBatchState>(window))
+{
+}
+
+MethodBatch::~MethodBatch()
+{
+    state->Abandon();
+}
+
+QStatus MethodBatch::Send(MethodBatchListener* listener,
+                          MethodInvocationBase::ReplyDispatch dispatch)
+{
+    return state->Send(listener, dispatch);
+}
+
+void MethodBatch::Wait()
+{
+    state->Wait();
+}
+
+size_t MethodBatch::GetSize() const
+{
+    return state->GetSize();
+}
+}
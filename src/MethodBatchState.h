@@ -0,0 +1,118 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+
+#ifndef METHODBATCHSTATE_H_
+#define METHODBATCHSTATE_H_
+
+#include <memory>
+#include <vector>
+
+#include <alljoyn/InterfaceDescription.h>
+#include <alljoyn/MsgArg.h>
+#include <alljoyn/ProxyBusObject.h>
+
+#include <datadriven/Completion.h>
+#include <datadriven/MethodBatch.h>
+#include <datadriven/Mutex.h>
+
+namespace datadriven {
+/**
+ * \private Shared state of a MethodBatch. Queued and in-flight invocations
+ * refer to it, so it outlives the MethodBatch until the last call completed.
+ */
+class MethodBatchState :
+    public std::enable_shared_from_this<MethodBatchState> {
+  public:
+    MethodBatchState(size_t window);
+
+    ~MethodBatchState();
+
+    /**
+     * Queue a call of \a inv. Its arguments are copied.
+     * \retval false if the batch was already sent, the caller must send the call itself
+     */
+    bool Add(const std::shared_ptr<MethodInvocationBase>& inv,
+             const ajn::ProxyBusObject& proxy,
+             const ajn::InterfaceDescription::Member& member,
+             bool noReply,
+             const ajn::MsgArg* args,
+             size_t numArgs,
+             uint32_t timeout);
+
+    /** Start sending the queued calls */
+    QStatus Send(MethodBatchListener* listener,
+                 MethodInvocationBase::ReplyDispatch dispatch);
+
+    /** Fail the calls that were not sent yet, used if the batch is never sent */
+    void Abandon();
+
+    /** Called by an invocation of this batch once it completed */
+    void OnCallDone();
+
+    void Wait();
+
+    size_t GetSize() const;
+
+    /** Get the batch that is active on the current thread, or NULL */
+    static MethodBatchState* GetCurrent();
+
+    /** Make \a state the active batch on the current thread */
+    static void SetCurrent(MethodBatchState* state);
+
+  private:
+    struct Call {
+        std::shared_ptr<MethodInvocationBase> inv;
+        ajn::ProxyBusObject proxy;
+        const ajn::InterfaceDescription::Member* member;
+        bool noReply;
+        std::vector<ajn::MsgArg> args;
+        uint32_t timeout;
+
+        Call(const std::shared_ptr<MethodInvocationBase>& inv,
+             const ajn::ProxyBusObject& proxy,
+             const ajn::InterfaceDescription::Member& member,
+             bool noReply,
+             const ajn::MsgArg* args,
+             size_t numArgs,
+             uint32_t timeout) :
+            inv(inv), proxy(proxy), member(&member), noReply(noReply),
+            args(args, args + numArgs), timeout(timeout) { }
+    };
+
+    /** Send queued calls as long as the window allows */
+    void Pump();
+
+    /** Signal waiters and notify the listener */
+    void Finish();
+
+    mutable datadriven::Mutex mutex;
+    const size_t window;
+    /** queued calls, a call is deleted (and its entry cleared) once sent */
+    std::vector<Call*> calls;
+    size_t size;
+    size_t next;
+    size_t inFlight;
+    bool sent;
+    bool pumping;
+    bool finished;
+    MethodBatchListener* listener;
+    MethodInvocationBase::ReplyDispatch dispatch;
+    Completion completion;
+};
+}
+
+#endif /* METHODBATCHSTATE_H_ */
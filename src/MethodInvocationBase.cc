@@ -14,9 +14,13 @@
  *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  ******************************************************************************/
 
+#include <datadriven/CallDeadline.h>
 #include <datadriven/MethodInvocationBase.h>
 #include <datadriven/Marshal.h>
 
+#include "DeadlineCall.h"
+#include "MethodBatchState.h"
+#include "PendingCalls.h"
 #include "RegisteredTypeDescription.h"
 #include "ObserverManager.h"
 
@@ -33,7 +37,7 @@ class MethodTask :
     void Execute() const
     {
         std::shared_ptr<MethodInvocationBase> invoc = inv.lock();
-        if (invoc) {
+        if (invoc && MethodInvocationBase::CANCELLED != invoc->GetState()) {
             invoc->HandleReply();
         }
     }
@@ -42,52 +46,146 @@ class MethodTask :
     std::weak_ptr<MethodInvocationBase> inv;
 };
 
+/**
+ * Stores a property value fetched from a remote object in its proxy, in
+ * order with the change notifications handled by the ObserverManager.
+ */
+class CachePropertyTask :
+    public ObserverManager::Task {
+  public:
+    CachePropertyTask(const ObjectId& objId,
+                      const qcc::String& ifName,
+                      const qcc::String& propName,
+                      const ajn::MsgArg& value) :
+        objId(objId), ifName(ifName), propName(propName), value(value) { }
+
+    void Execute() const
+    {
+        std::shared_ptr<ObserverManager> mgr = ObserverManager::GetInstance();
+        std::shared_ptr<ObserverCache> cache = mgr ? mgr->GetCache(ifName) : nullptr;
+        if (cache) {
+            std::shared_ptr<ProxyInterface> proxy = cache->GetObject(objId);
+            if (proxy) {
+                proxy->CacheProperty(propName.c_str(), value);
+            }
+        }
+    }
+
+  private:
+    ObjectId objId;
+    qcc::String ifName;
+    qcc::String propName;
+    ajn::MsgArg value;
+};
+
+/** Identifies the property to cache for an asynchronous get property call */
+class CachePropertyContext {
+  public:
+    ObjectId objId;
+    qcc::String ifName;
+    qcc::String propName;
+
+    CachePropertyContext(const ObjectId& objId, const qcc::String& ifName, const char* propName) :
+        objId(objId), ifName(ifName), propName(propName) { }
+};
+
+static std::atomic<MethodInvocationBase::ReplyDispatch> defaultReplyDispatch(MethodInvocationBase::DISPATCH_QUEUED);
+
+void MethodInvocationBase::SetDefaultReplyDispatch(ReplyDispatch dispatch)
+{
+    defaultReplyDispatch = dispatch;
+}
+
+MethodInvocationBase::ReplyDispatch MethodInvocationBase::GetDefaultReplyDispatch()
+{
+    return defaultReplyDispatch;
+}
+
 void MethodInvocationBase::ScheduleMethodReplyListener()
 {
+    if (DISPATCH_INLINE == replyDispatch) {
+        HandleReply();
+        return;
+    }
+
     std::shared_ptr<ObserverManager> mgr = ObserverManager::GetInstance();
     if (mgr) {
         MethodTask* task = new MethodTask(weak_this);
-        mgr->Enqueue(task);
+        if (DISPATCH_EXECUTOR == replyDispatch) {
+            mgr->EnqueueReply(task);
+        } else {
+            mgr->Enqueue(task, ObserverManager::Lane::REPLY);
+        }
+    }
+}
+
+void MethodInvocationBase::ListenerAttached()
+{
+    // whoever comes second, the listener or the reply, schedules the listener
+    if ((listenerFlags.fetch_or(LISTENER_SET) & REPLY_DONE) && CANCELLED != state.load()) {
+        ScheduleMethodReplyListener();
     }
 }
 
 MethodInvocationBase::MethodInvocationBase() :
     state(WAITING),
-    shared_this(nullptr),
-    sem(new Semaphore())
+    replyDispatch(DISPATCH_QUEUED),
+    callId(0),
+    cacheContext(NULL),
+    listenerFlags(0)
 {
 }
 
 MethodInvocationBase::~MethodInvocationBase()
 {
-    if (nullptr != sem) {
-        // Note: We cannot cancel started async method calls in Alljoyn, so we can
-        //       still get OnReplyMessage calls during destruction of MethodInvocationBase.
-        //       Putting the semaphore to null before deleting it reduces the chance of
-        //       getting core dumps when Alljoyn calls back to this object.
-        //       But there is still a race condition here, in which a reply message is using
-        //       the sem member variable while we are deleting it.
-        Semaphore* tmp = sem;
-        sem = nullptr;
-        delete tmp;
-    }
+    // Note: PendingCalls keeps the invocation alive while AllJoyn can still
+    //       call back for it, so no reply handler can be running at this point.
+    delete cacheContext;
     weak_this.reset();
 }
 
 MethodInvocationBase::MethodInvocationBase(MethodInvocationBase&& inv) :
-    state(std::move(inv.state))
+    state(inv.state.load()),
+    replyDispatch(inv.replyDispatch),
+    callId(0),
+    cacheContext(inv.cacheContext),
+    listenerFlags(inv.listenerFlags.load())
 {
-    // move semaphore ownership
-    sem = inv.sem;
-    inv.sem = nullptr;
+    inv.cacheContext = NULL;
+    if (inv.completion.IsSignaled()) {
+        completion.Signal();
+    }
 }
 
 void MethodInvocationBase::SetRefCountedPtr(std::shared_ptr<MethodInvocationBase> inv)
 {
-    shared_this = inv;
     weak_this = inv;
 }
 
+void MethodInvocationBase::SetUserHandle(std::shared_ptr<MethodInvocationBase> handle)
+{
+    userHandle = handle;
+}
+
+size_t MethodInvocationBase::GetPendingCount()
+{
+    return PendingCalls::GetInstance().GetCount();
+}
+
+uintptr_t MethodInvocationBase::AddPending()
+{
+    std::shared_ptr<MethodInvocationBase> self = weak_this.lock();
+    uintptr_t id = self ? PendingCalls::GetInstance().Add(self) : 0;
+    callId = id;
+    return id;
+}
+
+bool MethodInvocationBase::RemovePending(uintptr_t id)
+{
+    callId = 0;
+    return nullptr != PendingCalls::GetInstance().Remove(id);
+}
+
 MethodInvocationBase::InvState MethodInvocationBase::GetState() const
 {
     return state;
@@ -95,27 +193,52 @@ MethodInvocationBase::InvState MethodInvocationBase::GetState() const
 
 void MethodInvocationBase::WaitForReply()
 {
-    if (WAITING == state) {
-        if (nullptr == sem) {
-            SetReplyStatus(ER_FAIL);
-        } else {
-            sem->Wait();
-        }
+    if (WAITING == state.load()) {
+        completion.Wait();
     }
 }
 
 void MethodInvocationBase::SetReplyStatus(const QStatus status)
 {
-    GetConsumerMethodReply().SetStatus(status);
-    state = READY;
-    shared_this = nullptr;
+    callId = 0;
+    if (CANCELLED != state.load()) {
+        GetConsumerMethodReply().SetStatus(status);
+    }
+    InvState expected = WAITING;
+    state.compare_exchange_strong(expected, READY);
+    completion.Signal();
+
+    unsigned int flags = listenerFlags.fetch_or(REPLY_DONE);
+    if (LISTENER_SET == flags && CANCELLED != state.load()) {
+        ScheduleMethodReplyListener();
+    }
+
+    std::shared_ptr<MethodBatchState> done;
+    done.swap(batch);
+    if (done) {
+        done->OnCallDone();
+    }
 }
 
 void MethodInvocationBase::Cancel()
 {
-    GetConsumerMethodReply().SetStatus(ER_FAIL);
-    state = CANCELLED;
-    weak_this.reset();
+    uintptr_t id = callId.exchange(0);
+    std::shared_ptr<MethodInvocationBase> pending = id ? PendingCalls::GetInstance().Remove(id) : nullptr;
+
+    // a call made under a deadline may also be waiting to be sent again
+    bool inProgress = pending || (deadlineCall && deadlineCall->Cancel());
+
+    if (inProgress) {
+        // we got the call out of the registry, so the reply handler never will
+        GetConsumerMethodReply().SetStatus(ER_FAIL);
+        state = CANCELLED;
+        SetReplyStatus(ER_FAIL);
+    } else if ((0 == id) && !deadlineCall) {
+        // not sent yet, e.g. still queued on a batch: Send sees the state and fails the call
+        InvState expected = WAITING;
+        state.compare_exchange_strong(expected, CANCELLED);
+    }
+    // otherwise the reply handler owns the call, or it completed: leave its outcome alone
 }
 
 void MethodInvocationBase::Exec(const ProxyInterface& intf,
@@ -124,40 +247,113 @@ void MethodInvocationBase::Exec(const ProxyInterface& intf,
                                 size_t numArgs,
                                 uint32_t timeout)
 {
-    QStatus status;
-    qcc::String noReply = "";
-
-    if (intf.IsAlive()) {
-        MessageReceiver::ReplyHandler handler =
-            static_cast<MessageReceiver::ReplyHandler>(&MethodInvocationBase::OnReplyMessage);
-        const ajn::InterfaceDescription::Member& member = intf.GetTypeDescription().GetMember(memberNumber);
-        member.GetAnnotation(ajn::org::freedesktop::DBus::AnnotateNoReply, noReply);
+    const CallDeadline* deadline = CallDeadline::GetCurrent();
+    if (nullptr != deadline) {
+        uint32_t remaining = deadline->GetRemaining();
+        if (0 == remaining) {
+            QStatus status = ER_TIMEOUT;
+            QCC_LogError(status, ("Deadline passed, not calling method"));
+            SetReplyStatus(status);
+            return;
+        }
+        if (remaining < timeout) {
+            timeout = remaining;
+        }
+    }
 
-        if (noReply == "true") {
-            status = intf.GetProxyBusObject().MethodCall(member, msgarg, numArgs);
-        } else {
-            status = intf.GetProxyBusObject().MethodCallAsync(member, this, handler, msgarg, numArgs, NULL, timeout);
+    const RegisteredTypeDescription& desc = intf.GetTypeDescription();
+    bool noReply = desc.IsNoReply(memberNumber);
+    MethodBatchState* current = MethodBatchState::GetCurrent();
+    bool alive = intf.IsAlive();
+
+    // batched calls are sent by the batch, so the deadline only bounds their timeout
+    if ((nullptr != deadline) && (nullptr == current) && !noReply && (alive || deadline->GetFailover())) {
+        std::shared_ptr<MethodInvocationBase> self = weak_this.lock();
+        if (nullptr == self) {
+            QStatus status = ER_FAIL;
+            QCC_LogError(status, ("Invocation is not referenced, not calling method"));
+            SetReplyStatus(status);
+            return;
+        }
+        deadlineCall = std::make_shared<DeadlineCall>(*deadline, desc.GetDescription().GetName(), intf.GetObjectId(),
+                                                      memberNumber, msgarg, numArgs, timeout);
+        deadlineCall->Start(self, intf);
+    } else if (alive) {
+        const ajn::InterfaceDescription::Member& member = desc.GetMember(memberNumber);
+        std::shared_ptr<MethodInvocationBase> self = current ? weak_this.lock() : nullptr;
+
+        if ((nullptr == self) ||
+            !current->Add(self, intf.GetProxyBusObject(), member, noReply, msgarg, numArgs, timeout)) {
+            Send(intf.GetProxyBusObject(), member, noReply, msgarg, numArgs, timeout);
         }
     } else {
-        status = ER_FAIL;   /* Is there a more suitable error ? */
+        QStatus status = ER_FAIL;   /* Is there a more suitable error ? */
         QCC_LogError(status, ("Cannot call method on dead object"));
+        SetReplyStatus(status);
+    }
+}
+
+QStatus MethodInvocationBase::SendAttempt(const ProxyInterface& intf,
+                                          int memberNumber,
+                                          const ajn::MsgArg* msgarg,
+                                          size_t numArgs,
+                                          uintptr_t id,
+                                          uint32_t timeout)
+{
+    const ajn::InterfaceDescription::Member& member = intf.GetTypeDescription().GetMember(memberNumber);
+    PendingCalls& pending = PendingCalls::GetInstance();
+    ajn::MessageReceiver::ReplyHandler handler =
+        static_cast<ajn::MessageReceiver::ReplyHandler>(&PendingCalls::OnReplyMessage);
+    return intf.GetProxyBusObject().MethodCallAsync(member, &pending, handler, msgarg, numArgs,
+                                                    reinterpret_cast<void*>(id), timeout);
+}
+
+void MethodInvocationBase::Send(const ajn::ProxyBusObject& proxy,
+                                const ajn::InterfaceDescription::Member& member,
+                                bool noReply,
+                                const ajn::MsgArg* msgarg,
+                                size_t numArgs,
+                                uint32_t timeout)
+{
+    QStatus status;
+    uintptr_t id = 0;
+
+    if (CANCELLED == state.load()) {
+        // cancelled while queued on a batch, do not bother the remote side
+        status = ER_FAIL;
+        GetConsumerMethodReply().SetStatus(status);
+    } else if (noReply) {
+        status = proxy.MethodCall(member, msgarg, numArgs);
+    } else if (0 != (id = AddPending())) {
+        PendingCalls& pending = PendingCalls::GetInstance();
+        ajn::MessageReceiver::ReplyHandler handler =
+            static_cast<ajn::MessageReceiver::ReplyHandler>(&PendingCalls::OnReplyMessage);
+        status = proxy.MethodCallAsync(member, &pending, handler, msgarg, numArgs,
+                                       reinterpret_cast<void*>(id), timeout);
+        if ((ER_OK != status) && !RemovePending(id)) {
+            return; // cancelled meanwhile, already complete
+        }
+    } else {
+        status = ER_FAIL;
+        QCC_LogError(status, ("Invocation is not referenced, not calling method"));
     }
     if (ER_OK != status) {
         SetReplyStatus(status);
-    } else if (noReply == "true") {
+    } else if (noReply) {
         // always mark a fire-and-forget call as successfully completed if no error occurred while firing
         SetReplyStatus(ER_OK);
     }
 }
 
-void MethodInvocationBase::OnReplyMessage(ajn::Message& message, void* context)
+void MethodInvocationBase::OnReplyMessage(ajn::Message& message, uintptr_t id)
 {
     QStatus status = ER_OK;
     qcc::String errorName;
     qcc::String errorDescription;
+    bool isReply = false;
 
-    if (shared_this.use_count() > 1) {
-        // we are not the only ones referring to this invocation
+    if (!userHandle.expired() && CANCELLED != state.load()) {
+        // the application still refers to this invocation
 
         // Check if this message is an error message and set the appropriate error variables
         if (ajn::MESSAGE_ERROR == message->GetType()) {
@@ -196,7 +392,13 @@ void MethodInvocationBase::OnReplyMessage(ajn::Message& message, void* context)
              * NOTE: there is a special case. When a MethodReply is sent with ER_OK QStatus code
              * we end up here and treat it like a succeeded MethodReply
              */
+            isReply = true;
+        }
 
+        if ((nullptr != deadlineCall) && !deadlineCall->OnResult(id, status)) {
+            return; // answered by another attempt, or sent again
+        }
+        if (isReply) {
             const ajn::MsgArg* msgarg;
             size_t numArgs;
 
@@ -207,15 +409,8 @@ void MethodInvocationBase::OnReplyMessage(ajn::Message& message, void* context)
         }
         GetConsumerMethodReply().SetErrorName(errorName);
         GetConsumerMethodReply().SetErrorDescription(errorDescription);
-        if (shared_this->HasListener() && state != CANCELLED) {
-            ScheduleMethodReplyListener();
-        }
         SetReplyStatus(status);
-
-        if (nullptr != sem) {
-            sem->Post();
-        }
-    } else {
+    } else if ((nullptr == deadlineCall) || deadlineCall->OnResult(id, ER_FAIL)) {
         SetReplyStatus(ER_FAIL); // no-one listening anymore
     }
 }
@@ -231,15 +426,37 @@ void MethodInvocationBase::GetProperty(const ProxyInterface& intf,
                                        uint32_t timeout)
 {
     QStatus status;
+    ajn::MsgArg cached;
 
-    if (intf.IsAlive()) {
-        const char* ifName = intf.GetTypeDescription().GetDescription().GetName().c_str();
+    if (intf.IsAlive() && intf.GetCachedProperty(propName, cached)) {
+        // not invalidated since it was last fetched, no need to go remote
+        status = GetConsumerMethodReply().Unmarshal(&cached, 1);
+        if (ER_OK != status) {
+            QCC_LogError(status, ("Failed to unmarshal cached property data"));
+        }
+        SetReplyStatus(status);
+    } else if (intf.IsAlive()) {
+        const qcc::String& ifName = intf.GetTypeDescription().GetDescription().GetName();
         // remove const from ProxyBusObject because GetPropertyAsync() is
         // non-const although it calls the const MethodCall()
         ajn::ProxyBusObject& proxy = const_cast<ajn::ProxyBusObject&>(intf.GetProxyBusObject());
+        PendingCalls& pending = PendingCalls::GetInstance();
         ajn::ProxyBusObject::Listener::GetPropertyCB cb =
-            static_cast<ajn::ProxyBusObject::Listener::GetPropertyCB>(&MethodInvocationBase::OnGetProperty);
-        status = proxy.GetPropertyAsync(ifName, propName, this, cb, NULL, timeout);
+            static_cast<ajn::ProxyBusObject::Listener::GetPropertyCB>(&PendingCalls::OnGetProperty);
+        // stale properties are cached again once fetched
+        if (intf.IsStale(propName)) {
+            cacheContext = new CachePropertyContext(intf.GetObjectId(), ifName, propName);
+        }
+        uintptr_t id = AddPending();
+        if (0 == id) {
+            status = ER_FAIL;
+            QCC_LogError(status, ("Invocation is not referenced, not getting property"));
+        } else {
+            status = proxy.GetPropertyAsync(ifName.c_str(), propName, &pending, cb, reinterpret_cast<void*>(id), timeout);
+            if ((ER_OK != status) && !RemovePending(id)) {
+                return; // cancelled meanwhile, already complete
+            }
+        }
     } else {
         status = ER_FAIL;   /* Is there a more suitable error ? */
         QCC_LogError(status, ("Cannot get property from dead object"));
@@ -250,21 +467,24 @@ void MethodInvocationBase::GetProperty(const ProxyInterface& intf,
 }
 
 void MethodInvocationBase::OnGetProperty(QStatus status,
-                                         ajn::ProxyBusObject* obj,
-                                         const ajn::MsgArg& value,
-                                         void* context)
+                                         const ajn::MsgArg& value)
 {
     if (ER_OK == status) {
         const ajn::MsgArg& msgarg = datadriven::MsgArgDereference(value);
+        if (nullptr != cacheContext) {
+            std::shared_ptr<ObserverManager> mgr = ObserverManager::GetInstance();
+            if (mgr) {
+                mgr->Enqueue(new CachePropertyTask(cacheContext->objId, cacheContext->ifName,
+                                                   cacheContext->propName, msgarg),
+                             ObserverManager::Lane::UPDATE);
+            }
+        }
         status = GetConsumerMethodReply().Unmarshal(&msgarg, 1);
         if (ER_OK != status) {
             QCC_LogError(status, ("Failed to unmarshal get property data"));
         }
     }
     SetReplyStatus(status);
-    if (nullptr != sem) {
-        sem->Post();
-    }
 }
 
 /** \private
@@ -286,9 +506,20 @@ void MethodInvocationBase::SetProperty(const ProxyInterface& intf,
         // remove const from ProxyBusObject because SetPropertyAsync() is
         // non-const although it calls the const MethodCall()
         ajn::ProxyBusObject& proxy = const_cast<ajn::ProxyBusObject&>(intf.GetProxyBusObject());
+        PendingCalls& pending = PendingCalls::GetInstance();
         ajn::ProxyBusObject::Listener::SetPropertyCB cb =
-            static_cast<ajn::ProxyBusObject::Listener::SetPropertyCB>(&MethodInvocationBase::OnSetProperty);
-        status = proxy.SetPropertyAsync(ifName, propName, propValue, this, cb, NULL, timeout);
+            static_cast<ajn::ProxyBusObject::Listener::SetPropertyCB>(&PendingCalls::OnSetProperty);
+        uintptr_t id = AddPending();
+        if (0 == id) {
+            status = ER_FAIL;
+            QCC_LogError(status, ("Invocation is not referenced, not setting property"));
+        } else {
+            status = proxy.SetPropertyAsync(ifName, propName, propValue, &pending, cb, reinterpret_cast<void*>(id),
+                                            timeout);
+            if ((ER_OK != status) && !RemovePending(id)) {
+                return; // cancelled meanwhile, already complete
+            }
+        }
     } else {
         status = ER_FAIL;   /* Is there a more suitable error ? */
         QCC_LogError(status, ("Cannot set property on dead object"));
@@ -297,14 +528,4 @@ void MethodInvocationBase::SetProperty(const ProxyInterface& intf,
         SetReplyStatus(status);
     }
 }
-
-void MethodInvocationBase::OnSetProperty(QStatus status,
-                                         ajn::ProxyBusObject* obj,
-                                         void* context)
-{
-    SetReplyStatus(status);
-    if (nullptr != sem) {
-        sem->Post();
-    }
-}
 }
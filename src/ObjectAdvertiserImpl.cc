@@ -24,6 +24,9 @@
 #include <qcc/Debug.h>
 #define QCC_MODULE "DD_PROVIDER"
 
+/** Maximum number of method calls waiting for their handler, further calls are refused */
+#define PROVIDER_QUEUE_CAPACITY 4096
+
 using namespace ajn;
 using namespace datadriven;
 using namespace qcc;
@@ -82,19 +85,24 @@ ObjectAdvertiserImpl::ObjectAdvertiserImpl(BusAttachment* bus,
             QCC_LogError(errorStatus, ("Failed to bind session port"));
             break;
         }
+        // calls are enqueued on the bus dispatch thread, which must never wait: when the
+        // handlers fall behind, further calls are refused (see ProvidedObjectImpl::CallMethodHandler)
+        providerAsync.SetCapacity(PROVIDER_QUEUE_CAPACITY, AsyncTaskQueue::OVERFLOW_DROP);
         providerAsync.AsyncTaskQueue::Start();
         errorStatus = ER_OK;
     } while (0);
+    Metrics::AddSource(this);
 }
 
 ObjectAdvertiserImpl::~ObjectAdvertiserImpl()
 {
+    Metrics::RemoveSource(this);
     providerAsync.Stop();
 
     SessionPort sp = DATADRIVEN_SERVICE_PORT;
 
     // We use lock here in case an asynchronous task was started before we stopped the queue
-    providersMutex.Lock();
+    providersMutex.Lock(MUTEX_CONTEXT);
     // Remove providers and related busObjects and cached data
     std::set<std::weak_ptr<ProvidedObjectImpl> >::const_iterator objIt = providers.begin();
     std::set<std::weak_ptr<ProvidedObjectImpl> >::const_iterator objIt_end = providers.end();
@@ -115,7 +123,7 @@ ObjectAdvertiserImpl::~ObjectAdvertiserImpl()
     busConnection->GetBusAttachment().UnbindSessionPort(sp);
 
     providers.clear();
-    providersMutex.Unlock();
+    providersMutex.Unlock(MUTEX_CONTEXT);
 }
 
 ajn::BusAttachment& ObjectAdvertiserImpl::GetBusAttachment() const
@@ -134,7 +142,7 @@ QStatus ObjectAdvertiserImpl::AddProvidedObject(std::weak_ptr<ProvidedObjectImpl
 
     std::shared_ptr<ProvidedObjectImpl> shobj = object.lock();
     if (shobj) {
-        providersMutex.Lock();
+        providersMutex.Lock(MUTEX_CONTEXT);
         std::set<std::weak_ptr<ProvidedObjectImpl> >::iterator objIt = providers.find(object);
         if (objIt == providers.end()) {
             result = AdvertiseBusObject(shobj);
@@ -144,7 +152,7 @@ QStatus ObjectAdvertiserImpl::AddProvidedObject(std::weak_ptr<ProvidedObjectImpl
                 QCC_LogError(result, ("Could not advertise object on the bus"));
             }
         }
-        providersMutex.Unlock();
+        providersMutex.Unlock(MUTEX_CONTEXT);
     }
     return result;
 }
@@ -153,7 +161,7 @@ void ObjectAdvertiserImpl::RemoveProvidedObject(std::weak_ptr<ProvidedObjectImpl
 {
     std::shared_ptr<ProvidedObjectImpl> shobj = object.lock();
     if (shobj) {
-        providersMutex.Lock();
+        providersMutex.Lock(MUTEX_CONTEXT);
         std::set<std::weak_ptr<ProvidedObjectImpl> >::iterator objIt = providers.find(object);
         if (objIt != providers.end()) {
             QStatus result = UnadvertiseBusObject(shobj);
@@ -162,7 +170,7 @@ void ObjectAdvertiserImpl::RemoveProvidedObject(std::weak_ptr<ProvidedObjectImpl
             }
             providers.erase(objIt);
         }
-        providersMutex.Unlock();
+        providersMutex.Unlock(MUTEX_CONTEXT);
     }
 }
 
@@ -172,17 +180,27 @@ void ObjectAdvertiserImpl::CallMethodHandler(std::weak_ptr<ProvidedObjectImpl> o
                                              const ajn::InterfaceDescription::Member* member,
                                              ajn::Message& message)
 {
-    providersMutex.Lock();
+    providersMutex.Lock(MUTEX_CONTEXT);
     std::set<std::weak_ptr<ProvidedObjectImpl> >::iterator objIt = providers.find(object);
     if (objIt != providers.end()) {
         (ctx->*handler)(member, const_cast<ajn::Message&>(message));
     }
-    providersMutex.Unlock();
+    providersMutex.Unlock(MUTEX_CONTEXT);
+}
+
+bool ObjectAdvertiserImpl::ProviderAsyncEnqueue(const Task* task)
+{
+    return providerAsync.Enqueue(task);
+}
+
+AsyncTaskQueue::Stats ObjectAdvertiserImpl::GetQueueStats() const
+{
+    return providerAsync.GetStats();
 }
 
-void ObjectAdvertiserImpl::ProviderAsyncEnqueue(const Task* task)
+void ObjectAdvertiserImpl::CollectMetrics(Metrics::Snapshot& snapshot) const
 {
-    providerAsync.Enqueue(task);
+    providerAsync.CollectMetrics("provider", snapshot);
 }
 
 QStatus ObjectAdvertiserImpl::AdvertiseBusObject(std::shared_ptr<BusObject> busObject)
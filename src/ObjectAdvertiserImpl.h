@@ -23,6 +23,7 @@
 #include <vector>
 
 #include <qcc/String.h>
+#include <datadriven/Metrics.h>
 #include <datadriven/Mutex.h>
 #include <datadriven/ObjectAdvertiser.h>
 
@@ -49,7 +50,7 @@ class ProvidedObjectImpl;
  * - unregister them from the Bus and hide them again from About.
  */
 class ObjectAdvertiserImpl :
-    private AsyncTask, ajn::SessionPortListener {
+    private AsyncTask, ajn::SessionPortListener, private Metrics::Source {
   public:
     ObjectAdvertiserImpl(ajn::BusAttachment* bus,
                          ajn::AboutData* aboutData = nullptr,
@@ -76,7 +77,22 @@ class ObjectAdvertiserImpl :
         virtual void Execute() const = 0;
     };
 
-    void ProviderAsyncEnqueue(const Task* bctd);
+    /**
+     * Queue \a bctd for the provider thread.
+     *
+     * \return false if the queue is full and the task was dropped
+     */
+    bool ProviderAsyncEnqueue(const Task* bctd);
+
+    /**
+     * Statistics of the queue of method calls waiting for their handler.
+     */
+    AsyncTaskQueue::Stats GetQueueStats() const;
+
+    /**
+     * Add the queue of method calls to a metrics snapshot.
+     */
+    void CollectMetrics(Metrics::Snapshot& snapshot) const;
 
     QStatus GetStatus() const;
 
@@ -15,29 +15,98 @@
  ******************************************************************************/
 
 #include <algorithm>
+#include <map>
+#include <set>
 
 #include <datadriven/ObserverBase.h>
 #include <datadriven/SignalListener.h>
+#include <datadriven/UpdateTracer.h>
 #include "RegisteredTypeDescription.h"
 
 #include "BusConnectionImpl.h"
 #include "ObserverManager.h"
+#include "SignalHub.h"
 
 #include <qcc/Debug.h>
 #define QCC_MODULE "DD_CONSUMER"
 
 namespace datadriven {
+/**
+ * Merge the property changes of a later PropertiesChanged signal into those
+ * of an earlier one: later values win, and a property ends up either
+ * changed or invalidated, whichever happened last.
+ */
+static void MergeProperties(ajn::MsgArg& changed,
+                            ajn::MsgArg& invalidated,
+                            const ajn::MsgArg& nextChanged,
+                            const ajn::MsgArg& nextInvalidated)
+{
+    std::map<qcc::String, ajn::MsgArg*> values;
+    std::set<qcc::String> invalid;
+    const ajn::MsgArg* changedArgs[] = { &changed, &nextChanged };
+    const ajn::MsgArg* invalidatedArgs[] = { &invalidated, &nextInvalidated };
+
+    for (int i = 0; i < 2; i++) {
+        size_t num = 0;
+        ajn::MsgArg* entries = NULL;
+        if (ER_OK == changedArgs[i]->Get("a{sv}", &num, &entries)) {
+            for (size_t j = 0; j < num; j++) {
+                const char* name;
+                ajn::MsgArg* value;
+                if (ER_OK == entries[j].Get("{sv}", &name, &value)) {
+                    values[name] = value;
+                    invalid.erase(name);
+                }
+            }
+        }
+        num = 0;
+        entries = NULL;
+        if (ER_OK == invalidatedArgs[i]->Get("as", &num, &entries)) {
+            for (size_t j = 0; j < num; j++) {
+                const char* name;
+                if (ER_OK == entries[j].Get("s", &name)) {
+                    invalid.insert(name);
+                    values.erase(name);
+                }
+            }
+        }
+    }
+
+    // the merged args refer to the originals until they are stabilized
+    std::vector<ajn::MsgArg> entries(values.size());
+    size_t i = 0;
+    for (std::map<qcc::String, ajn::MsgArg*>::const_iterator it = values.begin(); it != values.end(); ++it, ++i) {
+        entries[i].Set("{sv}", it->first.c_str(), it->second);
+    }
+    std::vector<const char*> names;
+    for (std::set<qcc::String>::const_iterator it = invalid.begin(); it != invalid.end(); ++it) {
+        names.push_back(it->c_str());
+    }
+    ajn::MsgArg mergedChanged;
+    ajn::MsgArg mergedInvalidated;
+    mergedChanged.Set("a{sv}", entries.size(), entries.empty() ? NULL : &entries[0]);
+    mergedChanged.Stabilize();
+    mergedInvalidated.Set("as", names.size(), names.empty() ? NULL : &names[0]);
+    mergedInvalidated.Stabilize();
+    changed = mergedChanged;
+    invalidated = mergedInvalidated;
+}
+
 class ObserverBase::ObserverTask :
     public ObserverManager::Task {
   public:
     ObserverTask(std::weak_ptr<ObserverBase> _observer,
                  const ObjectId& objId,
                  const ajn::MsgArg& changedProps,
-                 const ajn::MsgArg& invalidatedProps) :
+                 const ajn::MsgArg& invalidatedProps,
+                 uint64_t trace,
+                 uint64_t key) :
         observerBase(_observer),
         id(objId),
         changedProps(changedProps),
-        invalidatedProps(invalidatedProps)
+        invalidatedProps(invalidatedProps),
+        trace(trace),
+        key(key)
     { }
 
     virtual ~ObserverTask()
@@ -45,17 +114,50 @@ class ObserverBase::ObserverTask :
 
     void Execute() const
     {
+        UpdateTracer::Record(trace, UpdateTracer::DEQUEUED);
         std::shared_ptr<ObserverBase> obs = observerBase.lock();
         if (obs) {
+            // the cache stamps the remaining stages of the trace
+            UpdateTracer::SetCurrent(trace);
             obs->UpdateObject(id, &changedProps, &invalidatedProps);
+            UpdateTracer::SetCurrent(0);
         }
     }
 
+    bool Coalesce(const ObserverManager::Task& next)
+    {
+        const ObserverTask* task = dynamic_cast<const ObserverTask*>(&next);
+        if ((nullptr == task) ||
+            observerBase.owner_before(task->observerBase) || task->observerBase.owner_before(observerBase) ||
+            (id.GetBusObjectPath() != task->id.GetBusObjectPath()) || (id.GetBusName() != task->id.GetBusName())) {
+            return false;
+        }
+        // merging would apply the invalidations ahead of property values fetched
+        // in the meantime (queued behind this task), and those would then be
+        // cached as valid
+        if ((ajn::ALLJOYN_ARRAY == task->invalidatedProps.typeId) &&
+            (0 != task->invalidatedProps.v_array.GetNumElements())) {
+            return false;
+        }
+        MergeProperties(changedProps, invalidatedProps, task->changedProps, task->invalidatedProps);
+        UpdateTracer::Merge(task->trace, trace);
+        return true;
+    }
+
+    bool CoalesceKey(uint64_t& key) const
+    {
+        key = this->key;
+        return true;
+    }
+
   private:
     std::weak_ptr<ObserverBase> observerBase;
     ObjectId id;
     ajn::MsgArg changedProps;
     ajn::MsgArg invalidatedProps;
+    uint64_t trace;
+    /** the object and the observer, see Coalesce */
+    uint64_t key;
 };
 
 ObserverBase::ObserverBase(const TypeDescription& typeDesc,
@@ -86,15 +188,14 @@ ObserverBase::~ObserverBase()
     // observer for the related proxy interface
     observerMgr->UnregisterObserver(observerBase, ifName);
     // clean out any signal handlers
-    signalListenersMutex.Lock();
-    for (SignalListenerMap::const_iterator it = signalListeners.begin();
-         it != signalListeners.end(); it++) {
-        SignalListenerBase* listener = it->second;
-        busConnectionImpl->GetBusAttachment().UnregisterSignalHandler(static_cast<ajn::MessageReceiver*>(listener),
-                                                                      listener->GetHandler(), listener->GetMember(),
-                                                                      NULL);
+    ajn::BusAttachment& bus = busConnectionImpl->GetBusAttachment();
+    signalHubsMutex.Lock();
+    for (SignalHubMap::const_iterator it = signalHubs.begin(); it != signalHubs.end(); it++) {
+        bus.UnregisterSignalHandler(static_cast<ajn::MessageReceiver*>(it->second.get()),
+                                    SignalHub::GetHandler(), it->first, NULL);
     }
-    signalListenersMutex.Unlock();
+    signalHubs.clear();
+    signalHubsMutex.Unlock();
 }
 
 QStatus ObserverBase::SetRefCountedPtr(std::weak_ptr<ObserverBase> observer)
@@ -102,6 +203,9 @@ QStatus ObserverBase::SetRefCountedPtr(std::weak_ptr<ObserverBase> observer)
     observerBase = observer;
     qcc::String ifName = registeredTypeDesc->GetDescription().GetName();
     status = observerMgr->RegisterObserver(observerBase, ifName);
+    if (ER_OK == status) {
+        cache = observerMgr->GetCache(ifName);
+    }
     return status;
 }
 
@@ -114,52 +218,60 @@ size_t ObserverBase::Size()
 QStatus ObserverBase::AddSignalListener(SignalListenerBase* listener,
                                         int memberNumber)
 {
-    signalListenersMutex.Lock();
+    QStatus result = ER_OK;
+
+    signalHubsMutex.Lock();
     const ajn::InterfaceDescription::Member* member = &registeredTypeDesc->GetMember(memberNumber);
     listener->SetObserver(observerBase);
     listener->SetMember(member);
-    SignalListenerMap::iterator it = signalListeners.find(member);
-    if (it == signalListeners.end()) {
-        // Register with Bus Attachment
+    SignalHubMap::iterator it = signalHubs.find(member);
+    if (it == signalHubs.end()) {
+        // first listener for this signal: register a hub with the Bus Attachment
+        std::shared_ptr<SignalHub> hub = std::make_shared<SignalHub>(observerBase, member);
         ajn::BusAttachment& bus = busConnectionImpl->GetBusAttachment();
-        status = bus.RegisterSignalHandler(static_cast<ajn::MessageReceiver*>(listener),
-                                           listener->GetHandler(), member, NULL);
-        if (ER_OK == status) {
-            // Add the new listener to the map
-            signalListeners[member] = listener;
+        result = bus.RegisterSignalHandler(static_cast<ajn::MessageReceiver*>(hub.get()),
+                                           SignalHub::GetHandler(), member, NULL);
+        if (ER_OK == result) {
+            it = signalHubs.insert(std::make_pair(member, hub)).first;
+        } else {
+            QCC_LogError(result, ("Failed to register signal handler"));
         }
     }
-    signalListenersMutex.Unlock();
-    return status;
+    if (ER_OK == result) {
+        it->second->Add(listener);
+    }
+    signalHubsMutex.Unlock();
+    return result;
 }
 
 QStatus ObserverBase::RemoveSignalListener(SignalListenerBase* listener)
 {
-    signalListenersMutex.Lock();
-    SignalListenerMap::iterator it = signalListeners.find(listener->GetMember());
-    if (it != signalListeners.end()) {
-        if (listener == it->second) {
-            // Unregister from Bus Attachment
-            ajn::BusAttachment& bus = busConnectionImpl->GetBusAttachment();
-            status = bus.UnregisterSignalHandler(static_cast<ajn::MessageReceiver*>(listener),
-                                                 listener->GetHandler(), listener->GetMember(), NULL);
-            // Remove it from the map
-            signalListeners.erase(it);
-        }
+    std::shared_ptr<SignalHub> hub;
+
+    signalHubsMutex.Lock();
+    SignalHubMap::iterator it = signalHubs.find(listener->GetMember());
+    if (it != signalHubs.end()) {
+        hub = it->second;
     }
-    signalListenersMutex.Unlock();
-    return status;
-}
+    signalHubsMutex.Unlock();
 
-void ObserverBase::HandleSignal(SignalListenerBase* listener,
-                                const ajn::Message& message)
-{
-    signalListenersMutex.Lock();
-    SignalListenerMap::iterator it = signalListeners.find(listener->GetMember());
-    if ((it != signalListeners.end()) && (listener == it->second)) {
-        listener->SignalHandler(message);
+    // wait for delivery to the listener to finish without holding signalHubsMutex
+    if ((nullptr == hub) || !hub->Remove(listener)) {
+        return ER_OK;
     }
-    signalListenersMutex.Unlock();
+
+    QStatus result = ER_OK;
+    signalHubsMutex.Lock();
+    it = signalHubs.find(hub->GetMember());
+    if ((it != signalHubs.end()) && (hub == it->second) && (0 == hub->GetSize())) {
+        // last listener gone: unregister from Bus Attachment
+        ajn::BusAttachment& bus = busConnectionImpl->GetBusAttachment();
+        result = bus.UnregisterSignalHandler(static_cast<ajn::MessageReceiver*>(hub.get()),
+                                             SignalHub::GetHandler(), hub->GetMember(), NULL);
+        signalHubs.erase(it);
+    }
+    signalHubsMutex.Unlock();
+    return result;
 }
 
 /** Return observer construction status */
@@ -182,9 +294,12 @@ void ObserverBase::PropertiesChanged(ajn::ProxyBusObject& obj,
     QCC_DbgPrintf(("ObserverBase: got PropertyChanged signal from '%s' in '%s' (changed: %d, invalidated: %d)",
                    obj.GetPath().c_str(), obj.GetServiceName().c_str()));
 
+    uint64_t trace = UpdateTracer::Begin(UpdateTracer::RECEIVED, obj.GetPath().c_str(), ifaceName);
     ObjectId objectId(busConnectionImpl->GetBusAttachment(), obj.GetServiceName(), obj.GetPath(), obj.GetSessionId());
-    ObserverTask* task = new ObserverTask(observerBase, objectId, changed, invalidated);
-    observerMgr->Enqueue(task);
+    uint64_t key = ObserverCache::Hash(obj.GetServiceName().c_str(), obj.GetPath().c_str()) ^
+                   static_cast<uint64_t>(reinterpret_cast<uintptr_t>(this));
+    ObserverTask* task = new ObserverTask(observerBase, objectId, changed, invalidated, trace, key);
+    observerMgr->Enqueue(task, ObserverManager::Lane::UPDATE);
 }
 
 std::shared_ptr<BusConnectionImpl> ObserverBase::GetBusConnection() const
@@ -201,12 +316,11 @@ void ObserverBase::UpdateObject(const ObjectId& objId,
 
     if (cache != nullptr) {
         QCC_DbgPrintf(("Update object (%s, %s)", objId.GetBusName().c_str(), objId.GetBusObjectPath().c_str()));
-        objProxy = cache->UpdateObject(objId, changedProps);
+        objProxy = cache->UpdateObject(objId, changedProps, invalidatedProps);
         if (nullptr == objProxy) {
             QCC_LogError(ER_FAIL, ("Observer => UpdateObject: Failed to get proxy object"));
         }
     }
-    // TODO handle invalidated props
 }
 
 ObjectId* ObserverBase::GetObjectId(ajn::Message message)
@@ -216,7 +330,6 @@ ObjectId* ObserverBase::GetObjectId(ajn::Message message)
 
 std::shared_ptr<ProxyInterface> ObserverBase::GetObject(const ObjectId& objId)
 {
-    std::shared_ptr<ObserverCache> cache = observerMgr->GetCache(registeredTypeDesc->GetDescription().GetName());
     std::shared_ptr<ProxyInterface> proxyObj = nullptr;
     if (nullptr != cache) {
         proxyObj = cache->GetObject(objId);
@@ -224,6 +337,17 @@ std::shared_ptr<ProxyInterface> ObserverBase::GetObject(const ObjectId& objId)
     return proxyObj;
 }
 
+std::shared_ptr<ProxyInterface> ObserverBase::GetObject(const ajn::Message& message)
+{
+    std::shared_ptr<ProxyInterface> proxyObj = nullptr;
+    if (nullptr != cache) {
+        const char* sender = message->GetSender();
+        const char* path = message->GetObjectPath();
+        proxyObj = cache->GetObject(sender, path, ObserverCache::Hash(sender, path));
+    }
+    return proxyObj;
+}
+
 std::vector<std::shared_ptr<ProxyInterface> > ObserverBase::GetObjects() const
 {
     std::shared_ptr<ObserverCache> cache = observerMgr->GetCache(registeredTypeDesc->GetDescription().GetName());
@@ -16,9 +16,11 @@
 
 #include <algorithm>
 #include <memory>
+#include <string.h>
 
 #include <datadriven/ObjectAllocator.h>
 #include <datadriven/ObserverBase.h>
+#include <datadriven/UpdateTracer.h>
 
 #include "ObserverCache.h"
 
@@ -26,71 +28,91 @@
 #define QCC_MODULE "DD_CONSUMER"
 
 namespace datadriven {
+namespace {
+/** Matches the entries of an ObserverArray that refer to the same observer */
+struct SameObserver {
+    SameObserver(const std::weak_ptr<ObserverBase>& observer) :
+        observer(observer) { }
+
+    bool operator()(const std::weak_ptr<ObserverBase>& other) const
+    {
+        return !observer.owner_before(other) && !other.owner_before(observer);
+    }
+
+    const std::weak_ptr<ObserverBase>& observer;
+};
+}
+
 // PUBLIC //
 ObserverCache::ObserverCache(const qcc::String ifName,
                              std::weak_ptr<ObjectAllocator> alloc) :
-    ifName(ifName), allocator(alloc)
+    observers(std::make_shared<ObserverArray>()), sweepPosition(deadObjects.end()), ifName(ifName), allocator(alloc)
 {
 }
 
 ObserverCache::~ObserverCache()
 {
-    mutex.Lock();
-    if (0 != observers.size()) {
+    if (!observers->empty()) {
         QCC_DbgPrintf(("The observer list was not empty"));
-        observers.clear();
     }
-    mutex.Unlock();
 }
 
 void ObserverCache::AddObserver(std::weak_ptr<ObserverBase> observer)
 {
     QCC_DbgPrintf(("Add observer to cache for interface %s", ifName.c_str()));
-    mutex.Lock();
-    ObserverSet::iterator found = observers.find(observer);
-    if (found == observers.end()) {
-        observers.insert(observer);
+    mutex.Lock(MUTEX_CONTEXT);
+    if (observers->end() == std::find_if(observers->begin(), observers->end(), SameObserver(observer))) {
+        std::shared_ptr<ObserverArray> next = std::make_shared<ObserverArray>(*observers);
+        next->push_back(observer);
+        std::atomic_store(&observers, ObserverSnapshot(next));
     }
-    mutex.Unlock();
+    mutex.Unlock(MUTEX_CONTEXT);
 }
 
 size_t ObserverCache::RemoveObserver(std::weak_ptr<ObserverBase> observer)
 {
-    mutex.Lock();
-    ObserverSet::iterator found = observers.find(observer);
-    if (found != observers.end()) {
+    mutex.Lock(MUTEX_CONTEXT);
+    ObserverArray::const_iterator found = std::find_if(observers->begin(), observers->end(), SameObserver(observer));
+    if (found != observers->end()) {
         QCC_DbgPrintf(("Remove observer from cache for interface %s", ifName.c_str()));
-        observers.erase(found);
+        std::shared_ptr<ObserverArray> next = std::make_shared<ObserverArray>();
+        next->reserve(observers->size() - 1);
+        next->insert(next->end(), observers->begin(), found);
+        next->insert(next->end(), found + 1, observers->end());
+        std::atomic_store(&observers, ObserverSnapshot(next));
     }
-    size_t size = observers.size();
-    mutex.Unlock();
+    size_t size = observers->size();
+    mutex.Unlock(MUTEX_CONTEXT);
     return size;
 }
 
 void ObserverCache::NotifyObserver(std::weak_ptr<ObserverBase> observer)
 {
     QCC_DbgPrintf(("Notify observer about objects in cache for interface %s", ifName.c_str()));
-    mutex.Lock();
+    mutex.LockShared(MUTEX_CONTEXT);
     std::shared_ptr<ObserverBase> obs = observer.lock();
     if (nullptr != obs) {
-        for (ObjectIdToSharedPtrMap::iterator iterator = livingObjects.begin(); iterator != livingObjects.end();
-             iterator++) {
-            mutex.Unlock();
-            obs->UpdateObject(iterator->second);
-            mutex.Lock();
-            iterator = livingObjects.lower_bound(iterator->first);
+        ObjectIdToSharedPtrMap::iterator iterator = livingObjects.begin();
+        while (iterator != livingObjects.end()) {
+            /* the entry may be gone once we relock, so hold on to copies */
+            ObjectId objId = iterator->first;
+            std::shared_ptr<ProxyInterface> proxyObj = iterator->second;
+            mutex.UnlockShared(MUTEX_CONTEXT);
+            obs->UpdateObject(proxyObj);
+            mutex.LockShared(MUTEX_CONTEXT);
+            iterator = livingObjects.upper_bound(objId);
         }
     }
-    mutex.Unlock();
+    mutex.UnlockShared(MUTEX_CONTEXT);
 }
 
 void ObserverCache::NotifyObjectExistence(std::shared_ptr<ProxyInterface> proxyObj, bool add,
-                                          ObserverSet notifiedObservers)
+                                          const ObserverSnapshot& notifiedObservers)
 {
     if (nullptr != proxyObj) {
         // Notify All observers
-        for (ObserverCache::ObserverSet::const_iterator vectorIterator = notifiedObservers.begin();
-             vectorIterator != notifiedObservers.end();
+        for (ObserverArray::const_iterator vectorIterator = notifiedObservers->begin();
+             vectorIterator != notifiedObservers->end();
              vectorIterator++) {
             std::shared_ptr<ObserverBase> observer = (*vectorIterator).lock();
             if (observer) {
@@ -107,7 +129,7 @@ void ObserverCache::NotifyObjectExistence(std::shared_ptr<ProxyInterface> proxyO
 ObserverCache::NotificationSet ObserverCache::AddObject(const ObjectId& objId)
 {
     std::shared_ptr<ProxyInterface> proxyObj;
-    mutex.Lock();
+    mutex.Lock(MUTEX_CONTEXT);
     ObjectIdToSharedPtrMap::iterator aliveIterator = livingObjects.find(objId);
     if (aliveIterator != livingObjects.end()) {
         proxyObj = aliveIterator->second;
@@ -131,6 +153,9 @@ ObserverCache::NotificationSet ObserverCache::AddObject(const ObjectId& objId)
                                (unsigned long)objId.GetSessionId()));
             }
 
+            if (sweepPosition == deadIterator) {
+                ++sweepPosition;
+            }
             deadObjects.erase(deadIterator);
         } else {
             QCC_DbgPrintf(("There was no weak ptr @%s, pth = '%s', session = %lu",
@@ -147,6 +172,7 @@ ObserverCache::NotificationSet ObserverCache::AddObject(const ObjectId& objId)
 
         if (nullptr != proxyObj) {
             livingObjects.insert(aliveIterator, std::pair<ObjectId, std::shared_ptr<ProxyInterface> >(objId, proxyObj));
+            IndexObject(objId, proxyObj, true);
             proxyObj->SetAlive(true);
             QCC_DbgPrintf(("(Re-)add object @%s, path = '%s', session = %lu",
                            objId.GetBusName().c_str(), objId.GetBusObjectPath().c_str(),
@@ -154,7 +180,7 @@ ObserverCache::NotificationSet ObserverCache::AddObject(const ObjectId& objId)
         }
     }
     NotificationSet snapshot = { proxyObj, GetObservers() };
-    mutex.Unlock();
+    mutex.Unlock(MUTEX_CONTEXT);
 
     return snapshot;
 }
@@ -163,7 +189,7 @@ ObserverCache::NotificationSet ObserverCache::RemoveObject(const ObjectId& objId
 {
     /* We agreed we would not remove the object, but rather convert the strong reference to a weak reference. */
 
-    mutex.Lock();
+    mutex.Lock(MUTEX_CONTEXT);
     ObjectIdToSharedPtrMap::iterator it = livingObjects.find(objId);
     NotificationSet snapshot = { nullptr, GetObservers() };
     if (it != livingObjects.end()) {
@@ -171,6 +197,7 @@ ObserverCache::NotificationSet ObserverCache::RemoveObject(const ObjectId& objId
         std::shared_ptr<ProxyInterface> proxyObj = it->second;
         it->second->SetAlive(false);
 
+        IndexObject(objId, proxyObj, false);
         livingObjects.erase(it);
         deadObjects.insert(std::pair<ObjectId, std::weak_ptr<ProxyInterface> >(objId, weak));
         snapshot.interface = proxyObj;
@@ -179,15 +206,21 @@ ObserverCache::NotificationSet ObserverCache::RemoveObject(const ObjectId& objId
                        objId.GetBusName().c_str(), objId.GetBusObjectPath().c_str(),
                        (unsigned long)objId.GetSessionId()));
     }
-    mutex.Unlock();
-    GarbageCollect();         /* TODO: not always trigger this */
+    /* sweeping a few more entries than are added keeps the graveyard free of
+     * gone objects at a constant cost per removal */
+    GarbageCollect(GRAVEYARD_SWEEP);
+    mutex.Unlock(MUTEX_CONTEXT);
     return snapshot;
 }
 
-std::shared_ptr<ProxyInterface> ObserverCache::UpdateObject(const ObjectId& objId, const ajn::MsgArg* dict)
+std::shared_ptr<ProxyInterface> ObserverCache::UpdateObject(const ObjectId& objId,
+                                                            const ajn::MsgArg* dict,
+                                                            const ajn::MsgArg* invalidated)
 {
-    mutex.Lock();
+    mutex.Lock(MUTEX_CONTEXT);
     std::shared_ptr<ProxyInterface> proxyObj = nullptr;
+    /* the observers registered when the update was applied */
+    ObserverSnapshot notifiedObservers = observers;
     QStatus status = ER_OK;
     ObjectIdToSharedPtrMap::iterator it = livingObjects.find(objId);
     if (it != livingObjects.end()) {
@@ -196,15 +229,19 @@ std::shared_ptr<ProxyInterface> ObserverCache::UpdateObject(const ObjectId& objI
         status = proxyObj->GetStatus();
         if (ER_OK != status) {
             QCC_LogError(ER_FAIL, ("UpdateObject: Failed to unmarshal properties"));
+        } else if (nullptr != invalidated) {
+            proxyObj->InvalidateProperties(*invalidated);
         }
     }
-    mutex.Unlock();
+    mutex.Unlock(MUTEX_CONTEXT);
+    uint64_t trace = UpdateTracer::GetCurrent();
+    UpdateTracer::Record(trace, UpdateTracer::UNMARSHALED);
 
     // Notify all observers about the change in proxy interface objects
     if (nullptr != proxyObj) {
         // Notify All observers
-        for (ObserverCache::ObserverSet::const_iterator vectorIterator = observers.begin();
-             vectorIterator != observers.end();
+        for (ObserverArray::const_iterator vectorIterator = notifiedObservers->begin();
+             vectorIterator != notifiedObservers->end();
              vectorIterator++) {
             std::shared_ptr<ObserverBase> observer = (*vectorIterator).lock();
             if (observer) {
@@ -219,6 +256,8 @@ std::shared_ptr<ProxyInterface> ObserverCache::UpdateObject(const ObjectId& objI
         if (ER_OK != status) {
             /* Reset the proxyObj */
             proxyObj.reset();
+        } else {
+            UpdateTracer::Record(trace, UpdateTracer::DELIVERED);
         }
     } else {
         QCC_DbgPrintf(("Failed to find object @%s, path = '%s', session = %lu",
@@ -231,13 +270,14 @@ std::shared_ptr<ProxyInterface> ObserverCache::UpdateObject(const ObjectId& objI
 
 std::shared_ptr<ProxyInterface> ObserverCache::GetObject(const ObjectId& objId)
 {
-    mutex.Lock();
+    mutex.LockShared(MUTEX_CONTEXT);
     ObjectIdToSharedPtrMap::iterator it = livingObjects.find(objId);
     if (it != livingObjects.end()) {
-        mutex.Unlock();
-        return it->second;
+        std::shared_ptr<ProxyInterface> proxyObj = it->second;
+        mutex.UnlockShared(MUTEX_CONTEXT);
+        return proxyObj;
     }
-    mutex.Unlock();
+    mutex.UnlockShared(MUTEX_CONTEXT);
 
     QCC_DbgPrintf(("Failed to find object @%s, path = '%s', session = %lu",
                    objId.GetBusName().c_str(), objId.GetBusObjectPath().c_str(), (unsigned long)objId.GetSessionId()));
@@ -245,20 +285,67 @@ std::shared_ptr<ProxyInterface> ObserverCache::GetObject(const ObjectId& objId)
     return std::shared_ptr<ProxyInterface>();
 }
 
+std::shared_ptr<ProxyInterface> ObserverCache::GetObject(const char* busName,
+                                                         const char* path,
+                                                         uint64_t hash)
+{
+    std::shared_ptr<ProxyInterface> proxyObj;
+    mutex.LockShared(MUTEX_CONTEXT);
+    std::pair<LivingIndex::const_iterator, LivingIndex::const_iterator> range = livingIndex.equal_range(hash);
+    for (LivingIndex::const_iterator it = range.first; it != range.second; ++it) {
+        const ObjectId& objId = it->second->GetObjectId();
+        if ((0 == strcmp(objId.GetBusObjectPath().c_str(), path)) &&
+            (0 == strcmp(objId.GetBusName().c_str(), busName))) {
+            proxyObj = it->second;
+            break;
+        }
+    }
+    mutex.UnlockShared(MUTEX_CONTEXT);
+    return proxyObj;
+}
+
+uint64_t ObserverCache::Hash(const char* busName, const char* path)
+{
+    /* FNV-1a over both strings, including the terminating NUL of the bus name as separator */
+    uint64_t hash = 14695981039346656037ULL;
+    const char* s = busName;
+    do {
+        hash = (hash ^ (unsigned char)*s) * 1099511628211ULL;
+    } while (*s++ != '\0');
+    for (s = path; *s != '\0'; s++) {
+        hash = (hash ^ (unsigned char)*s) * 1099511628211ULL;
+    }
+    return hash;
+}
+
 std::vector<std::shared_ptr<ProxyInterface> > ObserverCache::LivingObjects() const
 {
     std::vector<std::shared_ptr<ProxyInterface> > objects;
+    mutex.LockShared(MUTEX_CONTEXT);
     objects.reserve(livingObjects.size());
     for (ObjectIdToSharedPtrMap::const_iterator objit = livingObjects.begin(); objit != livingObjects.end(); ++objit) {
         objects.push_back(objit->second);
     }
+    mutex.UnlockShared(MUTEX_CONTEXT);
 
     return objects;
 }
 
-ObserverCache::ObserverSet ObserverCache::GetObservers() const
+ObserverCache::ObserverSnapshot ObserverCache::GetObservers() const
+{
+    return std::atomic_load(&observers);
+}
+
+void ObserverCache::CollectMetrics(Metrics::Snapshot& snapshot) const
 {
-    return observers;
+    Metrics::Cache cache;
+    cache.interfaceName = ifName;
+    mutex.LockShared(MUTEX_CONTEXT);
+    cache.living = livingObjects.size();
+    cache.dead = deadObjects.size();
+    cache.observers = observers->size();
+    mutex.UnlockShared(MUTEX_CONTEXT);
+    snapshot.caches.push_back(cache);
 }
 
 // PRIVATE //
@@ -276,16 +363,33 @@ bool ObserverCache::ObjectIdComp::operator()(const ObjectId& o1, const ObjectId&
     return false;
 }
 
-void ObserverCache::GarbageCollect()
+void ObserverCache::IndexObject(const ObjectId& objId, const std::shared_ptr<ProxyInterface>& proxyObj, bool add)
 {
-    mutex.Lock();
-    for (ObjectIdToWeakPtrMap::iterator deadit = deadObjects.begin(); deadit != deadObjects.end();) {
-        if (deadit->second.expired()) {
-            deadObjects.erase(deadit++);
+    uint64_t hash = Hash(objId.GetBusName().c_str(), objId.GetBusObjectPath().c_str());
+    if (add) {
+        livingIndex.insert(std::make_pair(hash, proxyObj));
+        return;
+    }
+    std::pair<LivingIndex::iterator, LivingIndex::iterator> range = livingIndex.equal_range(hash);
+    for (LivingIndex::iterator it = range.first; it != range.second; ++it) {
+        if (it->second == proxyObj) {
+            livingIndex.erase(it);
+            break;
+        }
+    }
+}
+
+void ObserverCache::GarbageCollect(size_t budget)
+{
+    for (size_t i = 0; (i < budget) && !deadObjects.empty(); i++) {
+        if (sweepPosition == deadObjects.end()) {
+            sweepPosition = deadObjects.begin();
+        }
+        if (sweepPosition->second.expired()) {
+            deadObjects.erase(sweepPosition++);
         } else {
-            ++deadit;
+            ++sweepPosition;
         }
     }
-    mutex.Unlock();
 }
 }
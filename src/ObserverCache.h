@@ -19,10 +19,16 @@
 
 #include <map>
 #include <memory>
-#include <set>
+#include <unordered_map>
+#include <vector>
 
+#include <datadriven/Metrics.h>
 #include <datadriven/ObjectId.h>
 #include <datadriven/ProxyInterface.h>
+#include <datadriven/SharedMutex.h>
+
+/** Graveyard entries looked at per removed object */
+#define GRAVEYARD_SWEEP 4
 
 namespace datadriven {
 class ObserverBase;
@@ -31,9 +37,16 @@ class ObjectAllocator;
 class ObserverCache {
   public:
     /**
-     * Set of observers for a specific proxy interface.
+     * Observers for a specific proxy interface.
      */
-    typedef std::set<std::weak_ptr<ObserverBase>, std::owner_less <std::weak_ptr<ObserverBase> > > ObserverSet;
+    typedef std::vector<std::weak_ptr<ObserverBase> > ObserverArray;
+
+    /**
+     * Immutable snapshot of the observers. Adding or removing an observer
+     * publishes a new array, so a snapshot can be iterated without locking
+     * for as long as it is held.
+     */
+    typedef std::shared_ptr<const ObserverArray> ObserverSnapshot;
 
     /**
      * This structure keeps a snapshot of an interface instance and the observers to be notified about
@@ -41,7 +54,7 @@ class ObserverCache {
      */
     typedef struct {
         std::shared_ptr<ProxyInterface> interface;
-        ObserverSet observers;
+        ObserverSnapshot observers;
     } NotificationSet;
 
     /**
@@ -103,10 +116,12 @@ class ObserverCache {
      *
      * \param objId the object identifier
      * \param dict the updated properties
+     * \param invalidated the (optional) names of the invalidated properties
      * \return the updated proxy interface object
      */
     std::shared_ptr<ProxyInterface> UpdateObject(const ObjectId& objId,
-                                                 const ajn::MsgArg* dict);
+                                                 const ajn::MsgArg* dict,
+                                                 const ajn::MsgArg* invalidated = nullptr);
 
     /**
      * Trigger the application when an object was added or removed.
@@ -116,7 +131,7 @@ class ObserverCache {
      */
     void NotifyObjectExistence(std::shared_ptr<ProxyInterface> obj,
                                bool add,
-                               ObserverSet observers);
+                               const ObserverSnapshot& observers);
 
     /**
      * This will return, by definition, a living object
@@ -126,16 +141,47 @@ class ObserverCache {
      * */
     std::shared_ptr<ProxyInterface> GetObject(const ObjectId& objId);
 
+    /**
+     * Look up a living object by the sender and object path of a message,
+     * without building an ObjectId. This is the signal delivery fast path.
+     *
+     * \param busName unique bus name of the object's host
+     * \param path object path
+     * \param hash Hash(busName, path)
+     * \return the proxy interface object, or nullptr if it is not alive
+     */
+    std::shared_ptr<ProxyInterface> GetObject(const char* busName,
+                                              const char* path,
+                                              uint64_t hash);
+
+    /**
+     * Hash of a bus name and object path pair, as used by the fast path
+     * GetObject.
+     *
+     * \param busName unique bus name
+     * \param path object path
+     * \return the hash
+     */
+    static uint64_t Hash(const char* busName,
+                         const char* path);
+
     /* TODO: REPLACE THIS NAIVE APPROACH (by reusing the iterator on livingobjects*/
     std::vector<std::shared_ptr<ProxyInterface> > LivingObjects() const;
 
     /**
-     * Returns the set of observers.
+     * Returns the current observers. Does not lock and does not copy them.
+     */
+    ObserverSnapshot GetObservers() const;
+
+    /**
+     * Add the number of living and dead objects and of observers of this
+     * cache to a metrics snapshot.
      */
-    ObserverSet GetObservers() const;
+    void CollectMetrics(Metrics::Snapshot& snapshot) const;
 
   private:
-    ObserverSet observers;
+    /** Only replaced as a whole, with std::atomic_store under the mutex */
+    ObserverSnapshot observers;
 
     /* ignore busAttachment here (not relevant and probably will go out anyway) */
     struct ObjectIdComp {
@@ -146,8 +192,14 @@ class ObserverCache {
     typedef std::map<ObjectId, std::weak_ptr<ProxyInterface>, ObjectIdComp> ObjectIdToWeakPtrMap;
 
     ObjectIdToSharedPtrMap livingObjects;
+    /** livingObjects indexed by Hash(busName, path) */
+    typedef std::unordered_multimap<uint64_t, std::shared_ptr<ProxyInterface> > LivingIndex;
+    LivingIndex livingIndex;
     ObjectIdToWeakPtrMap deadObjects;         /* aka the graveyard */
-    mutable datadriven::Mutex mutex;         /* is recursive */
+    /** Where the next GarbageCollect continues, deadObjects.end() to start over */
+    ObjectIdToWeakPtrMap::iterator sweepPosition;
+    /* lookups lock shared, everything else exclusively; not recursive */
+    mutable datadriven::SharedMutex mutex;
 
     /**
      * The name of the interface for which this cache is created
@@ -160,7 +212,18 @@ class ObserverCache {
      */
     std::weak_ptr<ObjectAllocator> allocator;
 
-    void GarbageCollect();
+    /**
+     * Remove up to \a budget graveyard entries whose object is gone,
+     * continuing where the previous call stopped. Must be called with the
+     * mutex held.
+     *
+     * \param budget number of entries to look at
+     */
+    void GarbageCollect(size_t budget);
+
+    void IndexObject(const ObjectId& objId,
+                     const std::shared_ptr<ProxyInterface>& proxyObj,
+                     bool add);
 };
 }
 
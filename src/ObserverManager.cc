@@ -26,6 +26,11 @@
 #include <qcc/Debug.h>
 #define QCC_MODULE "DD_CONSUMER"
 
+/** Number of queued consumer tasks beyond which property updates of the same object are merged */
+#define CONSUMER_QUEUE_CAPACITY 10000
+/** Time in ms after which a consumer task is run regardless of its lane */
+#define CONSUMER_QUEUE_MAX_WAIT 250
+
 namespace datadriven {
 class ObserverManagerTask :
     public ObserverManager::Task {
@@ -106,9 +111,57 @@ void ObserverManager::OnTask(TaskData const* taskdata)
     data->Execute();
 }
 
-void ObserverManager::Enqueue(const Task* task)
+/* datadriven::AsyncTask */
+bool ObserverManager::OnCoalesceKey(TaskData const* taskdata, uint64_t& key)
+{
+    return static_cast<const Task*>(taskdata)->CoalesceKey(key);
+}
+
+/* datadriven::AsyncTask */
+bool ObserverManager::OnCoalesce(TaskData const* queued, TaskData const* incoming)
+{
+    // the queue owns the queued task and does not touch it while we merge
+    Task* task = const_cast<Task*>(static_cast<const Task*>(queued));
+    return task->Coalesce(*static_cast<const Task*>(incoming));
+}
+
+void ObserverManager::Enqueue(const Task* task, Lane lane)
+{
+    asyncTaskQueue.Enqueue(task, static_cast<unsigned int>(lane));
+}
+
+void ObserverManager::EnqueueReply(const Task* task)
+{
+    replyTaskQueueMutex.Lock();
+    if (!replyTaskQueueStarted) {
+        replyTaskQueue.Start();
+        replyTaskQueueStarted = true;
+    }
+    replyTaskQueue.Enqueue(task);
+    replyTaskQueueMutex.Unlock();
+}
+
+AsyncTaskQueue::Stats ObserverManager::GetQueueStats() const
 {
-    asyncTaskQueue.Enqueue(task);
+    return asyncTaskQueue.GetStats();
+}
+
+AsyncTaskQueue::Stats ObserverManager::GetReplyQueueStats() const
+{
+    return replyTaskQueue.GetStats();
+}
+
+void ObserverManager::CollectMetrics(Metrics::Snapshot& snapshot) const
+{
+    cachesMutex.LockShared(MUTEX_CONTEXT);
+    for (ObserverCacheMap::const_iterator it = caches.begin(); it != caches.end(); ++it) {
+        it->second->CollectMetrics(snapshot);
+    }
+    cachesMutex.UnlockShared(MUTEX_CONTEXT);
+
+    asyncTaskQueue.CollectMetrics("consumer", snapshot);
+    replyTaskQueue.CollectMetrics("reply", snapshot);
+    sessionMgr->CollectMetrics(snapshot);
 }
 
 std::shared_ptr<ObserverManager> ObserverManager::GetInstance(std::shared_ptr<
@@ -138,21 +191,36 @@ ObserverManager::ObserverManager(std::shared_ptr<BusConnectionImpl> busConnectio
     status(ER_OK),
     busConnection(busConnection),
     sessionMgr(new SessionManager(busConnection->GetBusAttachment())),
-    asyncTaskQueue(this, true)
+    asyncTaskQueue(this, true),
+    replyTaskQueue(this, true),
+    replyTaskQueueStarted(false)
 {
     status = sessionMgr->GetStatus();
     if (ER_OK != status) {
         QCC_LogError(status, ("Failed to start session manager"));
     }
     this->sessionMgr->RegisterListener(this);
+    // under an update storm, merge property updates of the same object rather than queue them all;
+    // tasks are enqueued from bus callbacks, sometimes with objectsMutex held, so this never waits
+    asyncTaskQueue.SetCapacity(CONSUMER_QUEUE_CAPACITY, AsyncTaskQueue::OVERFLOW_COALESCE);
+    // replies should not wait behind a discovery or update backlog
+    asyncTaskQueue.SetLanes(static_cast<unsigned int>(Lane::COUNT), CONSUMER_QUEUE_MAX_WAIT);
     asyncTaskQueue.Start();
+    Metrics::AddSource(this);
 }
 
 ObserverManager::~ObserverManager()
 {
+    Metrics::RemoveSource(this);
     busConnection->GetBusAttachment().UnregisterAboutListener(*this);
     Stop();
     asyncTaskQueue.Stop();
+    replyTaskQueueMutex.Lock();
+    if (replyTaskQueueStarted) {
+        replyTaskQueue.Stop();
+        replyTaskQueueStarted = false;
+    }
+    replyTaskQueueMutex.Unlock();
     delete sessionMgr;
 }
 
@@ -163,10 +231,9 @@ QStatus ObserverManager::GetStatus() const
 
 void ObserverManager::Stop()
 {
-    cachesMutex.Lock();
+    /* not under cachesMutex: the session manager calls us with its own mutex held */
     QCC_DbgPrintf(("Stop observer manager"));
     sessionMgr->UnregisterListener(this);
-    cachesMutex.Unlock();
 }
 
 QStatus ObserverManager::RegisterObserver(std::weak_ptr<ObserverBase> observer,
@@ -176,7 +243,7 @@ QStatus ObserverManager::RegisterObserver(std::weak_ptr<ObserverBase> observer,
     bool newCache = false;
     std::shared_ptr<ObserverCache> cache = nullptr;
 
-    cachesMutex.Lock();
+    cachesMutex.Lock(MUTEX_CONTEXT);
     do {
         ObserverCacheMap::iterator iterator = caches.find(ifName);
         if (caches.end() == iterator) {
@@ -190,10 +257,13 @@ QStatus ObserverManager::RegisterObserver(std::weak_ptr<ObserverBase> observer,
         }
         if (nullptr != cache) {
             cache->AddObserver(observer);
-            cache->NotifyObserver(observer);
         }
     } while (0);
-    cachesMutex.Unlock();
+    cachesMutex.Unlock(MUTEX_CONTEXT);
+    if (nullptr != cache) {
+        /* calls into the application, which may look up caches itself */
+        cache->NotifyObserver(observer);
+    }
     if (newCache) {
         PopulateCache(cache, ifName);
     }
@@ -203,7 +273,7 @@ QStatus ObserverManager::RegisterObserver(std::weak_ptr<ObserverBase> observer,
 void ObserverManager::UnregisterObserver(std::weak_ptr<ObserverBase> observer,
                                          qcc::String ifName)
 {
-    cachesMutex.Lock();
+    cachesMutex.Lock(MUTEX_CONTEXT);
     ObserverCacheMap::iterator iterator = caches.find(ifName);
     if (caches.end() != iterator) {
         std::shared_ptr<ObserverCache> cache = iterator->second;
@@ -215,18 +285,18 @@ void ObserverManager::UnregisterObserver(std::weak_ptr<ObserverBase> observer,
     } else {
         QCC_LogError(ER_FAIL, ("Cache not found !"));
     }
-    cachesMutex.Unlock();
+    cachesMutex.Unlock(MUTEX_CONTEXT);
 }
 
 const std::shared_ptr<ObserverCache> ObserverManager::GetCache(qcc::String ifName)
 {
-    cachesMutex.Lock();
+    cachesMutex.LockShared(MUTEX_CONTEXT);
     ObserverCacheMap::iterator iterator = caches.find(ifName);
     std::shared_ptr<ObserverCache> cache = nullptr;
     if (iterator != caches.end()) {
         cache = iterator->second;
     }
-    cachesMutex.Unlock();
+    cachesMutex.UnlockShared(MUTEX_CONTEXT);
     return cache;
 }
 
@@ -234,12 +304,14 @@ std::vector<std::weak_ptr<ObserverCache> > ObserverManager::GetObserverCaches(co
 const
 {
     std::vector<std::weak_ptr<ObserverCache> > wcaches;
+    cachesMutex.LockShared(MUTEX_CONTEXT);
     for (qcc::String ifName : ifNames) {
         std::map<const qcc::String, std::shared_ptr<ObserverCache> >::const_iterator it = caches.find(ifName);
         if (it != caches.end()) {
             wcaches.push_back(it->second);
         }
     }
+    cachesMutex.UnlockShared(MUTEX_CONTEXT);
 
     return wcaches;
 }
@@ -251,7 +323,7 @@ void ObserverManager::AddObject(const std::vector<qcc::String>& ifNames,
                    objectId.GetBusObjectPath().c_str()));
     ObserverManagerTask* taskData =
         new ObserverManagerTask(GetObserverCaches(ifNames), objectId, Action::ADD);
-    asyncTaskQueue.Enqueue(taskData);
+    asyncTaskQueue.Enqueue(taskData, static_cast<unsigned int>(Lane::DISCOVERY));
 }
 
 void ObserverManager::RemoveObject(const std::vector<qcc::String>& ifNames,
@@ -261,13 +333,13 @@ void ObserverManager::RemoveObject(const std::vector<qcc::String>& ifNames,
                    objectId.GetBusObjectPath().c_str()));
     ObserverManagerTask* taskData =
         new ObserverManagerTask(GetObserverCaches(ifNames), objectId, Action::REMOVE);
-    asyncTaskQueue.Enqueue(taskData);
+    asyncTaskQueue.Enqueue(taskData, static_cast<unsigned int>(Lane::DISCOVERY));
 }
 
 void ObserverManager::PopulateCache(std::shared_ptr<ObserverCache> cache,
                                     const qcc::String& ifName)
 {
-    objectsMutex.Lock();
+    objectsMutex.Lock(MUTEX_CONTEXT);
     ObjectDescriptionsMap::const_iterator it = discoveredObjects.begin();
 
     while (it != discoveredObjects.end()) {
@@ -296,7 +368,7 @@ void ObserverManager::PopulateCache(std::shared_ptr<ObserverCache> cache,
         delete[] paths;
         it++;
     }
-    objectsMutex.Unlock();
+    objectsMutex.Unlock(MUTEX_CONTEXT);
 }
 
 void ObserverManager::ObjectDescriptionsDifference(const qcc::String& busName,
@@ -347,7 +419,7 @@ void ObserverManager::Announced(const char* busName, uint16_t version,
     QCC_UNUSED(version);
     QCC_UNUSED(aboutDataArg);
 
-    objectsMutex.Lock();
+    objectsMutex.Lock(MUTEX_CONTEXT);
 
     // Ask session manager if a session already exists
     ajn::SessionId sessionId;
@@ -359,7 +431,7 @@ void ObserverManager::Announced(const char* busName, uint16_t version,
     QStatus status = objDesc.CreateFromMsgArg(objectDescriptionArg);
     if (status != ER_OK) {
         QCC_LogError(status, ("Failed to translate about object description"));
-        objectsMutex.Unlock();
+        objectsMutex.Unlock(MUTEX_CONTEXT);
         return;
     }
     if (!discovered || established) {
@@ -381,34 +453,34 @@ void ObserverManager::Announced(const char* busName, uint16_t version,
     }
     discoveredObjects[session] = objDesc;
 
-    objectsMutex.Unlock();
+    objectsMutex.Unlock(MUTEX_CONTEXT);
 }
 
 void ObserverManager::OnSessionEstablished(const SessionManager::Session& session,
                                            const ajn::SessionId& sessionId)
 {
     QCC_DbgPrintf(("Session established for '%s'", session.GetBusName().c_str()));
-    objectsMutex.Lock();
+    objectsMutex.Lock(MUTEX_CONTEXT);
     ajn::AboutObjectDescription empty;
     ObjectDescriptionsMap::const_iterator it = discoveredObjects.find(session);
     assert(it != discoveredObjects.end());
 
     ObjectDescriptionsDifference(session.GetBusName(), sessionId, it->second, empty,
                                  Action::ADD);
-    objectsMutex.Unlock();
+    objectsMutex.Unlock(MUTEX_CONTEXT);
 }
 
 void ObserverManager::OnSessionLost(const SessionManager::Session& session,
                                     const ajn::SessionId& sessionId)
 {
     QCC_DbgPrintf(("Session lost for '%s'", session.GetBusName().c_str()));
-    objectsMutex.Lock();
+    objectsMutex.Lock(MUTEX_CONTEXT);
     ajn::AboutObjectDescription empty;
     ObjectDescriptionsMap::const_iterator it = discoveredObjects.find(session);
     assert(it != discoveredObjects.end());
 
     ObjectDescriptionsDifference(session.GetBusName(), sessionId, it->second, empty,
                                  Action::REMOVE);
-    objectsMutex.Unlock();
+    objectsMutex.Unlock(MUTEX_CONTEXT);
 }
 }
@@ -24,7 +24,9 @@
 #include <alljoyn/AboutObjectDescription.h>
 
 #include <qcc/String.h>
+#include <datadriven/Metrics.h>
 #include <datadriven/Mutex.h>
+#include <datadriven/SharedMutex.h>
 
 #include "ObserverCache.h"
 #include "SessionManager.h"
@@ -35,13 +37,27 @@ class BusConnectionImpl;
 class ObserverManager :
     private ajn::AboutListener,
     private AsyncTask,
-    private SessionManager::Listener {
+    private SessionManager::Listener,
+    private Metrics::Source {
   public:
     enum class Action :
     int8_t {
         ADD, REMOVE
     };
 
+    /**
+     * Priority lanes of the consumer task queue, highest priority first.
+     * Object additions share the lane of removals so both stay in order.
+     */
+    enum class Lane :
+    uint8_t {
+        REPLY,      /**< method replies and batch completions */
+        DISCOVERY,  /**< objects added or removed */
+        SIGNAL,     /**< signals */
+        UPDATE,     /**< property updates */
+        COUNT
+    };
+
     static std::shared_ptr<ObserverManager> GetInstance(std::shared_ptr<BusConnectionImpl> busConn = nullptr);
 
     ~ObserverManager();
@@ -87,9 +103,65 @@ class ObserverManager :
         public TaskData {
       public:
         virtual void Execute() const = 0;
+
+        /**
+         * Merge \a next into this task while it is still queued, when the
+         * queue is full. Tasks that can be merged (e.g. successive property
+         * updates of the same object) override this.
+         *
+         * \param next the task being enqueued
+         * \return true if \a next was merged and must not be executed
+         */
+        virtual bool Coalesce(const Task& next)
+        {
+            return false;
+        }
+
+        /**
+         * Tasks that Coalesce could merge must have the same key, so the
+         * queue only offers \a next to the most recent of those.
+         *
+         * \param[out] key the key
+         * \return false if the task is never merged
+         */
+        virtual bool CoalesceKey(uint64_t& key) const
+        {
+            return false;
+        }
     };
 
-    void Enqueue(const Task* task);
+    /**
+     * Run \a task on the consumer thread. Tasks of a higher priority lane
+     * overtake those of lower ones, unless those waited too long.
+     *
+     * \param task the task, deleted once executed
+     * \param lane the priority lane of the task
+     */
+    void Enqueue(const Task* task,
+                 Lane lane);
+
+    /**
+     * Run \a task on the dedicated reply executor instead of the shared
+     * queue, so it does not wait behind discovery and property updates.
+     * The executor thread is started on first use.
+     */
+    void EnqueueReply(const Task* task);
+
+    /**
+     * Statistics of the consumer task queue
+     */
+    AsyncTaskQueue::Stats GetQueueStats() const;
+
+    /**
+     * Statistics of the reply executor queue
+     */
+    AsyncTaskQueue::Stats GetReplyQueueStats() const;
+
+    /**
+     * Add the observer caches, the task queues and the sessions to a
+     * metrics snapshot.
+     */
+    void CollectMetrics(Metrics::Snapshot& snapshot) const;
 
   private:
     /**
@@ -122,9 +194,10 @@ class ObserverManager :
     ObserverCacheMap caches;
 
     /**
-     * Mutex that protects access to the observer cache map
+     * Protects access to the observer cache map. Lookups lock it shared;
+     * it is not recursive, so no callbacks are made while holding it.
      */
-    datadriven::Mutex cachesMutex;
+    mutable datadriven::SharedMutex cachesMutex;
 
     /**
      * Reference to busConnection
@@ -141,6 +214,22 @@ class ObserverManager :
      */
     mutable AsyncTaskQueue asyncTaskQueue;
 
+    /**
+     * Asynchronous task queue for method reply listeners that asked for the
+     * reply executor.
+     */
+    mutable AsyncTaskQueue replyTaskQueue;
+
+    /**
+     * Whether replyTaskQueue was started
+     */
+    bool replyTaskQueueStarted;
+
+    /**
+     * Mutex that protects starting and stopping replyTaskQueue
+     */
+    datadriven::Mutex replyTaskQueueMutex;
+
     /**
      * Add a new object (this method will enqueue a new async task object)
      *
@@ -202,6 +291,12 @@ class ObserverManager :
 
     virtual void OnTask(TaskData const* taskdata);
 
+    virtual bool OnCoalesceKey(TaskData const* taskdata,
+                               uint64_t& key);
+
+    virtual bool OnCoalesce(TaskData const* queued,
+                            TaskData const* incoming);
+
     std::vector<std::weak_ptr<ObserverCache> > GetObserverCaches(const std::vector<qcc::String>& ifNames) const;
 };
 }
@@ -0,0 +1,101 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+
+#include <datadriven/MethodInvocationBase.h>
+
+#include "PendingCalls.h"
+
+namespace datadriven {
+PendingCalls& PendingCalls::GetInstance()
+{
+    // never destroyed: AllJoyn may call back until the bus attachment is gone
+    static PendingCalls* instance = new PendingCalls();
+    return *instance;
+}
+
+PendingCalls::PendingCalls() :
+    nextId(1), count(0)
+{
+}
+
+uintptr_t PendingCalls::Add(const std::shared_ptr<MethodInvocationBase>& inv)
+{
+    uintptr_t id = nextId.fetch_add(1);
+    if (0 == id) {
+        // wrapped around, 0 means "not pending"
+        id = nextId.fetch_add(1);
+    }
+    Shard& shard = shards[id % SHARDS];
+    shard.mutex.Lock();
+    shard.calls[id] = inv;
+    shard.mutex.Unlock();
+    count++;
+    return id;
+}
+
+std::shared_ptr<MethodInvocationBase> PendingCalls::Remove(uintptr_t id)
+{
+    std::shared_ptr<MethodInvocationBase> inv;
+    Shard& shard = shards[id % SHARDS];
+    shard.mutex.Lock();
+    std::unordered_map<uintptr_t, std::shared_ptr<MethodInvocationBase> >::iterator it = shard.calls.find(id);
+    if (shard.calls.end() != it) {
+        inv.swap(it->second);
+        shard.calls.erase(it);
+    }
+    shard.mutex.Unlock();
+    if (inv) {
+        count--;
+    }
+    return inv;
+}
+
+size_t PendingCalls::GetCount() const
+{
+    return count;
+}
+
+void PendingCalls::OnReplyMessage(ajn::Message& message, void* context)
+{
+    uintptr_t id = reinterpret_cast<uintptr_t>(context);
+    std::shared_ptr<MethodInvocationBase> inv = Remove(id);
+    if (inv) {
+        inv->OnReplyMessage(message, id);
+    }
+}
+
+void PendingCalls::OnGetProperty(QStatus status,
+                                 ajn::ProxyBusObject* obj,
+                                 const ajn::MsgArg& value,
+                                 void* context)
+{
+    std::shared_ptr<MethodInvocationBase> inv = Remove(reinterpret_cast<uintptr_t>(context));
+    if (inv) {
+        inv->OnGetProperty(status, value);
+    }
+}
+
+void PendingCalls::OnSetProperty(QStatus status,
+                                 ajn::ProxyBusObject* obj,
+                                 void* context)
+{
+    std::shared_ptr<MethodInvocationBase> inv = Remove(reinterpret_cast<uintptr_t>(context));
+    if (inv) {
+        inv->SetReplyStatus(status);
+    }
+}
+}
@@ -0,0 +1,104 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+
+#ifndef PENDINGCALLS_H_
+#define PENDINGCALLS_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+#include <alljoyn/InterfaceDescription.h> // needed by MessageReceiver.h
+#include <alljoyn/Message.h>
+#include <alljoyn/MessageReceiver.h>
+#include <alljoyn/ProxyBusObject.h>
+
+#include <datadriven/Mutex.h>
+
+namespace datadriven {
+class MethodInvocationBase;
+
+/**
+ * \private Registry of method invocations that were sent and wait for
+ * AllJoyn to call back with a reply, an error or a time-out.
+ *
+ * AllJoyn offers no way to withdraw the reply handler of an asynchronous
+ * call, so the registry, which lives as long as the process, is the
+ * receiver of all replies. The call context passed to AllJoyn is only a
+ * call id. The registry owns a reference to each pending invocation, and
+ * whoever removes the entry first, the reply handler or Cancel(), takes
+ * over that reference. A cancelled invocation is therefore released right
+ * away, and a late reply for it finds no entry and is dropped.
+ */
+class PendingCalls :
+    public ajn::MessageReceiver,
+    public ajn::ProxyBusObject::Listener {
+  public:
+    static PendingCalls& GetInstance();
+
+    /**
+     * Register \a inv as pending.
+     * \return the call id to pass as context to AllJoyn, never 0
+     */
+    uintptr_t Add(const std::shared_ptr<MethodInvocationBase>& inv);
+
+    /**
+     * Unregister call \a id.
+     * \return the invocation, or nullptr if it was already removed
+     */
+    std::shared_ptr<MethodInvocationBase> Remove(uintptr_t id);
+
+    /** Number of pending calls */
+    size_t GetCount() const;
+
+    /** Reply handler for MethodCallAsync, \a context is the call id */
+    void OnReplyMessage(ajn::Message& message,
+                        void* context);
+
+    /** Callback for GetPropertyAsync, \a context is the call id */
+    void OnGetProperty(QStatus status,
+                       ajn::ProxyBusObject* obj,
+                       const ajn::MsgArg& value,
+                       void* context);
+
+    /** Callback for SetPropertyAsync, \a context is the call id */
+    void OnSetProperty(QStatus status,
+                       ajn::ProxyBusObject* obj,
+                       void* context);
+
+  private:
+    /** Calls are spread over shards by id, so unrelated calls rarely contend */
+    static const size_t SHARDS = 16;
+
+    struct Shard {
+        mutable datadriven::Mutex mutex;
+        std::unordered_map<uintptr_t, std::shared_ptr<MethodInvocationBase> > calls;
+    };
+
+    Shard shards[SHARDS];
+    std::atomic<uintptr_t> nextId;
+    std::atomic<size_t> count;
+
+    PendingCalls();
+
+    PendingCalls(const PendingCalls&);
+    void operator=(const PendingCalls&);
+};
+}
+
+#endif /* PENDINGCALLS_H_ */
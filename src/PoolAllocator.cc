@@ -0,0 +1,111 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+
+#include <new>
+
+#include <datadriven/PoolAllocator.h>
+
+#include "common/ThreadLocal.h"
+
+/* blocks are cached in size classes of POOL_GRANULE bytes, up to POOL_MAX_SIZE */
+#define POOL_GRANULE 64
+#define POOL_MAX_SIZE 1024
+#define POOL_CLASSES (POOL_MAX_SIZE / POOL_GRANULE)
+
+/* bounds the memory a thread keeps cached */
+#define POOL_MAX_CACHED 32
+
+namespace datadriven {
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+/**
+ * The blocks cached by one thread, returned to the heap when it exits.
+ */
+struct FreeLists {
+    FreeBlock* heads[POOL_CLASSES];
+    unsigned int counts[POOL_CLASSES];
+
+    FreeLists() : heads(), counts() { }
+
+    ~FreeLists();
+};
+
+static DD_THREAD_LOCAL FreeLists freeLists;
+/* set once the lists of the thread are gone, blocks then bypass the cache */
+static DD_THREAD_LOCAL bool released = false;
+
+FreeLists::~FreeLists()
+{
+    for (size_t cls = 0; cls < POOL_CLASSES; cls++) {
+        while (NULL != heads[cls]) {
+            FreeBlock* block = heads[cls];
+            heads[cls] = block->next;
+            ::operator delete(block);
+        }
+        counts[cls] = 0;
+    }
+    released = true;
+}
+
+static inline size_t SizeClass(size_t size)
+{
+    return (size + POOL_GRANULE - 1) / POOL_GRANULE - 1;
+}
+
+void* PoolAllocate(size_t size)
+{
+    if (0 == size || size > POOL_MAX_SIZE) {
+        return ::operator new(size);
+    }
+    size_t cls = SizeClass(size);
+    if (released) {
+        return ::operator new((cls + 1) * POOL_GRANULE);
+    }
+    FreeLists& lists = freeLists;
+    FreeBlock* block = lists.heads[cls];
+    if (NULL == block) {
+        /* always allocate the full class size so blocks are interchangeable */
+        return ::operator new((cls + 1) * POOL_GRANULE);
+    }
+    lists.heads[cls] = block->next;
+    lists.counts[cls]--;
+    return block;
+}
+
+void PoolFree(void* ptr, size_t size)
+{
+    if (NULL == ptr) {
+        return;
+    }
+    if (0 == size || size > POOL_MAX_SIZE || released) {
+        ::operator delete(ptr);
+        return;
+    }
+    size_t cls = SizeClass(size);
+    FreeLists& lists = freeLists;
+    if (lists.counts[cls] >= POOL_MAX_CACHED) {
+        ::operator delete(ptr);
+        return;
+    }
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    block->next = lists.heads[cls];
+    lists.heads[cls] = block;
+    lists.counts[cls]++;
+}
+} /* namespace datadriven */
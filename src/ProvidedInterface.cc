@@ -15,7 +15,11 @@
  ******************************************************************************/
 
 #include <iostream>
+#include <string.h>
 
+#include <datadriven/MarshalArena.h>
+#include <datadriven/Metrics.h>
+#include <datadriven/UpdateTracer.h>
 #include <datadriven/ProvidedInterface.h>
 #include <datadriven/ProvidedObject.h>
 #include "RegisteredTypeDescription.h"
@@ -29,7 +33,8 @@
 namespace datadriven {
 ProvidedInterface::ProvidedInterface(const TypeDescription& desc,
                                      std::shared_ptr<ProvidedObjectImpl> providedObject) :
-    _status(ER_OK), desc(desc), object(providedObject)
+    _status(ER_OK), desc(desc), object(providedObject), propertiesVersion(1), getAllVersion(0),
+    uncachedProperties(desc.GetUncachedReadablePropertyNames())
 {
     const std::vector<const char*> names = desc.GetEmittablePropertyNames();
     std::vector<const char*>::const_iterator it;
@@ -75,25 +80,209 @@ QStatus ProvidedInterface::Update()
         return ER_FAIL;
     }
 
+    uint64_t trace = UpdateTracer::Begin(UpdateTracer::UPDATE, object->GetPath(), desc.GetName().c_str());
+
     // Marshal all properties
-    if (ER_OK != (_status = MarshalProperties())) {
+    if (ER_OK != (_status = RefreshProperties())) {
         return _status;
     }
+    UpdateTracer::Record(trace, UpdateTracer::MARSHALED);
+
+    return SignalUpdate(trace);
+}
+
+/* FNV-1a, used to detect changes in marshaled property values */
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+static void HashBytes(uint64_t& hash, const void* data, size_t len)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < len; ++i) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+}
+
+/**
+ * Hash the type and content of a MsgArg.
+ * \return false if the MsgArg holds a type that cannot be hashed, in which
+ *         case the value must be considered changed
+ */
+static bool HashMsgArg(uint64_t& hash, const ajn::MsgArg& arg)
+{
+    HashBytes(hash, &arg.typeId, sizeof(arg.typeId));
+    switch (arg.typeId) {
+    case ajn::ALLJOYN_BOOLEAN:
+        HashBytes(hash, &arg.v_bool, sizeof(arg.v_bool));
+        return true;
+
+    case ajn::ALLJOYN_BYTE:
+        HashBytes(hash, &arg.v_byte, sizeof(arg.v_byte));
+        return true;
+
+    case ajn::ALLJOYN_INT16:
+    case ajn::ALLJOYN_UINT16:
+        HashBytes(hash, &arg.v_uint16, sizeof(arg.v_uint16));
+        return true;
+
+    case ajn::ALLJOYN_INT32:
+    case ajn::ALLJOYN_UINT32:
+        HashBytes(hash, &arg.v_uint32, sizeof(arg.v_uint32));
+        return true;
+
+    case ajn::ALLJOYN_INT64:
+    case ajn::ALLJOYN_UINT64:
+    case ajn::ALLJOYN_DOUBLE:
+        HashBytes(hash, &arg.v_uint64, sizeof(arg.v_uint64));
+        return true;
+
+    case ajn::ALLJOYN_STRING:
+        HashBytes(hash, arg.v_string.str, arg.v_string.len);
+        return true;
+
+    case ajn::ALLJOYN_OBJECT_PATH:
+        HashBytes(hash, arg.v_objPath.str, arg.v_objPath.len);
+        return true;
+
+    case ajn::ALLJOYN_SIGNATURE:
+        HashBytes(hash, arg.v_signature.sig, arg.v_signature.len);
+        return true;
+
+    case ajn::ALLJOYN_VARIANT:
+        return HashMsgArg(hash, *arg.v_variant.val);
+
+    case ajn::ALLJOYN_DICT_ENTRY:
+        return HashMsgArg(hash, *arg.v_dictEntry.key) && HashMsgArg(hash, *arg.v_dictEntry.val);
+
+    case ajn::ALLJOYN_STRUCT:
+        for (size_t i = 0; i < arg.v_struct.numMembers; ++i) {
+            if (!HashMsgArg(hash, arg.v_struct.members[i])) {
+                return false;
+            }
+        }
+        HashBytes(hash, &arg.v_struct.numMembers, sizeof(arg.v_struct.numMembers));
+        return true;
+
+    case ajn::ALLJOYN_ARRAY: {
+            const char* sig = arg.v_array.GetElemSig();
+            size_t numElements = arg.v_array.GetNumElements();
+            const ajn::MsgArg* elements = arg.v_array.GetElements();
+
+            if (sig) {
+                HashBytes(hash, sig, strlen(sig));
+            }
+            for (size_t i = 0; i < numElements; ++i) {
+                if (!HashMsgArg(hash, elements[i])) {
+                    return false;
+                }
+            }
+            HashBytes(hash, &numElements, sizeof(numElements));
+            return true;
+        }
+
+    case ajn::ALLJOYN_BOOLEAN_ARRAY:
+        HashBytes(hash, arg.v_scalarArray.v_bool, arg.v_scalarArray.numElements * sizeof(bool));
+        return true;
+
+    case ajn::ALLJOYN_BYTE_ARRAY:
+        HashBytes(hash, arg.v_scalarArray.v_byte, arg.v_scalarArray.numElements * sizeof(uint8_t));
+        return true;
+
+    case ajn::ALLJOYN_INT16_ARRAY:
+    case ajn::ALLJOYN_UINT16_ARRAY:
+        HashBytes(hash, arg.v_scalarArray.v_uint16, arg.v_scalarArray.numElements * sizeof(uint16_t));
+        return true;
+
+    case ajn::ALLJOYN_INT32_ARRAY:
+    case ajn::ALLJOYN_UINT32_ARRAY:
+        HashBytes(hash, arg.v_scalarArray.v_uint32, arg.v_scalarArray.numElements * sizeof(uint32_t));
+        return true;
+
+    case ajn::ALLJOYN_INT64_ARRAY:
+    case ajn::ALLJOYN_UINT64_ARRAY:
+    case ajn::ALLJOYN_DOUBLE_ARRAY:
+        HashBytes(hash, arg.v_scalarArray.v_uint64, arg.v_scalarArray.numElements * sizeof(uint64_t));
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+QStatus ProvidedInterface::RefreshProperties()
+{
+    propertiesMutex.Lock();
+    {
+        // the marshaled properties are cached, keep them out of any arena
+        MarshalArena::Scope heap(NULL);
+        _status = MarshalProperties();
+    }
+    // the cached values may have been touched even if marshaling failed
+    bool changed = (ER_OK != _status);
+    if (ER_OK == _status) {
+        std::map<qcc::String, PropertyValue*>::iterator it;
+        for (it = marshaledProperties.begin(); it != marshaledProperties.end(); ++it) {
+            PropertyValue* pv = it->second;
+            uint64_t hash = FNV_OFFSET;
+            bool hashed = HashMsgArg(hash, pv->msgArg);
+
+            if (!hashed || !pv->hashed || (hash != pv->hash)) {
+                pv->dirty = true;
+                changed = true;
+            }
+            pv->hash = hash;
+            pv->hashed = hashed;
+        }
+    }
+    // a GetAll reply built before stays valid as long as nothing changed
+    if (changed) {
+        propertiesVersion++;
+    }
+    propertiesMutex.Unlock();
+    return _status;
+}
 
-    return SignalUpdate();
+void ProvidedInterface::MarkAllDirty()
+{
+    std::map<qcc::String, PropertyValue*>::iterator it;
+    for (it = marshaledProperties.begin(); it != marshaledProperties.end(); ++it) {
+        it->second->dirty = true;
+    }
 }
 
-QStatus ProvidedInterface::SignalUpdate()
+QStatus ProvidedInterface::SignalUpdate(uint64_t trace)
 {
     /* Get list of properties that have to be emitted */
-    std::vector<const char*> propertyNames = desc.GetEmittablePropertyNames();
+    std::vector<const char*> propertyNames;
+    std::map<qcc::String, PropertyValue*>::iterator it;
+
+    propertyNames.reserve(marshaledProperties.size());
+    for (it = marshaledProperties.begin(); it != marshaledProperties.end(); ++it) {
+        if (it->second->dirty) {
+            propertyNames.push_back(it->first.c_str());
+        }
+    }
     invalidatedPropertiesMutex.Lock(); /* for safe altering invalidatedProperties list */
     propertyNames.insert(propertyNames.end(), invalidatedProperties.begin(), invalidatedProperties.end());
     invalidatedProperties.clear();
     invalidatedPropertiesMutex.Unlock();
+
+    if (propertyNames.empty()) {
+        /* nothing changed */
+        return ER_OK;
+    }
+
     /* signal change */
-    return object->EmitPropChanged(desc.GetName().c_str(), &propertyNames[0],
-                                   propertyNames.size(), ajn::SESSION_ID_ALL_HOSTED, 0);
+    QStatus status = object->EmitPropChanged(desc.GetName().c_str(), &propertyNames[0],
+                                             propertyNames.size(), ajn::SESSION_ID_ALL_HOSTED, 0);
+    if (ER_OK == status) {
+        UpdateTracer::Record(trace, UpdateTracer::EMITTED);
+        Metrics::Increment(Metrics::PROVIDER_UPDATES);
+        for (it = marshaledProperties.begin(); it != marshaledProperties.end(); ++it) {
+            it->second->dirty = false;
+        }
+    }
+    return status;
 }
 
 QStatus ProvidedInterface::EmitSignal(int signalNumber,
@@ -110,24 +299,89 @@ QStatus ProvidedInterface::GetStatus() const
 
 QStatus ProvidedInterface::GetProperty(const char* propName, ajn::MsgArg& value)
 {
-    qcc::String annotation;
-    const ajn::InterfaceDescription ifDesc = iface->GetInterfaceDescription();
-    ifDesc.GetPropertyAnnotation(propName, ajn::org::freedesktop::DBus::AnnotateEmitsChanged, annotation);
-
-    if (annotation == "true") {
+    // only properties that emit changes (EmitsChangedSignal == true) are cached
+    propertiesMutex.Lock();
+    std::map<qcc::String, PropertyValue*>::const_iterator it = marshaledProperties.find(propName);
+    if (it != marshaledProperties.end()) {
         // Get will be done on the cache
-        std::map<qcc::String, PropertyValue*>::const_iterator it = marshaledProperties.find(propName);
-        if (it != marshaledProperties.end()) {
-            value = it->second->msgArg;
-            _status = ER_OK;
-        }
+        value = it->second->msgArg;
+        propertiesMutex.Unlock();
+        _status = ER_OK;
     } else {
-        // Get will be handled by ProvidedInterface derived class
+        // Get will be handled by ProvidedInterface derived class, which may take its own locks
+        propertiesMutex.Unlock();
         _status = DispatchGetProperty(propName, value);
     }
     return _status;
 }
 
+/**
+ * The cached part of a GetAll reply
+ */
+struct ProvidedInterface::GetAllReply {
+    /** names of the cached properties, the keys of marshaledProperties */
+    std::vector<const char*> names;
+    /** copies of the cached property values */
+    std::vector<ajn::MsgArg> values;
+    /** dictionary entries referring to names and values */
+    std::vector<ajn::MsgArg> entries;
+};
+
+QStatus ProvidedInterface::ReplyGetAll(const ajn::Message& msg)
+{
+    QStatus status = ER_OK;
+
+    // only copy the cached values under the lock, the application callbacks
+    // and the reply run unlocked as they may block or take other locks
+    propertiesMutex.Lock();
+    if (!getAllReply || (getAllVersion != propertiesVersion)) {
+        std::shared_ptr<GetAllReply> reply = std::make_shared<GetAllReply>();
+        reply->names.reserve(marshaledProperties.size());
+        reply->values.reserve(marshaledProperties.size());
+        std::map<qcc::String, PropertyValue*>::iterator it;
+        for (it = marshaledProperties.begin(); it != marshaledProperties.end(); ++it) {
+            reply->names.push_back(it->first.c_str());
+            reply->values.push_back(it->second->msgArg);
+        }
+        reply->entries.resize(reply->values.size());
+        for (size_t i = 0; i < reply->values.size(); ++i) {
+            reply->entries[i].Set("{sv}", reply->names[i], &reply->values[i]);
+        }
+        getAllReply = reply;
+        getAllVersion = propertiesVersion;
+    }
+    std::shared_ptr<const GetAllReply> cached = getAllReply;
+    propertiesMutex.Unlock();
+
+    ajn::MsgArg dict;
+    std::vector<ajn::MsgArg> values(uncachedProperties.size());
+    std::vector<ajn::MsgArg> entries;
+    if (uncachedProperties.empty()) {
+        dict.Set("a{sv}", cached->entries.size(), cached->entries.empty() ? NULL : &cached->entries[0]);
+    } else {
+        size_t numCached = cached->values.size();
+        entries.resize(numCached + uncachedProperties.size());
+        for (size_t i = 0; i < numCached; ++i) {
+            entries[i].Set("{sv}", cached->names[i], &cached->values[i]);
+        }
+        for (size_t i = 0; (ER_OK == status) && (i < uncachedProperties.size()); ++i) {
+            status = DispatchGetProperty(uncachedProperties[i], values[i]);
+            if (ER_OK == status) {
+                entries[numCached + i].Set("{sv}", uncachedProperties[i], &values[i]);
+            }
+        }
+        dict.Set("a{sv}", entries.size(), &entries[0]);
+    }
+
+    if (ER_OK == status) {
+        status = object->MethodReply(msg, &dict, 1);
+    } else {
+        QCC_LogError(status, ("Failed to get properties of interface '%s'", desc.GetName().c_str()));
+        object->MethodReplyErrorCode(msg, status);
+    }
+    return status;
+}
+
 QStatus ProvidedInterface::SetProperty(const char* propName, ajn::MsgArg& value)
 {
     return DispatchSetProperty(propName, value);
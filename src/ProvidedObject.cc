@@ -142,11 +142,14 @@ QStatus ProvidedObject::UpdateAll()
     std::map<qcc::String, const ProvidedInterface*>::iterator endit = interfaces.end();
     for (; it != endit; ++it) {
         ProvidedInterface* intf = const_cast<ProvidedInterface*>(it->second);
-        if (ER_OK != (status = intf->MarshalProperties())) {
+        if (ER_OK != (status = intf->RefreshProperties())) {
             return status;
         }
     }
 
+    // A newly exposed object announces all its properties
+    bool exposed = (ST_REGISTERED != providedObjectImpl->GetState());
+
     // Register the object on the bus
     status = providedObjectImpl->Register();
     if (ER_OK != status) {
@@ -155,9 +158,13 @@ QStatus ProvidedObject::UpdateAll()
     }
 
     // Call the propertiesChanged signal for all provided interfaces of the object
+    // (the properties were marshaled above, no need to go through Update again)
     for (it = interfaces.begin(); it != endit; ++it) {
         ProvidedInterface* intf = const_cast<ProvidedInterface*>(it->second);
-        status = intf->Update();
+        if (exposed) {
+            intf->MarkAllDirty();
+        }
+        status = intf->SignalUpdate();
         if (ER_OK != status) {
             QCC_LogError(status, ("Failed to update for a given interface"));
             return status;
@@ -200,4 +207,14 @@ QStatus ProvidedObject::Set(const char* ifcName, const char* propName, ajn::MsgA
     }
     return status;
 }
+
+QStatus ProvidedObject::ReplyGetAll(const char* ifcName, const ajn::Message& msg)
+{
+    QStatus status = ER_BUS_NO_SUCH_INTERFACE;
+    ProvidedInterface* intf = const_cast<ProvidedInterface*>(GetInterfaceByName(ifcName));
+    if (NULL != intf) {
+        status = intf->ReplyGetAll(msg);
+    }
+    return status;
+}
 }
@@ -15,6 +15,7 @@
  ******************************************************************************/
 
 #include <datadriven/ProvidedInterface.h>
+#include <datadriven/Metrics.h>
 
 #include <algorithm>
 
@@ -63,14 +64,14 @@ ProvidedObjectImpl::ProvidedObjectImpl(std::weak_ptr<ObjectAdvertiserImpl> objec
                                        const qcc::String& path,
                                        ProvidedObject& obj) :
     BusObject(path.c_str()), objectAdvertiserImpl(objectAdvertiserImpl), state(ProvidedObject::ST_CONSTRUCTED),
-    providedObject(obj)
+    mutex(false), providedObject(obj)
 {
 }
 
 ProvidedObjectImpl::ProvidedObjectImpl(std::weak_ptr<ObjectAdvertiserImpl> objectAdvertiserImpl,
                                        ProvidedObject& obj) :
     BusObject(GeneratePath().c_str()), objectAdvertiserImpl(objectAdvertiserImpl),
-    state(ProvidedObject::ST_CONSTRUCTED), providedObject(obj)
+    state(ProvidedObject::ST_CONSTRUCTED), mutex(false), providedObject(obj)
 {
 }
 
@@ -80,9 +81,9 @@ ProvidedObjectImpl::~ProvidedObjectImpl()
 
 qcc::String ProvidedObjectImpl::GeneratePath()
 {
-    qcc::String guid;
-    GuidUtil::GetInstance()->GenerateGUID(&guid);
-    return "/O" + guid;
+    char path[2 + GUID_STRING_MAX_LENGTH + END_OF_STRING_LENGTH] = { '/', 'O' };
+    GuidUtil::GetInstance()->GenerateGUID(path + 2);
+    return qcc::String(path);
 }
 
 QStatus ProvidedObjectImpl::Register()
@@ -118,22 +119,27 @@ void ProvidedObjectImpl::CallMethodHandler(ajn::MessageReceiver::MethodHandler h
         // of the DDAPI and we use the mechanism of BusObject.h
         (this->*handler)(member, message);
     } else {
-        qcc::String name = member->iface->GetName();
-        mutex.Lock();
-        std::vector<qcc::String>::iterator it = std::find(interfaceNames.begin(), interfaceNames.end(), name);
-        if (it != interfaceNames.end()) {
+        std::unordered_map<const ajn::InterfaceDescription::Member*, DispatchInterface*>::const_iterator it =
+            dispatchTable.find(member);
+        bool known = (it != dispatchTable.end()) && it->second->provided.load(std::memory_order_acquire);
+        if (known) {
+            Metrics::Increment(Metrics::PROVIDER_METHOD_CALLS);
             ajn::MessageReceiver* ctxObject = static_cast<ajn::MessageReceiver*>(context);
             std::shared_ptr<ObjectAdvertiserImpl> advertiser = objectAdvertiserImpl.lock();
-            if (advertiser) {
-                advertiser->ProviderAsyncEnqueue(new MethodHandlerTask(objectAdvertiserImpl,
-                                                                       self,
-                                                                       ctxObject,
-                                                                       handler,
-                                                                       member,
-                                                                       message));
+            if (advertiser &&
+                !advertiser->ProviderAsyncEnqueue(new MethodHandlerTask(objectAdvertiserImpl,
+                                                                        self,
+                                                                        ctxObject,
+                                                                        handler,
+                                                                        member,
+                                                                        message))) {
+                // the method handlers fell behind; fail the call now rather than
+                // keep the bus thread waiting (the queue counts it as dropped)
+                QStatus status = ER_BUS_METHOD_CALL_ABORTED;
+                QCC_LogError(status, ("Method handlers fell behind, refusing call to '%s'", member->name.c_str()));
+                MethodReply(message, status);
             }
         }
-        mutex.Unlock();
     }
 }
 
@@ -176,6 +182,8 @@ QStatus ProvidedObjectImpl::EmitSignal(const ajn::InterfaceDescription::Member&
         if (status != ER_OK) {
             QCC_LogError(status, ("Failed to emit signal '%s' in interface '%s' for bus object at path '%s'",
                                   signal.name.c_str(), signal.iface->GetName(), GetPath()));
+        } else {
+            Metrics::Increment(Metrics::PROVIDER_SIGNALS);
         }
     }
     return status;
@@ -220,6 +228,11 @@ void ProvidedObjectImpl::RemoveInterfaceName(const qcc::String& name)
     if (it != interfaceNames.end()) {
         interfaceNames.erase(it);
     }
+    for (size_t i = 0; i < dispatchInterfaces.size(); ++i) {
+        if (name == dispatchInterfaces[i]->iface->GetName()) {
+            dispatchInterfaces[i]->provided.store(false, std::memory_order_release);
+        }
+    }
     mutex.Unlock();
 }
 
@@ -231,24 +244,73 @@ const char* ProvidedObjectImpl::GetPath() const
 
 QStatus ProvidedObjectImpl::Get(const char* ifcName, const char* propName, ajn::MsgArg& val)
 {
+    Metrics::Increment(Metrics::PROVIDER_GETS);
     return providedObject.Get(ifcName, propName, val);
 }
 
 QStatus ProvidedObjectImpl::Set(const char* ifcName, const char* propName, ajn::MsgArg& val)
 {
+    Metrics::Increment(Metrics::PROVIDER_SETS);
     return providedObject.Set(ifcName, propName, val);
 }
 
+void ProvidedObjectImpl::GetAllProps(const ajn::InterfaceDescription::Member* member, ajn::Message& msg)
+{
+    const ajn::MsgArg* ifcArg = msg->GetArg(0);
+    if ((NULL != ifcArg) && (ajn::ALLJOYN_STRING == ifcArg->typeId)) {
+        if (ER_BUS_NO_SUCH_INTERFACE != providedObject.ReplyGetAll(ifcArg->v_string.str, msg)) {
+            return;
+        }
+    }
+    BusObject::GetAllProps(member, msg);
+}
+
+ProvidedObjectImpl::DispatchInterface* ProvidedObjectImpl::FindDispatchInterface(
+    const ajn::InterfaceDescription* iface) const
+{
+    for (size_t i = 0; i < dispatchInterfaces.size(); ++i) {
+        if (iface == dispatchInterfaces[i]->iface) {
+            return dispatchInterfaces[i].get();
+        }
+    }
+    return NULL;
+}
+
 QStatus ProvidedObjectImpl::AddInterfaceToBus(const ajn::InterfaceDescription& iface)
 {
-    return BusObject::AddInterface(iface, ajn::BusObject::ANNOUNCED);
+    if (ProvidedObject::ST_REGISTERED == state) {
+        QCC_LogError(ER_BUS_CANNOT_ADD_INTERFACE, ("Cannot add an interface to an object on the bus"));
+        return ER_BUS_CANNOT_ADD_INTERFACE;
+    }
+
+    QStatus status = BusObject::AddInterface(iface, ajn::BusObject::ANNOUNCED);
+    if (ER_OK == status) {
+        mutex.Lock();
+        dispatchInterfaces.push_back(std::unique_ptr<DispatchInterface>(new DispatchInterface(&iface)));
+        mutex.Unlock();
+    }
+    return status;
 }
 
 QStatus ProvidedObjectImpl::AddMethodHandlerToBus(const ajn::InterfaceDescription::Member* member,
                                                   ajn::MessageReceiver::MethodHandler handler,
                                                   void* context)
 {
-    return BusObject::AddMethodHandler(member, handler, context);
+    if (ProvidedObject::ST_REGISTERED == state) {
+        QCC_LogError(ER_BUS_CANNOT_ADD_HANDLER, ("Cannot add a method handler to an object on the bus"));
+        return ER_BUS_CANNOT_ADD_HANDLER;
+    }
+
+    QStatus status = BusObject::AddMethodHandler(member, handler, context);
+    if ((ER_OK == status) && (NULL != context)) {
+        mutex.Lock();
+        DispatchInterface* dispatch = FindDispatchInterface(member->iface);
+        if (NULL != dispatch) {
+            dispatchTable[member] = dispatch;
+        }
+        mutex.Unlock();
+    }
+    return status;
 }
 
 void ProvidedObjectImpl::SetRefCountedPtr(std::weak_ptr<ProvidedObjectImpl> obj)
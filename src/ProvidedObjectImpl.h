@@ -17,7 +17,9 @@
 #ifndef PROVIDEDOBJECTIMPL_H_
 #define PROVIDEDOBJECTIMPL_H_
 
+#include <atomic>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include <alljoyn/BusObject.h>
@@ -158,8 +160,28 @@ class ProvidedObjectImpl :
 
     QStatus Register();
 
+    /**
+     * Adds an interface to the bus object. Interfaces can only be added
+     * while the object is not exposed on the bus.
+     * \param iface the interface description
+     * \retval ER_OK on success
+     * \retval ER_BUS_CANNOT_ADD_INTERFACE if the object is exposed on the bus
+     * \retval others on failure
+     */
     QStatus AddInterfaceToBus(const ajn::InterfaceDescription& iface);
 
+    /**
+     * Adds a method handler to the bus object and to its dispatch table.
+     * Like interfaces, handlers can only be added while the object is not
+     * exposed on the bus.
+     * \param member the method member of an interface added before
+     * \param handler the handler
+     * \param context the ProvidedInterface implementing the method, or NULL
+     *                for handlers of the BusObject itself
+     * \retval ER_OK on success
+     * \retval ER_BUS_CANNOT_ADD_HANDLER if the object is exposed on the bus
+     * \retval others on failure
+     */
     QStatus AddMethodHandlerToBus(const ajn::InterfaceDescription::Member* member,
                                   ajn::MessageReceiver::MethodHandler handler,
                                   void* context = NULL);
@@ -197,16 +219,49 @@ class ProvidedObjectImpl :
     ProvidedObjectImpl(std::weak_ptr<ObjectAdvertiserImpl> objectAdvertiser,
                        ProvidedObject& obj);
 
+  protected:
+    /**
+     * Handle a bus request to read all properties of an interface.
+     *
+     * For the interfaces of the provided object the reply is built from the
+     * cached properties of the ProvidedInterface, instead of through a Get
+     * call per property. Other interfaces are handled by the BusObject.
+     */
+    virtual void GetAllProps(const ajn::InterfaceDescription::Member* member,
+                             ajn::Message& msg);
+
   private:
     /* unfortunately BusObject does not expose its interfaces.
      * Maybe in the future we can change this at BusObject level and then we don't need to store it ourselves.. */
     std::weak_ptr<ObjectAdvertiserImpl> objectAdvertiserImpl;
     ProvidedObject::State state;
     std::weak_ptr<ProvidedObjectImpl> self; // Weak pointer that can be passed to other objects
-    datadriven::Mutex mutex;
+    datadriven::Mutex mutex; /* protects interfaceNames and dispatchInterfaces */
     std::vector<qcc::String> interfaceNames;
     ProvidedObject& providedObject;
 
+    /**
+     * Dispatch state of an interface added to the bus object. The interface
+     * stays on the BusObject when it is removed from the provided object,
+     * so its method calls are dropped from then on.
+     */
+    struct DispatchInterface {
+        const ajn::InterfaceDescription* iface;
+        std::atomic<bool> provided;
+
+        DispatchInterface(const ajn::InterfaceDescription* iface) :
+            iface(iface), provided(true) { }
+    };
+
+    /* One entry per interface, in the order they were added */
+    std::vector<std::unique_ptr<DispatchInterface> > dispatchInterfaces;
+
+    /* Method member to the interface it belongs to. Only modified while the
+     * object is not on the bus, so method calls look it up without locking. */
+    std::unordered_map<const ajn::InterfaceDescription::Member*, DispatchInterface*> dispatchTable;
+
+    DispatchInterface* FindDispatchInterface(const ajn::InterfaceDescription* iface) const;
+
     void CallMethodHandler(ajn::MessageReceiver::MethodHandler handler,
                            const ajn::InterfaceDescription::Member* member,
                            ajn::Message& message,
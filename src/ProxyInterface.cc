@@ -19,6 +19,8 @@
 #include <datadriven/Marshal.h>
 #include <datadriven/ProxyInterface.h>
 
+#include "DeadlineCall.h"
+#include "ObserverManager.h"
 #include "RegisteredTypeDescription.h"
 
 #include <qcc/Debug.h>
@@ -27,6 +29,92 @@
 namespace datadriven {
 using namespace ajn;
 
+/**
+ * Applies fetched property values through the observer cache, so observers
+ * are notified as for a PropertiesChanged signal.
+ */
+class PropertiesUpdateTask :
+    public ObserverManager::Task {
+  public:
+    PropertiesUpdateTask(const ObjectId& objId,
+                         const qcc::String& ifName,
+                         const ajn::MsgArg& values) :
+        objId(objId), ifName(ifName), values(values) { }
+
+    void Execute() const
+    {
+        std::shared_ptr<ObserverManager> mgr = ObserverManager::GetInstance();
+        if (mgr) {
+            std::shared_ptr<ObserverCache> cache = mgr->GetCache(ifName);
+            if (cache) {
+                cache->UpdateObject(objId, &values);
+            }
+        }
+    }
+
+  private:
+    ObjectId objId;
+    qcc::String ifName;
+    ajn::MsgArg values;
+};
+
+/**
+ * Receives the reply of a stale property refresh. Deletes itself when the
+ * reply is handled, so it does not depend on the lifetime of the proxy.
+ */
+class ProxyInterface::RefreshListener :
+    public ajn::ProxyBusObject::Listener {
+  public:
+    RefreshListener(const ObjectId& objId,
+                    const qcc::String& ifName,
+                    const qcc::String& propName) :
+        objId(objId), ifName(ifName), propName(propName) { }
+
+    void OnGetProperty(QStatus status,
+                       ajn::ProxyBusObject* obj,
+                       const ajn::MsgArg& value,
+                       void* context)
+    {
+        if (ER_OK == status) {
+            ajn::MsgArg entry;
+            ajn::MsgArg dict;
+            ajn::MsgArg* val = const_cast<ajn::MsgArg*>(&datadriven::MsgArgDereference(value));
+            entry.Set("{sv}", propName.c_str(), val);
+            dict.Set("a{sv}", 1, &entry);
+            Deliver(dict);
+        } else {
+            QCC_LogError(status, ("Failed to refresh property '%s'", propName.c_str()));
+        }
+        delete this;
+    }
+
+    void OnGetAllProperties(QStatus status,
+                            ajn::ProxyBusObject* obj,
+                            const ajn::MsgArg& values,
+                            void* context)
+    {
+        if (ER_OK == status) {
+            Deliver(values);
+        } else {
+            QCC_LogError(status, ("Failed to refresh properties of '%s'", ifName.c_str()));
+        }
+        delete this;
+    }
+
+  private:
+    ObjectId objId;
+    qcc::String ifName;
+    qcc::String propName;
+
+    void Deliver(const ajn::MsgArg& values)
+    {
+        std::shared_ptr<ObserverManager> mgr = ObserverManager::GetInstance();
+        if (mgr) {
+            mgr->Enqueue(new PropertiesUpdateTask(objId, ifName, values), ObserverManager::Lane::UPDATE);
+        }
+    }
+};
+
 const ObjectId& ProxyInterface::GetObjectId() const
 {
     return objId;
@@ -34,13 +122,18 @@ const ObjectId& ProxyInterface::GetObjectId() const
 
 ProxyInterface::ProxyInterface(const RegisteredTypeDescription& desc,
                                const ObjectId& objId) :
-    status(ER_FAIL), desc(desc), objId(objId), alive(false), propChangedListener(nullptr)
+    status(ER_FAIL), desc(desc), objId(objId), liveness(0), mutex(false), propChangedListener(nullptr)
 {
     proxyBusObject = objId.MakeProxyBusObject();
     status = proxyBusObject.AddInterface(desc.GetInterfaceDescription());
     if (ER_OK != status) {
         QCC_LogError(status, ("Failed to add interface"));
     }
+
+    const std::vector<const char*> names = desc.GetDescription().GetInvalidatingPropertyNames();
+    for (std::vector<const char*>::const_iterator it = names.begin(); it != names.end(); ++it) {
+        lazyProperties[*it] = LazyProperty();
+    }
 }
 
 ProxyInterface::~ProxyInterface()
@@ -77,18 +170,26 @@ const RegisteredTypeDescription& ProxyInterface::GetTypeDescription() const
 
 bool ProxyInterface::IsAlive() const
 {
-    bool retval;
-    mutex.Lock();
-    retval = alive;
-    mutex.Unlock();
-    return retval;
+    return IsAlive(GetLiveness());
+}
+
+uint32_t ProxyInterface::GetLiveness() const
+{
+    return liveness.load(std::memory_order_acquire);
 }
 
 void ProxyInterface::SetAlive(bool _alive)
 {
-    mutex.Lock();
-    alive = _alive;
-    mutex.Unlock();
+    uint32_t current = liveness.load(std::memory_order_relaxed);
+    do {
+        if (IsAlive(current) == _alive) {
+            return;
+        }
+    } while (!liveness.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel));
+    if (_alive) {
+        // calls made under a CallDeadline may be waiting for this object
+        DeadlineCall::NotifyAlive();
+    }
 }
 
 const ajn::ProxyBusObject& ProxyInterface::GetProxyBusObject() const
@@ -151,9 +252,127 @@ void ProxyInterface::UpdateProperties(const ajn::MsgArg* values)
                         QCC_LogError(status, ("ProxyInterface: Failed to unmarshal property: %s", key->v_string.str));
                         break;
                     }
+                    if (!lazyProperties.empty()) {
+                        CacheProperty(key->v_string.str, msgarg);
+                    }
                 }
             }
         }
     }
 }
+
+void ProxyInterface::InvalidateProperties(const ajn::MsgArg& invalidated)
+{
+    if ((ajn::ALLJOYN_ARRAY != invalidated.typeId) || lazyProperties.empty()) {
+        return;
+    }
+
+    const ajn::MsgArg* elem = invalidated.v_array.GetElements();
+    size_t numElem = invalidated.v_array.GetNumElements();
+    mutex.Lock();
+    for (size_t i = 0; i < numElem; i++) {
+        if (ajn::ALLJOYN_STRING == elem[i].typeId) {
+            std::map<qcc::String, LazyProperty>::iterator it = lazyProperties.find(elem[i].v_string.str);
+            if (it != lazyProperties.end()) {
+                it->second.valid = false;
+                it->second.value.Clear();
+            }
+        }
+    }
+    mutex.Unlock();
+}
+
+void ProxyInterface::CacheProperty(const char* propName, const ajn::MsgArg& value)
+{
+    mutex.Lock();
+    std::map<qcc::String, LazyProperty>::iterator it = lazyProperties.find(propName);
+    if (it != lazyProperties.end()) {
+        it->second.value = value;
+        it->second.valid = true;
+    }
+    mutex.Unlock();
+}
+
+bool ProxyInterface::GetCachedProperty(const char* propName, ajn::MsgArg& value) const
+{
+    bool retval = false;
+    mutex.Lock();
+    std::map<qcc::String, LazyProperty>::const_iterator it = lazyProperties.find(propName);
+    if ((it != lazyProperties.end()) && it->second.valid) {
+        value = it->second.value;
+        retval = true;
+    }
+    mutex.Unlock();
+    return retval;
+}
+
+bool ProxyInterface::IsStale(const char* propName) const
+{
+    bool retval = false;
+    mutex.Lock();
+    std::map<qcc::String, LazyProperty>::const_iterator it = lazyProperties.find(propName);
+    if (it != lazyProperties.end()) {
+        retval = !it->second.valid;
+    }
+    mutex.Unlock();
+    return retval;
+}
+
+bool ProxyInterface::HasStaleProperties() const
+{
+    bool retval = false;
+    mutex.Lock();
+    std::map<qcc::String, LazyProperty>::const_iterator it;
+    for (it = lazyProperties.begin(); !retval && (it != lazyProperties.end()); ++it) {
+        retval = !it->second.valid;
+    }
+    mutex.Unlock();
+    return retval;
+}
+
+QStatus ProxyInterface::RefreshStaleProperties(uint32_t timeout)
+{
+    QStatus result = ER_OK;
+    qcc::String propName;
+    size_t numStale;
+    bool isAlive;
+
+    mutex.Lock();
+    std::map<qcc::String, LazyProperty>::const_iterator it;
+    for (it = lazyProperties.begin(), numStale = 0; it != lazyProperties.end(); ++it) {
+        if (!it->second.valid) {
+            propName = it->first;
+            numStale++;
+        }
+    }
+    mutex.Unlock();
+    isAlive = IsAlive();
+
+    if (0 == numStale) {
+        return ER_OK;
+    }
+    if (!isAlive) {
+        result = ER_FAIL;   /* Is there a more suitable error ? */
+        QCC_LogError(result, ("Cannot refresh properties of dead object"));
+        return result;
+    }
+
+    const qcc::String& ifName = desc.GetDescription().GetName();
+    RefreshListener* listener = new RefreshListener(objId, ifName, propName);
+    if (1 == numStale) {
+        ajn::ProxyBusObject::Listener::GetPropertyCB cb =
+            static_cast<ajn::ProxyBusObject::Listener::GetPropertyCB>(&RefreshListener::OnGetProperty);
+        result = proxyBusObject.GetPropertyAsync(ifName.c_str(), propName.c_str(), listener, cb, NULL, timeout);
+    } else {
+        // several stale properties, fetch them all in a single round trip
+        ajn::ProxyBusObject::Listener::GetAllPropertiesCB cb =
+            static_cast<ajn::ProxyBusObject::Listener::GetAllPropertiesCB>(&RefreshListener::OnGetAllProperties);
+        result = proxyBusObject.GetAllPropertiesAsync(ifName.c_str(), listener, cb, NULL, timeout);
+    }
+    if (ER_OK != result) {
+        QCC_LogError(result, ("Failed to refresh stale properties"));
+        delete listener;
+    }
+    return result;
+}
 }
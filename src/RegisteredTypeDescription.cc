@@ -49,6 +49,9 @@ QStatus RegisteredTypeDescription::RegisterInterface(ajn::BusAttachment& ba,
         if (ER_OK == status) {
             status = desc.ResolveMembers(*inst->iface, &inst->member);
         }
+        if (ER_OK == status) {
+            inst->ResolveAnnotations();
+        }
     }
 
     if (status != ER_OK) {
@@ -82,4 +85,23 @@ const ajn::InterfaceDescription::Member& RegisteredTypeDescription::GetMember(in
 {
     return *member[memberNumber];
 }
+
+bool RegisteredTypeDescription::IsNoReply(int memberNumber) const
+{
+    return noReply[memberNumber];
+}
+
+void RegisteredTypeDescription::ResolveAnnotations()
+{
+    size_t numMembers = desc.GetMemberCount();
+
+    noReply.assign(numMembers, false);
+    for (size_t i = 0; i < numMembers; i++) {
+        qcc::String value;
+        if ((NULL != member[i]) && (ajn::MESSAGE_METHOD_CALL == member[i]->memberType) &&
+            member[i]->GetAnnotation(ajn::org::freedesktop::DBus::AnnotateNoReply, value)) {
+            noReply[i] = (value == "true");
+        }
+    }
+}
 };
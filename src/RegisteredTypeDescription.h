@@ -18,6 +18,7 @@
 #define REGISTEREDTYPEDESCRIPTION_H_
 
 #include <memory>
+#include <vector>
 
 #include <alljoyn/BusAttachment.h>
 #include <alljoyn/InterfaceDescription.h>
@@ -50,6 +51,9 @@ class RegisteredTypeDescription {
     /** Get specific member of AJN-level interface description */
     const ajn::InterfaceDescription::Member& GetMember(int memberNumber) const;
 
+    /** Whether member \a memberNumber is a method annotated with NoReply (resolved at registration) */
+    bool IsNoReply(int memberNumber) const;
+
     ~RegisteredTypeDescription();
 
   protected:
@@ -62,8 +66,14 @@ class RegisteredTypeDescription {
     /** array of pointer to ajn members */
     const ajn::InterfaceDescription::Member** member;
 
+    /** NoReply annotation per member, indexed like member */
+    std::vector<bool> noReply;
+
   private:
     RegisteredTypeDescription(const TypeDescription& desc);
+
+    /** Look up the annotations of all members once, see IsNoReply */
+    void ResolveAnnotations();
 };
 }
 
@@ -27,6 +27,8 @@
 
 #define PING_GROUP "DDAPI"
 #define PING_TIME 15
+/** Number of pending session leaves beyond which leaves of the same session are merged */
+#define SESSION_QUEUE_CAPACITY 1024
 
 using namespace ajn;
 using namespace datadriven;
@@ -40,6 +42,7 @@ SessionManager::SessionManager(BusAttachment& ba) :
     pingListener(new AutoPingListener(this))
 {
     do {
+        async.SetCapacity(SESSION_QUEUE_CAPACITY, AsyncTaskQueue::OVERFLOW_COALESCE);
         async.AsyncTaskQueue::Start();
 
         pingManager = std::unique_ptr<ajn::AutoPinger>(new ajn::AutoPinger(ba));
@@ -78,6 +81,25 @@ QStatus SessionManager::GetStatus() const
     return ret;
 }
 
+AsyncTaskQueue::Stats SessionManager::GetQueueStats() const
+{
+    return async.GetStats();
+}
+
+void SessionManager::CollectMetrics(Metrics::Snapshot& snapshot) const
+{
+    mutex.Lock(__FUNCTION__, __LINE__);
+    snapshot.sessions += sessions.size();
+    for (SessionVector::const_iterator it = sessions.begin(); it != sessions.end(); ++it) {
+        if ((*it).IsEstablished()) {
+            snapshot.establishedSessions++;
+        }
+    }
+    mutex.Unlock(__FUNCTION__, __LINE__);
+
+    async.CollectMetrics("session", snapshot);
+}
+
 bool SessionManager::IsSessionEstablished(const qcc::String& uniqueBusName,
                                           const ajn::SessionPort port) const
 {
@@ -207,9 +229,15 @@ void SessionManager::JoinSessionCB(QStatus status, SessionId id,
         }
         if (ER_OK != status) {
             QCC_LogError(status, ("Session could not be joined"));
+            Metrics::Increment(Metrics::SESSION_JOIN_FAILURES);
             break;
         }
 
+        Metrics::Increment(Metrics::SESSION_JOINS);
+        if (session->GetJoinStarted() != 0) {
+            Metrics::RecordTiming(Metrics::SESSION_JOIN_LATENCY, MutexProfiler::Now() - session->GetJoinStarted());
+        }
+
         QCC_DbgPrintf(("Session %lu established with %s", (unsigned long)id, session->GetBusName().c_str()));
         SessionVector::iterator sessionIt = std::search_n(sessions.begin(), sessions.end(), 1,
                                                           *session, SessionManager::SessionComp);
@@ -248,6 +276,8 @@ void SessionManager::SessionLost(ajn::SessionId sessionId, SessionLostReason rea
             break;
         }
 
+        Metrics::Increment(Metrics::SESSION_LOSSES);
+
         // Inform about our loss
         for (SessionListenerSet::iterator it = sessionListeners.begin(); it != sessionListeners.end(); it++) {
             (*it)->OnSessionLost(*sessionIt, sessionId);
@@ -281,8 +311,25 @@ QStatus SessionManager::JoinSession(Session* session)
 {
     SessionOpts opts(SessionOpts::TRAFFIC_MESSAGES, false, SessionOpts::PROXIMITY_ANY, TRANSPORT_ANY);
 
-    return clientBusAttachment.JoinSessionAsync(session->GetBusName().c_str(), session->GetPort(),
-                                                this, opts, this, (void*)session);
+    session->JoinStarted(Metrics::IsEnabled() ? MutexProfiler::Now() : 0);
+    QStatus status = clientBusAttachment.JoinSessionAsync(session->GetBusName().c_str(), session->GetPort(),
+                                                          this, opts, this, (void*)session);
+    if (ER_OK != status) {
+        Metrics::Increment(Metrics::SESSION_JOIN_FAILURES);
+    }
+    return status;
+}
+
+bool SessionManager::OnCoalesceKey(TaskData const* taskdata, uint64_t& key)
+{
+    key = static_cast<const LeaveSessionData*>(taskdata)->GetSessionId();
+    return true;
+}
+
+bool SessionManager::OnCoalesce(TaskData const* queued, TaskData const* incoming)
+{
+    return static_cast<const LeaveSessionData*>(queued)->GetSessionId() ==
+           static_cast<const LeaveSessionData*>(incoming)->GetSessionId();
 }
 
 void SessionManager::OnTask(TaskData const* taskdata)
@@ -340,6 +387,8 @@ void SessionManager::AutoPingListener::DestinationLost(const qcc::String& group,
     for (SessionManager::SessionVector::iterator itSession = sessionMgr->sessions.begin();
          itSession != sessionMgr->sessions.end(); itSession++) {
         if (((*itSession).GetBusName() == destination) && (*itSession).IsEstablished()) {
+            Metrics::Increment(Metrics::SESSION_LOSSES);
+
             // Inform about our loss
             for (SessionManager::SessionListenerSet::iterator it = sessionMgr->sessionListeners.begin();
                  it != sessionMgr->sessionListeners.end();
@@ -29,6 +29,7 @@
 #include <alljoyn/PingListener.h>
 #include <alljoyn/AutoPinger.h>
 
+#include <datadriven/Metrics.h>
 #include <datadriven/Mutex.h>
 #include "common/AsyncTaskQueue.h"
 
@@ -62,6 +63,19 @@ class SessionManager :
      */
     QStatus GetStatus() const;
 
+    /**
+     * Statistics of the session manager's task queue.
+     *
+     * \return the queue statistics
+     */
+    AsyncTaskQueue::Stats GetQueueStats() const;
+
+    /**
+     * Add the number of sessions and the session manager's task queue to a
+     * metrics snapshot.
+     */
+    void CollectMetrics(Metrics::Snapshot& snapshot) const;
+
     /**
      * Check if a session has been setup.
      *
@@ -103,14 +117,14 @@ class SessionManager :
     class Session {
       public:
         Session() :
-            port(0), id(0), sessionEstablished(false), refCount(1) { }
+            port(0), id(0), sessionEstablished(false), refCount(1), joinStarted(0) { }
 
         Session(ajn::SessionId id) :
-            port(0), id(id), sessionEstablished(false), refCount(1) { }
+            port(0), id(id), sessionEstablished(false), refCount(1), joinStarted(0) { }
 
         Session(qcc::String busName,
                 ajn::SessionPort port) :
-            busName(busName), port(port), id(0), sessionEstablished(false), refCount(1) { }
+            busName(busName), port(port), id(0), sessionEstablished(false), refCount(1), joinStarted(0) { }
 
         /**
          * Overloading the operator<
@@ -170,12 +184,24 @@ class SessionManager :
          */
         unsigned int Decrement() { return --refCount; }
 
+        /**
+         * Sets the time the session join was started
+         * \param[in] started monotonic time in ns, 0 if not measured
+         */
+        void JoinStarted(uint64_t started) { joinStarted = started; }
+
+        /**
+         * \return the time the session join was started, 0 if not measured
+         */
+        uint64_t GetJoinStarted() const { return joinStarted; }
+
       private:
         qcc::String busName;
         ajn::SessionPort port;
         ajn::SessionId id;
         bool sessionEstablished;
         unsigned int refCount;
+        uint64_t joinStarted;
     };
 
     /**
@@ -394,6 +420,19 @@ class SessionManager :
      * Called when a new task on the asynchronous task queue needs to be handled.
      */
     virtual void OnTask(TaskData const* taskdata);
+
+    /**
+     * Leave tasks are merged per session, see OnCoalesce.
+     */
+    virtual bool OnCoalesceKey(TaskData const* taskdata,
+                               uint64_t& key);
+
+    /**
+     * Called when the asynchronous task queue is full. Leaving the same
+     * session twice is pointless, so such tasks are merged.
+     */
+    virtual bool OnCoalesce(TaskData const* queued,
+                            TaskData const* incoming);
 };
 } /* namespace datadriven */
 #undef QCC_MODULE
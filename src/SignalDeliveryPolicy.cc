@@ -0,0 +1,77 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <datadriven/SignalDeliveryPolicy.h>
+
+namespace datadriven {
+SignalDeliveryPolicy::SignalDeliveryPolicy() :
+    capacity(0), latestPerObject(false), sampling(1)
+{
+}
+
+SignalDeliveryPolicy SignalDeliveryPolicy::DropOldest(size_t capacity)
+{
+    return SignalDeliveryPolicy().SetCapacity(capacity);
+}
+
+SignalDeliveryPolicy SignalDeliveryPolicy::LatestPerObject()
+{
+    return SignalDeliveryPolicy().SetLatestPerObject(true);
+}
+
+SignalDeliveryPolicy SignalDeliveryPolicy::EveryNth(uint32_t n)
+{
+    return SignalDeliveryPolicy().SetSampling(n);
+}
+
+SignalDeliveryPolicy& SignalDeliveryPolicy::SetCapacity(size_t capacity)
+{
+    this->capacity = capacity;
+    return *this;
+}
+
+SignalDeliveryPolicy& SignalDeliveryPolicy::SetLatestPerObject(bool latest)
+{
+    latestPerObject = latest;
+    return *this;
+}
+
+SignalDeliveryPolicy& SignalDeliveryPolicy::SetSampling(uint32_t n)
+{
+    sampling = (0 == n) ? 1 : n;
+    return *this;
+}
+
+size_t SignalDeliveryPolicy::GetCapacity() const
+{
+    return capacity;
+}
+
+bool SignalDeliveryPolicy::GetLatestPerObject() const
+{
+    return latestPerObject;
+}
+
+uint32_t SignalDeliveryPolicy::GetSampling() const
+{
+    return sampling;
+}
+
+bool SignalDeliveryPolicy::IsDefault() const
+{
+    return (0 == capacity) && !latestPerObject && (1 == sampling);
+}
+}
@@ -0,0 +1,313 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <algorithm>
+
+#include <datadriven/ObserverBase.h>
+#include <datadriven/SignalListenerBase.h>
+
+#include "ObserverManager.h"
+#include "SignalHub.h"
+#include "common/ThreadLocal.h"
+
+#include <qcc/Debug.h>
+#define QCC_MODULE "DD_CONSUMER"
+
+namespace datadriven {
+/** Whether the current thread is delivering a signal */
+static DD_THREAD_LOCAL bool inDispatch = false;
+
+class SignalHub::SignalTask :
+    public ObserverManager::Task {
+  public:
+    SignalTask(std::shared_ptr<SignalHub> hub,
+               ajn::Message& message) :
+        hub(hub), message(message)
+    { }
+
+    void Execute() const
+    {
+        QCC_DbgPrintf(("SignalTask => Execute called"));
+
+        hub->Dispatch(message);
+    }
+
+  private:
+    std::shared_ptr<SignalHub> hub;
+    ajn::Message message;
+};
+
+class SignalHub::DrainTask :
+    public ObserverManager::Task {
+  public:
+    DrainTask(std::shared_ptr<SignalHub> hub,
+              std::shared_ptr<SignalQueue> queue) :
+        hub(hub), queue(queue)
+    { }
+
+    void Execute() const
+    {
+        hub->Drain(queue);
+    }
+
+  private:
+    std::shared_ptr<SignalHub> hub;
+    std::shared_ptr<SignalQueue> queue;
+};
+
+std::vector<std::shared_ptr<SignalQueue> >::const_iterator SignalHub::Listeners::Find(SignalListenerBase* listener)
+const
+{
+    std::vector<std::shared_ptr<SignalQueue> >::const_iterator it = queued.begin();
+    while ((it != queued.end()) && ((*it)->GetListener() != listener)) {
+        ++it;
+    }
+    return it;
+}
+
+SignalHub::SignalHub(std::weak_ptr<ObserverBase> observer,
+                     const ajn::InterfaceDescription::Member* member) :
+    observer(observer), member(member), listeners(new Listeners()), numDirect(0), numQueued(0), dispatching(false),
+    readers(0), waiting(0), generation(0), numRetired(0)
+{
+}
+
+SignalHub::~SignalHub()
+{
+    delete listeners.load();
+    FreeRetired(generation);
+}
+
+ajn::MessageReceiver::SignalHandler SignalHub::GetHandler()
+{
+    return static_cast<MessageReceiver::SignalHandler>(&SignalHub::ThreadHandler);
+}
+
+const ajn::InterfaceDescription::Member* SignalHub::GetMember() const
+{
+    return member;
+}
+
+void SignalHub::ThreadHandler(const ajn::InterfaceDescription::Member* member,
+                              const char* srcPath,
+                              ajn::Message& message)
+{
+    if (member == NULL || srcPath == NULL) {
+        QCC_LogError(ER_FAIL, ("Invalid arguments"));
+        return;
+    }
+
+    QCC_DbgPrintf(("SignalHub: Got signal '%s' from path '%s' in '%s'", member->name.c_str(), srcPath,
+                   message->GetSender()));
+
+    std::shared_ptr<ObserverManager> mgr = ObserverManager::GetInstance();
+    if (!mgr) {
+        return;
+    }
+    // most hubs only have listeners with the default policy, which need no array
+    bool direct = (0 != numDirect.load());
+    std::vector<std::shared_ptr<SignalQueue> > drain;
+    if (0 != numQueued.load()) {
+        // a reader, so the array is not freed under us; counted before it is loaded
+        readers++;
+        const Listeners* current = listeners.load();
+        direct = !current->direct.empty();
+        for (size_t i = 0; i < current->queued.size(); i++) {
+            if (current->queued[i]->Offer(message)) {
+                drain.push_back(current->queued[i]);
+            }
+        }
+        readers--;
+        if (0 != numRetired.load()) {
+            mutex.Lock();
+            Reclaim();
+            mutex.Unlock();
+        }
+    }
+
+    // the array may be gone by now, only the queues we hold on to are used
+    if (direct) {
+        mgr->Enqueue(new SignalTask(shared_from_this(), message), ObserverManager::Lane::SIGNAL);
+    }
+    for (size_t i = 0; i < drain.size(); i++) {
+        mgr->Enqueue(new DrainTask(shared_from_this(), drain[i]), ObserverManager::Lane::SIGNAL);
+    }
+}
+
+bool SignalHub::Add(SignalListenerBase* listener)
+{
+    mutex.Lock();
+    const Listeners* current = listeners.load();
+    bool added = (current->direct.end() == std::find(current->direct.begin(), current->direct.end(), listener)) &&
+                 (current->queued.end() == current->Find(listener));
+    if (added) {
+        Listeners* next = new Listeners(*current);
+        const SignalDeliveryPolicy& policy = listener->GetDeliveryPolicy();
+        if (policy.IsDefault()) {
+            next->direct.push_back(listener);
+        } else {
+            next->queued.push_back(std::make_shared<SignalQueue>(listener, policy));
+        }
+        Publish(next);
+    }
+    mutex.Unlock();
+    return added;
+}
+
+bool SignalHub::Remove(SignalListenerBase* listener)
+{
+    mutex.Lock();
+    const Listeners* current = listeners.load();
+    std::vector<SignalListenerBase*>::const_iterator direct =
+        std::find(current->direct.begin(), current->direct.end(), listener);
+    std::vector<std::shared_ptr<SignalQueue> >::const_iterator queued = current->Find(listener);
+    bool removed = (direct != current->direct.end()) || (queued != current->queued.end());
+    if (removed) {
+        Listeners* next = new Listeners(*current);
+        if (direct != current->direct.end()) {
+            next->direct.erase(next->direct.begin() + (direct - current->direct.begin()));
+        } else {
+            (*queued)->Close();
+            next->queued.erase(next->queued.begin() + (queued - current->queued.begin()));
+        }
+        Publish(next);
+    }
+    mutex.Unlock();
+
+    if (removed) {
+        // no locks held: the listener being called may add or remove listeners itself
+        WaitForDispatch();
+    }
+    return removed;
+}
+
+size_t SignalHub::GetSize() const
+{
+    mutex.Lock();
+    const Listeners* current = listeners.load();
+    size_t size = current->direct.size() + current->queued.size();
+    mutex.Unlock();
+    return size;
+}
+
+void SignalHub::Publish(Listeners* next)
+{
+    const Listeners* previous = listeners.exchange(next);
+    numDirect = next->direct.size();
+    numQueued = next->queued.size();
+    retired.push_back(std::make_pair(++generation, previous));
+    numRetired = retired.size();
+}
+
+void SignalHub::FreeRetired(uint64_t upTo)
+{
+    std::vector<std::pair<uint64_t, const Listeners*> >::iterator it = retired.begin();
+    for (; (it != retired.end()) && (it->first <= upTo); ++it) {
+        delete it->second;
+    }
+    retired.erase(retired.begin(), it);
+    numRetired = retired.size();
+}
+
+void SignalHub::WaitForDispatch()
+{
+    if (inDispatch) {
+        // called from a signal callback, the array is freed once delivery is done
+        return;
+    }
+    // a delivery that starts from now on uses the new array
+    mutex.Lock();
+    waiting++;
+    while (dispatching.load()) {
+        dispatched.Wait(mutex);
+    }
+    waiting--;
+    Reclaim();
+    mutex.Unlock();
+}
+
+void SignalHub::Reclaim()
+{
+    // a reader or delivery that starts after these checks loads the current
+    // array, which is never retired while we hold the mutex
+    if ((0 == readers.load()) && !dispatching.load()) {
+        FreeRetired(generation);
+    }
+}
+
+void SignalHub::Dispatch(const ajn::Message& message)
+{
+    std::shared_ptr<ObserverBase> obs = observer.lock();
+    if (!obs) {
+        return;
+    }
+
+    BeginDispatch();
+    const Listeners* current = listeners.load();
+    if (!current->direct.empty()) {
+        current->direct[0]->DispatchSignal(message, current->direct.data(), current->direct.size());
+    }
+    EndDispatch();
+}
+
+void SignalHub::Drain(const std::shared_ptr<SignalQueue>& queue)
+{
+    std::shared_ptr<ObserverBase> obs = observer.lock();
+    if (!obs) {
+        return;
+    }
+
+    BeginDispatch();
+    queue->TakeAll(batch);
+    for (SignalQueue::Entries::const_iterator it = batch.begin(); it != batch.end(); ++it) {
+        // checked after BeginDispatch, so Remove either sees us dispatching or we see it closed
+        if (queue->IsClosed()) {
+            break;
+        }
+        SignalListenerBase* listener = queue->GetListener();
+        listener->DispatchSignal(it->message, &listener, 1);
+        queue->CountDelivered();
+    }
+    batch.clear();
+    EndDispatch();
+
+    std::shared_ptr<ObserverManager> mgr = ObserverManager::GetInstance();
+    if (queue->Drained() && !queue->IsClosed() && mgr) {
+        // signals that arrived during delivery go to the back of the consumer queue
+        mgr->Enqueue(new DrainTask(shared_from_this(), queue), ObserverManager::Lane::SIGNAL);
+    }
+}
+
+void SignalHub::BeginDispatch()
+{
+    dispatching = true;
+    inDispatch = true;
+}
+
+void SignalHub::EndDispatch()
+{
+    inDispatch = false;
+    dispatching = false;
+    // WaitForDispatch counts itself before checking dispatching, so either it
+    // sees we are done or we see it waiting
+    if ((0 != waiting.load()) || (0 != numRetired.load())) {
+        mutex.Lock();
+        Reclaim();
+        dispatched.Broadcast();
+        mutex.Unlock();
+    }
+}
+}
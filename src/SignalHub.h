@@ -0,0 +1,189 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef SIGNALHUB_H_
+#define SIGNALHUB_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <alljoyn/InterfaceDescription.h> // needed by MessageReceiver.h
+#include <alljoyn/Message.h>
+#include <alljoyn/MessageReceiver.h>
+
+#include <datadriven/Condition.h>
+#include <datadriven/Mutex.h>
+
+#include "SignalQueue.h"
+
+namespace datadriven {
+class ObserverBase;
+class SignalListenerBase;
+
+/**
+ * \private Receives one signal for one observer from AllJoyn and fans it
+ * out to all signal listeners added for it.
+ *
+ * The signal is queued once on the ObserverManager, whose single consumer
+ * thread unmarshals it once and delivers it to every listener. The
+ * listeners are kept in an immutable array that is replaced as a whole
+ * when a listener is added or removed, so neither delivery nor the AllJoyn
+ * thread take a lock. A replaced array is only freed once no delivery and no
+ * AllJoyn thread can still be reading it.
+ *
+ * Listeners with a delivery policy other than the default one each have
+ * their own SignalQueue instead, which is drained by a separate task that
+ * unmarshals the signals for that listener alone.
+ *
+ * Once RemoveSignalListener returns, the removed listener is not called
+ * anymore, unless it is removed from within a signal callback: then the
+ * signal being delivered may still reach it.
+ */
+class SignalHub :
+    public ajn::MessageReceiver,
+    public std::enable_shared_from_this<SignalHub> {
+  public:
+    SignalHub(std::weak_ptr<ObserverBase> observer,
+              const ajn::InterfaceDescription::Member* member);
+
+    ~SignalHub();
+
+    /**
+     * Returns the signal handler to register with AllJoyn
+     */
+    static ajn::MessageReceiver::SignalHandler GetHandler();
+
+    /**
+     * Get the signal member
+     */
+    const ajn::InterfaceDescription::Member* GetMember() const;
+
+    /**
+     * Add a listener.
+     * \retval false if the listener was already added
+     */
+    bool Add(SignalListenerBase* listener);
+
+    /**
+     * Remove a listener and wait until it is no longer being called.
+     * \retval false if the listener was not added
+     */
+    bool Remove(SignalListenerBase* listener);
+
+    /**
+     * Number of listeners
+     */
+    size_t GetSize() const;
+
+    /**
+     * Deliver a signal to the listeners, called on the consumer thread.
+     */
+    void Dispatch(const ajn::Message& message);
+
+    /**
+     * Deliver the signals waiting in \a queue, called on the consumer thread.
+     */
+    void Drain(const std::shared_ptr<SignalQueue>& queue);
+
+  private:
+    /** Listener array */
+    struct Listeners {
+        /** Listeners with the default policy */
+        std::vector<SignalListenerBase*> direct;
+        /** Queues of the listeners with another policy */
+        std::vector<std::shared_ptr<SignalQueue> > queued;
+
+        std::vector<std::shared_ptr<SignalQueue> >::const_iterator Find(SignalListenerBase* listener) const;
+    };
+
+    class SignalTask;
+    class DrainTask;
+
+    void ThreadHandler(const ajn::InterfaceDescription::Member* member,
+                       const char* srcPath,
+                       ajn::Message& message);
+
+    /**
+     * Replace the listener array, called with mutex locked
+     */
+    void Publish(Listeners* next);
+
+    /**
+     * Wait until no signal is being delivered with a replaced array, unless
+     * called while delivering one.
+     */
+    void WaitForDispatch();
+
+    /**
+     * Free the retired arrays if nobody can be reading them, called with
+     * mutex locked
+     */
+    void Reclaim();
+
+    std::weak_ptr<ObserverBase> observer;
+    const ajn::InterfaceDescription::Member* member;
+
+    /** Current listener array, never NULL */
+    std::atomic<const Listeners*> listeners;
+
+    /** Sizes of the current array, so the AllJoyn thread only reads it for queued listeners */
+    std::atomic<size_t> numDirect;
+    std::atomic<size_t> numQueued;
+
+    /** A signal is being delivered */
+    std::atomic<bool> dispatching;
+
+    /** Number of AllJoyn threads reading the listener array */
+    std::atomic<unsigned int> readers;
+
+    /** Number of threads in WaitForDispatch */
+    std::atomic<unsigned int> waiting;
+
+    /** Signalled by EndDispatch when there are waiting threads */
+    datadriven::Condition dispatched;
+
+    /** Signals being drained, only used on the consumer thread */
+    SignalQueue::Entries batch;
+
+    /** Protects writers, retired and the queued listeners */
+    mutable datadriven::Mutex mutex;
+
+    /** Replaced listener arrays that may still be in use by Dispatch, in order of replacement */
+    std::vector<std::pair<uint64_t, const Listeners*> > retired;
+
+    /** Number of listener arrays replaced so far */
+    uint64_t generation;
+
+    /** Size of retired, to check it without locking */
+    std::atomic<size_t> numRetired;
+
+    /** Free the retired arrays up to \a upTo, called with mutex locked and no reader left */
+    void FreeRetired(uint64_t upTo);
+
+    /** Start delivering on the consumer thread */
+    void BeginDispatch();
+
+    /** Done delivering on the consumer thread */
+    void EndDispatch();
+
+    SignalHub(const SignalHub&);
+    void operator=(const SignalHub&);
+};
+}
+
+#endif /* SIGNALHUB_H_ */
@@ -15,40 +15,10 @@
  ******************************************************************************/
 
 #include <datadriven/SignalListenerBase.h>
-#include "BusConnectionImpl.h"
-#include "ObserverManager.h"
-
-#include <qcc/Debug.h>
-#define QCC_MODULE "DD_CONSUMER"
 
 namespace datadriven {
-class SignalListenerBase::SignalTask :
-    public ObserverManager::Task {
-  public:
-    SignalTask(SignalListenerBase* listener,
-               std::weak_ptr<ObserverBase> observerBase,
-               ajn::Message& message) :
-        listener(listener), observerBase(observerBase), message(message)
-    { }
-
-    void Execute() const
-    {
-        QCC_DbgPrintf(("SignalTask => Execute called"));
-
-        std::shared_ptr<ObserverBase> obs = observerBase.lock();
-        if (obs) {
-            obs->HandleSignal(listener, message);
-        }
-    }
-
-  private:
-    SignalListenerBase* listener;
-    std::weak_ptr<ObserverBase> observerBase;
-    ajn::Message message;
-};
-
 SignalListenerBase::SignalListenerBase() :
-    observerBase(), member(NULL)
+    observerBase(), member(NULL), received(0), delivered(0), dropped(0), merged(0)
 {
 }
 
@@ -59,42 +29,38 @@ SignalListenerBase::~SignalListenerBase()
 {
 }
 
-ajn::MessageReceiver::SignalHandler SignalListenerBase::GetHandler()
+void SignalListenerBase::SetObserver(std::weak_ptr<ObserverBase> observerBase)
 {
-    return static_cast<MessageReceiver::SignalHandler>(&SignalListenerBase::ThreadHandler);
+    this->observerBase = observerBase;
 }
 
-void SignalListenerBase::ThreadHandler(const ajn::InterfaceDescription::Member* member,
-                                       const char* srcPath,
-                                       ajn::Message& message)
+const ajn::InterfaceDescription::Member* SignalListenerBase::GetMember()
 {
-    if (member == NULL || srcPath == NULL) {
-        QCC_LogError(ER_FAIL, ("Invalid arguments"));
-        return;
-    }
-
-    QCC_DbgPrintf(("SignalListenerBase: Got signal '%s' from path '%s' in '%s'", member->name.c_str(), srcPath,
-                   message->GetSender()));
+    return member;
+}
 
-    std::shared_ptr<ObserverManager> mgr = ObserverManager::GetInstance();
-    if (mgr) {
-        SignalTask* task = new SignalTask(this, observerBase, message);
-        mgr->Enqueue(task);
-    }
+void SignalListenerBase::SetMember(const ajn::InterfaceDescription::Member* member)
+{
+    this->member = member;
 }
 
-void SignalListenerBase::SetObserver(std::weak_ptr<ObserverBase> observerBase)
+void SignalListenerBase::SetDeliveryPolicy(const SignalDeliveryPolicy& policy)
 {
-    this->observerBase = observerBase;
+    this->policy = policy;
 }
 
-const ajn::InterfaceDescription::Member* SignalListenerBase::GetMember()
+const SignalDeliveryPolicy& SignalListenerBase::GetDeliveryPolicy() const
 {
-    return member;
+    return policy;
 }
 
-void SignalListenerBase::SetMember(const ajn::InterfaceDescription::Member* member)
+SignalDeliveryStats SignalListenerBase::GetDeliveryStats() const
 {
-    this->member = member;
+    SignalDeliveryStats stats;
+    stats.received = received.load();
+    stats.delivered = delivered.load();
+    stats.dropped = dropped.load();
+    stats.merged = merged.load();
+    return stats;
 }
 }
@@ -0,0 +1,139 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <string.h>
+
+#include <datadriven/SignalListenerBase.h>
+
+#include "ObserverCache.h"
+#include "SignalQueue.h"
+
+#include <qcc/Debug.h>
+#define QCC_MODULE "DD_CONSUMER"
+
+namespace datadriven {
+SignalQueue::SignalQueue(SignalListenerBase* listener,
+                         const SignalDeliveryPolicy& policy) :
+    listener(listener), policy(policy), head(0), count(0), scheduled(false), closed(false)
+{
+}
+
+SignalListenerBase* SignalQueue::GetListener() const
+{
+    return listener;
+}
+
+bool SignalQueue::Offer(const ajn::Message& message)
+{
+    bool schedule = false;
+
+    mutex.Lock();
+    do {
+        // the AllJoyn thread may still offer to a queue its listener was removed from
+        if (closed.load()) {
+            break;
+        }
+        listener->received++;
+        if (0 != (count++ % policy.GetSampling())) {
+            listener->dropped++;
+            break;
+        }
+
+        uint64_t hash = 0;
+        if (policy.GetLatestPerObject()) {
+            const char* sender = message->GetSender();
+            const char* path = message->GetObjectPath();
+            hash = ObserverCache::Hash(sender, path);
+            std::unordered_map<uint64_t, uint64_t>::iterator it = latest.find(hash);
+            if (it != latest.end()) {
+                Entry& waiting = entries[it->second - head];
+                if ((0 == strcmp(waiting.message->GetObjectPath(), path)) &&
+                    (0 == strcmp(waiting.message->GetSender(), sender))) {
+                    // keep the position of the signal it replaces
+                    waiting.message = message;
+                    listener->merged++;
+                    break;
+                }
+            }
+        }
+
+        if ((0 != policy.GetCapacity()) && (entries.size() >= policy.GetCapacity())) {
+            DropOldest();
+        }
+        if (policy.GetLatestPerObject()) {
+            // on a hash collision the signal is queued without replacing anything
+            latest[hash] = head + entries.size();
+        }
+        entries.push_back(Entry(message, hash));
+        if (!scheduled) {
+            scheduled = true;
+            schedule = true;
+        }
+    } while (0);
+    mutex.Unlock();
+
+    return schedule;
+}
+
+void SignalQueue::TakeAll(Entries& batch)
+{
+    mutex.Lock();
+    head += entries.size();
+    entries.swap(batch);
+    latest.clear();
+    mutex.Unlock();
+}
+
+bool SignalQueue::Drained()
+{
+    mutex.Lock();
+    scheduled = !entries.empty();
+    bool reschedule = scheduled;
+    mutex.Unlock();
+    return reschedule;
+}
+
+void SignalQueue::CountDelivered()
+{
+    listener->delivered++;
+}
+
+void SignalQueue::Close()
+{
+    // once this returns, Offer does not touch the listener anymore
+    mutex.Lock();
+    closed = true;
+    mutex.Unlock();
+}
+
+bool SignalQueue::IsClosed() const
+{
+    return closed.load();
+}
+
+void SignalQueue::DropOldest()
+{
+    if (policy.GetLatestPerObject()) {
+        std::unordered_map<uint64_t, uint64_t>::iterator it = latest.find(entries.front().hash);
+        if ((it != latest.end()) && (it->second == head)) {
+            latest.erase(it);
+        }
+    }
+    entries.pop_front();
+    head++;
+    listener->dropped++;
+}
+}
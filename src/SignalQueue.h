@@ -0,0 +1,122 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef SIGNALQUEUE_H_
+#define SIGNALQUEUE_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <unordered_map>
+
+#include <alljoyn/Message.h>
+
+#include <datadriven/Mutex.h>
+#include <datadriven/SignalDeliveryPolicy.h>
+
+namespace datadriven {
+class SignalListenerBase;
+
+/**
+ * \private Signals waiting for one listener with a delivery policy.
+ *
+ * Signals are offered on the AllJoyn thread that received them and taken
+ * in batches on the consumer thread. The policy is applied on arrival, so
+ * the number of waiting signals never exceeds the policy's capacity (a
+ * batch being delivered not included).
+ */
+class SignalQueue {
+  public:
+    /** A waiting signal */
+    struct Entry {
+        Entry(const ajn::Message& message,
+              uint64_t hash) :
+            message(message), hash(hash) { }
+
+        ajn::Message message;
+        /** ObserverCache::Hash of the signal's sender and path, if merging */
+        uint64_t hash;
+    };
+
+    typedef std::deque<Entry> Entries;
+
+    SignalQueue(SignalListenerBase* listener,
+                const SignalDeliveryPolicy& policy);
+
+    /**
+     * Get the listener the signals are for
+     */
+    SignalListenerBase* GetListener() const;
+
+    /**
+     * Apply the policy to a received signal.
+     * \retval true if the queue needs to be drained, the caller must
+     *         schedule a drain
+     */
+    bool Offer(const ajn::Message& message);
+
+    /**
+     * Move all waiting signals to the (empty) \a batch.
+     */
+    void TakeAll(Entries& batch);
+
+    /**
+     * Called after a drain.
+     * \retval true if signals arrived in the mean time, the caller must
+     *         schedule another drain
+     */
+    bool Drained();
+
+    /**
+     * Count a signal handed to the listener
+     */
+    void CountDelivered();
+
+    /**
+     * The listener was removed, no signals are delivered to it anymore.
+     */
+    void Close();
+
+    /**
+     * Whether the listener was removed
+     */
+    bool IsClosed() const;
+
+  private:
+    SignalListenerBase* listener;
+    const SignalDeliveryPolicy policy;
+
+    datadriven::Mutex mutex;
+    Entries entries;
+    /** Sequence number of the first element of entries */
+    uint64_t head;
+    /** Sequence number of the waiting signal per object, if merging */
+    std::unordered_map<uint64_t, uint64_t> latest;
+    /** Number of signals received, for sampling */
+    uint64_t count;
+    /** A drain is scheduled or running */
+    bool scheduled;
+
+    std::atomic<bool> closed;
+
+    void DropOldest();
+
+    SignalQueue(const SignalQueue&);
+    void operator=(const SignalQueue&);
+};
+}
+
+#endif /* SIGNALQUEUE_H_ */
@@ -154,6 +154,11 @@ QStatus TypeDescription::ResolveMembers(const ajn::InterfaceDescription& iface,
     return status;
 }
 
+size_t TypeDescription::GetMemberCount() const
+{
+    return methods.size() + signals.size();
+}
+
 std::vector<const char*> TypeDescription::GetEmittablePropertyNames() const
 {
     std::vector<const char*> names;
@@ -167,6 +172,32 @@ std::vector<const char*> TypeDescription::GetEmittablePropertyNames() const
     return names;
 }
 
+std::vector<const char*> TypeDescription::GetUncachedReadablePropertyNames() const
+{
+    std::vector<const char*> names;
+    std::vector<Property>::const_iterator it;
+
+    for (it = properties.begin(); it != properties.end(); it++) {
+        if (((*it).emits != EmitChangesSignal::ALWAYS) && ((*it).access & ajn::PROP_ACCESS_READ)) {
+            names.push_back((*it).name);
+        }
+    }
+    return names;
+}
+
+std::vector<const char*> TypeDescription::GetInvalidatingPropertyNames() const
+{
+    std::vector<const char*> names;
+    std::vector<Property>::const_iterator it;
+
+    for (it = properties.begin(); it != properties.end(); it++) {
+        if (((*it).emits == EmitChangesSignal::INVALIDATES) && ((*it).access & ajn::PROP_ACCESS_READ)) {
+            names.push_back((*it).name);
+        }
+    }
+    return names;
+}
+
 bool TypeDescription::HasProperties() const
 {
     return (0 != properties.size());
@@ -15,11 +15,15 @@
  ******************************************************************************/
 
 #include "AsyncTaskQueue.h"
-#include <queue>
+#include <chrono>
+#include <deque>
 #ifdef _WIN32
 #include <process.h>
 #endif
 
+/** Number of tasks taken by priority while others aged, before an aged task overtakes them */
+#define AGED_TASK_INTERVAL 3
+
 using namespace datadriven;
 
 TaskData::~TaskData()
@@ -28,27 +32,215 @@ TaskData::~TaskData()
 
 AsyncTaskQueue::AsyncTaskQueue(AsyncTask* asyncTask,
                                bool ownership) :
+    m_Lanes(1), m_Depth(0), m_MaxWait(0), m_SinceAged(0), m_Capacity(0), m_Policy(OVERFLOW_BLOCK), m_Waiting(0),
     m_IsStopping(true), m_AsyncTask(asyncTask), m_ownership(ownership)
 {
+    m_Stats.depth = 0;
+    m_Stats.highWatermark = 0;
+    m_Stats.enqueued = 0;
+    m_Stats.executed = 0;
+    m_Stats.dropped = 0;
+    m_Stats.coalesced = 0;
+    m_Stats.blocked = 0;
+    m_Stats.maxWait = 0;
+#ifdef _WIN32
+    m_ThreadId = 0;
+    InitializeCriticalSection(&m_Lock);
+    InitializeConditionVariable(&m_QueueChanged);
+    InitializeConditionVariable(&m_QueueNotFull);
+#else
+    pthread_mutex_init(&m_Lock, NULL);
+    pthread_cond_init(&m_QueueChanged, NULL);
+    pthread_cond_init(&m_QueueNotFull, NULL);
+#endif
 }
 
 AsyncTaskQueue::~AsyncTaskQueue()
 {
+#ifdef _WIN32
+    DeleteCriticalSection(&m_Lock);
+#else
+    pthread_cond_destroy(&m_QueueNotFull);
+    pthread_cond_destroy(&m_QueueChanged);
+    pthread_mutex_destroy(&m_Lock);
+#endif
 }
 
-void AsyncTaskQueue::Enqueue(TaskData const* taskdata)
+void AsyncTaskQueue::SetCapacity(size_t capacity,
+                                 OverflowPolicy policy)
 {
 #ifdef _WIN32
     EnterCriticalSection(&m_Lock);
-    m_MessageQueue.push(taskdata);
-    WakeConditionVariable(&m_QueueChanged);
+    m_Capacity = capacity;
+    m_Policy = policy;
+    WakeAllConditionVariable(&m_QueueNotFull);
     LeaveCriticalSection(&m_Lock);
 #else
     pthread_mutex_lock(&m_Lock);
-    m_MessageQueue.push(taskdata);
-    pthread_cond_signal(&m_QueueChanged);
+    m_Capacity = capacity;
+    m_Policy = policy;
+    pthread_cond_broadcast(&m_QueueNotFull);
+    pthread_mutex_unlock(&m_Lock);
+#endif
+}
+
+void AsyncTaskQueue::SetLanes(unsigned int numLanes,
+                              uint32_t maxWait)
+{
+#ifdef _WIN32
+    EnterCriticalSection(&m_Lock);
+#else
+    pthread_mutex_lock(&m_Lock);
+#endif
+    if ((0 == m_Depth) && (0 != numLanes)) {
+        m_Lanes.resize(numLanes);
+        m_MaxWait = maxWait;
+    }
+#ifdef _WIN32
+    LeaveCriticalSection(&m_Lock);
+#else
+    pthread_mutex_unlock(&m_Lock);
+#endif
+}
+
+AsyncTaskQueue::Stats AsyncTaskQueue::GetStats() const
+{
+#ifdef _WIN32
+    EnterCriticalSection(&m_Lock);
+    Stats stats = m_Stats;
+    stats.depth = m_Depth;
+    LeaveCriticalSection(&m_Lock);
+#else
+    pthread_mutex_lock(&m_Lock);
+    Stats stats = m_Stats;
+    stats.depth = m_Depth;
+    pthread_mutex_unlock(&m_Lock);
+#endif
+    return stats;
+}
+
+void AsyncTaskQueue::CollectMetrics(const char* name,
+                                    Metrics::Snapshot& snapshot) const
+{
+    Stats stats = GetStats();
+    Metrics::Queue queue;
+    queue.name = name;
+    queue.depth = stats.depth;
+    queue.highWatermark = stats.highWatermark;
+    queue.enqueued = stats.enqueued;
+    queue.executed = stats.executed;
+    queue.dropped = stats.dropped;
+    queue.coalesced = stats.coalesced;
+    queue.blocked = stats.blocked;
+    queue.maxWait = stats.maxWait;
+    snapshot.queues.push_back(queue);
+}
+
+bool AsyncTaskQueue::IsReceiverThread() const
+{
+    if (m_IsStopping) {
+        return false;
+    }
+#ifdef _WIN32
+    return GetCurrentThreadId() == m_ThreadId;
+#else
+    return pthread_equal(pthread_self(), m_Thread);
+#endif
+}
+
+uint64_t AsyncTaskQueue::Now()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool AsyncTaskQueue::MakeRoom(TaskData const* taskdata,
+                              unsigned int lane,
+                              const Entry& entry)
+{
+    if (OVERFLOW_DROP == m_Policy) {
+        m_Stats.dropped++;
+        return false;
+    }
+
+    if (OVERFLOW_COALESCE == m_Policy) {
+        // only the most recent task with the same key is offered the merge, the
+        // queue is never scanned, and what cannot be merged is queued regardless
+        if (entry.indexed) {
+            std::unordered_map<uint64_t, Coalescible>::iterator it = m_Coalescible.find(entry.key);
+            if ((it != m_Coalescible.end()) && (it->second.lane == lane) &&
+                m_AsyncTask->OnCoalesce(it->second.taskData, taskdata)) {
+                m_Stats.coalesced++;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // the receiver never waits for itself, and a stopping queue is not drained anymore
+    if (IsReceiverThread()) {
+        return true;
+    }
+    m_Stats.blocked++;
+    m_Waiting++;
+    while (!m_IsStopping && (0 != m_Capacity) && (m_Depth >= m_Capacity)) {
+#ifdef _WIN32
+        SleepConditionVariableCS(&m_QueueNotFull, &m_Lock, INFINITE);
+#else
+        pthread_cond_wait(&m_QueueNotFull, &m_Lock);
+#endif
+    }
+    m_Waiting--;
+    return true;
+}
+
+bool AsyncTaskQueue::Enqueue(TaskData const* taskdata,
+                             unsigned int lane)
+{
+#ifdef _WIN32
+    EnterCriticalSection(&m_Lock);
+#else
+    pthread_mutex_lock(&m_Lock);
+#endif
+    if (lane >= m_Lanes.size()) {
+        lane = m_Lanes.size() - 1;
+    }
+    Entry entry = { taskdata, ((m_Lanes.size() > 1) || Metrics::IsEnabled()) ? Now() : 0, false, 0 };
+    if (OVERFLOW_COALESCE == m_Policy) {
+        entry.indexed = m_AsyncTask->OnCoalesceKey(taskdata, entry.key);
+    }
+    bool queued = true;
+    if ((0 != m_Capacity) && (m_Depth >= m_Capacity)) {
+        queued = MakeRoom(taskdata, lane, entry);
+    }
+    if (queued) {
+        m_Lanes[lane].push_back(entry);
+        if (entry.indexed) {
+            Coalescible coalescible = { taskdata, lane };
+            m_Coalescible[entry.key] = coalescible;
+        }
+        m_Depth++;
+        m_Stats.enqueued++;
+        if (m_Depth > m_Stats.highWatermark) {
+            m_Stats.highWatermark = m_Depth;
+        }
+#ifdef _WIN32
+        WakeConditionVariable(&m_QueueChanged);
+#else
+        pthread_cond_signal(&m_QueueChanged);
+#endif
+    }
+    // only a dropped task is lost, a merged one runs as part of the queued one
+    bool accepted = queued || (OVERFLOW_DROP != m_Policy);
+#ifdef _WIN32
+    LeaveCriticalSection(&m_Lock);
+#else
     pthread_mutex_unlock(&m_Lock);
 #endif
+    if (!queued && m_ownership) {
+        delete taskdata;
+    }
+    return accepted;
 }
 
 void AsyncTaskQueue::Start()
@@ -60,15 +252,11 @@ void AsyncTaskQueue::Start()
     m_IsStopping = false;
 
 #ifdef _WIN32
-    InitializeCriticalSection(&m_Lock);
-    InitializeConditionVariable(&m_QueueChanged);
     m_handle =
         reinterpret_cast<HANDLE>(_beginthreadex(NULL, 256 * 1024,
                                                 (unsigned int(__stdcall*)(void*))ReceiverThreadWrapper,
-                                                this, 0, NULL));
+                                                this, 0, (unsigned int*)&m_ThreadId));
 #else
-    pthread_mutex_init(&m_Lock, NULL);
-    pthread_cond_init(&m_QueueChanged, NULL);
     pthread_create(&m_Thread, NULL, ReceiverThreadWrapper, this);
 #endif
 }
@@ -81,37 +269,81 @@ void AsyncTaskQueue::Stop()
 
 #ifdef _WIN32
     EnterCriticalSection(&m_Lock);
-    while (!m_MessageQueue.empty()) {
-        TaskData const* taskData = m_MessageQueue.front();
-        m_MessageQueue.pop();
+    while (0 != m_Depth) {
+        TaskData const* taskData = Pop();
         if (m_ownership) {
             delete taskData;
         }
     }
     m_IsStopping = true;
     WakeConditionVariable(&m_QueueChanged);
+    WakeAllConditionVariable(&m_QueueNotFull);
     LeaveCriticalSection(&m_Lock);
     WaitForSingleObject(m_handle, INFINITE);
     CloseHandle(m_handle);
-    DeleteCriticalSection(&m_Lock);
 #else
     pthread_mutex_lock(&m_Lock);
-    while (!m_MessageQueue.empty()) {
-        TaskData const* taskData = m_MessageQueue.front();
-        m_MessageQueue.pop();
+    while (0 != m_Depth) {
+        TaskData const* taskData = Pop();
         if (m_ownership) {
             delete taskData;
         }
     }
     m_IsStopping = true;
     pthread_cond_signal(&m_QueueChanged);
+    pthread_cond_broadcast(&m_QueueNotFull);
     pthread_mutex_unlock(&m_Lock);
     pthread_join(m_Thread, NULL);
-    pthread_cond_destroy(&m_QueueChanged);
-    pthread_mutex_destroy(&m_Lock);
 #endif
 }
 
+TaskData const* AsyncTaskQueue::Pop()
+{
+    std::deque<Entry>* next = NULL;
+    if (1 == m_Lanes.size()) {
+        next = &m_Lanes[0];
+    } else {
+        // the first task of the highest priority lane, but every so many tasks the
+        // oldest task of a lower priority lane that waited too long, if any
+        std::deque<Entry>* aged = NULL;
+        uint64_t deadline = Now() - m_MaxWait;
+        for (std::vector<std::deque<Entry> >::iterator it = m_Lanes.begin(); it != m_Lanes.end(); ++it) {
+            if (it->empty()) {
+                continue;
+            }
+            if (NULL == next) {
+                next = &*it;
+            } else if ((it->front().enqueued <= deadline) &&
+                       ((NULL == aged) || (it->front().enqueued < aged->front().enqueued))) {
+                aged = &*it;
+            }
+        }
+        if ((NULL != aged) && (m_SinceAged >= AGED_TASK_INTERVAL)) {
+            next = aged;
+            m_SinceAged = 0;
+        } else if (NULL != aged) {
+            m_SinceAged++;
+        }
+    }
+    TaskData const* taskData = next->front().taskData;
+    uint64_t enqueued = next->front().enqueued;
+    if (next->front().indexed) {
+        std::unordered_map<uint64_t, Coalescible>::iterator it = m_Coalescible.find(next->front().key);
+        if ((it != m_Coalescible.end()) && (it->second.taskData == taskData)) {
+            m_Coalescible.erase(it);
+        }
+    }
+    if ((0 != enqueued) && Metrics::IsEnabled()) {
+        uint64_t wait = Now() - enqueued;
+        if (wait > m_Stats.maxWait) {
+            m_Stats.maxWait = wait;
+        }
+    }
+    next->pop_front();
+    m_Depth--;
+    return taskData;
+}
+
 void* AsyncTaskQueue::ReceiverThreadWrapper(void* context)
 {
     AsyncTaskQueue* asyncTask = reinterpret_cast<AsyncTaskQueue*>(context);
@@ -127,9 +359,12 @@ void AsyncTaskQueue::Receiver()
 #ifdef _WIN32
     EnterCriticalSection(&m_Lock);
     while (!m_IsStopping) {
-        while (!m_MessageQueue.empty()) {
-            TaskData const* taskData = m_MessageQueue.front();
-            m_MessageQueue.pop();
+        while (0 != m_Depth) {
+            TaskData const* taskData = Pop();
+            m_Stats.executed++;
+            if (0 != m_Waiting) {
+                WakeConditionVariable(&m_QueueNotFull);
+            }
             LeaveCriticalSection(&m_Lock);
             m_AsyncTask->OnTask(taskData);
             if (m_ownership) {
@@ -150,9 +385,12 @@ void AsyncTaskQueue::Receiver()
 #else
     pthread_mutex_lock(&m_Lock);
     while (!m_IsStopping) {
-        while (!m_MessageQueue.empty()) {
-            TaskData const* taskData = m_MessageQueue.front();
-            m_MessageQueue.pop();
+        while (0 != m_Depth) {
+            TaskData const* taskData = Pop();
+            m_Stats.executed++;
+            if (0 != m_Waiting) {
+                pthread_cond_signal(&m_QueueNotFull);
+            }
             pthread_mutex_unlock(&m_Lock);
             m_AsyncTask->OnTask(taskData);
             if (m_ownership) {
@@ -24,7 +24,13 @@
 #else
 #include <pthread.h>
 #endif
-#include <queue>
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include <datadriven/Metrics.h>
 
 namespace datadriven {
 /**
@@ -57,6 +63,36 @@ class AsyncTask {
      *  @param taskdata - pointer to the data that currently processed.
      */
     virtual void OnTask(TaskData const* taskdata) = 0;
+
+    /**
+     * OnCoalesceKey - identify what a task can be merged with, used by the
+     *  OVERFLOW_COALESCE policy to find the queued task to offer an incoming
+     *  one to without scanning the queue. Called with the queue locked.
+     *  @param taskdata - the task.
+     *  @param[out] key - tasks that may be merged have the same key, collisions
+     *                    are allowed as OnCoalesce has the final word.
+     *  @return false if the task can never be merged.
+     */
+    virtual bool OnCoalesceKey(TaskData const* taskdata,
+                               uint64_t& key)
+    {
+        return false;
+    }
+
+    /**
+     * OnCoalesce - merge a task into one that is still queued, used by the
+     *  OVERFLOW_COALESCE policy when the queue is full. Called with the
+     *  queue locked, so it must not enqueue anything itself.
+     *  @param queued - the most recent queued task of the same lane with the
+     *                  same OnCoalesceKey.
+     *  @param incoming - the task being enqueued.
+     *  @return true if \a incoming was merged into \a queued and can be discarded.
+     */
+    virtual bool OnCoalesce(TaskData const* queued,
+                            TaskData const* incoming)
+    {
+        return false;
+    }
 };
 
 /**
@@ -64,6 +100,30 @@ class AsyncTask {
  */
 class AsyncTaskQueue {
   public:
+    /**
+     * What Enqueue does when the queue holds as many tasks as its capacity
+     */
+    enum OverflowPolicy {
+        OVERFLOW_BLOCK,     /**< wait until the consumer made room */
+        OVERFLOW_DROP,      /**< discard the new task */
+        OVERFLOW_COALESCE   /**< merge the new task into a queued one (AsyncTask::OnCoalesce), else queue it
+                                 anyway: for producers that must never wait, like bus callbacks */
+    };
+
+    /**
+     * Queue statistics
+     */
+    struct Stats {
+        size_t depth;           /**< tasks currently queued */
+        size_t highWatermark;   /**< highest depth seen */
+        uint64_t enqueued;      /**< tasks accepted */
+        uint64_t executed;      /**< tasks taken off the queue and executed */
+        uint64_t dropped;       /**< tasks discarded on overflow */
+        uint64_t coalesced;     /**< tasks merged into a queued one on overflow */
+        uint64_t blocked;       /**< Enqueue calls that had to wait for room */
+        uint64_t maxWait;       /**< longest time in ms a task was queued, see Metrics::Queue */
+    };
+
     /**
      * AsyncTaskQueue constructor
      *  @param asyncTask - pointer to the class which callbacks will be called.
@@ -86,9 +146,51 @@ class AsyncTaskQueue {
     void Stop();
 
     /**
-     * Enqueue data
+     * Enqueue data. When the queue is full this applies the overflow
+     * policy, except on the queue's own thread, which never waits for
+     * itself and always enqueues.
+     *  @param taskdata - the task.
+     *  @param lane - the priority lane of the task, see SetLanes.
+     *  @return false if the task was dropped (OVERFLOW_DROP), true if it
+     *          was queued or merged into a queued one.
+     */
+    bool Enqueue(TaskData const* taskdata,
+                 unsigned int lane = 0);
+
+    /**
+     * Split the queue in priority lanes, call before Start. Tasks are taken
+     * from the lowest numbered lane that is not empty, so within a lane they
+     * stay in order but a task can overtake tasks of a higher numbered lane.
+     * To prevent starvation, a task that waited \a maxWait ms overtakes the
+     * lanes before it, oldest first, but only once every few tasks so that
+     * fresh tasks of a high priority lane never wait behind a whole aged
+     * backlog.
+     *  @param numLanes - number of lanes, 1 (the default) for a plain FIFO.
+     *  @param maxWait - time in ms after which a task is taken regardless of its lane.
+     */
+    void SetLanes(unsigned int numLanes,
+                  uint32_t maxWait);
+
+    /**
+     * Limit the number of queued tasks.
+     *  @param capacity - maximum number of queued tasks, 0 (the default) for no limit.
+     *  @param policy - what to do with a task enqueued while the queue is full.
      */
-    void Enqueue(TaskData const* taskdata);
+    void SetCapacity(size_t capacity,
+                     OverflowPolicy policy);
+
+    /**
+     * Get the queue statistics
+     */
+    Stats GetStats() const;
+
+    /**
+     * Add the queue statistics to a metrics snapshot
+     *  @param name - name of the queue in the snapshot.
+     *  @param snapshot - the snapshot.
+     */
+    void CollectMetrics(const char* name,
+                        Metrics::Snapshot& snapshot) const;
 
   private:
     /**
@@ -100,21 +202,90 @@ class AsyncTaskQueue {
     pthread_t m_Thread;
 #endif
 
+#ifdef _WIN32
+    DWORD m_ThreadId;
+#endif
+
+    /**
+     * A queued task
+     */
+    struct Entry {
+        TaskData const* taskData;
+        /** Time it was enqueued, in ms, if there are several lanes or metrics are enabled */
+        uint64_t enqueued;
+        /** Whether it is in m_Coalescible under \a key */
+        bool indexed;
+        uint64_t key;
+    };
+
+    /**
+     * A queued task that tasks can be merged into
+     */
+    struct Coalescible {
+        TaskData const* taskData;
+        unsigned int lane;
+    };
+
+    /**
+     * The most recent queued task per coalesce key, OVERFLOW_COALESCE only
+     */
+    std::unordered_map<uint64_t, Coalescible> m_Coalescible;
+
     /**
-     * A Queue that holds the messages
+     * The queues that hold the messages, one per lane
      */
-    std::queue<TaskData const*> m_MessageQueue;
+    std::vector<std::deque<Entry> > m_Lanes;
+
+    /**
+     * Total number of queued messages
+     */
+    size_t m_Depth;
+
+    /**
+     * Aging limit in ms for prioritized lanes
+     */
+    uint32_t m_MaxWait;
+
+    /**
+     * Number of tasks taken by priority while others aged, since an aged task overtook them
+     */
+    unsigned int m_SinceAged;
 
     /**
      * The mutex Lock
      */
-    pthread_mutex_t m_Lock;
+    mutable pthread_mutex_t m_Lock;
 
     /**
      * The Queue Changed thread condition
      */
     pthread_cond_t m_QueueChanged;
 
+    /**
+     * Signalled when a full queue got room, or the queue is stopping
+     */
+    pthread_cond_t m_QueueNotFull;
+
+    /**
+     * Maximum number of queued tasks, 0 for no limit
+     */
+    size_t m_Capacity;
+
+    /**
+     * What to do on overflow
+     */
+    OverflowPolicy m_Policy;
+
+    /**
+     * Number of producers waiting for room
+     */
+    size_t m_Waiting;
+
+    /**
+     * Statistics, depth excluded
+     */
+    Stats m_Stats;
+
     /**
      * is the thread in the process of shutting down
      */
@@ -131,6 +302,29 @@ class AsyncTaskQueue {
      */
     void Receiver();
 
+    /**
+     * Whether the caller is the receiver thread
+     */
+    bool IsReceiverThread() const;
+
+    /**
+     * Apply the overflow policy to \a taskdata, called locked on a full queue.
+     * @return true if the task may be queued, false if it was discarded
+     */
+    bool MakeRoom(TaskData const* taskdata,
+                  unsigned int lane,
+                  const Entry& entry);
+
+    /**
+     * Take the next task off the (non-empty) queue, called locked.
+     */
+    TaskData const* Pop();
+
+    /**
+     * Monotonic time in ms
+     */
+    static uint64_t Now();
+
     /**
      * class to report about events to the client
      */
@@ -14,84 +14,98 @@
  *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  ******************************************************************************/
 
-#include <iostream>     // std::cout
-#include <fstream>      // std::ifstream
 #include <sys/types.h>
-#include <string>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include "GuidUtil.h"
-#if defined(QCC_OS_DARWIN)
-#include <limits.h>
-#include <CoreFoundation/CFUUID.h>
-#elif defined(_WIN32)
-#include <limits.h>
-#else
-#include <linux/limits.h>
-#endif
 #ifdef _WIN32
 #include <Rpc.h>
 #pragma comment(lib, "rpcrt4.lib")
+#else
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
-//static const char DEVICE_ID_FILE_NAME[] = "alljoyn-deviceId.txt";
+#define QCC_MODULE "DD_COMMON"
 
 using namespace datadriven;
 using namespace qcc;
 
-GuidUtil* GuidUtil::pGuidUtil = NULL;
+namespace {
+/* finalizer of splitmix64, a bijection that spreads every input bit */
+uint64_t Mix(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
 
-GuidUtil* GuidUtil::GetInstance()
+void ToHex(uint64_t value, char* out)
 {
-    if (pGuidUtil == NULL) {
-        pGuidUtil = new GuidUtil();
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 15; i >= 0; i--) {
+        out[i] = digits[value & 0xf];
+        value >>= 4;
     }
-    return pGuidUtil;
+}
 }
 
-GuidUtil::GuidUtil()
+GuidUtil* GuidUtil::GetInstance()
 {
+    /* initialized exactly once, even when called concurrently */
+    static GuidUtil instance;
+    return &instance;
 }
 
-GuidUtil::~GuidUtil()
+GuidUtil::GuidUtil() :
+    counter(0)
 {
+    ReadSeed(seed);
 }
 
-void GuidUtil::NormalizeString(char* strGUID)
+GuidUtil::~GuidUtil()
 {
-    //remove the '-' from the string:
-    std::string sGUID(strGUID);
-    std::string::size_type nposition = std::string::npos;
-    while ((nposition = sGUID.find('-')) != std::string::npos) {
-        sGUID.erase(nposition, 1);
-    }
-    strcpy(strGUID, sGUID.c_str());
 }
 
-void GuidUtil::GenerateGUIDUtil(char* strGUID)
+void GuidUtil::ReadSeed(uint64_t out[2])
 {
 #ifdef _WIN32
     UUID uuid;
-    UuidCreate(&uuid);
-    RPC_CSTR str;
-    UuidToStringA(&uuid, &str);
-    memcpy(strGUID, str, GUID_STRING_MAX_LENGTH + GUID_HYPHEN_MAX_LENGTH);
-    strGUID[GUID_STRING_MAX_LENGTH + GUID_HYPHEN_MAX_LENGTH + 1] = 0;
-    RpcStringFreeA(&str);
-#elif defined(QCC_OS_DARWIN)
-    CFUUIDRef cfUUID = CFUUIDCreate(NULL);
-    CFStringRef cfUUIDString = CFUUIDCreateString(NULL, cfUUID);
-    const int len = CFStringGetLength(cfUUIDString);
-    CFStringGetCString(cfUUIDString, strGUID, len + 1, CFStringGetSystemEncoding());
-    CFRelease(cfUUID);
-    NormalizeString(strGUID);
+    if (RPC_S_OK == UuidCreate(&uuid)) {
+        memcpy(out, &uuid, sizeof(uuid));
+        return;
+    }
 #else
-    std::ifstream ifs("/proc/sys/kernel/random/uuid", std::ifstream::in);
-    ifs.getline(strGUID, GUID_STRING_MAX_LENGTH + GUID_HYPHEN_MAX_LENGTH + END_OF_STRING_LENGTH);
-    ifs.close();
-    NormalizeString(strGUID);
+    int fd = open("/dev/urandom", O_RDONLY);
+    if (fd >= 0) {
+        ssize_t len = read(fd, out, 2 * sizeof(uint64_t));
+        close(fd);
+        if ((ssize_t)(2 * sizeof(uint64_t)) == len) {
+            return;
+        }
+    }
 #endif
+    QCC_LogError(ER_FAIL, ("No random source available, seeding GUIDs from the clock"));
+    out[0] = Mix((uint64_t)time(NULL));
+    out[1] = Mix(out[0] ^ (uint64_t)(uintptr_t)&out ^ (uint64_t)clock());
+}
+
+void GuidUtil::GenerateGUID(char* strGUID)
+{
+    uint64_t n = counter.fetch_add(1, std::memory_order_relaxed);
+    /* Mix is a bijection, so every counter value gives a different half */
+    uint64_t hi = Mix(seed[0] + n);
+    uint64_t lo = Mix(seed[1] + n);
+
+    /* version 4, variant 1 */
+    hi = (hi & ~0xf000ULL) | 0x4000ULL;
+    lo = (lo & ~(0xc000000000000000ULL)) | 0x8000000000000000ULL;
+
+    ToHex(hi, strGUID);
+    ToHex(lo, strGUID + 16);
+    strGUID[GUID_STRING_MAX_LENGTH] = '\0';
 }
 
 void GuidUtil::GenerateGUID(qcc::String* guid)
@@ -100,7 +114,7 @@ void GuidUtil::GenerateGUID(qcc::String* guid)
         return;
     }
 
-    char tempstrGUID[GUID_STRING_MAX_LENGTH + GUID_HYPHEN_MAX_LENGTH + END_OF_STRING_LENGTH];
-    GenerateGUIDUtil(tempstrGUID);
+    char tempstrGUID[GUID_STRING_MAX_LENGTH + END_OF_STRING_LENGTH];
+    GenerateGUID(tempstrGUID);
     guid->assign(tempstrGUID);
 }
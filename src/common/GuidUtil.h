@@ -17,6 +17,10 @@
 #ifndef GUID_UTIL_H_
 #define GUID_UTIL_H_
 
+#include <stdint.h>
+
+#include <atomic>
+
 #include <qcc/Debug.h>
 #include <qcc/String.h>
 
@@ -28,6 +32,11 @@ namespace datadriven {
 /**
  * implements GUID utilities
  * Generation, saving, exposing - 128 bit unique number
+ *
+ * GUIDs are random (version 4) UUIDs without hyphens. They are generated in
+ * process: the generator is seeded once from the operating system's random
+ * source, after which every GUID is derived from the seed and a process-wide
+ * counter. This is thread-safe and does not touch the file system.
  */
 class GuidUtil {
   public:
@@ -43,31 +52,37 @@ class GuidUtil {
      */
     void GenerateGUID(qcc::String* guid);
 
+    /**
+     * Generate a GUID into a caller provided buffer
+     * @param strGUID buffer of at least GUID_STRING_MAX_LENGTH + END_OF_STRING_LENGTH
+     *                characters, receives the NUL terminated GUID
+     */
+    void GenerateGUID(char* strGUID);
+
   private:
     /**
-     * Constructor for GuidUtil
+     * Constructor for GuidUtil, seeds the generator
      */
     GuidUtil();
     /**
      * Destructor for GuidUtil
      */
     virtual ~GuidUtil();
+
     /**
-     * NormalizeString
-     * @param strGUID
+     * Fill \a out with random bytes from the operating system
      */
-    void NormalizeString(char* strGUID);
+    static void ReadSeed(uint64_t out[2]);
 
     /**
-     * GenerateGUIDUtil
-     * @param strGUID
+     * Seed of the generator
      */
-    void GenerateGUIDUtil(char* strGUID);
+    uint64_t seed[2];
 
     /**
-     * a pointer to singleton GuidUtil
+     * Number of GUIDs generated so far
      */
-    static GuidUtil* pGuidUtil;
+    std::atomic<uint64_t> counter;
 };
 } //namespace datadriven
 
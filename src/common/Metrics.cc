@@ -0,0 +1,195 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <string.h>
+
+#include <algorithm>
+
+#include <datadriven/Metrics.h>
+#include <datadriven/Mutex.h>
+
+#include "ThreadTables.h"
+
+using namespace datadriven;
+
+namespace {
+typedef HistogramCounters<MutexProfiler::BUCKETS> Counters;
+
+struct ThreadTable {
+    std::atomic<uint64_t> counters[Metrics::NUM_COUNTERS];
+    Counters timings[Metrics::NUM_TIMINGS];
+    /* whether a live thread owns this table */
+    std::atomic<bool> inUse;
+    /* next table in the registry, immutable once published */
+    ThreadTable* next;
+
+    ThreadTable() :
+        next(NULL)
+    {
+        Clear();
+        inUse.store(true, std::memory_order_relaxed);
+    }
+
+    void Clear()
+    {
+        for (unsigned int i = 0; i < Metrics::NUM_COUNTERS; i++) {
+            counters[i].store(0, std::memory_order_relaxed);
+        }
+        for (unsigned int i = 0; i < Metrics::NUM_TIMINGS; i++) {
+            timings[i].Clear();
+        }
+    }
+};
+
+/* Sources are few and only change when an observer manager, session manager
+ * or object advertiser comes or goes, a plain locked vector will do. */
+datadriven::Mutex& SourcesMutex()
+{
+    static datadriven::Mutex mutex(false);
+    return mutex;
+}
+
+std::vector<const Metrics::Source*>& Sources()
+{
+    static std::vector<const Metrics::Source*> sources;
+    return sources;
+}
+
+const char* counterNames[Metrics::NUM_COUNTERS] = {
+    "provider_gets",
+    "provider_sets",
+    "provider_method_calls",
+    "provider_signals",
+    "provider_updates",
+    "session_joins",
+    "session_join_failures",
+    "session_losses"
+};
+
+const char* timingNames[Metrics::NUM_TIMINGS] = {
+    "session_join_latency"
+};
+}
+
+std::atomic<bool> Metrics::enabled(false);
+
+Metrics::Snapshot::Snapshot() :
+    time(0), sessions(0), establishedSessions(0)
+{
+    memset(counters, 0, sizeof(counters));
+}
+
+void Metrics::Enable(bool enable)
+{
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+const char* Metrics::GetName(Counter counter)
+{
+    return (counter < NUM_COUNTERS) ? counterNames[counter] : "unknown";
+}
+
+const char* Metrics::GetName(Timing timing)
+{
+    return (timing < NUM_TIMINGS) ? timingNames[timing] : "unknown";
+}
+
+void Metrics::Record(Counter counter,
+                     uint64_t n)
+{
+    AddOwned(ThreadTables<ThreadTable>::Get()->counters[counter], n);
+}
+
+void Metrics::RecordTiming(Timing timing,
+                           uint64_t ns)
+{
+    if (IsEnabled()) {
+        ThreadTables<ThreadTable>::Get()->timings[timing].Record(ns);
+    }
+}
+
+void Metrics::AddSource(const Source* source)
+{
+    SourcesMutex().Lock(MUTEX_CONTEXT);
+    Sources().push_back(source);
+    SourcesMutex().Unlock(MUTEX_CONTEXT);
+}
+
+void Metrics::RemoveSource(const Source* source)
+{
+    SourcesMutex().Lock(MUTEX_CONTEXT);
+    std::vector<const Source*>& sources = Sources();
+    sources.erase(std::remove(sources.begin(), sources.end(), source), sources.end());
+    SourcesMutex().Unlock(MUTEX_CONTEXT);
+}
+
+void Metrics::GetSnapshot(Snapshot& snapshot)
+{
+    snapshot = Snapshot();
+    snapshot.time = MutexProfiler::Now();
+
+    for (ThreadTable* table = ThreadTables<ThreadTable>::First(); table; table = table->next) {
+        for (unsigned int i = 0; i < NUM_COUNTERS; i++) {
+            snapshot.counters[i] += table->counters[i].load(std::memory_order_relaxed);
+        }
+        for (unsigned int i = 0; i < NUM_TIMINGS; i++) {
+            table->timings[i].MergeInto(snapshot.timings[i]);
+        }
+    }
+
+    SourcesMutex().Lock(MUTEX_CONTEXT);
+    const std::vector<const Source*>& sources = Sources();
+    for (size_t i = 0; i < sources.size(); i++) {
+        sources[i]->CollectMetrics(snapshot);
+    }
+    SourcesMutex().Unlock(MUTEX_CONTEXT);
+}
+
+void Metrics::Dump(FILE* out)
+{
+    Snapshot snapshot;
+    GetSnapshot(snapshot);
+
+    for (unsigned int i = 0; i < NUM_COUNTERS; i++) {
+        fprintf(out, "counter %s %llu\n", counterNames[i], (unsigned long long)snapshot.counters[i]);
+    }
+    for (unsigned int i = 0; i < NUM_TIMINGS; i++) {
+        const Histogram& timing = snapshot.timings[i];
+        fprintf(out, "timing %s %llu %.1f %.1f %.1f\n", timingNames[i], (unsigned long long)timing.GetCount(),
+                timing.GetPercentile(50) / 1000.0, timing.GetPercentile(99) / 1000.0, timing.max / 1000.0);
+    }
+    for (size_t i = 0; i < snapshot.caches.size(); i++) {
+        const Cache& cache = snapshot.caches[i];
+        fprintf(out, "cache %s %zu %zu %zu\n", cache.interfaceName.c_str(), cache.living, cache.dead,
+                cache.observers);
+    }
+    for (size_t i = 0; i < snapshot.queues.size(); i++) {
+        const Queue& queue = snapshot.queues[i];
+        fprintf(out, "queue %s %zu %zu %llu %llu %llu %llu %llu %llu\n", queue.name, queue.depth, queue.highWatermark,
+                (unsigned long long)queue.enqueued, (unsigned long long)queue.executed,
+                (unsigned long long)queue.dropped, (unsigned long long)queue.coalesced,
+                (unsigned long long)queue.blocked, (unsigned long long)queue.maxWait);
+    }
+    fprintf(out, "sessions %zu %zu\n", snapshot.sessions, snapshot.establishedSessions);
+    fflush(out);
+}
+
+void Metrics::Reset()
+{
+    for (ThreadTable* table = ThreadTables<ThreadTable>::First(); table; table = table->next) {
+        table->Clear();
+    }
+}
@@ -0,0 +1,225 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include <datadriven/MutexProfiler.h>
+
+#include "ThreadTables.h"
+
+/** Call sites per thread, a power of two. Samples of further sites are dropped. */
+#define SITES_PER_THREAD 256
+
+using namespace datadriven;
+
+namespace {
+typedef HistogramCounters<MutexProfiler::BUCKETS> Counters;
+
+struct SiteSlot {
+    /* set once by the owning thread, line before file */
+    std::atomic<const char*> file;
+    std::atomic<uint32_t> line;
+    std::atomic<uint64_t> acquisitions;
+    std::atomic<uint64_t> contended;
+    Counters wait;
+    Counters hold;
+};
+
+struct ThreadTable {
+    SiteSlot slots[SITES_PER_THREAD];
+    /* whether a live thread owns this table */
+    std::atomic<bool> inUse;
+    /* next table in the registry, immutable once published */
+    ThreadTable* next;
+
+    ThreadTable() :
+        next(NULL)
+    {
+        for (unsigned int i = 0; i < SITES_PER_THREAD; i++) {
+            slots[i].file.store(NULL, std::memory_order_relaxed);
+            slots[i].line.store(0, std::memory_order_relaxed);
+            slots[i].acquisitions.store(0, std::memory_order_relaxed);
+            slots[i].contended.store(0, std::memory_order_relaxed);
+            slots[i].wait.Clear();
+            slots[i].hold.Clear();
+        }
+        inUse.store(true, std::memory_order_relaxed);
+    }
+
+    SiteSlot* Find(const char* file,
+                   uint32_t line)
+    {
+        size_t hash = (reinterpret_cast<size_t>(file) >> 3) ^ (line * 2654435761u);
+        for (unsigned int probe = 0; probe < SITES_PER_THREAD; probe++) {
+            SiteSlot& slot = slots[(hash + probe) & (SITES_PER_THREAD - 1)];
+            const char* slotFile = slot.file.load(std::memory_order_relaxed);
+            if (NULL == slotFile) {
+                slot.line.store(line, std::memory_order_relaxed);
+                slot.file.store(file, std::memory_order_release);
+                return &slot;
+            }
+            if ((slotFile == file) && (slot.line.load(std::memory_order_relaxed) == line)) {
+                return &slot;
+            }
+        }
+        return NULL;
+    }
+};
+
+SiteSlot* FindSite(const char* file,
+                   uint32_t line)
+{
+    return ThreadTables<ThreadTable>::Get()->Find(file, line);
+}
+
+bool MoreWait(const MutexProfiler::Site& a,
+              const MutexProfiler::Site& b)
+{
+    return a.wait.total > b.wait.total;
+}
+}
+
+std::atomic<bool> MutexProfiler::enabled(false);
+
+MutexProfiler::Histogram::Histogram() :
+    total(0), max(0)
+{
+    memset(buckets, 0, sizeof(buckets));
+}
+
+uint64_t MutexProfiler::Histogram::GetCount() const
+{
+    uint64_t count = 0;
+    for (unsigned int i = 0; i < BUCKETS; i++) {
+        count += buckets[i];
+    }
+    return count;
+}
+
+uint64_t MutexProfiler::Histogram::GetPercentile(unsigned int percentile) const
+{
+    uint64_t count = GetCount();
+    uint64_t rank = (count * std::min(percentile, 100u) + 99) / 100;
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < BUCKETS; i++) {
+        seen += buckets[i];
+        if ((seen >= rank) && (seen > 0)) {
+            return std::min((uint64_t)1 << i, max);
+        }
+    }
+    return 0;
+}
+
+void MutexProfiler::Enable(bool enable)
+{
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+uint64_t MutexProfiler::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void MutexProfiler::RecordLock(const char* file,
+                               uint32_t line,
+                               bool contended,
+                               uint64_t wait)
+{
+    SiteSlot* slot = FindSite(file, line);
+    if (NULL == slot) {
+        return;
+    }
+    AddOwned(slot->acquisitions, 1);
+    if (contended) {
+        AddOwned(slot->contended, 1);
+        slot->wait.Record(wait);
+    }
+}
+
+void MutexProfiler::RecordHold(const char* file,
+                               uint32_t line,
+                               uint64_t hold)
+{
+    SiteSlot* slot = FindSite(file, line);
+    if (NULL != slot) {
+        slot->hold.Record(hold);
+    }
+}
+
+void MutexProfiler::GetSites(std::vector<Site>& sites)
+{
+    sites.clear();
+    for (ThreadTable* table = ThreadTables<ThreadTable>::First(); table; table = table->next) {
+        for (unsigned int i = 0; i < SITES_PER_THREAD; i++) {
+            const SiteSlot& slot = table->slots[i];
+            const char* file = slot.file.load(std::memory_order_acquire);
+            if (NULL == file) {
+                continue;
+            }
+            uint32_t line = slot.line.load(std::memory_order_relaxed);
+            /* the same site may be known under different string addresses */
+            std::vector<Site>::iterator it = sites.begin();
+            while ((it != sites.end()) && ((it->line != line) || (0 != strcmp(it->file, file)))) {
+                ++it;
+            }
+            if (it == sites.end()) {
+                Site site;
+                site.file = file;
+                site.line = line;
+                site.acquisitions = 0;
+                site.contended = 0;
+                it = sites.insert(sites.end(), site);
+            }
+            it->acquisitions += slot.acquisitions.load(std::memory_order_relaxed);
+            it->contended += slot.contended.load(std::memory_order_relaxed);
+            slot.wait.MergeInto(it->wait);
+            slot.hold.MergeInto(it->hold);
+        }
+    }
+    std::sort(sites.begin(), sites.end(), MoreWait);
+}
+
+void MutexProfiler::Dump(FILE* out)
+{
+    std::vector<Site> sites;
+    GetSites(sites);
+    for (size_t i = 0; i < sites.size(); i++) {
+        const Site& site = sites[i];
+        fprintf(out, "%s:%u %llu %llu %.1f %.1f %.1f %.1f %.1f\n", site.file, site.line,
+                (unsigned long long)site.acquisitions, (unsigned long long)site.contended,
+                site.wait.total / 1000.0, site.wait.GetPercentile(99) / 1000.0,
+                site.hold.total / 1000.0, site.hold.GetPercentile(99) / 1000.0,
+                site.hold.max / 1000.0);
+    }
+    fflush(out);
+}
+
+void MutexProfiler::Reset()
+{
+    for (ThreadTable* table = ThreadTables<ThreadTable>::First(); table; table = table->next) {
+        for (unsigned int i = 0; i < SITES_PER_THREAD; i++) {
+            SiteSlot& slot = table->slots[i];
+            slot.acquisitions.store(0, std::memory_order_relaxed);
+            slot.contended.store(0, std::memory_order_relaxed);
+            slot.wait.Clear();
+            slot.hold.Clear();
+        }
+    }
+}
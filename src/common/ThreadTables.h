@@ -0,0 +1,151 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef THREADTABLES_H_
+#define THREADTABLES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "ThreadLocal.h"
+
+namespace datadriven {
+/**
+ * Registry of per-thread tables of statistics.
+ *
+ * Every thread gets a table of type T that only it writes to, so recording
+ * takes no locks and shares no cache lines with other threads. Readers walk
+ * all tables from First(). Tables are never freed: a table released by an
+ * exiting thread is taken over by the next new thread, so their number is
+ * bounded by the largest number of recording threads at any one time.
+ *
+ * T must be default constructible, marking itself in use, and have the
+ * members
+ *   std::atomic<bool> inUse;   whether a live thread owns the table
+ *   T* next;                   next table, immutable once published
+ */
+template <typename T> class ThreadTables {
+  public:
+    /**
+     * The table of the calling thread.
+     */
+    static T* Get()
+    {
+        static DD_THREAD_LOCAL Owner owner;
+        if (NULL == owner.table) {
+            owner.table = Claim();
+        }
+        return owner.table;
+    }
+
+    /**
+     * The most recently created table, follow T::next for the others.
+     */
+    static T* First()
+    {
+        return registry.load(std::memory_order_acquire);
+    }
+
+  private:
+    struct Owner {
+        T* table;
+
+        Owner() :
+            table(NULL) { }
+
+        ~Owner()
+        {
+            if (table) {
+                table->inUse.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    static T* Claim()
+    {
+        for (T* table = First(); table; table = table->next) {
+            bool expected = false;
+            if (table->inUse.compare_exchange_strong(expected, true)) {
+                return table;
+            }
+        }
+        T* table = new T();
+        table->next = registry.load(std::memory_order_relaxed);
+        while (!registry.compare_exchange_weak(table->next, table, std::memory_order_release)) {
+        }
+        return table;
+    }
+
+    static std::atomic<T*> registry;
+};
+
+template <typename T> std::atomic<T*> ThreadTables<T>::registry(NULL);
+
+/**
+ * Add \a value to a counter that only the calling thread writes to. A
+ * relaxed load and store is enough and avoids locked instructions.
+ */
+inline void AddOwned(std::atomic<uint64_t>& counter,
+                     uint64_t value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/**
+ * Per-thread recorder of a log2 histogram, see MutexProfiler::Histogram.
+ */
+template <unsigned int BUCKETS> struct HistogramCounters {
+    std::atomic<uint64_t> buckets[BUCKETS];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> max;
+
+    void Record(uint64_t value)
+    {
+        unsigned int bucket = 0;
+        for (uint64_t v = value; v && (bucket < BUCKETS - 1); v >>= 1) {
+            bucket++;
+        }
+        AddOwned(buckets[bucket], 1);
+        AddOwned(total, value);
+        if (value > max.load(std::memory_order_relaxed)) {
+            max.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    template <typename H> void MergeInto(H& histogram) const
+    {
+        for (unsigned int i = 0; i < BUCKETS; i++) {
+            histogram.buckets[i] += buckets[i].load(std::memory_order_relaxed);
+        }
+        histogram.total += total.load(std::memory_order_relaxed);
+        histogram.max = std::max(histogram.max, max.load(std::memory_order_relaxed));
+    }
+
+    void Clear()
+    {
+        for (unsigned int i = 0; i < BUCKETS; i++) {
+            buckets[i].store(0, std::memory_order_relaxed);
+        }
+        total.store(0, std::memory_order_relaxed);
+        max.store(0, std::memory_order_relaxed);
+    }
+};
+}
+
+#endif /* THREADTABLES_H_ */
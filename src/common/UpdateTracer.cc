@@ -0,0 +1,225 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
+#include <datadriven/Mutex.h>
+#include <datadriven/MutexProfiler.h>
+#include <datadriven/UpdateTracer.h>
+
+#include "ThreadLocal.h"
+
+using namespace datadriven;
+
+namespace {
+/* Only taken while tracing, a plain lock around the ring will do. It is
+ * never held while calling out, so it nests inside any other lock. */
+datadriven::Mutex& RingMutex()
+{
+    static datadriven::Mutex mutex(false);
+    return mutex;
+}
+
+UpdateTracer::Trace* Ring()
+{
+    static UpdateTracer::Trace ring[UpdateTracer::CAPACITY];
+    return ring;
+}
+
+/** number of updates seen, for sampling */
+std::atomic<uint64_t> sequence(0);
+/** number of traced updates, the trace ids, so consecutive traces use consecutive slots */
+std::atomic<uint64_t> traced(0);
+std::atomic<unsigned int> sampling(1);
+DD_THREAD_LOCAL uint64_t current = 0;
+
+const char* stageNames[UpdateTracer::NUM_STAGES] = {
+    "update",
+    "marshal",
+    "emit",
+    "receive",
+    "queue",
+    "unmarshal",
+    "deliver"
+};
+
+bool CompareId(const UpdateTracer::Trace& left,
+               const UpdateTracer::Trace& right)
+{
+    return left.id < right.id;
+}
+
+unsigned long ProcessId()
+{
+#ifdef _WIN32
+    return GetCurrentProcessId();
+#else
+    return getpid();
+#endif
+}
+}
+
+std::atomic<bool> UpdateTracer::enabled(false);
+
+UpdateTracer::Trace::Trace() :
+    id(0), mergedInto(0)
+{
+    memset(stamps, 0, sizeof(stamps));
+}
+
+void UpdateTracer::Enable(bool enable,
+                          unsigned int every)
+{
+    sampling.store((0 == every) ? 1 : every, std::memory_order_relaxed);
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+const char* UpdateTracer::GetName(Stage stage)
+{
+    return (stage < NUM_STAGES) ? stageNames[stage] : "unknown";
+}
+
+uint64_t UpdateTracer::Start(Stage stage,
+                             const char* path,
+                             const char* interfaceName)
+{
+    uint64_t seq = sequence.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (0 != (seq % sampling.load(std::memory_order_relaxed))) {
+        return 0;
+    }
+    uint64_t id = traced.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    uint64_t now = MutexProfiler::Now();
+    RingMutex().Lock(MUTEX_CONTEXT);
+    Trace& trace = Ring()[id % CAPACITY];
+    trace = Trace();
+    trace.id = id;
+    trace.path = path;
+    trace.interfaceName = interfaceName;
+    trace.stamps[stage] = now;
+    RingMutex().Unlock(MUTEX_CONTEXT);
+    return id;
+}
+
+void UpdateTracer::Stamp(uint64_t id,
+                         Stage stage)
+{
+    uint64_t now = MutexProfiler::Now();
+    RingMutex().Lock(MUTEX_CONTEXT);
+    Trace& trace = Ring()[id % CAPACITY];
+    // the slot may have been taken by a later trace already
+    if (trace.id == id) {
+        trace.stamps[stage] = now;
+    }
+    RingMutex().Unlock(MUTEX_CONTEXT);
+}
+
+void UpdateTracer::Merge(uint64_t id,
+                         uint64_t into)
+{
+    if (0 == id) {
+        return;
+    }
+    RingMutex().Lock(MUTEX_CONTEXT);
+    Trace& trace = Ring()[id % CAPACITY];
+    if (trace.id == id) {
+        trace.mergedInto = into;
+    }
+    RingMutex().Unlock(MUTEX_CONTEXT);
+}
+
+void UpdateTracer::SetCurrent(uint64_t id)
+{
+    current = id;
+}
+
+uint64_t UpdateTracer::GetCurrent()
+{
+    return current;
+}
+
+void UpdateTracer::GetTraces(std::vector<Trace>& traces)
+{
+    traces.clear();
+    RingMutex().Lock(MUTEX_CONTEXT);
+    const Trace* ring = Ring();
+    for (unsigned int i = 0; i < CAPACITY; i++) {
+        if (0 != ring[i].id) {
+            traces.push_back(ring[i]);
+        }
+    }
+    RingMutex().Unlock(MUTEX_CONTEXT);
+    std::sort(traces.begin(), traces.end(), CompareId);
+}
+
+void UpdateTracer::DumpChromeTrace(FILE* out)
+{
+    std::vector<Trace> traces;
+    GetTraces(traces);
+
+    // object paths and interface names never hold characters JSON needs escaped
+    unsigned long pid = ProcessId();
+    const char* separator = "";
+    fprintf(out, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < traces.size(); i++) {
+        const Trace& trace = traces[i];
+        int previous = -1;
+        for (int stage = 0; stage < NUM_STAGES; stage++) {
+            if (0 == trace.stamps[stage]) {
+                continue;
+            }
+            if (previous >= 0) {
+                const char* category = (stage < RECEIVED) ? "provider" : "consumer";
+                fprintf(out, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"b\",\"id\":%llu,\"pid\":%lu,\"tid\":0,"
+                        "\"ts\":%.3f,\"args\":{\"path\":\"%s\",\"interface\":\"%s\"}},\n",
+                        separator, stageNames[stage], category, (unsigned long long)trace.id, pid,
+                        trace.stamps[previous] / 1000.0, trace.path.c_str(), trace.interfaceName.c_str());
+                fprintf(out, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"e\",\"id\":%llu,\"pid\":%lu,\"tid\":0,"
+                        "\"ts\":%.3f}",
+                        stageNames[stage], category, (unsigned long long)trace.id, pid,
+                        trace.stamps[stage] / 1000.0);
+                separator = ",\n";
+            }
+            previous = stage;
+        }
+        if (0 != trace.mergedInto) {
+            fprintf(out, "%s{\"name\":\"merged\",\"cat\":\"consumer\",\"ph\":\"n\",\"id\":%llu,\"pid\":%lu,\"tid\":0,"
+                    "\"ts\":%.3f,\"args\":{\"into\":%llu,\"path\":\"%s\",\"interface\":\"%s\"}}",
+                    separator, (unsigned long long)trace.id, pid, trace.stamps[RECEIVED] / 1000.0,
+                    (unsigned long long)trace.mergedInto, trace.path.c_str(), trace.interfaceName.c_str());
+            separator = ",\n";
+        }
+    }
+    fprintf(out, "\n]}\n");
+    fflush(out);
+}
+
+void UpdateTracer::Reset()
+{
+    RingMutex().Lock(MUTEX_CONTEXT);
+    Trace* ring = Ring();
+    for (unsigned int i = 0; i < CAPACITY; i++) {
+        ring[i] = Trace();
+    }
+    RingMutex().Unlock(MUTEX_CONTEXT);
+}
@@ -27,6 +27,7 @@
 #include <assert.h>
 
 #include <datadriven/Mutex.h>
+#include <datadriven/MutexProfiler.h>
 #include <qcc/Debug.h>
 
 #include <alljoyn/Status.h>
@@ -48,8 +49,17 @@ void Mutex::Init()
         printf("***** Mutex attribute initialization failure: %d - %s\n", ret, strerror(ret));
         goto cleanup;
     }
-    // We want entities to be able to lock a mutex multiple times without deadlocking or reporting an error.
-    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    if (recursive) {
+        // We want entities to be able to lock a mutex multiple times without deadlocking or reporting an error.
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    } else {
+#ifdef NDEBUG
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_NORMAL);
+#else
+        // catch a second lock by the owner instead of deadlocking
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ERRORCHECK);
+#endif
+    }
 
     ret = pthread_mutex_init(&mutex, &attr);
     if (ret != 0) {
@@ -62,6 +72,7 @@ void Mutex::Init()
     isInitialized = true;
     file = NULL;
     line = -1;
+    lockedAt = 0;
 
 cleanup:
     // Don't need the attribute once it has been assigned to a mutex.
@@ -103,17 +114,22 @@ QStatus Mutex::Lock()
 
 QStatus Mutex::Lock(const char* file, uint32_t line)
 {
-#ifdef NDEBUG
+#if defined(NDEBUG) && !defined(DATADRIVEN_MUTEX_PROFILING)
     return Lock();
 #else
     if (!isInitialized) {
         return ER_INIT_FAILED;
     }
 
+    bool profiling = MutexProfiler::IsEnabled();
+    uint64_t waitStart = 0;
     QStatus status;
     if (TryLock()) {
         status = ER_OK;
     } else {
+        if (profiling) {
+            waitStart = MutexProfiler::Now();
+        }
         status = Lock();
         if (status == ER_OK) {
             QCC_DbgPrintf(("Lock Acquired %s:%d", file, line));
@@ -124,6 +140,11 @@ QStatus Mutex::Lock(const char* file, uint32_t line)
     if (status == ER_OK) {
         this->file = reinterpret_cast<const char*>(file);
         this->line = line;
+        lockedAt = 0;
+        if (profiling) {
+            lockedAt = MutexProfiler::Now();
+            MutexProfiler::RecordLock(file, line, waitStart != 0, waitStart ? lockedAt - waitStart : 0);
+        }
     }
     return status;
 #endif
@@ -148,12 +169,18 @@ QStatus Mutex::Unlock()
 
 QStatus Mutex::Unlock(const char* file, uint32_t line)
 {
-#ifdef NDEBUG
+#if defined(NDEBUG) && !defined(DATADRIVEN_MUTEX_PROFILING)
     return Unlock();
 #else
     if (!isInitialized) {
         return ER_INIT_FAILED;
     }
+    /* a recursive relock overwrote the lock site, the hold time is that of
+     * the innermost lock and the outer unlock finds nothing to record */
+    if ((0 != lockedAt) && (NULL != this->file)) {
+        MutexProfiler::RecordHold(this->file, this->line, MutexProfiler::Now() - lockedAt);
+    }
+    lockedAt = 0;
     this->file = NULL;
     this->line = -1;
     int ret = pthread_mutex_unlock(&mutex);
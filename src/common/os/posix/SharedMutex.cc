@@ -0,0 +1,197 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#include <qcc/platform.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include <datadriven/SharedMutex.h>
+#include <datadriven/MutexProfiler.h>
+
+#include <alljoyn/Status.h>
+
+/** @internal */
+#define QCC_MODULE "MUTEX"
+
+using namespace datadriven;
+
+SharedMutex::SharedMutex() :
+    isInitialized(false), file(NULL), line(0), lockedAt(0)
+{
+    int ret;
+    pthread_rwlockattr_t attr;
+    ret = pthread_rwlockattr_init(&attr);
+    if (ret != 0) {
+        fflush(stdout);
+        // Can't use ER_LogError() since it uses mutexs under the hood.
+        printf("***** SharedMutex attribute initialization failure: %d - %s\n", ret, strerror(ret));
+        return;
+    }
+#if defined(__GLIBC__)
+    // glibc prefers readers by default, which lets a busy reader side starve writers
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+
+    ret = pthread_rwlock_init(&rwlock, &attr);
+    if (ret != 0) {
+        fflush(stdout);
+        // Can't use ER_LogError() since it uses mutexs under the hood.
+        printf("***** SharedMutex initialization failure: %d - %s\n", ret, strerror(ret));
+    } else {
+        isInitialized = true;
+    }
+    pthread_rwlockattr_destroy(&attr);
+}
+
+SharedMutex::~SharedMutex()
+{
+    if (!isInitialized) {
+        return;
+    }
+
+    int ret = pthread_rwlock_destroy(&rwlock);
+    if (ret != 0) {
+        fflush(stdout);
+        // Can't use ER_LogError() since it uses mutexs under the hood.
+        printf("***** SharedMutex destruction failure: %d - %s\n", ret, strerror(ret));
+        assert(false);
+    }
+}
+
+QStatus SharedMutex::Lock()
+{
+    if (!isInitialized) {
+        return ER_INIT_FAILED;
+    }
+
+    int ret = pthread_rwlock_wrlock(&rwlock);
+    if (ret != 0) {
+        fflush(stdout);
+        // Can't use ER_LogError() since it uses mutexes under the hood.
+        printf("***** SharedMutex lock failure: %d - %s\n", ret, strerror(ret));
+        assert(false);
+        return ER_OS_ERROR;
+    }
+    return ER_OK;
+}
+
+QStatus SharedMutex::Lock(const char* file, uint32_t line)
+{
+#if defined(NDEBUG) && !defined(DATADRIVEN_MUTEX_PROFILING)
+    return Lock();
+#else
+    if (!MutexProfiler::IsEnabled()) {
+        return Lock();
+    }
+    if (!isInitialized) {
+        return ER_INIT_FAILED;
+    }
+
+    uint64_t waitStart = 0;
+    if (0 != pthread_rwlock_trywrlock(&rwlock)) {
+        waitStart = MutexProfiler::Now();
+        QStatus status = Lock();
+        if (status != ER_OK) {
+            return status;
+        }
+    }
+    this->file = file;
+    this->line = line;
+    lockedAt = MutexProfiler::Now();
+    MutexProfiler::RecordLock(file, line, waitStart != 0, waitStart ? lockedAt - waitStart : 0);
+    return ER_OK;
+#endif
+}
+
+QStatus SharedMutex::Unlock()
+{
+    if (!isInitialized) {
+        return ER_INIT_FAILED;
+    }
+
+    int ret = pthread_rwlock_unlock(&rwlock);
+    if (ret != 0) {
+        fflush(stdout);
+        // Can't use ER_LogError() since it uses mutexes under the hood.
+        printf("***** SharedMutex unlock failure: %d - %s\n", ret, strerror(ret));
+        assert(false);
+        return ER_OS_ERROR;
+    }
+    return ER_OK;
+}
+
+QStatus SharedMutex::Unlock(const char* file, uint32_t line)
+{
+    if (0 != lockedAt) {
+        MutexProfiler::RecordHold(this->file, this->line, MutexProfiler::Now() - lockedAt);
+        lockedAt = 0;
+    }
+    return Unlock();
+}
+
+QStatus SharedMutex::LockShared()
+{
+    if (!isInitialized) {
+        return ER_INIT_FAILED;
+    }
+
+    int ret = pthread_rwlock_rdlock(&rwlock);
+    if (ret != 0) {
+        fflush(stdout);
+        // Can't use ER_LogError() since it uses mutexes under the hood.
+        printf("***** SharedMutex shared lock failure: %d - %s\n", ret, strerror(ret));
+        assert(false);
+        return ER_OS_ERROR;
+    }
+    return ER_OK;
+}
+
+QStatus SharedMutex::LockShared(const char* file, uint32_t line)
+{
+#if defined(NDEBUG) && !defined(DATADRIVEN_MUTEX_PROFILING)
+    return LockShared();
+#else
+    if (!MutexProfiler::IsEnabled()) {
+        return LockShared();
+    }
+    if (!isInitialized) {
+        return ER_INIT_FAILED;
+    }
+
+    uint64_t waitStart = 0;
+    if (0 != pthread_rwlock_tryrdlock(&rwlock)) {
+        waitStart = MutexProfiler::Now();
+        QStatus status = LockShared();
+        if (status != ER_OK) {
+            return status;
+        }
+    }
+    MutexProfiler::RecordLock(file, line, waitStart != 0, waitStart ? MutexProfiler::Now() - waitStart : 0);
+    return ER_OK;
+#endif
+}
+
+QStatus SharedMutex::UnlockShared()
+{
+    return Unlock();
+}
+
+QStatus SharedMutex::UnlockShared(const char* file, uint32_t line)
+{
+    return UnlockShared();
+}
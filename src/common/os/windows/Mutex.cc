@@ -28,6 +28,7 @@
 
 #include <qcc/Thread.h>
 #include <datadriven/Mutex.h>
+#include <datadriven/MutexProfiler.h>
 
 /** @internal */
 #define QCC_MODULE "MUTEX"
@@ -42,6 +43,9 @@ using namespace datadriven;
 
 void Mutex::Init()
 {
+    file = NULL;
+    line = 0;
+    lockedAt = 0;
     if (!initialized) {
         // Starting with Vista this always returns non-zero so this test will be less and less important
         // in the future (http://msdn.microsoft.com/en-us/library/windows/desktop/ms683476.aspx)
@@ -76,6 +80,21 @@ QStatus Mutex::Lock(void)
 
 QStatus Mutex::Lock(const char* file, uint32_t line)
 {
+    if (MutexProfiler::IsEnabled()) {
+        uint64_t waitStart = 0;
+        if (!TryLock()) {
+            waitStart = MutexProfiler::Now();
+            QStatus status = Lock();
+            if (status != ER_OK) {
+                return status;
+            }
+        }
+        this->file = file;
+        this->line = line;
+        lockedAt = MutexProfiler::Now();
+        MutexProfiler::RecordLock(file, line, waitStart != 0, waitStart ? lockedAt - waitStart : 0);
+        return ER_OK;
+    }
 #if NO_LOCK_TRACE
     return Lock();
 #else
@@ -106,6 +125,10 @@ QStatus Mutex::Unlock(void)
 
 QStatus Mutex::Unlock(const char* file, uint32_t line)
 {
+    if (0 != lockedAt) {
+        MutexProfiler::RecordHold(this->file, this->line, MutexProfiler::Now() - lockedAt);
+        lockedAt = 0;
+    }
 #if NO_LOCK_TRACE
     return Unlock();
 #else
@@ -0,0 +1,109 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <windows.h>
+
+#include <datadriven/SharedMutex.h>
+#include <datadriven/MutexProfiler.h>
+
+/** @internal */
+#define QCC_MODULE "MUTEX"
+
+using namespace datadriven;
+
+SharedMutex::SharedMutex() :
+    file(NULL), line(0), lockedAt(0)
+{
+    InitializeSRWLock(&rwlock);
+}
+
+SharedMutex::~SharedMutex()
+{
+    // slim reader/writer locks need no cleanup
+}
+
+QStatus SharedMutex::Lock()
+{
+    AcquireSRWLockExclusive(&rwlock);
+    return ER_OK;
+}
+
+QStatus SharedMutex::Lock(const char* file, uint32_t line)
+{
+    if (!MutexProfiler::IsEnabled()) {
+        return Lock();
+    }
+
+    uint64_t waitStart = 0;
+    if (!TryAcquireSRWLockExclusive(&rwlock)) {
+        waitStart = MutexProfiler::Now();
+        AcquireSRWLockExclusive(&rwlock);
+    }
+    this->file = file;
+    this->line = line;
+    lockedAt = MutexProfiler::Now();
+    MutexProfiler::RecordLock(file, line, waitStart != 0, waitStart ? lockedAt - waitStart : 0);
+    return ER_OK;
+}
+
+QStatus SharedMutex::Unlock()
+{
+    ReleaseSRWLockExclusive(&rwlock);
+    return ER_OK;
+}
+
+QStatus SharedMutex::Unlock(const char* file, uint32_t line)
+{
+    if (0 != lockedAt) {
+        MutexProfiler::RecordHold(this->file, this->line, MutexProfiler::Now() - lockedAt);
+        lockedAt = 0;
+    }
+    return Unlock();
+}
+
+QStatus SharedMutex::LockShared()
+{
+    AcquireSRWLockShared(&rwlock);
+    return ER_OK;
+}
+
+QStatus SharedMutex::LockShared(const char* file, uint32_t line)
+{
+    if (!MutexProfiler::IsEnabled()) {
+        return LockShared();
+    }
+
+    uint64_t waitStart = 0;
+    if (!TryAcquireSRWLockShared(&rwlock)) {
+        waitStart = MutexProfiler::Now();
+        AcquireSRWLockShared(&rwlock);
+    }
+    MutexProfiler::RecordLock(file, line, waitStart != 0, waitStart ? MutexProfiler::Now() - waitStart : 0);
+    return ER_OK;
+}
+
+QStatus SharedMutex::UnlockShared()
+{
+    ReleaseSRWLockShared(&rwlock);
+    return ER_OK;
+}
+
+QStatus SharedMutex::UnlockShared(const char* file, uint32_t line)
+{
+    return UnlockShared();
+}
@@ -24,6 +24,7 @@
 
 #include <datadriven/Signature.h>
 #include <datadriven/ObjectPath.h>
+#include <datadriven/FlatMap.h>
 
 // provider
 #include "AllTypes.h"
@@ -129,6 +130,10 @@ template <typename T> void dump(const string& prefix,
 template <typename K, typename V> void dump(const string& prefix,
                                             const std::map<const K, V>& m);
 
+// datadriven::FlatMap<const K, V>
+template <typename K, typename V> void dump(const string& prefix,
+                                            const datadriven::FlatMap<K, V>& m);
+
 // implementations
 
 template <typename T> void dump(const string& prefix, const T& t)
@@ -192,6 +197,13 @@ template <typename K, typename V> void dump(const string& prefix, const std::map
         dump(prefix, it->first, it->second);
     }
 }
+
+template <typename K, typename V> void dump(const string& prefix, const datadriven::FlatMap<K, V>& m)
+{
+    for (typename datadriven::FlatMap<K, V>::const_iterator it = m.begin(); it != m.end(); ++it) {
+        dump(prefix, it->first, it->second);
+    }
+}
 };
 
 #endif /* DUMP_H_ */
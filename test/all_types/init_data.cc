@@ -132,4 +132,18 @@ template <> void init_data<bool>(std::map<const bool, bool>& m,
         b = !b;
     }
 }
+
+void init_data(datadriven::FlatMap<const bool, bool>& m,
+               size_t nelem,
+               long long& cnt)
+{
+    bool b = true;
+
+    // maximum two values in map with boolean keys
+    nelem = nelem > 2 ? 2 : nelem;
+    for (size_t i = 0; i < nelem; i++) {
+        m[b] = b;
+        b = !b;
+    }
+}
 };
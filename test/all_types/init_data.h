@@ -22,6 +22,7 @@
 
 #include <datadriven/Signature.h>
 #include <datadriven/ObjectPath.h>
+#include <datadriven/FlatMap.h>
 
 // provider
 #include "AllTypes.h"
@@ -51,6 +52,15 @@ template <> void init_data<bool>(std::map<const bool, bool>& m,
                                  size_t nelem,
                                  long long& cnt);
 
+// dictionaries generated with DICT_TYPE=flat
+template <typename K, typename V> void init_data(datadriven::FlatMap<K, V>& m,
+                                                 size_t nelem,
+                                                 long long& cnt);
+
+void init_data(datadriven::FlatMap<const bool, bool>& m,
+               size_t nelem,
+               long long& cnt);
+
 template <typename T> void init_data(T& t, size_t nelem, long long& cnt)
 {
     t = ++cnt;
@@ -117,6 +127,21 @@ template <typename K, typename V> void init_data(std::map<const K, V>& m, size_t
     }
 }
 
+template <typename K, typename V> void init_data(datadriven::FlatMap<K, V>& m, size_t nelem, long long& cnt)
+{
+    /* Clear, just in case something is still left in the map */
+    m.clear();
+    for (size_t i = 0; i < nelem; i++) {
+        long long old_cnt = cnt;
+        typename datadriven::FlatMap<K, V>::key_type k;
+        V v;
+
+        init_data(k, nelem, cnt);
+        init_data(v, nelem, old_cnt);
+        m[k] = v;
+    }
+}
+
 void init_data(AllTypes& at,
                size_t nelem);
 };
@@ -123,6 +123,22 @@ template <> void validate<bool, bool>(const std::map<const bool, bool>& m,
     }
 }
 
+void validate(const datadriven::FlatMap<const bool, bool>& m,
+              size_t nelem,
+              long long& cnt)
+{
+    bool b = false; // map is sorted so false comes first
+
+    // maximum two values in map with boolean keys
+    nelem = nelem > 2 ? 2 : nelem;
+    assert(nelem == m.size());
+    for (datadriven::FlatMap<const bool, bool>::const_iterator it = m.begin(); it != m.end(); ++it) {
+        assert(b == it->first);
+        assert(b == it->second);
+        b = !b;
+    }
+}
+
 void validate(const AllTypesProxy::Properties& atpp,
               size_t nelem)
 {
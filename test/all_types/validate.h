@@ -22,6 +22,7 @@
 
 #include <datadriven/Signature.h>
 #include <datadriven/ObjectPath.h>
+#include <datadriven/FlatMap.h>
 
 // provider
 #include "AllTypes.h"
@@ -51,6 +52,15 @@ template <> void validate<bool, bool>(const std::map<const bool, bool>& m,
                                       size_t nelem,
                                       long long& cnt);
 
+// dictionaries generated with DICT_TYPE=flat
+template <typename K, typename V> void validate(const datadriven::FlatMap<K, V>& m,
+                                                size_t nelem,
+                                                long long& cnt);
+
+void validate(const datadriven::FlatMap<const bool, bool>& m,
+              size_t nelem,
+              long long& cnt);
+
 template <typename T> void validate(const T& t, size_t nelem, long long& cnt)
 {
     assert(++cnt == (long long)t);
@@ -113,6 +123,17 @@ template <typename K, typename V> void validate(const std::map<const K, V>& m, s
     }
 }
 
+template <typename K, typename V> void validate(const datadriven::FlatMap<K, V>& m, size_t nelem, long long& cnt)
+{
+    assert(nelem == m.size());
+    for (typename datadriven::FlatMap<K, V>::const_iterator it = m.begin(); it != m.end(); ++it) {
+        long long old_cnt = cnt;
+
+        validate(it->first, nelem, cnt);
+        validate(it->second, nelem, old_cnt);
+    }
+}
+
 void validate(const AllTypesProxy::Properties& atpp,
               size_t nelem);
 
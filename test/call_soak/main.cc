@@ -0,0 +1,192 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <datadriven/datadriven.h>
+#include <datadriven/Semaphore.h>
+#include <alljoyn/Init.h>
+
+#include "CallSoakInterface.h"
+#include "CallSoakProxy.h"
+
+using namespace std;
+using namespace gen::org_allseenalliance_test;
+
+/**
+ * Soak test for method calls that never get a reply.
+ *
+ * The consumer issues rounds of calls the provider never answers. Half of
+ * them are cancelled right away, the other half are left to time out.
+ * Cancelled calls must be released immediately, timed out ones once AllJoyn
+ * reports the time-out, so the number of pending calls and the memory use
+ * of the consumer stay bounded however long it runs. Prints one line per
+ * round:
+ *
+ *   call_soak <round> <pending after issuing> <pending after time-out> <rss kB>
+ */
+namespace test_system_call_soak {
+#define ROUNDS 30
+#define CALLS_PER_ROUND 2000
+#define CALL_TIMEOUT 200
+
+static long RssKilobytes()
+{
+    long pages = 0;
+    long resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+
+    if (NULL != f) {
+        if (2 != fscanf(f, "%ld %ld", &pages, &resident)) {
+            resident = 0;
+        }
+        fclose(f);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/***[ provider code ]**********************************************************/
+
+class CallSoak :
+    public datadriven::ProvidedObject,
+    public CallSoakInterface {
+  public:
+    CallSoak(shared_ptr<datadriven::ObjectAdvertiser> advertiser) :
+        datadriven::ProvidedObject(advertiser),
+        CallSoakInterface(this)
+    {
+    }
+
+  protected:
+    void Ignore(int32_t i, std::shared_ptr<IgnoreReply> _reply)
+    {
+        // dropping the reply without sending it, the caller times out
+    }
+
+    void Echo(int32_t i, std::shared_ptr<EchoReply> _reply)
+    {
+        _reply->Send(i);
+    }
+};
+
+static void be_provider(void)
+{
+    shared_ptr<datadriven::ObjectAdvertiser> advertiser = datadriven::ObjectAdvertiser::Create();
+    assert(nullptr != advertiser);
+
+    CallSoak obj(advertiser);
+    QStatus status = obj.UpdateAll();
+    assert(ER_OK == status);
+    (void)status;
+
+    while (true) {
+        sleep(1);
+    }
+}
+
+/***[ consumer code ]**********************************************************/
+
+static datadriven::Semaphore _sync;
+
+class CallSoakListener :
+    public datadriven::Observer<CallSoakProxy>::Listener {
+  public:
+    void OnUpdate(const std::shared_ptr<CallSoakProxy>& proxy)
+    {
+        _sync.Post();
+    }
+};
+
+static void Round(const CallSoakProxy& proxy, int round)
+{
+    for (int32_t i = 0; i < CALLS_PER_ROUND; i++) {
+        std::shared_ptr<datadriven::MethodInvocation<CallSoakProxy::IgnoreReply> > inv =
+            proxy.Ignore(i, CALL_TIMEOUT);
+        if (0 == (i % 2)) {
+            inv->Cancel();
+            // a cancelled call completes right away
+            assert(datadriven::MethodInvocationBase::CANCELLED == inv->GetState());
+            assert(ER_FAIL == inv->GetReply().GetStatus());
+        }
+    }
+    size_t issued = datadriven::MethodInvocationBase::GetPendingCount();
+    // cancelled calls are not pending anymore
+    assert(issued <= CALLS_PER_ROUND / 2);
+
+    // wait for the remaining calls to time out
+    size_t pending = issued;
+    for (int wait = 0; (0 != pending) && (wait < 50); wait++) {
+        usleep(CALL_TIMEOUT * 1000);
+        pending = datadriven::MethodInvocationBase::GetPendingCount();
+    }
+    printf("call_soak %d %zu %zu %ld\n", round, issued, pending, RssKilobytes());
+    assert(0 == pending);
+}
+
+static void be_consumer(void)
+{
+    CallSoakListener listener;
+    std::shared_ptr<datadriven::Observer<CallSoakProxy> > observer =
+        datadriven::Observer<CallSoakProxy>::Create(&listener);
+    assert(nullptr != observer);
+
+    // wait for object
+    _sync.Wait();
+    std::shared_ptr<CallSoakProxy> proxy = *observer->begin();
+    assert(nullptr != proxy);
+
+    for (int round = 0; round < ROUNDS; round++) {
+        Round(*proxy, round);
+    }
+
+    // the consumer still works after all that
+    std::shared_ptr<datadriven::MethodInvocation<CallSoakProxy::EchoReply> > inv = proxy->Echo(ROUNDS);
+    const CallSoakProxy::EchoReply& reply = inv->GetReply();
+    assert(ER_OK == reply.GetStatus());
+    assert(ROUNDS == reply.o);
+    (void)reply;
+}
+};
+
+/***[ main code ]**************************************************************/
+
+using namespace test_system_call_soak;
+
+int main(int argc, char** argv)
+{
+    if (AllJoynInit() != ER_OK) {
+        return EXIT_FAILURE;
+    }
+
+    // only play provider if first command-line argument starts with a 'p'
+    if (argc <= 1) {
+        printf("Usage: %s <consumer|provider>\n", argv[0]);
+        return 1;
+    }
+    if ('p' == *argv[1]) {
+        be_provider();
+    } else {
+        be_consumer();
+    }
+
+    AllJoynShutdown();
+
+    return 0;
+}
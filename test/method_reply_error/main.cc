@@ -14,6 +14,7 @@
  *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  ******************************************************************************/
 
+#include <chrono>
 #include <iostream>
 
 #include <datadriven/datadriven.h>
@@ -38,7 +39,8 @@ class Methods :
   public:
     Methods(shared_ptr<datadriven::ObjectAdvertiser> advertiser) :
         datadriven::ProvidedObject(advertiser),
-        MethodReplyErrorInterface(this)
+        MethodReplyErrorInterface(this),
+        flaky(0)
     {
     }
 
@@ -61,6 +63,25 @@ class Methods :
         cout << "Provider sending ErrorCode reply" << endl;
         _reply->SendErrorCode(ER_WARNING);
     }
+
+    void Flaky(std::shared_ptr<FlakyReply> _reply)
+    {
+        /* only answer every other call, as if half of the replies got lost */
+        if (flaky++ % 2) {
+            cout << "Provider sending Flaky reply" << endl;
+            _reply->Send();
+        } else {
+            cout << "Provider dropping Flaky reply" << endl;
+        }
+    }
+
+    void Silent(std::shared_ptr<SilentReply> _reply)
+    {
+        cout << "Provider not replying to Silent" << endl;
+    }
+
+  private:
+    unsigned int flaky;
 };
 
 static void be_provider(void)
@@ -134,6 +155,70 @@ static void test_method_reply_error(const MethodReplyErrorProxy& mp)
     cout << "ErrorCode method call returned an error \"" << QCC_StatusText(replyErrorCode.GetStatus()) << "\"" << endl;
 }
 
+static long long ElapsedMillis(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * \test Method calls under a deadline.
+ *       -# A call made after the deadline passed fails right away
+ *       -# An unanswered call times out at the deadline, not after the default timeout
+ *       -# A hedged call is answered by the second attempt when the first reply is lost
+ *       -# Cancelling a hedged call releases all its attempts
+ */
+static void test_method_deadline(const MethodReplyErrorProxy& mp)
+{
+    /* Deadline already passed */
+    {
+        datadriven::CallDeadline deadline(0);
+        datadriven::CallDeadline::Scope scope(deadline);
+        std::shared_ptr<datadriven::MethodInvocation<MethodReplyErrorProxy::NormalReply> > inv = mp.Normal();
+        assert(ER_TIMEOUT == inv->GetReply().GetStatus());
+    }
+
+    /* No reply before the deadline */
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::shared_ptr<datadriven::MethodInvocation<MethodReplyErrorProxy::SilentReply> > invSilent;
+    {
+        datadriven::CallDeadline deadline(500);
+        datadriven::CallDeadline::Scope scope(deadline);
+        invSilent = mp.Silent();
+    }
+    cout << "Consumer waiting for Silent to time out" << endl;
+    assert(ER_TIMEOUT == invSilent->GetReply().GetStatus());
+    long long elapsed = ElapsedMillis(start);
+    cout << "Silent timed out after " << elapsed << " ms" << endl;
+    assert(elapsed < 5000);
+
+    /* First reply lost, the hedge is answered */
+    start = std::chrono::steady_clock::now();
+    std::shared_ptr<datadriven::MethodInvocation<MethodReplyErrorProxy::FlakyReply> > invFlaky;
+    {
+        datadriven::CallDeadline deadline(10000);
+        deadline.SetHedgeDelay(200);
+        datadriven::CallDeadline::Scope scope(deadline);
+        invFlaky = mp.Flaky();
+    }
+    cout << "Consumer waiting for a Flaky reply" << endl;
+    assert(ER_OK == invFlaky->GetReply().GetStatus());
+    elapsed = ElapsedMillis(start);
+    cout << "Flaky answered after " << elapsed << " ms" << endl;
+    assert(elapsed >= 200 && elapsed < 10000);
+
+    /* Cancel a hedged call */
+    {
+        datadriven::CallDeadline deadline(10000);
+        deadline.SetHedgeDelay(50);
+        datadriven::CallDeadline::Scope scope(deadline);
+        invSilent = mp.Silent();
+    }
+    usleep(200 * 1000);
+    invSilent->Cancel();
+    assert(ER_FAIL == invSilent->GetReply().GetStatus());
+    assert(0 == datadriven::MethodInvocationBase::GetPendingCount());
+}
+
 static void be_consumer(void)
 {
     MethodReplyErrorListener ml = MethodReplyErrorListener();
@@ -151,6 +236,7 @@ static void be_consumer(void)
         assert(ER_OK == it->GetStatus());
         cout << "Consumer in iterator for " << it->GetObjectId() << endl;
         test_method_reply_error(**it);
+        test_method_deadline(**it);
     }
     cout << "Consumer done" << endl;
 }
@@ -14,7 +14,10 @@
  *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  ******************************************************************************/
 
+#include <time.h>
+
 #include <iostream>
+#include <vector>
 
 #include <datadriven/datadriven.h>
 #include <datadriven/Semaphore.h>
@@ -32,6 +35,8 @@ using namespace gen::org_allseenalliance_test;
 namespace test_system_methods {
 #define TIMEOUT 1 * 1000
 #define NUMBER 12345
+#define THROUGHPUT_CALLS 10000
+#define THROUGHPUT_WINDOW 64
 
 /***[ provider code ]**********************************************************/
 
@@ -68,6 +73,11 @@ class Methods :
         _reply->Send();
     }
 
+    void Echo(int32_t i, std::shared_ptr<EchoReply> _reply)
+    {
+        _reply->Send(i);
+    }
+
     // This method does not return a reply
     void ReplyAsync(uint32_t timeout, std::shared_ptr<ReplyAsyncReply> _reply)
     {
@@ -284,6 +294,95 @@ static void test_method_reply_response_after_cancel(const MethodsProxy& mp)
     sleep(2 * TIMEOUT / 1000); // wait for response to arrive, no callback expected
 }
 
+static double NowSeconds()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * \test Method call throughput.
+ *       -# call Echo and wait for each reply before the next call
+ *       -# call Echo with a window of outstanding calls
+ *       -# every reply must carry the argument of its call
+ *       -# print the number of calls per second for both
+ */
+static void test_method_throughput(const MethodsProxy& mp)
+{
+    double start = NowSeconds();
+    for (int32_t i = 0; i < THROUGHPUT_CALLS; i++) {
+        std::shared_ptr<datadriven::MethodInvocation<MethodsProxy::EchoReply> > inv = mp.Echo(i);
+        const MethodsProxy::EchoReply& reply = inv->GetReply();
+        assert(ER_OK == reply.GetStatus());
+        assert(i == reply.o);
+    }
+    double elapsed = NowSeconds() - start;
+    cout << "Consumer sequential calls/sec: " << THROUGHPUT_CALLS / elapsed << endl;
+
+    std::vector<std::shared_ptr<datadriven::MethodInvocation<MethodsProxy::EchoReply> > > window(THROUGHPUT_WINDOW);
+    start = NowSeconds();
+    for (int32_t i = 0; i < THROUGHPUT_CALLS + THROUGHPUT_WINDOW; i++) {
+        std::shared_ptr<datadriven::MethodInvocation<MethodsProxy::EchoReply> >& slot =
+            window[i % THROUGHPUT_WINDOW];
+        if (slot) {
+            const MethodsProxy::EchoReply& reply = slot->GetReply();
+            assert(ER_OK == reply.GetStatus());
+            assert(i - THROUGHPUT_WINDOW == reply.o);
+        }
+        slot = (i < THROUGHPUT_CALLS) ? mp.Echo(i) : nullptr;
+    }
+    elapsed = NowSeconds() - start;
+    cout << "Consumer pipelined calls/sec: " << THROUGHPUT_CALLS / elapsed << endl;
+}
+
+class MyBatchListener :
+    public datadriven::MethodBatchListener {
+    void OnBatchComplete()
+    {
+        cout << "Consumer batch complete" << endl;
+        _sync.Post();
+    }
+};
+
+/**
+ * \test Method call batch.
+ *       -# queue Echo calls on a batch with a bounded window
+ *       -# no call completes before the batch is sent
+ *       -# send the batch and wait for the batch listener
+ *       -# every reply must carry the argument of its call
+ */
+static void test_method_batch(const MethodsProxy& mp)
+{
+    MyBatchListener listener;
+    datadriven::MethodBatch batch(THROUGHPUT_WINDOW);
+    std::vector<std::shared_ptr<datadriven::MethodInvocation<MethodsProxy::EchoReply> > > invs;
+    {
+        datadriven::MethodBatch::Scope scope(batch);
+        for (int32_t i = 0; i < THROUGHPUT_CALLS; i++) {
+            invs.push_back(mp.Echo(i));
+        }
+    }
+    assert(THROUGHPUT_CALLS == batch.GetSize());
+    assert(datadriven::MethodInvocationBase::WAITING == invs.back()->GetState());
+
+    double start = NowSeconds();
+    assert(ER_OK == batch.Send(&listener));
+    assert(ER_FAIL == batch.Send());
+    _sync.Wait();
+    double elapsed = NowSeconds() - start;
+    batch.Wait();
+    cout << "Consumer batched calls/sec: " << THROUGHPUT_CALLS / elapsed << endl;
+
+    for (int32_t i = 0; i < THROUGHPUT_CALLS; i++) {
+        assert(datadriven::MethodInvocationBase::READY == invs[i]->GetState());
+        const MethodsProxy::EchoReply& reply = invs[i]->GetReply();
+        assert(ER_OK == reply.GetStatus());
+        assert(i == reply.o);
+    }
+}
+
 static void be_consumer(void)
 {
     MethodsListener ml = MethodsListener();
@@ -308,6 +407,8 @@ static void be_consumer(void)
         test_method_reply_async(**it);
         test_method_reply_callback_cancel(**it);
         test_method_reply_response_after_cancel(**it);
+        test_method_throughput(**it);
+        test_method_batch(**it);
     }
     cout << "Consumer done" << endl;
 }
@@ -16,6 +16,7 @@
 
 #include <ostream>
 #include <datadriven/Mutex.h>
+#include <datadriven/Semaphore.h>
 
 #include "consumer.h"
 
@@ -141,10 +141,11 @@ class DDAPIPropertiesConsumer :
         // verify state
         PropertiesProxy::Properties props = pp->GetProperties();
         assert(signal_offset + INITIAL_ET == props.PropEmitTrue);
+        // only the last update invalidates PropEmitInvalidates
+        assert((2 == updated) == pp->IsStale(PROP_EI));
         // continue test
         proxy = pp;
         assert(ER_OK == sync.Post());
-        // TODO check invalidated properties
         updated++;
     }
 };
@@ -32,8 +32,46 @@ def __codegen_detect(env):
         e['PYTHONPATH'] = ajcg_root + '/dist/lib/python'
     return ajcg, e
 
+# the dictionary types the generator emits: std::map<const K, V>
+__DICT_TYPE_RE = re.compile(r'\bstd::map<(?=const\b)')
+__FIRST_INCLUDE_RE = re.compile(r'^(#include[^\n]*)$', re.M)
+
+def __codegen_flat_dicts(target):
+    """Change the dictionary types of the generated code from std::map to
+    datadriven::FlatMap.
+
+    The code generator has no notion of alternative containers and cannot be
+    made to emit a typedef for them, so this is done on its output. Only the
+    dictionary types are changed, which the generator always spells
+    std::map<const K, V>; any other std::map is left alone. The FlatMap
+    header is included right after the first include of every changed file.
+
+    FlatMap offers the subset of the std::map interface the generated code
+    uses, but applications using the generated types should know that
+    inserting or erasing invalidates all iterators and references, and that
+    keys must not be modified through an iterator. See FlatMap.h."""
+    for node in target:
+        path = node.abspath
+        if not os.path.isfile(path):
+            continue
+        with open(path) as f:
+            content = f.read()
+        content, count = __DICT_TYPE_RE.subn('datadriven::FlatMap<', content)
+        if 0 == count:
+            continue
+        content, count = __FIRST_INCLUDE_RE.subn(r'\1\n#include <datadriven/FlatMap.h>', content, 1)
+        if 0 == count:
+            raise Exception('No include found in %s, aborting!' % path)
+        with open(path, 'w') as f:
+            f.write(content)
+
 def __codegen(target, source, env):
-    """Generate Data-driven API C++ code for the given sources."""
+    """Generate Data-driven API C++ code for the given sources.
+
+    The DICT_TYPE construction variable selects the container used for
+    dictionary types: 'map' (std::map, default) or 'flat'
+    (datadriven::FlatMap). This changes the public types of the generated
+    code, applications must be built with the same setting."""
     target_cc = []
     target_h = []
     lang = 'ddcpp'
@@ -49,6 +87,11 @@ def __codegen(target, source, env):
         p.wait()
         if 0 != p.returncode:
             raise Exception('Code generation failed, aborting!')
+    dict_type = env.get('DICT_TYPE', 'map')
+    if 'flat' == dict_type:
+        __codegen_flat_dicts(target)
+    elif 'map' != dict_type:
+        raise Exception('Unsupported DICT_TYPE %s, aborting!' % dict_type)
     return None
 
 def __codegen_emitter(target, source, env):
@@ -0,0 +1,308 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <datadriven/Semaphore.h>
+
+#include "common/AsyncTaskQueue.h"
+
+using namespace datadriven;
+
+/**
+ * Tests for the bounded asynchronous task queue.
+ */
+namespace test_unit_asynctaskqueue {
+class KeyedTask :
+    public TaskData {
+  public:
+    KeyedTask(int key) :
+        key(key), merged(0) { }
+
+    int key;
+    int merged;
+};
+
+class CountingTask :
+    public AsyncTask {
+  public:
+    CountingTask() :
+        executed(0), merged(0), gate(nullptr) { }
+
+    void OnEmptyQueue() { }
+
+    void OnTask(TaskData const* taskdata)
+    {
+        if (nullptr != gate) {
+            gate->Wait();
+        }
+        const KeyedTask* task = static_cast<const KeyedTask*>(taskdata);
+        merged += task->merged;
+        order.push_back(task->key);
+        executed++;
+    }
+
+    bool OnCoalesceKey(TaskData const* taskdata,
+                       uint64_t& key)
+    {
+        key = static_cast<const KeyedTask*>(taskdata)->key;
+        return true;
+    }
+
+    bool OnCoalesce(TaskData const* queued,
+                    TaskData const* incoming)
+    {
+        KeyedTask* task = const_cast<KeyedTask*>(static_cast<const KeyedTask*>(queued));
+        if (task->key != static_cast<const KeyedTask*>(incoming)->key) {
+            return false;
+        }
+        task->merged++;
+        return true;
+    }
+
+    std::atomic<int> executed;
+    std::atomic<int> merged;
+    Semaphore* gate;
+    /** keys of the executed tasks, only read once the queue is stopped */
+    std::vector<int> order;
+};
+
+static void WaitExecuted(CountingTask& counting,
+                         int num)
+{
+    for (int i = 0; (i < 500) && (counting.executed < num); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+/* *
+ * \test A full queue with the drop policy discards new tasks.
+ * */
+TEST(AsyncTaskQueue, Drop) {
+    CountingTask counting;
+    AsyncTaskQueue queue(&counting);
+
+    // not started yet, so nothing is taken off the queue
+    queue.SetCapacity(2, AsyncTaskQueue::OVERFLOW_DROP);
+    for (int i = 0; i < 5; i++) {
+        // the caller learns which tasks were dropped
+        EXPECT_EQ(i < 2, queue.Enqueue(new KeyedTask(i)));
+    }
+
+    AsyncTaskQueue::Stats stats = queue.GetStats();
+    EXPECT_EQ((size_t)2, stats.depth);
+    EXPECT_EQ((size_t)2, stats.highWatermark);
+    EXPECT_EQ((uint64_t)2, stats.enqueued);
+    EXPECT_EQ((uint64_t)3, stats.dropped);
+    EXPECT_EQ((uint64_t)0, stats.coalesced);
+
+    queue.Start();
+    WaitExecuted(counting, 2);
+    queue.Stop();
+    EXPECT_EQ(2, counting.executed);
+    EXPECT_EQ((size_t)0, queue.GetStats().depth);
+}
+
+/* *
+ * \test A full queue with the coalesce policy merges new tasks into queued
+ *       ones that accept them.
+ * */
+TEST(AsyncTaskQueue, Coalesce) {
+    CountingTask counting;
+    AsyncTaskQueue queue(&counting);
+
+    queue.SetCapacity(2, AsyncTaskQueue::OVERFLOW_COALESCE);
+    queue.Enqueue(new KeyedTask(1));
+    queue.Enqueue(new KeyedTask(2));
+    queue.Enqueue(new KeyedTask(1));
+    queue.Enqueue(new KeyedTask(2));
+    queue.Enqueue(new KeyedTask(2));
+
+    AsyncTaskQueue::Stats stats = queue.GetStats();
+    EXPECT_EQ((size_t)2, stats.depth);
+    EXPECT_EQ((uint64_t)2, stats.enqueued);
+    EXPECT_EQ((uint64_t)3, stats.coalesced);
+
+    queue.Start();
+    WaitExecuted(counting, 2);
+    queue.Stop();
+    EXPECT_EQ(2, counting.executed);
+    EXPECT_EQ(3, counting.merged);
+}
+
+/* *
+ * \test A full queue with the coalesce policy never makes producers wait:
+ *       tasks that cannot be merged are queued beyond the capacity, and only
+ *       the most recent queued task with the same key is merged into.
+ * */
+TEST(AsyncTaskQueue, CoalesceNeverBlocks) {
+    CountingTask counting;
+    AsyncTaskQueue queue(&counting);
+
+    // not started, so a producer that waited for room would hang here
+    queue.SetCapacity(1, AsyncTaskQueue::OVERFLOW_COALESCE);
+    queue.SetLanes(2, 10000);
+    queue.Enqueue(new KeyedTask(1));
+    queue.Enqueue(new KeyedTask(2));
+    queue.Enqueue(new KeyedTask(3));
+    queue.Enqueue(new KeyedTask(2));
+    // a different lane is never merged into
+    queue.Enqueue(new KeyedTask(3), 1);
+
+    AsyncTaskQueue::Stats stats = queue.GetStats();
+    EXPECT_EQ((size_t)4, stats.depth);
+    EXPECT_EQ((uint64_t)0, stats.blocked);
+    EXPECT_EQ((uint64_t)1, stats.coalesced);
+
+    queue.Start();
+    WaitExecuted(counting, 4);
+    queue.Stop();
+    EXPECT_EQ(4, counting.executed);
+    EXPECT_EQ(1, counting.merged);
+}
+
+/* *
+ * \test A full queue with the block policy makes producers wait until the
+ *       consumer made room, and loses nothing.
+ * */
+TEST(AsyncTaskQueue, Block) {
+    Semaphore gate;
+    CountingTask counting;
+    counting.gate = &gate;
+    AsyncTaskQueue queue(&counting);
+
+    queue.SetCapacity(1, AsyncTaskQueue::OVERFLOW_BLOCK);
+    queue.Start();
+    // the consumer takes at most one task and waits at the gate, one more fits
+    queue.Enqueue(new KeyedTask(0));
+    queue.Enqueue(new KeyedTask(1));
+
+    std::thread producer([&queue] () {
+                             queue.Enqueue(new KeyedTask(2));
+                         });
+    for (int i = 0; (i < 500) && (0 == queue.GetStats().blocked); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_LE((uint64_t)1, queue.GetStats().blocked);
+
+    for (int i = 0; i < 3; i++) {
+        gate.Post();
+    }
+    producer.join();
+    WaitExecuted(counting, 3);
+    queue.Stop();
+
+    AsyncTaskQueue::Stats stats = queue.GetStats();
+    EXPECT_EQ(3, counting.executed);
+    EXPECT_EQ((uint64_t)3, stats.enqueued);
+    EXPECT_EQ((uint64_t)0, stats.dropped);
+    EXPECT_EQ((size_t)1, stats.highWatermark);
+}
+
+/* *
+ * \test Tasks are taken from the highest priority lane first, and in order
+ *       within a lane.
+ * */
+TEST(AsyncTaskQueue, Lanes) {
+    CountingTask counting;
+    AsyncTaskQueue queue(&counting);
+
+    queue.SetLanes(3, 10000);
+    queue.Enqueue(new KeyedTask(20), 2);
+    queue.Enqueue(new KeyedTask(10), 1);
+    queue.Enqueue(new KeyedTask(21), 2);
+    queue.Enqueue(new KeyedTask(0), 0);
+    queue.Enqueue(new KeyedTask(11), 1);
+    // beyond the last lane means the last lane
+    queue.Enqueue(new KeyedTask(22), 7);
+
+    queue.Start();
+    WaitExecuted(counting, 6);
+    queue.Stop();
+
+    int expected[] = { 0, 10, 11, 20, 21, 22 };
+    ASSERT_EQ((size_t)6, counting.order.size());
+    for (int i = 0; i < 6; i++) {
+        EXPECT_EQ(expected[i], counting.order[i]);
+    }
+}
+
+/* *
+ * \test A task that waited longer than the aging limit overtakes tasks of
+ *       higher priority lanes, once every few of those.
+ * */
+TEST(AsyncTaskQueue, Aging) {
+    CountingTask counting;
+    AsyncTaskQueue queue(&counting);
+
+    queue.SetLanes(2, 50);
+    queue.Enqueue(new KeyedTask(10), 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    for (int i = 0; i < 5; i++) {
+        queue.Enqueue(new KeyedTask(i), 0);
+    }
+    queue.Enqueue(new KeyedTask(11), 1);
+
+    queue.Start();
+    WaitExecuted(counting, 7);
+    queue.Stop();
+
+    int expected[] = { 0, 1, 2, 10, 3, 4, 11 };
+    ASSERT_EQ((size_t)7, counting.order.size());
+    for (int i = 0; i < 7; i++) {
+        EXPECT_EQ(expected[i], counting.order[i]);
+    }
+}
+
+/* *
+ * \test A task enqueued on a high priority lane while a backlog of lower
+ *       priority tasks has aged does not wait behind that whole backlog.
+ * */
+TEST(AsyncTaskQueue, ReplyIntoAgedBacklog) {
+    Semaphore gate;
+    CountingTask counting;
+    counting.gate = &gate;
+    AsyncTaskQueue queue(&counting);
+
+    queue.SetLanes(2, 50);
+    queue.Start();
+    for (int i = 10; i < 30; i++) {
+        queue.Enqueue(new KeyedTask(i), 1);
+    }
+    // the consumer holds on to the first task until the backlog aged
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    queue.Enqueue(new KeyedTask(0), 0);
+
+    for (int i = 0; i < 21; i++) {
+        gate.Post();
+    }
+    WaitExecuted(counting, 21);
+    queue.Stop();
+
+    ASSERT_EQ((size_t)21, counting.order.size());
+    size_t position = 0;
+    while ((position < counting.order.size()) && (0 != counting.order[position])) {
+        position++;
+    }
+    // taken right after the task the consumer was executing, at worst after one aged task more
+    EXPECT_GE((size_t)2, position);
+}
+}
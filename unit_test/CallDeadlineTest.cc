@@ -0,0 +1,87 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <qcc/Thread.h>
+#include <datadriven/CallDeadline.h>
+
+using namespace datadriven;
+
+/**
+ * Tests for the deadline applied to method calls.
+ */
+namespace test_unit_calldeadline {
+/**
+ * \test The remaining time decreases and ends at zero.
+ */
+TEST(CallDeadlineTests, Remaining)
+{
+    CallDeadline deadline(200);
+    ASSERT_FALSE(deadline.IsExpired());
+    ASSERT_LE(deadline.GetRemaining(), 200u);
+    ASSERT_GT(deadline.GetRemaining(), 0u);
+    qcc::Sleep(300);
+    ASSERT_TRUE(deadline.IsExpired());
+    ASSERT_EQ(0u, deadline.GetRemaining());
+
+    CallDeadline passed(0);
+    ASSERT_TRUE(passed.IsExpired());
+}
+
+/**
+ * \test Default policy and the retry budget lower bound.
+ */
+TEST(CallDeadlineTests, Policy)
+{
+    CallDeadline deadline(1000);
+    ASSERT_EQ(0u, deadline.GetHedgeDelay());
+    ASSERT_TRUE(deadline.GetFailover());
+    ASSERT_EQ(3u, deadline.GetMaxAttempts());
+
+    deadline.SetHedgeDelay(50).SetFailover(false).SetMaxAttempts(0);
+    ASSERT_EQ(50u, deadline.GetHedgeDelay());
+    ASSERT_FALSE(deadline.GetFailover());
+    ASSERT_EQ(1u, deadline.GetMaxAttempts());
+}
+
+/**
+ * \test Scopes nest, and a nested scope never extends the deadline.
+ */
+TEST(CallDeadlineTests, Scope)
+{
+    ASSERT_TRUE(NULL == CallDeadline::GetCurrent());
+    CallDeadline outer(1000);
+    {
+        CallDeadline::Scope outerScope(outer);
+        ASSERT_EQ(outer.GetDeadline(), CallDeadline::GetCurrent()->GetDeadline());
+        {
+            CallDeadline longer(60000);
+            longer.SetHedgeDelay(10);
+            CallDeadline::Scope innerScope(longer);
+            ASSERT_EQ(outer.GetDeadline(), CallDeadline::GetCurrent()->GetDeadline());
+            ASSERT_EQ(10u, CallDeadline::GetCurrent()->GetHedgeDelay());
+        }
+        {
+            CallDeadline shorter(100);
+            CallDeadline::Scope innerScope(shorter);
+            ASSERT_EQ(shorter.GetDeadline(), CallDeadline::GetCurrent()->GetDeadline());
+        }
+        ASSERT_EQ(outer.GetDeadline(), CallDeadline::GetCurrent()->GetDeadline());
+    }
+    ASSERT_TRUE(NULL == CallDeadline::GetCurrent());
+}
+}
@@ -220,6 +220,11 @@ class TestObjectSignalListener :
         semaphore.Wait();
     }
 
+    QStatus TimedWait(uint32_t ms)
+    {
+        return semaphore.TimedWait(ms);
+    }
+
   private:
     Semaphore semaphore;
 };
@@ -0,0 +1,116 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+
+#include <gtest/gtest.h>
+
+#include <qcc/Thread.h>
+#include <datadriven/Completion.h>
+
+using namespace datadriven;
+
+/**
+ * Tests for the one-shot completion used by method invocations.
+ */
+namespace test_unit_completion {
+class MyThread :
+    public qcc::Thread {
+  public:
+    MyThread() :
+        completion(NULL), wait(false) { }
+
+    virtual ~MyThread() { }
+
+    Completion* completion;
+    bool wait;
+
+    virtual qcc::ThreadReturn STDCALL Run(void* arg)
+    {
+        if (wait) {
+            completion->Wait();
+        } else {
+            completion->Signal();
+        }
+        return arg;
+    }
+};
+
+class CompletionTests :
+    public testing::Test {
+  public:
+    CompletionTests() { }
+
+    virtual ~CompletionTests() { }
+
+    MyThread waiters[4];
+    MyThread signaler;
+};
+
+/**
+ * \test Signal before wait, waiting does not block.
+ */
+TEST_F(CompletionTests, SignalBeforeWait)
+{
+    Completion completion;
+    ASSERT_FALSE(completion.IsSignaled());
+    completion.Signal();
+    ASSERT_TRUE(completion.IsSignaled());
+    completion.Wait();
+    completion.Wait();
+    // signaling again has no effect
+    completion.Signal();
+    ASSERT_TRUE(completion.IsSignaled());
+}
+
+/**
+ * \test Wait before signal, all waiters are released.
+ */
+TEST_F(CompletionTests, WaitBeforeSignal)
+{
+    Completion completion;
+
+    for (size_t i = 0; i < sizeof(waiters) / sizeof(waiters[0]); i++) {
+        waiters[i].completion = &completion;
+        waiters[i].wait = true;
+        waiters[i].Start();
+    }
+    qcc::Sleep(1000); // ensure the waiters are started and waiting
+    ASSERT_FALSE(completion.IsSignaled());
+
+    signaler.completion = &completion;
+    signaler.Start();
+    signaler.Join();
+    for (size_t i = 0; i < sizeof(waiters) / sizeof(waiters[0]); i++) {
+        waiters[i].Join();
+    }
+    ASSERT_TRUE(completion.IsSignaled());
+}
+
+/**
+ * \test Racing signal and wait many times.
+ */
+TEST_F(CompletionTests, Race)
+{
+    for (int i = 0; i < 1000; i++) {
+        Completion completion;
+        signaler.completion = &completion;
+        signaler.Start();
+        completion.Wait();
+        ASSERT_TRUE(completion.IsSignaled());
+        signaler.Join();
+    }
+}
+}
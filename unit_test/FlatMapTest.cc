@@ -0,0 +1,111 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <datadriven/FlatMap.h>
+
+using namespace datadriven;
+
+/**
+ * Tests for the container behind the dictionary types generated with
+ * DICT_TYPE=flat. Code is written against the std::map based dictionaries,
+ * so FlatMap must behave the same for the interface it offers.
+ */
+namespace test_unit_flatmap {
+/* Uses a dictionary the way generated and application code does, and
+ * returns its content in iteration order. */
+template <typename Dict> std::vector<std::pair<int, int> > Exercise()
+{
+    Dict dict;
+    std::vector<std::pair<int, int> > content;
+
+    for (int i = 0; i < 16; i++) {
+        // out of order, with repeated keys
+        dict[(i * 7) % 11] = i;
+    }
+    dict.insert(typename Dict::value_type(3, 100));
+    dict.insert(typename Dict::value_type(42, 42));
+    dict.erase(5);
+    dict.erase(dict.find(0));
+    if (dict.end() == dict.find(99)) {
+        dict[99] = static_cast<int>(dict.count(42) + dict.count(5));
+    }
+    for (typename Dict::const_iterator it = dict.begin(); it != dict.end(); ++it) {
+        content.push_back(std::make_pair(it->first, it->second));
+    }
+    return content;
+}
+
+/* *
+ * \test The same code gives the same dictionary with FlatMap as with the
+ *       std::map it replaces in generated code.
+ * */
+TEST(FlatMap, SameAsMap) {
+    std::vector<std::pair<int, int> > expected = Exercise<std::map<const int, int> >();
+    std::vector<std::pair<int, int> > actual = Exercise<FlatMap<const int, int> >();
+
+    EXPECT_EQ(expected, actual);
+}
+
+/* *
+ * \test Assign takes over unsorted elements, keeping the last occurrence of
+ *       a key like repeated std::map::operator[] assignments do.
+ * */
+TEST(FlatMap, Assign) {
+    FlatMap<const int, int> dict;
+    FlatMap<const int, int>::container_type elements;
+
+    elements.push_back(std::make_pair(3, 1));
+    elements.push_back(std::make_pair(1, 2));
+    elements.push_back(std::make_pair(3, 3));
+    elements.push_back(std::make_pair(2, 4));
+    dict.Assign(elements);
+
+    EXPECT_TRUE(elements.empty());
+    ASSERT_EQ((size_t)3, dict.size());
+    EXPECT_EQ(2, dict[1]);
+    EXPECT_EQ(4, dict[2]);
+    EXPECT_EQ(3, dict[3]);
+
+    // already sorted input is kept as is
+    elements.push_back(std::make_pair(5, 5));
+    elements.push_back(std::make_pair(6, 6));
+    dict.Assign(elements);
+    ASSERT_EQ((size_t)2, dict.size());
+    EXPECT_EQ(5, dict.begin()->first);
+}
+
+/* *
+ * \test Equality compares keys and values, as for std::map.
+ * */
+TEST(FlatMap, Equality) {
+    FlatMap<const int, int> a;
+    FlatMap<const int, int> b;
+
+    a[1] = 1;
+    a[2] = 2;
+    b[2] = 2;
+    b[1] = 1;
+    EXPECT_TRUE(a == b);
+    b[2] = 3;
+    EXPECT_TRUE(a != b);
+}
+}
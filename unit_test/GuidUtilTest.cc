@@ -0,0 +1,94 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/GuidUtil.h"
+
+using namespace datadriven;
+
+/**
+ * Tests for the in-process GUID generator.
+ */
+namespace test_unit_guidutil {
+#define NUM_GUIDS 100000
+#define NUM_THREADS 4
+
+static bool IsValid(const char* guid)
+{
+    if (GUID_STRING_MAX_LENGTH != strlen(guid)) {
+        return false;
+    }
+    for (unsigned int i = 0; i < GUID_STRING_MAX_LENGTH; i++) {
+        if (!strchr("0123456789abcdef", guid[i])) {
+            return false;
+        }
+    }
+    /* version 4, RFC 4122 variant */
+    return ('4' == guid[12]) && (nullptr != strchr("89ab", guid[16]));
+}
+
+TEST(GuidUtil, Format)
+{
+    char guid[GUID_STRING_MAX_LENGTH + END_OF_STRING_LENGTH];
+    std::set<std::string> guids;
+
+    for (int i = 0; i < NUM_GUIDS; i++) {
+        GuidUtil::GetInstance()->GenerateGUID(guid);
+        ASSERT_TRUE(IsValid(guid)) << guid;
+        guids.insert(guid);
+    }
+    EXPECT_EQ((size_t)NUM_GUIDS, guids.size());
+
+    qcc::String str;
+    GuidUtil::GetInstance()->GenerateGUID(&str);
+    EXPECT_TRUE(IsValid(str.c_str()));
+    EXPECT_EQ(0u, guids.count(str.c_str()));
+}
+
+TEST(GuidUtil, Concurrent)
+{
+    std::vector<std::vector<std::string> > generated(NUM_THREADS);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < NUM_THREADS; t++) {
+        std::vector<std::string>* out = &generated[t];
+        threads.push_back(std::thread([out]() {
+                                          char guid[GUID_STRING_MAX_LENGTH + END_OF_STRING_LENGTH];
+                                          for (int i = 0; i < NUM_GUIDS / NUM_THREADS; i++) {
+                                              GuidUtil::GetInstance()->GenerateGUID(guid);
+                                              out->push_back(guid);
+                                          }
+                                      }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    std::set<std::string> guids;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        guids.insert(generated[t].begin(), generated[t].end());
+    }
+    EXPECT_EQ((size_t)NUM_GUIDS, guids.size());
+}
+}
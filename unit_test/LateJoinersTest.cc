@@ -245,5 +245,54 @@ TEST(LateJoiners, JoinPublishJoinDestroyJoinRemove) {
     testObjectListener2.WaitOnRemove(numPubObjs, 10);
     EXPECT_TRUE((int)testObjectListener2.removedObjectNames.size() == 0);
 }
+
+/* *
+ * \test This test verifies that late joiners receive the current property values,
+ *       also after the provider has already answered GetAll requests for the
+ *       previous values (the provider caches the GetAll reply).
+ *       Steps:
+ *       -# Publish many test objects and let an observer see them
+ *       -# Rename all published objects and update them
+ *       -# Create a late joiner observer
+ *       -# Verify that the late joiner only sees the new names
+ * */
+TEST(LateJoiners, PublishJoinUpdateJoin) {
+    int numPubObjs = 10;
+    shared_ptr<datadriven::ObjectAdvertiser> advertiser = ObjectAdvertiser::Create();
+    ASSERT_TRUE(advertiser != nullptr);
+    std::vector<unique_ptr<TestObject> > testObjects;
+
+    Publish(advertiser, testObjects, numPubObjs);
+
+    TestObjectListener testObjectListener;
+    std::shared_ptr<Observer<SimpleTestObjectProxy> > obs =
+        Observer<SimpleTestObjectProxy>::Create(&testObjectListener);
+    ASSERT_TRUE(obs->GetStatus() == ER_OK);
+    WaitOnUpdates(testObjectListener, numPubObjs);
+
+    //Rename all objects
+    for (int i = 0; i < numPubObjs; i++) {
+        char buffer[50];
+        snprintf(buffer, sizeof(buffer), "TestObjectRenamed%d", i);
+        testObjects[i]->SetName(qcc::String(buffer));
+        ASSERT_TRUE(testObjects[i]->SimpleTestObjectInterface::Update() == ER_OK);
+    }
+
+    //A late joiner should only see the new names
+    TestObjectListener testObjectListener2;
+    std::shared_ptr<Observer<SimpleTestObjectProxy> > obs2 =
+        Observer<SimpleTestObjectProxy>::Create(&testObjectListener2);
+    ASSERT_TRUE(obs2->GetStatus() == ER_OK);
+    testObjectListener2.WaitOnUpdate(numPubObjs, 10);
+    EXPECT_TRUE((int)testObjectListener2.nameToObjects.size() == numPubObjs);
+    for (int i = 0; i < numPubObjs; i++) {
+        char buffer[50];
+        snprintf(buffer, sizeof(buffer), "TestObjectRenamed%d", i);
+        EXPECT_TRUE(testObjectListener2.nameToObjects.find(qcc::String(buffer)) !=
+                    testObjectListener2.nameToObjects.end());
+    }
+
+    Remove(testObjects);
+}
 }
 //namespace
@@ -0,0 +1,213 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <datadriven/Metrics.h>
+
+#include "common/AsyncTaskQueue.h"
+
+using namespace datadriven;
+
+/**
+ * Tests of the runtime metrics registry.
+ */
+namespace test_unit_metrics {
+#define ROUNDS 10000
+#define THREADS 4
+
+class FixedSource :
+    public Metrics::Source {
+  public:
+    void CollectMetrics(Metrics::Snapshot& snapshot) const
+    {
+        Metrics::Cache cache;
+        cache.interfaceName = "org.test.Metrics";
+        cache.living = 3;
+        cache.dead = 1;
+        cache.observers = 2;
+        snapshot.caches.push_back(cache);
+        snapshot.sessions += 2;
+        snapshot.establishedSessions += 1;
+    }
+};
+
+class NopTask :
+    public AsyncTask {
+  public:
+    NopTask() :
+        executed(0) { }
+
+    void OnEmptyQueue() { }
+
+    void OnTask(TaskData const* taskdata)
+    {
+        executed++;
+    }
+
+    bool OnCoalesceKey(TaskData const* taskdata, uint64_t& key)
+    {
+        key = 0;
+        return true;
+    }
+
+    bool OnCoalesce(TaskData const* queued, TaskData const* incoming)
+    {
+        return true;
+    }
+
+    std::atomic<int> executed;
+};
+
+/* *
+ * \test Counters are only counted while enabled, and the counts of all
+ *       threads are summed.
+ * */
+TEST(Metrics, Counters) {
+    Metrics::Reset();
+    Metrics::Enable(false);
+    Metrics::Increment(Metrics::PROVIDER_GETS);
+
+    Metrics::Enable(true);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.push_back(std::thread([]() {
+                                          for (int i = 0; i < ROUNDS; i++) {
+                                              Metrics::Increment(Metrics::PROVIDER_GETS);
+                                              Metrics::Increment(Metrics::PROVIDER_SETS, 2);
+                                          }
+                                      }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+    Metrics::Enable(false);
+
+    Metrics::Snapshot snapshot;
+    Metrics::GetSnapshot(snapshot);
+    EXPECT_EQ((uint64_t)THREADS * ROUNDS, snapshot.counters[Metrics::PROVIDER_GETS]);
+    EXPECT_EQ((uint64_t)2 * THREADS * ROUNDS, snapshot.counters[Metrics::PROVIDER_SETS]);
+    EXPECT_EQ((uint64_t)0, snapshot.counters[Metrics::PROVIDER_METHOD_CALLS]);
+    EXPECT_STREQ("provider_gets", Metrics::GetName(Metrics::PROVIDER_GETS));
+
+    Metrics::Reset();
+    Metrics::GetSnapshot(snapshot);
+    EXPECT_EQ((uint64_t)0, snapshot.counters[Metrics::PROVIDER_GETS]);
+    EXPECT_EQ((uint64_t)0, snapshot.counters[Metrics::PROVIDER_SETS]);
+}
+
+/* *
+ * \test Recorded durations end up in the histogram of their timing.
+ * */
+TEST(Metrics, Timings) {
+    Metrics::Reset();
+    Metrics::Enable(true);
+    Metrics::RecordTiming(Metrics::SESSION_JOIN_LATENCY, 1000);
+    Metrics::RecordTiming(Metrics::SESSION_JOIN_LATENCY, 1000000);
+    Metrics::Enable(false);
+    Metrics::RecordTiming(Metrics::SESSION_JOIN_LATENCY, 1000);
+
+    Metrics::Snapshot snapshot;
+    Metrics::GetSnapshot(snapshot);
+    const Metrics::Histogram& latency = snapshot.timings[Metrics::SESSION_JOIN_LATENCY];
+    EXPECT_EQ((uint64_t)2, latency.GetCount());
+    EXPECT_EQ((uint64_t)1001000, latency.total);
+    EXPECT_EQ((uint64_t)1000000, latency.max);
+    Metrics::Reset();
+}
+
+/* *
+ * \test Registered sources add their state to snapshots until removed.
+ * */
+TEST(Metrics, Sources) {
+    FixedSource source;
+    Metrics::Snapshot snapshot;
+
+    Metrics::AddSource(&source);
+    Metrics::GetSnapshot(snapshot);
+    ASSERT_EQ((size_t)1, snapshot.caches.size());
+    EXPECT_EQ(qcc::String("org.test.Metrics"), snapshot.caches[0].interfaceName);
+    EXPECT_EQ((size_t)3, snapshot.caches[0].living);
+    EXPECT_EQ((size_t)2, snapshot.sessions);
+    EXPECT_EQ((size_t)1, snapshot.establishedSessions);
+
+    Metrics::RemoveSource(&source);
+    Metrics::Snapshot after;
+    Metrics::GetSnapshot(after);
+    EXPECT_TRUE(after.caches.empty());
+    EXPECT_EQ((size_t)0, after.sessions);
+}
+
+/* *
+ * \test A task queue reports its executed tasks and the longest wait.
+ * */
+TEST(Metrics, Queue) {
+    NopTask nop;
+    AsyncTaskQueue queue(&nop);
+
+    Metrics::Enable(true);
+    queue.Enqueue(new TaskData());
+    queue.Enqueue(new TaskData());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.Start();
+    for (int i = 0; (i < 500) && (nop.executed < 2); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    queue.Stop();
+    Metrics::Enable(false);
+
+    Metrics::Snapshot snapshot;
+    queue.CollectMetrics("test", snapshot);
+    ASSERT_EQ((size_t)1, snapshot.queues.size());
+    EXPECT_STREQ("test", snapshot.queues[0].name);
+    EXPECT_EQ((uint64_t)2, snapshot.queues[0].enqueued);
+    EXPECT_EQ((uint64_t)2, snapshot.queues[0].executed);
+    EXPECT_EQ((size_t)0, snapshot.queues[0].depth);
+    EXPECT_LE((uint64_t)20, snapshot.queues[0].maxWait);
+}
+
+/* *
+ * \test A task queue reports the tasks it merged on overflow.
+ * */
+TEST(Metrics, QueueCoalesced) {
+    NopTask nop;
+    AsyncTaskQueue queue(&nop);
+
+    // not started yet, so the queue stays full
+    queue.SetCapacity(1, AsyncTaskQueue::OVERFLOW_COALESCE);
+    for (int i = 0; i < 3; i++) {
+        queue.Enqueue(new TaskData());
+    }
+
+    Metrics::Snapshot snapshot;
+    queue.CollectMetrics("test", snapshot);
+    ASSERT_EQ((size_t)1, snapshot.queues.size());
+    EXPECT_EQ((uint64_t)1, snapshot.queues[0].enqueued);
+    EXPECT_EQ((uint64_t)2, snapshot.queues[0].coalesced);
+    EXPECT_EQ((uint64_t)0, snapshot.queues[0].dropped);
+
+    queue.Start();
+    for (int i = 0; (i < 500) && (nop.executed < 1); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    queue.Stop();
+    EXPECT_EQ(1, nop.executed);
+}
+}
@@ -0,0 +1,96 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <datadriven/Mutex.h>
+#include <datadriven/MutexProfiler.h>
+
+using namespace datadriven;
+
+/**
+ * Tests of the mutex contention profiler.
+ */
+namespace test_unit_mutexprofiler {
+#if !defined(NDEBUG) || defined(DATADRIVEN_MUTEX_PROFILING)
+#define ROUNDS 1000
+/* any line will do, as long as it is used by no other lock site */
+#define LOCK_LINE 4242
+
+static const MutexProfiler::Site* FindSite(const std::vector<MutexProfiler::Site>& sites,
+                                           uint32_t line)
+{
+    for (size_t i = 0; i < sites.size(); i++) {
+        if ((sites[i].line == line) && (0 == strcmp(sites[i].file, __FILE__))) {
+            return &sites[i];
+        }
+    }
+    return NULL;
+}
+
+/* *
+ * \test Acquisitions, waits and holds are attributed to their lock site and
+ *       merged across threads.
+ * */
+TEST(MutexProfiler, Sites) {
+    Mutex mutex;
+
+    MutexProfiler::Reset();
+    MutexProfiler::Enable(true);
+
+    auto worker = [&mutex]() {
+                      for (int i = 0; i < ROUNDS; i++) {
+                          mutex.Lock(__FILE__, LOCK_LINE);
+                          std::this_thread::sleep_for(std::chrono::microseconds(10));
+                          mutex.Unlock(__FILE__, __LINE__);
+                      }
+                  };
+    std::thread t1(worker);
+    std::thread t2(worker);
+    t1.join();
+    t2.join();
+
+    MutexProfiler::Enable(false);
+    // not recorded while disabled
+    mutex.Lock(__FILE__, LOCK_LINE);
+    mutex.Unlock(__FILE__, __LINE__);
+
+    std::vector<MutexProfiler::Site> sites;
+    MutexProfiler::GetSites(sites);
+    const MutexProfiler::Site* site = FindSite(sites, LOCK_LINE);
+    ASSERT_TRUE(NULL != site);
+    EXPECT_EQ((uint64_t)2 * ROUNDS, site->acquisitions);
+    EXPECT_EQ((uint64_t)2 * ROUNDS, site->hold.GetCount());
+    EXPECT_EQ(site->contended, site->wait.GetCount());
+    EXPECT_LT((uint64_t)0, site->contended);
+    EXPECT_LE((uint64_t)2 * ROUNDS * 10000, site->hold.total);
+    EXPECT_LE(site->hold.GetPercentile(50), site->hold.GetPercentile(99));
+
+    MutexProfiler::Reset();
+    MutexProfiler::GetSites(sites);
+    site = FindSite(sites, LOCK_LINE);
+    ASSERT_TRUE(NULL != site);
+    EXPECT_EQ((uint64_t)0, site->acquisitions);
+    EXPECT_EQ((uint64_t)0, site->hold.GetCount());
+}
+#endif
+}
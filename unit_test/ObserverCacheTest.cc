@@ -0,0 +1,289 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <stdio.h>
+
+#include <gtest/gtest.h>
+
+#include <datadriven/ObjectAllocator.h>
+#include <datadriven/ObserverBase.h>
+#include <datadriven/ProxyInterface.h>
+#include <datadriven/TypeDescription.h>
+
+#include "BusConnectionImpl.h"
+#include "ObserverCache.h"
+#include "ObserverManager.h"
+#include "RegisteredTypeDescription.h"
+
+using namespace std;
+using namespace ajn;
+using namespace datadriven;
+
+/**
+ * Tests of the observer cache bookkeeping.
+ */
+namespace test_unit_observercache {
+#define IFACE_NAME "org.allseenalliance.test.ObserverCache"
+#define BUS_NAME ":observer.cache"
+#define OBJECTS 2000
+#define STORM_OBJECTS 16
+#define STORM_UPDATES 20000
+#define STORM_OBSERVERS 500
+
+class CacheTypeDescription :
+    public TypeDescription {
+  public:
+    CacheTypeDescription() :
+        TypeDescription(IFACE_NAME)
+    {
+        AddProperty("value", "i", ajn::PROP_ACCESS_READ, EmitChangesSignal::ALWAYS);
+    }
+};
+
+class CacheProxyInterface :
+    public ProxyInterface {
+  public:
+    CacheProxyInterface(const RegisteredTypeDescription& desc,
+                        const ObjectId& objId) :
+        ProxyInterface(desc, objId) { }
+
+    virtual QStatus UnmarshalProperty(const char* name,
+                                      const ajn::MsgArg& value)
+    {
+        return ER_OK;
+    }
+};
+
+class CacheAllocator :
+    public ObjectAllocator {
+  public:
+    CacheAllocator(const RegisteredTypeDescription& desc) :
+        desc(desc) { }
+
+    ProxyInterface* Alloc(const ObjectId& objId)
+    {
+        return new CacheProxyInterface(desc, objId);
+    }
+
+  private:
+    const RegisteredTypeDescription& desc;
+};
+
+class StormObserver :
+    public ObserverBase {
+  public:
+    StormObserver(const TypeDescription& type) :
+        ObserverBase(type), added(0), removed(0), updated(0) { }
+
+    ProxyInterface* Alloc(const ObjectId& objId)
+    {
+        return new CacheProxyInterface(*registeredTypeDesc, objId);
+    }
+
+    void AddObject(const shared_ptr<ProxyInterface>& objProxy)
+    {
+        added++;
+    }
+
+    void RemoveObject(const shared_ptr<ProxyInterface>& objProxy)
+    {
+        removed++;
+    }
+
+    void UpdateObject(const shared_ptr<ProxyInterface>& objProxy)
+    {
+        updated++;
+    }
+
+    atomic<unsigned int> added;
+    atomic<unsigned int> removed;
+    atomic<unsigned int> updated;
+};
+
+class ObserverCacheTest :
+    public testing::Test {
+  public:
+    ObserverCacheTest() :
+        bus("ObserverCacheTest", true) { }
+
+    virtual void SetUp()
+    {
+        ASSERT_EQ(ER_OK, RegisteredTypeDescription::RegisterInterface(bus, type, registered));
+        allocator = make_shared<CacheAllocator>(*registered);
+    }
+
+  protected:
+    ObjectId Id(unsigned int i)
+    {
+        char path[32];
+        snprintf(path, sizeof(path), "/object/%u", i);
+        return ObjectId(bus, BUS_NAME, path, 0);
+    }
+
+    size_t Dead(const ObserverCache& cache)
+    {
+        Metrics::Snapshot snapshot;
+        cache.CollectMetrics(snapshot);
+        return snapshot.caches.empty() ? 0 : snapshot.caches[0].dead;
+    }
+
+    /**
+     * Add \a num objects, then remove them all while holding a reference to
+     * each of them.
+     */
+    void RemoveReferenced(ObserverCache& cache,
+                          unsigned int num,
+                          vector<shared_ptr<ProxyInterface> >& held)
+    {
+        for (unsigned int i = 0; i < num; i++) {
+            held.push_back(cache.AddObject(Id(i)).interface);
+        }
+        for (unsigned int i = 0; i < num; i++) {
+            cache.RemoveObject(Id(i));
+        }
+    }
+
+    BusAttachment bus;
+    CacheTypeDescription type;
+    unique_ptr<RegisteredTypeDescription> registered;
+    shared_ptr<CacheAllocator> allocator;
+};
+
+/* *
+ * \test Graveyard entries of objects that are gone are reclaimed while
+ *       other objects are removed, and referenced ones are kept.
+ * */
+TEST_F(ObserverCacheTest, Reclaim) {
+    ObserverCache cache(IFACE_NAME, allocator);
+    vector<shared_ptr<ProxyInterface> > held;
+
+    RemoveReferenced(cache, OBJECTS, held);
+    EXPECT_EQ((size_t)OBJECTS, Dead(cache));
+
+    // a referenced dead object comes back as the same proxy
+    shared_ptr<ProxyInterface> resurrected = cache.AddObject(Id(0)).interface;
+    EXPECT_TRUE(resurrected == held[0]);
+    EXPECT_EQ((size_t)OBJECTS - 1, Dead(cache));
+
+    // once released, the dead objects are swept while others are removed
+    held.clear();
+    resurrected.reset();
+    for (unsigned int i = OBJECTS; i < 2 * OBJECTS; i++) {
+        cache.AddObject(Id(i));
+        cache.RemoveObject(Id(i));
+    }
+    EXPECT_GT((size_t)OBJECTS / 2, Dead(cache));
+}
+
+/* *
+ * \test Once released, a graveyard of any size drains GRAVEYARD_SWEEP
+ *       entries per removal: it is empty after ceil(N / GRAVEYARD_SWEEP)
+ *       removals, and not a single removal earlier.
+ * */
+TEST_F(ObserverCacheTest, LinearRemoval) {
+    const unsigned int sizes[] = { OBJECTS, 8 * OBJECTS };
+
+    for (unsigned int num : sizes) {
+        ObserverCache cache(IFACE_NAME, allocator);
+        vector<shared_ptr<ProxyInterface> > held;
+
+        RemoveReferenced(cache, num, held);
+        EXPECT_EQ((size_t)num, Dead(cache));
+        held.clear();
+
+        // removing objects that were never added only sweeps the graveyard
+        unsigned int removals = (num + GRAVEYARD_SWEEP - 1) / GRAVEYARD_SWEEP;
+        for (unsigned int i = 0; i < removals - 1; i++) {
+            cache.RemoveObject(Id(num + i));
+        }
+        EXPECT_LT((size_t)0, Dead(cache));
+        cache.RemoveObject(Id(num + removals - 1));
+        EXPECT_EQ((size_t)0, Dead(cache));
+    }
+}
+
+/* *
+ * \test Observers come and go while updates, additions and removals are
+ *       being notified. An observer that stays registered throughout sees
+ *       every update. Run under ThreadSanitizer to check the notifications
+ *       for data races.
+ * */
+TEST(ObserverCache, ObserverChurn) {
+    CacheTypeDescription type;
+    // the first observer of an interface also allocates its proxies
+    shared_ptr<StormObserver> anchor = make_shared<StormObserver>(type);
+    ASSERT_EQ(ER_OK, anchor->SetRefCountedPtr(anchor));
+    shared_ptr<ObserverCache> cache = ObserverManager::GetInstance(anchor->GetBusConnection())->GetCache(IFACE_NAME);
+    ASSERT_TRUE(nullptr != cache);
+
+    BusAttachment& bus = anchor->GetBusConnection()->GetBusAttachment();
+    vector<ObjectId> ids;
+    for (unsigned int i = 0; i < STORM_OBJECTS; i++) {
+        char path[32];
+        snprintf(path, sizeof(path), "/storm/%u", i);
+        ids.push_back(ObjectId(bus, BUS_NAME, path, 0));
+        ObserverCache::NotificationSet added = cache->AddObject(ids.back());
+        cache->NotifyObjectExistence(added.interface, true, added.observers);
+    }
+    unsigned int addedBefore = anchor->added;
+
+    atomic<bool> storming(true);
+    MsgArg empty("a{sv}", 0, NULL);
+    auto updater = [&]() {
+                       for (unsigned int i = 0; i < STORM_UPDATES; i++) {
+                           EXPECT_TRUE(nullptr != cache->UpdateObject(ids[i % (STORM_OBJECTS / 2)], &empty));
+                       }
+                   };
+    auto churner = [&]() {
+                       for (unsigned int i = 0; i < STORM_OBSERVERS; i++) {
+                           shared_ptr<StormObserver> observer = make_shared<StormObserver>(type);
+                           EXPECT_EQ(ER_OK, observer->SetRefCountedPtr(observer));
+                       }
+                   };
+    // the second half of the objects keeps coming and going
+    auto mover = [&]() {
+                     for (unsigned int i = 0; storming; i++) {
+                         const ObjectId& id = ids[STORM_OBJECTS / 2 + i % (STORM_OBJECTS / 2)];
+                         ObserverCache::NotificationSet removed = cache->RemoveObject(id);
+                         cache->NotifyObjectExistence(removed.interface, false, removed.observers);
+                         ObserverCache::NotificationSet added = cache->AddObject(id);
+                         cache->NotifyObjectExistence(added.interface, true, added.observers);
+                     }
+                 };
+
+    thread mov(mover);
+    thread upd1(updater);
+    thread upd2(updater);
+    thread churn1(churner);
+    thread churn2(churner);
+    upd1.join();
+    upd2.join();
+    churn1.join();
+    churn2.join();
+    storming = false;
+    mov.join();
+
+    EXPECT_EQ((unsigned int)2 * STORM_UPDATES, anchor->updated);
+    EXPECT_EQ(anchor->added - addedBefore, anchor->removed);
+    EXPECT_EQ((size_t)1, cache->GetObservers()->size());
+    EXPECT_TRUE(cache->GetObservers()->front().lock() == anchor);
+}
+}
@@ -19,11 +19,14 @@
 
 #include <gtest/gtest.h>
 
+#include <alljoyn/BusObject.h>
+
 #include <datadriven/Observer.h>
 #include <datadriven/ObserverBase.h>
 #include <datadriven/ProxyInterface.h>
 #include <datadriven/TypeDescription.h>
 #include <datadriven/Semaphore.h>
+#include <datadriven/Mutex.h>
 #include <datadriven/Marshal.h>
 
 #include "BusConnectionImpl.h"
@@ -39,6 +42,7 @@ using namespace datadriven;
 #define IFACE_NAME "org.dummy"
 #define PROP_EMIT "emit"
 #define PROP_INVALIDATE "invalidate"
+#define PROP_INVALIDATE2 "invalidate2"
 
 static Semaphore _sync;
 
@@ -54,6 +58,7 @@ class MyTypeDescription :
     {
         AddProperty(PROP_EMIT, "i", ajn::PROP_ACCESS_READ, EmitChangesSignal::ALWAYS);
         AddProperty(PROP_INVALIDATE, "i", ajn::PROP_ACCESS_READ, EmitChangesSignal::INVALIDATES);
+        AddProperty(PROP_INVALIDATE2, "i", ajn::PROP_ACCESS_READ, EmitChangesSignal::INVALIDATES);
     }
 
     ~MyTypeDescription() { }
@@ -62,9 +67,9 @@ class MyTypeDescription :
 class MyProxyInterface :
     public ProxyInterface {
   public:
-    MyProxyInterface(BusAttachment& bus,
-                     RegisteredTypeDescription& desc) :
-        ProxyInterface(desc, ObjectId(bus, "", "", 0))
+    MyProxyInterface(RegisteredTypeDescription& desc,
+                     const ObjectId& objId) :
+        ProxyInterface(desc, objId)
     {
     }
 
@@ -98,6 +103,8 @@ class MyObserver :
     public ObserverBase {
   public:
     MyProxyInterface* proxy;
+    /* last object notified, keeps it around after it was removed */
+    shared_ptr<ProxyInterface> object;
 
     MyObserver(TypeDescription& type) :
         ObserverBase(type), proxy(nullptr), type(type)
@@ -119,25 +126,28 @@ class MyObserver :
 
     virtual ProxyInterface* Alloc(const ObjectId& objId)
     {
-        proxy = new MyProxyInterface(GetBusConnection()->GetBusAttachment(), *registeredTypeDesc);
+        proxy = new MyProxyInterface(*registeredTypeDesc, objId);
         return proxy;
     }
 
     virtual void AddObject(const shared_ptr<ProxyInterface>& objProxy)
     {
         //cout << "Adding object" << endl;
+        object = objProxy;
         _sync.Post();
     }
 
     virtual void RemoveObject(const shared_ptr<ProxyInterface>& objProxy)
     {
         //cout << "Removing object" << endl;
+        object = objProxy;
         _sync.Post();
     }
 
     virtual void UpdateObject(const shared_ptr<ProxyInterface>& objProxy)
     {
         //cout << "Updating object" << endl;
+        object = objProxy;
         _sync.Post();
     }
 
@@ -180,7 +190,7 @@ class PropertiesTests :
         std::shared_ptr<BusConnectionImpl> bc = observer->GetBusConnection();
         ObserverCache::NotificationSet notificationSet =
             ObserverManager::GetInstance(bc)->GetCache(IFACE_NAME)->AddObject(*id);
-        ObserverCache::ObserverSet observers = ObserverManager::GetInstance(bc)->GetCache(IFACE_NAME)->GetObservers();
+        ObserverCache::ObserverSnapshot observers = ObserverManager::GetInstance(bc)->GetCache(IFACE_NAME)->GetObservers();
         ObserverManager::GetInstance(bc)->GetCache(IFACE_NAME)->NotifyObjectExistence(notificationSet.interface,
                                                                                       true,
                                                                                       notificationSet.observers);
@@ -198,11 +208,17 @@ class PropertiesTests :
         _sync.Wait();
     }
 
-    void PropertiesChanged(MsgArg& changed,
-                           MsgArg& invalidated)
+    void SendPropertiesChanged(MsgArg& changed,
+                               MsgArg& invalidated)
     {
         observer->PropertiesChanged(*proxy, IFACE_NAME, changed, invalidated, nullptr);
         _sync.Wait();
+    }
+
+    void PropertiesChanged(MsgArg& changed,
+                           MsgArg& invalidated)
+    {
+        SendPropertiesChanged(changed, invalidated);
         observer->proxy->validate(changed, invalidated);
     }
 
@@ -217,7 +233,6 @@ class PropertiesTests :
         qcc::Sleep(200);
     }
 
-  private:
     MyTypeDescription type;
     shared_ptr<MyObserver> observer;
     ObjectId* id;
@@ -279,4 +294,308 @@ TEST_F(PropertiesTests, BothEmittedAndInvalidated)
 
     PropertiesChanged(changed, invalidated);
 }
+
+/**
+ * Serves the properties of the test interface with a constant value and
+ * counts how often each of them was read.
+ */
+class CountingBusObject :
+    public BusObject {
+  public:
+    CountingBusObject(BusAttachment& bus) :
+        BusObject(OBJECT_PATH), bus(bus)
+    {
+        AddInterface(*bus.GetInterface(IFACE_NAME));
+        bus.RegisterBusObject(*this);
+    }
+
+    ~CountingBusObject()
+    {
+        bus.UnregisterBusObject(*this);
+    }
+
+    int GetCount(const char* propName)
+    {
+        mutex.Lock();
+        int count = gets[propName];
+        mutex.Unlock();
+        return count;
+    }
+
+  protected:
+    virtual QStatus Get(const char* ifcName, const char* propName, MsgArg& val)
+    {
+        mutex.Lock();
+        gets[propName]++;
+        mutex.Unlock();
+        return val.Set("i", 42);
+    }
+
+  private:
+    BusAttachment& bus;
+    datadriven::Mutex mutex;
+    map<qcc::String, int> gets;
+};
+
+/**
+ * Same as PropertiesTests, but the object is served by a bus object on our
+ * own bus attachment so stale properties can really be refreshed.
+ */
+class RefreshTests :
+    public PropertiesTests {
+  public:
+    RefreshTests() :
+        busObject(nullptr)
+    {
+    }
+
+  protected:
+    CountingBusObject* busObject;
+
+    virtual void SetUp()
+    {
+        BusAttachment& bus = observer->GetBusConnection()->GetBusAttachment();
+        busObject = new CountingBusObject(bus);
+        delete proxy;
+        delete id;
+        id = new ObjectId(bus, bus.GetUniqueName(), OBJECT_PATH, 0);
+        proxy = new ProxyBusObject(bus, id->GetBusName().c_str(), id->GetBusObjectPath().c_str(), id->GetSessionId());
+        PropertiesTests::SetUp();
+    }
+
+    virtual void TearDown()
+    {
+        PropertiesTests::TearDown();
+        delete busObject;
+        busObject = nullptr;
+    }
+};
+
+/**
+ * Keeps the consumer thread busy until released.
+ */
+class BlockingTask :
+    public ObserverManager::Task {
+  public:
+    BlockingTask(Semaphore& started,
+                 Semaphore& release) :
+        started(started), release(release) { }
+
+    void Execute() const
+    {
+        started.Post();
+        release.Wait();
+    }
+
+  private:
+    Semaphore& started;
+    Semaphore& release;
+};
+
+/**
+ * Takes up room in the consumer queue; once it is full, the next filler
+ * is merged into the previous one.
+ */
+class FillerTask :
+    public ObserverManager::Task {
+  public:
+    void Execute() const { }
+
+    bool Coalesce(const Task& next)
+    {
+        return nullptr != dynamic_cast<const FillerTask*>(&next);
+    }
+
+    bool CoalesceKey(uint64_t& key) const
+    {
+        key = 0;
+        return true;
+    }
+};
+
+static void ExpectCached(const ProxyInterface& intf, const char* propName, int32_t expected)
+{
+    MsgArg value;
+    ASSERT_TRUE(intf.GetCachedProperty(propName, value));
+    int32_t actual = 0;
+    ASSERT_EQ(ER_OK, value.Get("i", &actual));
+    EXPECT_EQ(expected, actual);
+}
+
+/**
+ * \test Invalidating properties are stale until a value is received, become
+ *       stale again when invalidated and are served from the cache otherwise.
+ * */
+TEST_F(PropertiesTests, StaleAndCached)
+{
+    ProxyInterface* intf = observer->proxy;
+    MsgArg value;
+
+    EXPECT_TRUE(intf->IsStale(PROP_INVALIDATE));
+    EXPECT_TRUE(intf->IsStale(PROP_INVALIDATE2));
+    EXPECT_FALSE(intf->IsStale(PROP_EMIT));
+    EXPECT_TRUE(intf->HasStaleProperties());
+    EXPECT_FALSE(intf->GetCachedProperty(PROP_INVALIDATE, value));
+
+    // values as they would arrive in a GetAll reply
+    MsgArg value1("i", 1);
+    MsgArg value2("i", 2);
+    MsgArg entries[2];
+    entries[0].Set("{sv}", PROP_INVALIDATE, &value1);
+    entries[1].Set("{sv}", PROP_INVALIDATE2, &value2);
+    MsgArg changed("a{sv}", 2, entries);
+    MsgArg none("as", 0, nullptr);
+    SendPropertiesChanged(changed, none);
+
+    EXPECT_FALSE(intf->IsStale(PROP_INVALIDATE));
+    EXPECT_FALSE(intf->IsStale(PROP_INVALIDATE2));
+    EXPECT_FALSE(intf->HasStaleProperties());
+    ExpectCached(*intf, PROP_INVALIDATE, 1);
+    ExpectCached(*intf, PROP_INVALIDATE2, 2);
+    // nothing stale, nothing to fetch
+    EXPECT_EQ(ER_OK, intf->RefreshStaleProperties());
+
+    MsgArg unchanged("a{sv}", 0, nullptr);
+    const char* invalidated_entries[] = { PROP_INVALIDATE };
+    MsgArg invalidated("as", 1, invalidated_entries);
+    SendPropertiesChanged(unchanged, invalidated);
+
+    EXPECT_TRUE(intf->IsStale(PROP_INVALIDATE));
+    EXPECT_FALSE(intf->IsStale(PROP_INVALIDATE2));
+    EXPECT_TRUE(intf->HasStaleProperties());
+    EXPECT_FALSE(intf->GetCachedProperty(PROP_INVALIDATE, value));
+    ExpectCached(*intf, PROP_INVALIDATE2, 2);
+
+    MsgArg value3("i", 3);
+    MsgArg update[1];
+    update[0].Set("{sv}", PROP_INVALIDATE, &value3);
+    MsgArg updated("a{sv}", 1, update);
+    SendPropertiesChanged(updated, none);
+
+    EXPECT_FALSE(intf->IsStale(PROP_INVALIDATE));
+    EXPECT_FALSE(intf->HasStaleProperties());
+    ExpectCached(*intf, PROP_INVALIDATE, 3);
+}
+
+/**
+ * \test Stale properties of an object that is gone cannot be refreshed.
+ * */
+TEST_F(PropertiesTests, RefreshDead)
+{
+    shared_ptr<ProxyInterface> intf = observer->object;
+    ASSERT_TRUE(intf != nullptr);
+    RemoveObject();
+
+    EXPECT_FALSE(intf->IsAlive());
+    EXPECT_TRUE(intf->HasStaleProperties());
+    EXPECT_EQ(ER_FAIL, intf->RefreshStaleProperties());
+
+    // bring it back for TearDown
+    AddObject();
+}
+
+/**
+ * \test A single stale property is refreshed on its own.
+ * */
+TEST_F(RefreshTests, RefreshSingle)
+{
+    ProxyInterface* intf = observer->proxy;
+    MsgArg value1("i", 1);
+    MsgArg value2("i", 2);
+    MsgArg entries[2];
+    entries[0].Set("{sv}", PROP_INVALIDATE, &value1);
+    entries[1].Set("{sv}", PROP_INVALIDATE2, &value2);
+    MsgArg changed("a{sv}", 2, entries);
+    const char* invalidated_entries[] = { PROP_INVALIDATE };
+    MsgArg invalidated("as", 1, invalidated_entries);
+    SendPropertiesChanged(changed, invalidated);
+    ASSERT_TRUE(intf->IsStale(PROP_INVALIDATE));
+    ASSERT_FALSE(intf->IsStale(PROP_INVALIDATE2));
+
+    ASSERT_EQ(ER_OK, intf->RefreshStaleProperties());
+    _sync.Wait();
+
+    EXPECT_FALSE(intf->HasStaleProperties());
+    ExpectCached(*intf, PROP_INVALIDATE, 42);
+    ExpectCached(*intf, PROP_INVALIDATE2, 2);
+    EXPECT_EQ(1, busObject->GetCount(PROP_INVALIDATE));
+    EXPECT_EQ(0, busObject->GetCount(PROP_INVALIDATE2));
+    EXPECT_EQ(0, busObject->GetCount(PROP_EMIT));
+}
+
+/**
+ * \test Several stale properties are refreshed in a single GetAll.
+ * */
+TEST_F(RefreshTests, RefreshMultiple)
+{
+    ProxyInterface* intf = observer->proxy;
+    ASSERT_TRUE(intf->IsStale(PROP_INVALIDATE));
+    ASSERT_TRUE(intf->IsStale(PROP_INVALIDATE2));
+
+    ASSERT_EQ(ER_OK, intf->RefreshStaleProperties());
+    _sync.Wait();
+
+    EXPECT_FALSE(intf->HasStaleProperties());
+    ExpectCached(*intf, PROP_INVALIDATE, 42);
+    ExpectCached(*intf, PROP_INVALIDATE2, 42);
+    EXPECT_EQ(1, busObject->GetCount(PROP_INVALIDATE));
+    EXPECT_EQ(1, busObject->GetCount(PROP_INVALIDATE2));
+    // only GetAll asks for the emitting property
+    EXPECT_EQ(1, busObject->GetCount(PROP_EMIT));
+}
+
+/**
+ * \test A property invalidated while the consumer queue is full is not
+ *       merged ahead of a value fetched before it, so it stays stale.
+ * */
+TEST_F(RefreshTests, InvalidateBehindFetchOnFullQueue)
+{
+    ProxyInterface* intf = observer->proxy;
+    shared_ptr<ObserverManager> mgr = ObserverManager::GetInstance(observer->GetBusConnection());
+    MsgArg none("as", 0, nullptr);
+    MsgArg unchanged("a{sv}", 0, nullptr);
+    const char* invalidated_entries[] = { PROP_INVALIDATE };
+    MsgArg invalidated("as", 1, invalidated_entries);
+
+    MsgArg value1("i", 1);
+    MsgArg value2("i", 2);
+    MsgArg entries[2];
+    entries[0].Set("{sv}", PROP_INVALIDATE, &value1);
+    entries[1].Set("{sv}", PROP_INVALIDATE2, &value2);
+    MsgArg changed("a{sv}", 2, entries);
+    SendPropertiesChanged(changed, invalidated);
+    ASSERT_TRUE(intf->IsStale(PROP_INVALIDATE));
+
+    // stall the consumer and fill its queue
+    Semaphore started;
+    Semaphore release;
+    mgr->Enqueue(new BlockingTask(started, release), ObserverManager::Lane::UPDATE);
+    started.Wait();
+    uint64_t coalesced = mgr->GetQueueStats().coalesced;
+    while (mgr->GetQueueStats().coalesced == coalesced) {
+        mgr->Enqueue(new FillerTask(), ObserverManager::Lane::UPDATE);
+    }
+    coalesced = mgr->GetQueueStats().coalesced;
+
+    // update, fetched value, invalidation
+    MsgArg value3("i", 3);
+    MsgArg update[1];
+    update[0].Set("{sv}", PROP_EMIT, &value3);
+    MsgArg updated("a{sv}", 1, update);
+    observer->PropertiesChanged(*proxy, IFACE_NAME, updated, none, nullptr);
+    uint64_t enqueued = mgr->GetQueueStats().enqueued;
+    ASSERT_EQ(ER_OK, intf->RefreshStaleProperties());
+    while (mgr->GetQueueStats().enqueued == enqueued) {
+        qcc::Sleep(10);
+    }
+    observer->PropertiesChanged(*proxy, IFACE_NAME, unchanged, invalidated, nullptr);
+    EXPECT_EQ(coalesced, mgr->GetQueueStats().coalesced);
+
+    release.Post();
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(ER_OK, _sync.TimedWait(5000));
+    }
+    EXPECT_TRUE(intf->IsStale(PROP_INVALIDATE));
+    ExpectCached(*intf, PROP_INVALIDATE2, 2);
+}
 }
@@ -0,0 +1,126 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <datadriven/Mutex.h>
+#include <datadriven/SharedMutex.h>
+
+using namespace datadriven;
+
+/**
+ * Tests of the reader-writer lock.
+ */
+namespace test_unit_sharedmutex {
+#define THREADS 4
+#define ROUNDS 10000
+
+/* *
+ * \test Several threads can hold the lock shared at the same time.
+ * */
+TEST(SharedMutex, ConcurrentReaders) {
+    SharedMutex mutex;
+    std::atomic<int> readers(0);
+    std::atomic<int> maxReaders(0);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < THREADS; i++) {
+        threads.push_back(std::thread([&]() {
+                                          ASSERT_EQ(ER_OK, mutex.LockShared());
+                                          int now = ++readers;
+                                          // wait (bounded) for the other readers to get in
+                                          for (int j = 0; (j < 500) && (readers < THREADS); j++) {
+                                              std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                                          }
+                                          int seen = std::max(now, readers.load());
+                                          int prev = maxReaders.load();
+                                          while ((seen > prev) && !maxReaders.compare_exchange_weak(prev, seen)) {
+                                          }
+                                          ASSERT_EQ(ER_OK, mutex.UnlockShared());
+                                      }));
+    }
+    for (int i = 0; i < THREADS; i++) {
+        threads[i].join();
+    }
+    EXPECT_EQ(THREADS, maxReaders.load());
+}
+
+/* *
+ * \test Readers never see a writer's intermediate state, and writers
+ *       exclude each other.
+ * */
+TEST(SharedMutex, WritersExclude) {
+    SharedMutex mutex;
+    int a = 0;
+    int b = 0;
+    std::atomic<bool> torn(false);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < THREADS; i++) {
+        threads.push_back(std::thread([&]() {
+                                          for (int j = 0; j < ROUNDS; j++) {
+                                              mutex.Lock();
+                                              a++;
+                                              b++;
+                                              mutex.Unlock();
+                                          }
+                                      }));
+        threads.push_back(std::thread([&]() {
+                                          for (int j = 0; j < ROUNDS; j++) {
+                                              mutex.LockShared();
+                                              if (a != b) {
+                                                  torn = true;
+                                              }
+                                              mutex.UnlockShared();
+                                          }
+                                      }));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    EXPECT_FALSE(torn);
+    EXPECT_EQ(THREADS * ROUNDS, a);
+    EXPECT_EQ(THREADS * ROUNDS, b);
+}
+
+/* *
+ * \test A non-recursive Mutex provides mutual exclusion.
+ * */
+TEST(SharedMutex, PlainMutex) {
+    Mutex mutex(false);
+    int counter = 0;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < THREADS; i++) {
+        threads.push_back(std::thread([&]() {
+                                          for (int j = 0; j < ROUNDS; j++) {
+                                              ASSERT_EQ(ER_OK, mutex.Lock());
+                                              counter++;
+                                              ASSERT_EQ(ER_OK, mutex.Unlock());
+                                          }
+                                      }));
+    }
+    for (int i = 0; i < THREADS; i++) {
+        threads[i].join();
+    }
+    EXPECT_EQ(THREADS * ROUNDS, counter);
+}
+}
@@ -0,0 +1,131 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "Common.h"
+#include "ObserverCache.h"
+
+#include <qcc/Debug.h>
+#define QCC_MODULE "DD_TEST"
+
+/**
+ * Testing signal delivery to multiple listeners.
+ */
+namespace test_unit_signallistener {
+using namespace::test_unit_common;
+
+/* *
+ * \test Verify that all listeners for the same signal on one observer receive it.
+ *       Steps:
+ *       -# Create an observer and add two TestObjectSignalListeners for signal "Test"
+ *       -# Adding the same listener again has no effect
+ *       -# Issue a signal "Test" and verify both listeners receive it exactly once
+ *       -# Remove one listener, issue the signal again and verify only the other one receives it
+ *       -# Remove the last listener
+ * */
+TEST(SignalListener, MultipleListeners) {
+    shared_ptr<datadriven::ObjectAdvertiser> advertiser = ObjectAdvertiser::Create();
+    unique_ptr<TestObject> sto;
+
+    ASSERT_TRUE(advertiser != nullptr);
+
+    TestObjectListener testObjectListener;
+    TestObjectSignalListener first;
+    TestObjectSignalListener second;
+
+    std::shared_ptr<Observer<SimpleTestObjectProxy> > obs = Observer<SimpleTestObjectProxy>::Create(
+        &testObjectListener);
+    ASSERT_EQ(ER_OK, obs->GetStatus());
+    ASSERT_EQ(ER_OK, obs->AddSignalListener<SimpleTestObjectProxy::Test>(first));
+    ASSERT_EQ(ER_OK, obs->AddSignalListener<SimpleTestObjectProxy::Test>(second));
+    ASSERT_EQ(ER_OK, obs->AddSignalListener<SimpleTestObjectProxy::Test>(second));
+
+    sto = unique_ptr<TestObject>(new TestObject(advertiser, "SimpleTestObject"));
+    ASSERT_EQ(ER_OK, sto->UpdateAll());
+    testObjectListener.WaitOnAllUpdates(1);
+
+    ASSERT_EQ(ER_OK, sto->Test(DEFAULT_TEST_NAME));
+    ASSERT_EQ(ER_OK, first.TimedWait(5000));
+    ASSERT_EQ(ER_OK, second.TimedWait(5000));
+    ASSERT_EQ(ER_TIMEOUT, second.TimedWait(500));
+
+    ASSERT_EQ(ER_OK, obs->RemoveSignalListener<SimpleTestObjectProxy::Test>(first));
+    ASSERT_EQ(ER_OK, sto->Test(DEFAULT_TEST_NAME));
+    ASSERT_EQ(ER_OK, second.TimedWait(5000));
+    ASSERT_EQ(ER_TIMEOUT, first.TimedWait(500));
+
+    ASSERT_EQ(ER_OK, obs->RemoveSignalListener<SimpleTestObjectProxy::Test>(second));
+}
+
+/* *
+ * \test Verify that a sampling delivery policy only applies to its own listener.
+ *       Steps:
+ *       -# Add a listener with the default policy and one that gets every second signal
+ *       -# Issue four signals "Test" and verify the first listener receives all of them
+ *          and the second one only two
+ *       -# Verify the counters of the second listener
+ * */
+TEST(SignalListener, DeliveryPolicy) {
+    shared_ptr<datadriven::ObjectAdvertiser> advertiser = ObjectAdvertiser::Create();
+    unique_ptr<TestObject> sto;
+
+    ASSERT_TRUE(advertiser != nullptr);
+
+    TestObjectListener testObjectListener;
+    TestObjectSignalListener all;
+    TestObjectSignalListener sampled;
+    sampled.SetDeliveryPolicy(SignalDeliveryPolicy::EveryNth(2));
+
+    std::shared_ptr<Observer<SimpleTestObjectProxy> > obs = Observer<SimpleTestObjectProxy>::Create(
+        &testObjectListener);
+    ASSERT_EQ(ER_OK, obs->GetStatus());
+    ASSERT_EQ(ER_OK, obs->AddSignalListener<SimpleTestObjectProxy::Test>(all));
+    ASSERT_EQ(ER_OK, obs->AddSignalListener<SimpleTestObjectProxy::Test>(sampled));
+
+    sto = unique_ptr<TestObject>(new TestObject(advertiser, "SimpleTestObject"));
+    ASSERT_EQ(ER_OK, sto->UpdateAll());
+    testObjectListener.WaitOnAllUpdates(1);
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(ER_OK, sto->Test(DEFAULT_TEST_NAME));
+        ASSERT_EQ(ER_OK, all.TimedWait(5000));
+    }
+    ASSERT_EQ(ER_OK, sampled.TimedWait(5000));
+    ASSERT_EQ(ER_OK, sampled.TimedWait(5000));
+    ASSERT_EQ(ER_TIMEOUT, sampled.TimedWait(500));
+
+    SignalDeliveryStats stats = sampled.GetDeliveryStats();
+    EXPECT_EQ((uint64_t)4, stats.received);
+    EXPECT_EQ((uint64_t)2, stats.dropped);
+    EXPECT_EQ((uint64_t)0, stats.merged);
+    EXPECT_EQ((uint64_t)0, all.GetDeliveryStats().received);
+
+    ASSERT_EQ(ER_OK, obs->RemoveSignalListener<SimpleTestObjectProxy::Test>(sampled));
+    ASSERT_EQ(ER_OK, obs->RemoveSignalListener<SimpleTestObjectProxy::Test>(all));
+}
+
+/* *
+ * \test Verify that the sender and path hash used to look up the proxy for a
+ *       signal does not confuse the boundary between the two strings.
+ * */
+TEST(SignalListener, SenderPathHash) {
+    EXPECT_EQ(ObserverCache::Hash(":1.2", "/a"), ObserverCache::Hash(":1.2", "/a"));
+    EXPECT_NE(ObserverCache::Hash(":1.2", "/a"), ObserverCache::Hash(":1.2/", "a"));
+    EXPECT_NE(ObserverCache::Hash(":1.2", "/a"), ObserverCache::Hash(":1.3", "/a"));
+    EXPECT_NE(ObserverCache::Hash(":1.2", "/a"), ObserverCache::Hash(":1.2", "/b"));
+}
+}
@@ -0,0 +1,146 @@
+/******************************************************************************
+ * Copyright AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <thread>
+#include <vector>
+
+#include <datadriven/UpdateTracer.h>
+
+using namespace datadriven;
+
+/**
+ * Tests of the property update tracer.
+ */
+namespace test_unit_updatetracer {
+#define PATH "/tracer/object"
+#define IFACE "org.test.Tracer"
+
+/* *
+ * \test Stages are stamped in order on their trace, and nothing is traced
+ *       while disabled.
+ * */
+TEST(UpdateTracer, Stages) {
+    UpdateTracer::Reset();
+    EXPECT_EQ((uint64_t)0, UpdateTracer::Begin(UpdateTracer::UPDATE, PATH, IFACE));
+
+    UpdateTracer::Enable(true);
+    uint64_t provider = UpdateTracer::Begin(UpdateTracer::UPDATE, PATH, IFACE);
+    UpdateTracer::Record(provider, UpdateTracer::MARSHALED);
+    UpdateTracer::Record(provider, UpdateTracer::EMITTED);
+    uint64_t consumer = UpdateTracer::Begin(UpdateTracer::RECEIVED, PATH, IFACE);
+    std::thread([consumer]() {
+                    UpdateTracer::Record(consumer, UpdateTracer::DEQUEUED);
+                    UpdateTracer::SetCurrent(consumer);
+                    UpdateTracer::Record(UpdateTracer::GetCurrent(), UpdateTracer::UNMARSHALED);
+                    UpdateTracer::Record(UpdateTracer::GetCurrent(), UpdateTracer::DELIVERED);
+                    UpdateTracer::SetCurrent(0);
+                }).join();
+    UpdateTracer::Enable(false);
+    EXPECT_EQ((uint64_t)0, UpdateTracer::GetCurrent());
+
+    std::vector<UpdateTracer::Trace> traces;
+    UpdateTracer::GetTraces(traces);
+    ASSERT_EQ((size_t)2, traces.size());
+    EXPECT_EQ(provider, traces[0].id);
+    EXPECT_EQ(qcc::String(PATH), traces[0].path);
+    EXPECT_EQ(qcc::String(IFACE), traces[0].interfaceName);
+    EXPECT_LT((uint64_t)0, traces[0].stamps[UpdateTracer::UPDATE]);
+    EXPECT_LE(traces[0].stamps[UpdateTracer::UPDATE], traces[0].stamps[UpdateTracer::MARSHALED]);
+    EXPECT_LE(traces[0].stamps[UpdateTracer::MARSHALED], traces[0].stamps[UpdateTracer::EMITTED]);
+    EXPECT_EQ((uint64_t)0, traces[0].stamps[UpdateTracer::RECEIVED]);
+
+    EXPECT_EQ(consumer, traces[1].id);
+    EXPECT_EQ((uint64_t)0, traces[1].stamps[UpdateTracer::UPDATE]);
+    EXPECT_LE(traces[1].stamps[UpdateTracer::RECEIVED], traces[1].stamps[UpdateTracer::DEQUEUED]);
+    EXPECT_LE(traces[1].stamps[UpdateTracer::DEQUEUED], traces[1].stamps[UpdateTracer::UNMARSHALED]);
+    EXPECT_LE(traces[1].stamps[UpdateTracer::UNMARSHALED], traces[1].stamps[UpdateTracer::DELIVERED]);
+
+    UpdateTracer::Reset();
+    UpdateTracer::GetTraces(traces);
+    EXPECT_TRUE(traces.empty());
+}
+
+/* *
+ * \test Only one in every n updates is traced, and the ring keeps the most
+ *       recent traces.
+ * */
+TEST(UpdateTracer, SamplingAndRing) {
+    UpdateTracer::Reset();
+    UpdateTracer::Enable(true, 4);
+    unsigned int traced = 0;
+    uint64_t last = 0;
+    for (unsigned int i = 0; i < 8 * UpdateTracer::CAPACITY; i++) {
+        uint64_t id = UpdateTracer::Begin(UpdateTracer::RECEIVED, PATH, IFACE);
+        if (0 != id) {
+            traced++;
+            last = id;
+        }
+    }
+    UpdateTracer::Enable(false);
+    EXPECT_EQ(2 * UpdateTracer::CAPACITY, traced);
+
+    std::vector<UpdateTracer::Trace> traces;
+    UpdateTracer::GetTraces(traces);
+    // sampling does not leave slots unused, the ring holds the latest traces
+    ASSERT_EQ((size_t)UpdateTracer::CAPACITY, traces.size());
+    EXPECT_EQ(last, traces.back().id);
+    for (size_t i = 1; i < traces.size(); i++) {
+        EXPECT_EQ(traces[i - 1].id + 1, traces[i].id);
+    }
+    UpdateTracer::Reset();
+}
+
+/* *
+ * \test Merged updates refer to the update they were merged into, and all
+ *       traces end up in the Chrome trace.
+ * */
+TEST(UpdateTracer, ChromeTrace) {
+    UpdateTracer::Reset();
+    UpdateTracer::Enable(true);
+    uint64_t first = UpdateTracer::Begin(UpdateTracer::RECEIVED, PATH, IFACE);
+    uint64_t second = UpdateTracer::Begin(UpdateTracer::RECEIVED, PATH, IFACE);
+    UpdateTracer::Merge(second, first);
+    UpdateTracer::Record(first, UpdateTracer::DEQUEUED);
+    UpdateTracer::Enable(false);
+
+    std::vector<UpdateTracer::Trace> traces;
+    UpdateTracer::GetTraces(traces);
+    ASSERT_EQ((size_t)2, traces.size());
+    EXPECT_EQ((uint64_t)0, traces[0].mergedInto);
+    EXPECT_EQ(first, traces[1].mergedInto);
+
+    FILE* out = tmpfile();
+    ASSERT_TRUE(NULL != out);
+    UpdateTracer::DumpChromeTrace(out);
+    rewind(out);
+    char buffer[4096];
+    size_t len = fread(buffer, 1, sizeof(buffer) - 1, out);
+    buffer[len] = '\0';
+    fclose(out);
+
+    EXPECT_EQ(0, strncmp(buffer, "{\"traceEvents\":[", 16));
+    EXPECT_TRUE(NULL != strstr(buffer, "\"name\":\"queue\",\"cat\":\"consumer\",\"ph\":\"b\""));
+    EXPECT_TRUE(NULL != strstr(buffer, "\"name\":\"queue\",\"cat\":\"consumer\",\"ph\":\"e\""));
+    EXPECT_TRUE(NULL != strstr(buffer, "\"name\":\"merged\""));
+    EXPECT_TRUE(NULL != strstr(buffer, "\"path\":\"" PATH "\""));
+    UpdateTracer::Reset();
+}
+}